@@ -38,6 +38,16 @@ if(MFX_VPP)
   add_definitions(-DMFX_VPP)
 endif()
 
+if(MFX_COMPOSITOR)
+  pkg_check_modules(GSTREAMER_VIDEO_AGGREGATOR gstreamer-video-1.0>=1.16)
+  if(GSTREAMER_VIDEO_AGGREGATOR_FOUND)
+    add_definitions(-DMFX_COMPOSITOR)
+  else()
+    message(STATUS "GStreamer video library older than 1.16, disabling MFX_COMPOSITOR")
+    set(MFX_COMPOSITOR OFF)
+  endif()
+endif()
+
 if(MFX_SINK)
   add_definitions(-DMFX_SINK)
   if(WITH_WAYLAND)
@@ -90,6 +100,14 @@ if(MFX_JPEG_ENCODER)
   add_definitions(-DMFX_JPEG_ENCODER)
 endif()
 
+if(MFX_ABR_ENCODER)
+  add_definitions(-DMFX_ABR_ENCODER)
+endif()
+
+if(MFX_GOP_TRANSCODER)
+  add_definitions(-DMFX_GOP_TRANSCODER)
+endif()
+
 if(MFX_VC1_PARSER)
   FindVC1(PARSER)
   add_definitions(-DMFX_VC1_PARSER)
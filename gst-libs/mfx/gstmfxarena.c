@@ -0,0 +1,153 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "sysdeps.h"
+#include "gstmfxarena.h"
+
+#include <sys/mman.h>
+
+#define DEBUG 1
+#include "gstmfxdebug.h"
+
+#define PAGE_SIZE_2M (2 * 1024 * 1024)
+
+/* Free blocks are kept up to this amount, so that surface pools which
+ * get torn down on renegotiation don't pin memory forever */
+#define MAX_CACHED_SIZE (256 * 1024 * 1024)
+
+typedef struct _GstMfxArenaBlock GstMfxArenaBlock;
+
+/* Free blocks are chained through their own first bytes */
+struct _GstMfxArenaBlock
+{
+  GstMfxArenaBlock *next;
+};
+
+/* Block size to the first free block of that size */
+static GHashTable *free_blocks;
+static gsize cached_size;
+static GMutex arena_lock;
+
+static gsize
+get_block_size (gsize size)
+{
+  static gsize page_size;
+
+  if (size >= PAGE_SIZE_2M)
+    return GST_ROUND_UP_N (size, PAGE_SIZE_2M);
+
+  if (!page_size)
+    page_size = sysconf (_SC_PAGESIZE);
+  return GST_ROUND_UP_N (size, page_size);
+}
+
+static gpointer
+map_huge_block (gsize size)
+{
+  guint8 *data, *aligned;
+  gsize head;
+
+#ifdef MAP_HUGETLB
+  /* Explicit huge pages, if any were reserved by the administrator */
+  data = mmap (NULL, size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (MAP_FAILED != data)
+    return data;
+#endif
+
+  /* Otherwise over-map by one huge page and trim the excess, so that
+   * transparent huge pages can back the whole block */
+  data = mmap (NULL, size + PAGE_SIZE_2M, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED == data)
+    return NULL;
+
+  aligned = (guint8 *) GST_ROUND_UP_N ((guintptr) data, PAGE_SIZE_2M);
+  head = aligned - data;
+  if (head)
+    munmap (data, head);
+  munmap (aligned + size, PAGE_SIZE_2M - head);
+
+#ifdef MADV_HUGEPAGE
+  madvise (aligned, size, MADV_HUGEPAGE);
+#endif
+  return aligned;
+}
+
+gpointer
+gst_mfx_arena_alloc (gsize size)
+{
+  const gsize block_size = get_block_size (size);
+  GstMfxArenaBlock *block;
+  gpointer data;
+
+  g_mutex_lock (&arena_lock);
+  if (!free_blocks)
+    free_blocks = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  block = g_hash_table_lookup (free_blocks, GSIZE_TO_POINTER (block_size));
+  if (block) {
+    if (block->next)
+      g_hash_table_insert (free_blocks, GSIZE_TO_POINTER (block_size),
+          block->next);
+    else
+      g_hash_table_remove (free_blocks, GSIZE_TO_POINTER (block_size));
+    cached_size -= block_size;
+  }
+  g_mutex_unlock (&arena_lock);
+
+  if (block)
+    return block;
+
+  if (block_size >= PAGE_SIZE_2M) {
+    data = map_huge_block (block_size);
+  } else {
+    data = mmap (NULL, block_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == data)
+      data = NULL;
+  }
+
+  if (!data)
+    GST_ERROR ("failed to map %" G_GSIZE_FORMAT " bytes", block_size);
+  return data;
+}
+
+void
+gst_mfx_arena_free (gpointer data, gsize size)
+{
+  const gsize block_size = get_block_size (size);
+  GstMfxArenaBlock *const block = data;
+
+  if (!data)
+    return;
+
+  g_mutex_lock (&arena_lock);
+  if (cached_size + block_size <= MAX_CACHED_SIZE) {
+    block->next =
+        g_hash_table_lookup (free_blocks, GSIZE_TO_POINTER (block_size));
+    g_hash_table_insert (free_blocks, GSIZE_TO_POINTER (block_size), block);
+    cached_size += block_size;
+    data = NULL;
+  }
+  g_mutex_unlock (&arena_lock);
+
+  if (data)
+    munmap (data, block_size);
+}
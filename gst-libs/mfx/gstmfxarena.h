@@ -0,0 +1,44 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef GST_MFX_ARENA_H
+#define GST_MFX_ARENA_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Alignment of the blocks handed out by the arena, which system memory
+ * surfaces also use for their pitches and plane offsets */
+#define GST_MFX_ARENA_ALIGNMENT 64
+
+/* Allocates a page-aligned block of at least @size bytes for a system
+ * memory surface, backed by huge pages for frame sized blocks whenever
+ * the system provides them */
+gpointer
+gst_mfx_arena_alloc (gsize size);
+
+/* Returns a block of @size bytes obtained from gst_mfx_arena_alloc(),
+ * which is kept around for the next allocation of the same size */
+void
+gst_mfx_arena_free (gpointer data, gsize size);
+
+G_END_DECLS
+
+#endif /* GST_MFX_ARENA_H */
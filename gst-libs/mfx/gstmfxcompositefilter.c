@@ -29,7 +29,11 @@
 #include "gstmfxsurface.h"
 #include "gstmfxsurface_vaapi.h"
 #include "gstmfxsurfacecomposition.h"
+#include "gstmfxsurfacepool.h"
+#include "video-format.h"
 
+#define DEBUG 1
+#include "gstmfxdebug.h"
 
 struct _GstMfxCompositeFilter
 {
@@ -38,6 +42,9 @@ struct _GstMfxCompositeFilter
   GstMfxTaskAggregator *aggregator;
   GstMfxTask *vpp;
   GstMfxSurface *out_surface;
+  GstMfxSurfacePool *out_pool;
+  GstVideoInfo out_info;
+  gboolean has_out_info;
   gboolean inited;
 
   mfxSession session;
@@ -57,6 +64,7 @@ gst_mfx_composite_filter_finalize (GstMfxCompositeFilter * filter)
     g_slice_free1 ((sizeof (mfxVPPCompInputStream) * filter->composite.NumInputStream), filter->composite.InputStream);
 
   gst_mfx_surface_replace (&filter->out_surface, NULL);
+  gst_mfx_surface_pool_replace (&filter->out_pool, NULL);
   gst_mfx_task_aggregator_unref (filter->aggregator);
 
   MFXVideoVPP_Close (filter->session);
@@ -64,11 +72,43 @@ gst_mfx_composite_filter_finalize (GstMfxCompositeFilter * filter)
   gst_mfx_task_replace(&filter->vpp, NULL);
 }
 
+static void
+fill_input_stream (mfxVPPCompInputStream * stream,
+    const GstMfxRectangle * rect, GstMfxSurface * surface, gfloat alpha)
+{
+  stream->DstX = rect->x;
+  stream->DstY = rect->y;
+  stream->DstW = rect->width;
+  stream->DstH = rect->height;
+  stream->PixelAlphaEnable =
+      GST_MFX_SURFACE_FORMAT (surface) == GST_VIDEO_FORMAT_BGRA;
+  stream->GlobalAlphaEnable = alpha < 1.0;
+  stream->GlobalAlpha = stream->GlobalAlphaEnable ? alpha * 255 : 0;
+}
+
+static void
+get_base_rect (GstMfxCompositeFilter * filter,
+    GstMfxSurfaceComposition * composition, GstMfxRectangle * rect)
+{
+  const GstMfxRectangle *base_rect =
+      gst_mfx_surface_composition_get_base_rect (composition);
+
+  if (base_rect) {
+    *rect = *base_rect;
+  } else {
+    rect->x = filter->frame_info.CropX;
+    rect->y = filter->frame_info.CropY;
+    rect->width = filter->frame_info.CropW;
+    rect->height = filter->frame_info.CropH;
+  }
+}
+
 static gboolean
 configure_composite_filter (GstMfxCompositeFilter * filter,
   GstMfxSurfaceComposition * composition)
 {
   GstMfxSubpicture *subpicture = NULL;
+  GstMfxRectangle base_rect;
   guint num_rect = 0;
 
   g_return_val_if_fail (filter != NULL, FALSE);
@@ -78,16 +118,24 @@ configure_composite_filter (GstMfxCompositeFilter * filter,
     memset (&filter->composite, 0, sizeof (mfxExtVPPComposite));
     filter->composite.Header.BufferId = MFX_EXTBUFF_VPP_COMPOSITE;
     filter->composite.Header.BufferSz = sizeof (mfxExtVPPComposite);
-    filter->composite.Y = 0x10;
-    filter->composite.U = 0x80;
-    filter->composite.V = 0x80;
+    /* Black background, the Y/U/V fields alias R/G/B for RGB output */
+    if (filter->params.vpp.Out.FourCC == MFX_FOURCC_RGB4) {
+      filter->composite.R = 0;
+      filter->composite.G = 0;
+      filter->composite.B = 0;
+    } else {
+      filter->composite.Y = 0x10;
+      filter->composite.U = 0x80;
+      filter->composite.V = 0x80;
+    }
   }
 
   num_rect = gst_mfx_surface_composition_get_num_subpictures (composition);
 
   if (filter->num_rect != num_rect && filter->composite.InputStream) {
-    g_slice_free1(((num_rect+1)*sizeof (mfxVPPCompInputStream)),
-        filter->composite.InputStream);
+    g_slice_free1 ((filter->composite.NumInputStream *
+            sizeof (mfxVPPCompInputStream)), filter->composite.InputStream);
+    filter->composite.InputStream = NULL;
   }
 
   filter->num_rect = num_rect;
@@ -98,28 +146,26 @@ configure_composite_filter (GstMfxCompositeFilter * filter,
 
   if(!filter->composite.InputStream) {
     filter->composite.InputStream =
-        g_slice_alloc (filter->composite.NumInputStream *
+        g_slice_alloc0 (filter->composite.NumInputStream *
         sizeof (mfxVPPCompInputStream));
     if (!filter->composite.InputStream)
       return FALSE;
   }
 
   /* Fill the base picture */
-  filter->composite.InputStream[0].DstX = filter->frame_info.CropX;
-  filter->composite.InputStream[0].DstY = filter->frame_info.CropY;
-  filter->composite.InputStream[0].DstW = filter->frame_info.CropW;
-  filter->composite.InputStream[0].DstH = filter->frame_info.CropH;
+  get_base_rect (filter, composition, &base_rect);
+  fill_input_stream (&filter->composite.InputStream[0], &base_rect,
+      gst_mfx_surface_composition_get_base_surface (composition),
+      gst_mfx_surface_composition_get_base_alpha (composition));
 
   /* Fill the subpicture info */
   for (guint i=1; i < filter->composite.NumInputStream; i++) {
     subpicture = gst_mfx_surface_composition_get_subpicture (composition, i-1);
     if (!subpicture)
       return FALSE;
-    filter->composite.InputStream[i].DstX = subpicture->sub_rect.x;
-    filter->composite.InputStream[i].DstY = subpicture->sub_rect.y;
-    filter->composite.InputStream[i].DstH = subpicture->sub_rect.height;
-    filter->composite.InputStream[i].DstW = subpicture->sub_rect.width;
-    filter->composite.InputStream[i].PixelAlphaEnable = 1;
+    fill_input_stream (&filter->composite.InputStream[i],
+        &subpicture->sub_rect, subpicture->surface,
+        subpicture->global_alpha);
   }
 
   filter->ext_buffer = (mfxExtBuffer *) &filter->composite;
@@ -129,11 +175,113 @@ configure_composite_filter (GstMfxCompositeFilter * filter,
   return TRUE;
 }
 
+/* Checks whether the number, the placement or the blending of the
+ * input streams differs from the layout the VPP is currently
+ * configured with */
+static gboolean
+composite_layout_changed (GstMfxCompositeFilter * filter,
+    GstMfxSurfaceComposition * composition)
+{
+  GstMfxSubpicture *subpicture;
+  GstMfxRectangle base_rect;
+  mfxVPPCompInputStream stream;
+  guint i, num_rect;
+
+  num_rect = gst_mfx_surface_composition_get_num_subpictures (composition);
+  if (num_rect != filter->num_rect || !filter->composite.InputStream)
+    return TRUE;
+
+  memset (&stream, 0, sizeof (stream));
+  get_base_rect (filter, composition, &base_rect);
+  fill_input_stream (&stream, &base_rect,
+      gst_mfx_surface_composition_get_base_surface (composition),
+      gst_mfx_surface_composition_get_base_alpha (composition));
+  if (memcmp (&stream, &filter->composite.InputStream[0], sizeof (stream)))
+    return TRUE;
+
+  for (i = 0; i < num_rect; i++) {
+    subpicture = gst_mfx_surface_composition_get_subpicture (composition, i);
+
+    memset (&stream, 0, sizeof (stream));
+    fill_input_stream (&stream, &subpicture->sub_rect, subpicture->surface,
+        subpicture->global_alpha);
+    if (memcmp (&stream, &filter->composite.InputStream[i + 1],
+            sizeof (stream)))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* Input frames of the VPP must be large enough for every input stream,
+ * whichever pad it comes from */
+static void
+get_max_input_size (GstMfxSurfaceComposition * composition,
+    mfxU16 * width, mfxU16 * height)
+{
+  GstMfxSubpicture *subpicture;
+  mfxFrameInfo *info;
+  guint i, num_subpictures;
+
+  info = &gst_mfx_surface_get_frame_surface (
+      gst_mfx_surface_composition_get_base_surface (composition))->Info;
+  *width = info->Width;
+  *height = info->Height;
+
+  num_subpictures =
+      gst_mfx_surface_composition_get_num_subpictures (composition);
+  for (i = 0; i < num_subpictures; i++) {
+    subpicture = gst_mfx_surface_composition_get_subpicture (composition, i);
+    info = &gst_mfx_surface_get_frame_surface (subpicture->surface)->Info;
+    *width = MAX (*width, info->Width);
+    *height = MAX (*height, info->Height);
+  }
+}
+
+static gboolean
+init_params (GstMfxCompositeFilter * filter,
+    GstMfxSurfaceComposition * composition)
+{
+  mfxU16 width, height;
+
+  filter->params.vpp.In = filter->frame_info;
+  filter->params.vpp.Out = filter->frame_info;
+
+  if (filter->out_pool) {
+    GstMfxSurface *surface = gst_mfx_surface_new_from_pool (filter->out_pool);
+    if (!surface)
+      return FALSE;
+    filter->params.vpp.Out = gst_mfx_surface_get_frame_surface (surface)->Info;
+    gst_mfx_surface_unref (surface);
+
+    /* Input streams may be placed anywhere in the output frame */
+    filter->params.vpp.In.Width =
+        MAX (filter->params.vpp.In.Width, filter->params.vpp.Out.Width);
+    filter->params.vpp.In.Height =
+        MAX (filter->params.vpp.In.Height, filter->params.vpp.Out.Height);
+    filter->params.vpp.In.CropX = 0;
+    filter->params.vpp.In.CropY = 0;
+    filter->params.vpp.In.CropW = filter->params.vpp.Out.CropW;
+    filter->params.vpp.In.CropH = filter->params.vpp.Out.CropH;
+  }
+
+  get_max_input_size (composition, &width, &height);
+  filter->params.vpp.In.Width = MAX (filter->params.vpp.In.Width, width);
+  filter->params.vpp.In.Height = MAX (filter->params.vpp.In.Height, height);
+
+  if (!configure_composite_filter (filter, composition)) {
+    GST_ERROR ("Error initializing composite filter params.");
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_mfx_composite_filter_reset (GstMfxCompositeFilter * filter,
     GstMfxSurfaceComposition * composition)
 {
   mfxStatus sts = MFX_ERR_NONE;
+  mfxU16 width, height;
 
   g_return_val_if_fail (filter != NULL, FALSE);
   g_return_val_if_fail (composition != NULL, FALSE);
@@ -141,6 +289,31 @@ gst_mfx_composite_filter_reset (GstMfxCompositeFilter * filter,
   if (!filter->inited)
     return TRUE;
 
+  /* Reset can't grow the frames the VPP was initialized with, so an
+   * input larger than all previous ones needs a new VPP */
+  get_max_input_size (composition, &width, &height);
+  if (width > filter->params.vpp.In.Width
+      || height > filter->params.vpp.In.Height) {
+    GST_DEBUG ("input of %ux%u exceeds composite filter input frames, "
+        "restarting composite filter", width, height);
+
+    MFXVideoVPP_Close (filter->session);
+    if (!init_params (filter, composition))
+      return FALSE;
+
+    sts = MFXVideoVPP_Init (filter->session, &filter->params);
+    if (sts < 0) {
+      GST_ERROR ("Error initializing MFX VPP %d", sts);
+      return FALSE;
+    }
+    return TRUE;
+  }
+
+  if (!composite_layout_changed (filter, composition))
+    return TRUE;
+
+  GST_DEBUG ("composition layout changed, resetting composite filter");
+
   if (!configure_composite_filter (filter, composition))
       return FALSE;
 
@@ -233,26 +406,12 @@ gst_mfx_composite_filter_replace(GstMfxCompositeFilter ** old_filter_ptr,
     GST_MFX_MINI_OBJECT(new_filter));
 }
 
-static gboolean
-init_params (GstMfxCompositeFilter * filter,
-    GstMfxSurfaceComposition * composition)
-{
-  filter->params.vpp.In = filter->frame_info;
-  filter->params.vpp.Out = filter->frame_info;
-
-  if (!configure_composite_filter (filter, composition)) {
-    GST_ERROR ("Error initializing composite filter params.");
-    return FALSE;
-  }
-
-  return TRUE;
-}
-
 static gboolean
 gst_mfx_composite_filter_start (GstMfxCompositeFilter * filter,
   GstMfxSurfaceComposition * composition)
 {
   GstMfxSurface *base_surface;
+  GstMfxDisplay *display;
   mfxStatus sts = MFX_ERR_NONE;
   GstVideoInfo info;
 
@@ -261,27 +420,40 @@ gst_mfx_composite_filter_start (GstMfxCompositeFilter * filter,
   base_surface = gst_mfx_surface_composition_get_base_surface (composition);
   filter->frame_info = gst_mfx_surface_get_frame_surface (base_surface)->Info;
 
-  if (!init_params (filter, composition)) {
-    GST_ERROR ("Error initializing composite filter params.");
-    return FALSE;
+  if (filter->params.IOPattern & MFX_IOPATTERN_OUT_VIDEO_MEMORY) {
+    display = gst_mfx_surface_vaapi_get_display (base_surface);
+    gst_mfx_task_use_video_memory (filter->vpp);
+  } else {
+    display = gst_mfx_task_aggregator_get_display (filter->aggregator);
   }
 
-  gst_video_info_set_format(&info, GST_MFX_SURFACE_FORMAT (base_surface),
-    GST_MFX_SURFACE_WIDTH (base_surface), GST_MFX_SURFACE_HEIGHT (base_surface));
-
-  /* Allocate output surface for final composition */
-  if (filter->params.IOPattern & MFX_IOPATTERN_OUT_VIDEO_MEMORY) {
-    GstMfxDisplay *display =
-        gst_mfx_surface_vaapi_get_display (base_surface);
-    filter->out_surface = gst_mfx_surface_vaapi_new (display, &info, NULL);
+  /* Output surfaces are handed out downstream one per frame when the
+   * output format is set, otherwise a single one is rendered into */
+  if (filter->has_out_info) {
+    filter->out_pool = gst_mfx_surface_pool_new (display, &filter->out_info,
+        !(filter->params.IOPattern & MFX_IOPATTERN_OUT_VIDEO_MEMORY));
     gst_mfx_display_unref (display);
-
-    gst_mfx_task_use_video_memory (filter->vpp);
+    if (!filter->out_pool)
+      return FALSE;
   } else {
-    filter->out_surface = gst_mfx_surface_new (&info);
+    gst_video_info_set_format(&info, GST_MFX_SURFACE_FORMAT (base_surface),
+      GST_MFX_SURFACE_WIDTH (base_surface),
+      GST_MFX_SURFACE_HEIGHT (base_surface));
+
+    /* Allocate output surface for final composition */
+    if (filter->params.IOPattern & MFX_IOPATTERN_OUT_VIDEO_MEMORY)
+      filter->out_surface = gst_mfx_surface_vaapi_new (display, &info, NULL);
+    else
+      filter->out_surface = gst_mfx_surface_new (&info);
+    gst_mfx_display_unref (display);
+    if (!filter->out_surface)
+      return FALSE;
   }
-  if (!filter->out_surface)
+
+  if (!init_params (filter, composition)) {
+    GST_ERROR ("Error initializing composite filter params.");
     return FALSE;
+  }
 
   sts = MFXVideoVPP_Init (filter->session, &filter->params);
   if (sts < 0) {
@@ -291,6 +463,45 @@ gst_mfx_composite_filter_start (GstMfxCompositeFilter * filter,
   return TRUE;
 }
 
+/**
+ * gst_mfx_composite_filter_set_output_info:
+ * @filter: a #GstMfxCompositeFilter
+ * @info: the #GstVideoInfo of the composed frames
+ *
+ * Sets the size and format of the composed frames, which otherwise
+ * match the base surface. Each call to
+ * gst_mfx_composite_filter_apply_composition() then renders into a new
+ * surface from an internal pool, so that the output can be pushed
+ * downstream. This must be called before the first composition is
+ * applied.
+ *
+ * Return value: %TRUE on success
+ */
+gboolean
+gst_mfx_composite_filter_set_output_info (GstMfxCompositeFilter * filter,
+    const GstVideoInfo * info)
+{
+  g_return_val_if_fail (filter != NULL, FALSE);
+  g_return_val_if_fail (info != NULL, FALSE);
+
+  if (filter->inited) {
+    GST_ERROR ("composite filter output can't be changed once started");
+    return FALSE;
+  }
+
+  if (GST_VIDEO_INFO_FORMAT (info) != GST_VIDEO_FORMAT_NV12 &&
+      GST_VIDEO_INFO_FORMAT (info) != GST_VIDEO_FORMAT_BGRA) {
+    GST_ERROR ("unsupported composite output format %s",
+        gst_video_format_to_string (GST_VIDEO_INFO_FORMAT (info)));
+    return FALSE;
+  }
+
+  filter->out_info = *info;
+  filter->has_out_info = TRUE;
+
+  return TRUE;
+}
+
 gboolean
 gst_mfx_composite_filter_apply_composition (GstMfxCompositeFilter * filter,
   GstMfxSurfaceComposition * composition, GstMfxSurface ** out_surface)
@@ -305,8 +516,8 @@ gst_mfx_composite_filter_apply_composition (GstMfxCompositeFilter * filter,
   num_subpictures =
       gst_mfx_surface_composition_get_num_subpictures (composition);
 
-  /* Reset filter for every frame because subpicture dimension
-   * and position will be different for every frame. */
+  /* Only reset the filter when subpictures were added, removed
+   * or moved since the previous frame */
   if (!gst_mfx_composite_filter_reset (filter, composition))
     return FALSE;
 
@@ -321,6 +532,12 @@ gst_mfx_composite_filter_apply_composition (GstMfxCompositeFilter * filter,
   insurf = gst_mfx_surface_get_frame_surface (surface);
 
   /* Get output surface */
+  if (filter->out_pool) {
+    gst_mfx_surface_replace (&filter->out_surface, NULL);
+    filter->out_surface = gst_mfx_surface_new_from_pool (filter->out_pool);
+    if (!filter->out_surface)
+      return FALSE;
+  }
   outsurf = gst_mfx_surface_get_frame_surface (filter->out_surface);
   do {
     sts =
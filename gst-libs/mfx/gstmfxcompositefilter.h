@@ -49,6 +49,10 @@ void
 gst_mfx_composite_filter_replace(GstMfxCompositeFilter ** old_filter_ptr,
   GstMfxCompositeFilter * new_filter);
 
+gboolean
+gst_mfx_composite_filter_set_output_info (GstMfxCompositeFilter * filter,
+  const GstVideoInfo * info);
+
 gboolean
 gst_mfx_composite_filter_apply_composition (GstMfxCompositeFilter * filter,
   GstMfxSurfaceComposition * composition, GstMfxSurface ** out_surface);
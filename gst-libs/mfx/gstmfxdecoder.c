@@ -22,6 +22,7 @@
 #include <mfxplugin.h>
 #include <mfxvp8.h>
 #include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
 
 #include "gstmfxdecoder.h"
 #include "gstmfxfilter.h"
@@ -72,6 +73,19 @@ struct _GstMfxDecoder
   gboolean sync_out_surf;
   guint num_partial_frames;
 
+  /* Frames dropped ahead of decoding for keyframe-only / decimated output */
+  gboolean key_frames_only;
+  gboolean wait_intra;
+  guint frame_interval;
+  guint frame_count;
+  /* sps_max_sub_layers_minus1 + 1 of the last HEVC SPS, 0 if none seen */
+  guint max_sub_layers;
+
+  /* Smoothed submit-to-sync time of a frame, and the number of times
+   * the device or the surface pool held a frame back */
+  GstClockTime device_latency;
+  guint surface_waits;
+
   /* For special double frame rate deinterlacing case */
   GstClockTime current_pts;
   GstClockTime duration;
@@ -120,6 +134,28 @@ gst_mfx_decoder_skip_corrupted_frames (GstMfxDecoder * decoder)
   decoder->skip_corrupted_frames = TRUE;
 }
 
+void
+gst_mfx_decoder_set_key_frames_only (GstMfxDecoder * decoder,
+    gboolean key_frames_only)
+{
+  g_return_if_fail (decoder != NULL);
+
+  /* Frames following the last key frame were dropped, so the ones that
+   * come next may refer to them until the next intra frame */
+  if (decoder->key_frames_only && !key_frames_only)
+    decoder->wait_intra = TRUE;
+  decoder->key_frames_only = key_frames_only;
+}
+
+void
+gst_mfx_decoder_set_frame_interval (GstMfxDecoder * decoder,
+    guint frame_interval)
+{
+  g_return_if_fail (decoder != NULL);
+
+  decoder->frame_interval = MAX (frame_interval, 1);
+}
+
 void
 gst_mfx_decoder_should_use_video_memory (GstMfxDecoder * decoder,
     gboolean memtype_is_video)
@@ -315,8 +351,8 @@ gst_mfx_decoder_set_video_properties (GstMfxDecoder * decoder)
     frame_info->AspectRatioH = tmp_ratioH;
   }
 
-  frame_info->BitDepthChroma = 8;
-  frame_info->BitDepthLuma = 8;
+  frame_info->BitDepthChroma = frame_info->BitDepthLuma =
+      gst_mfx_video_format_get_bit_depth (frame_info->FourCC);
 
   frame_info->Width = GST_ROUND_UP_16 (decoder->info.width);
   if (decoder->params.mfx.CodecId == MFX_CODEC_HEVC) {
@@ -396,33 +432,159 @@ static gboolean
 gst_mfx_decoder_is_avc_intra (GstMfxDecoder * decoder, guint8 * cdata,
     gint size)
 {
-  gboolean have_intra = FALSE;
-
   if (!decoder || !cdata || !size)
     return FALSE;
 
-  gint32 offset = 0;
-  gint32 packet_size = 0;
+  return gst_mfx_utils_h264_avc_has_intra (cdata, size);
+}
+
+/* Finds the next NAL unit of an AVC (length-prefixed) or byte-stream
+ * buffer, returning its offset and size */
+static gboolean
+gst_mfx_decoder_next_nal_unit (GstMfxDecoder * decoder, const guint8 * data,
+    gint size, gint * offset, gint * nal_size)
+{
+  gint start, end;
 
-  while (offset < (size - 8)) {
-    packet_size = GST_READ_UINT32_BE(&cdata[offset]);
+  if (decoder->is_avc && MFX_CODEC_AVC == decoder->params.mfx.CodecId) {
+    if (*offset + 4 >= size)
+      return FALSE;
+    *nal_size = MIN (GST_READ_UINT32_BE (&data[*offset]), size - *offset - 4);
+    *offset += 4;
+    return TRUE;
+  }
 
-    offset += 4;
-    switch (cdata[offset] & 0x1f) {
-    case GST_H264_NAL_SLICE:
-      have_intra = gst_mfx_utils_h264_is_slice_intra (
-                       &cdata[offset], size - offset);
+  for (start = *offset; start + 3 < size; start++)
+    if (!data[start] && !data[start + 1] && data[start + 2] == 1)
       break;
-    case GST_H264_NAL_SLICE_IDR:
-      have_intra = TRUE;
+  if (start + 3 >= size)
+    return FALSE;
+  start += 3;
+
+  for (end = start; end + 3 <= size; end++)
+    if (!data[end] && !data[end + 1] && data[end + 2] <= 1)
       break;
-    }
-    offset += packet_size;
+  if (end + 3 > size)
+    end = size;
+
+  *offset = start;
+  *nal_size = end - start;
+  return TRUE;
+}
+
+/* Classifies a frame from its first picture / slice header. Codecs that
+ * are not parsed here rely on the sync point flag set by upstream */
+static void
+gst_mfx_decoder_get_frame_type (GstMfxDecoder * decoder,
+    GstVideoCodecFrame * frame, const guint8 * data, gint size,
+    gboolean * is_intra, gboolean * is_reference)
+{
+  gint offset = 0, nal_size = 0, i;
+  guint8 nal_type;
 
-    if (have_intra) break;
+  *is_intra = GST_VIDEO_CODEC_FRAME_IS_SYNC_POINT (frame);
+  *is_reference = TRUE;
+
+  switch (decoder->params.mfx.CodecId) {
+    case MFX_CODEC_AVC:
+      for (; gst_mfx_decoder_next_nal_unit (decoder, data, size, &offset,
+              &nal_size); offset += nal_size) {
+        if (!nal_size)
+          continue;
+        nal_type = data[offset] & NAL_UNITTYPE_BITS;
+        if (GST_H264_NAL_SLICE_IDR == nal_type) {
+          *is_intra = TRUE;
+          return;
+        }
+        if (GST_H264_NAL_SLICE == nal_type) {
+          *is_intra = gst_mfx_utils_h264_is_slice_intra (&data[offset],
+              nal_size);
+          *is_reference = (data[offset] & 0x60) != 0;
+          return;
+        }
+      }
+      break;
+    case MFX_CODEC_HEVC:
+      for (; gst_mfx_decoder_next_nal_unit (decoder, data, size, &offset,
+              &nal_size); offset += nal_size) {
+        if (nal_size < 2)
+          continue;
+        nal_type = (data[offset] >> 1) & 0x3f;
+        if (GST_H265_NAL_SPS == nal_type && nal_size > 2)
+          decoder->max_sub_layers = ((data[offset + 2] >> 1) & 0x7) + 1;
+        if (nal_type > GST_H265_NAL_SLICE_CRA_NUT)
+          continue;
+        *is_intra = nal_type >= GST_H265_NAL_SLICE_BLA_W_LP;
+        /* Even VCL types below the IRAP range are sub-layer non-reference,
+         * pictures of higher sub-layers may still refer to them. Only the
+         * highest sub-layer is known to be unreferenced */
+        if (!*is_intra && !(nal_type & 1) && nal_type <= 14)
+          *is_reference = !decoder->max_sub_layers
+              || (data[offset + 1] & 0x7) != decoder->max_sub_layers;
+        return;
+      }
+      break;
+    case MFX_CODEC_MPEG2:
+      for (i = 0; i + 5 < size; i++) {
+        if (data[i] || data[i + 1] || data[i + 2] != 1 || data[i + 3])
+          continue;
+        /* picture_coding_type follows the 10-bit temporal_reference */
+        switch ((data[i + 5] >> 3) & 0x7) {
+          case 1:
+            *is_intra = TRUE;
+            break;
+          case 3:
+            *is_intra = FALSE;
+            *is_reference = FALSE;
+            break;
+          default:
+            *is_intra = FALSE;
+            break;
+        }
+        return;
+      }
+      break;
+    default:
+      break;
   }
+}
 
-  return have_intra;
+/* Decides whether a frame has to be decoded at all for the configured
+ * output. Frames decoded only as references are flagged decode-only */
+static gboolean
+gst_mfx_decoder_select_frame (GstMfxDecoder * decoder,
+    GstVideoCodecFrame * frame, const guint8 * data, gint size)
+{
+  gboolean is_intra, is_reference;
+
+  if (!decoder->key_frames_only && !decoder->wait_intra
+      && decoder->frame_interval <= 1)
+    return TRUE;
+
+  gst_mfx_decoder_get_frame_type (decoder, frame, data, size,
+      &is_intra, &is_reference);
+
+  if (decoder->wait_intra) {
+    if (!is_intra)
+      return FALSE;
+    decoder->wait_intra = FALSE;
+  }
+  if (!decoder->key_frames_only && decoder->frame_interval <= 1)
+    return TRUE;
+
+  if (decoder->key_frames_only) {
+    if (!is_intra)
+      return FALSE;
+    /* Nothing decoded from now on refers to this frame */
+    is_reference = FALSE;
+  }
+
+  if (decoder->frame_count++ % decoder->frame_interval) {
+    if (!is_reference)
+      return FALSE;
+    GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY (frame);
+  }
+  return TRUE;
 }
 
 static gboolean
@@ -613,6 +775,8 @@ gst_mfx_decoder_init (GstMfxDecoder * decoder,
     goto error_init;
 
   decoder->pts_offset = GST_CLOCK_TIME_NONE;
+  decoder->frame_interval = 1;
+  decoder->device_latency = GST_CLOCK_TIME_NONE;
 
   g_queue_init (&decoder->decoded_frames);
   g_queue_init (&decoder->pending_frames);
@@ -901,6 +1065,7 @@ gst_mfx_decoder_reset (GstMfxDecoder * decoder)
 
   decoder->pts_offset = GST_CLOCK_TIME_NONE;
   decoder->current_pts = 0;
+  decoder->frame_count = 0;
 
   if (decoder->bitstream->len)
     g_byte_array_remove_range (decoder->bitstream, 0,
@@ -967,6 +1132,7 @@ gst_mfx_decoder_decode (GstMfxDecoder * decoder,
   mfxFrameSurface1 *insurf, *outsurf = NULL;
   mfxSyncPoint syncp;
   mfxStatus sts = MFX_ERR_NONE;
+  gint64 start_time;
 
   if(!GST_CLOCK_TIME_IS_VALID(frame->pts)) {
    frame->pts = frame->dts;
@@ -1028,6 +1194,12 @@ gst_mfx_decoder_decode (GstMfxDecoder * decoder,
     }
   }
 
+  if (!gst_mfx_decoder_select_frame (decoder, frame, minfo.data, minfo.size)) {
+    g_queue_push_head(&decoder->discarded_frames, frame);
+    ret = GST_MFX_DECODER_STATUS_ERROR_MORE_DATA;
+    goto end;
+  }
+
   if (!decoder->can_double_deinterlace) {
     /* Save frames for later synchronization with decoded MFX surfaces */
     g_queue_insert_sorted (&decoder->pending_frames, frame, sort_pts, NULL);
@@ -1072,11 +1244,15 @@ gst_mfx_decoder_decode (GstMfxDecoder * decoder,
     if (!surface)
       return GST_MFX_DECODER_STATUS_ERROR_ALLOCATION_FAILED;
 
+    /* Only the last submission counts, the retry sleeps are no device time */
     insurf = gst_mfx_surface_get_frame_surface (surface);
+    start_time = g_get_monotonic_time ();
     sts = MFXVideoDECODE_DecodeFrameAsync (decoder->session, &decoder->bs,
         insurf, &outsurf, &syncp);
     GST_DEBUG ("MFXVideoDECODE_DecodeFrameAsync status: %d", sts);
 
+    if (MFX_WRN_DEVICE_BUSY == sts || MFX_ERR_MORE_SURFACE == sts)
+      decoder->surface_waits++;
     if (MFX_WRN_DEVICE_BUSY == sts)
       g_usleep (100);
   } while (sts > 0 || MFX_ERR_MORE_SURFACE == sts);
@@ -1128,12 +1304,21 @@ gst_mfx_decoder_decode (GstMfxDecoder * decoder,
     }
     decoder->has_ready_frames = TRUE;
 
-    if (!gst_mfx_task_has_type (decoder->decode, GST_MFX_TASK_ENCODER))
+    if (!gst_mfx_task_has_type (decoder->decode, GST_MFX_TASK_ENCODER)) {
+      GstClockTime latency;
+
       do {
         sts = MFXVideoCORE_SyncOperation (decoder->session, syncp, 1000);
         GST_DEBUG ("MFXVideoCORE_SyncOperation status: %d", sts);
       } while (MFX_WRN_IN_EXECUTION == sts);
 
+      latency = (g_get_monotonic_time () - start_time) * GST_USECOND;
+      if (GST_CLOCK_TIME_IS_VALID (decoder->device_latency))
+        decoder->device_latency = (3 * decoder->device_latency + latency) / 4;
+      else
+        decoder->device_latency = latency;
+    }
+
     surface = gst_mfx_surface_pool_find_surface (decoder->pool, outsurf);
 
     /* Update stream properties if they have interlaced frames. An interlaced H264
@@ -1283,3 +1468,30 @@ gst_mfx_decoder_reset_async_depth (GstMfxDecoder *decoder, mfxU16 async_depth)
 {
    decoder->params.AsyncDepth = async_depth;
 }
+
+mfxU16
+gst_mfx_decoder_get_async_depth (GstMfxDecoder * decoder)
+{
+  g_return_val_if_fail (decoder != NULL, 0);
+
+  return decoder->params.AsyncDepth;
+}
+
+/* Smoothed time between submitting a frame and its synchronization,
+ * or GST_CLOCK_TIME_NONE if no frame was synchronized by the decoder */
+GstClockTime
+gst_mfx_decoder_get_device_latency (GstMfxDecoder * decoder)
+{
+  g_return_val_if_fail (decoder != NULL, GST_CLOCK_TIME_NONE);
+
+  return decoder->device_latency;
+}
+
+/* Number of frame retries on a busy device or an exhausted surface pool */
+guint
+gst_mfx_decoder_get_surface_waits (GstMfxDecoder * decoder)
+{
+  g_return_val_if_fail (decoder != NULL, 0);
+
+  return decoder->surface_waits;
+}
@@ -97,6 +97,14 @@ gst_mfx_decoder_get_video_info (GstMfxDecoder * decoder);
 void
 gst_mfx_decoder_skip_corrupted_frames (GstMfxDecoder * decoder);
 
+void
+gst_mfx_decoder_set_key_frames_only (GstMfxDecoder * decoder,
+    gboolean key_frames_only);
+
+void
+gst_mfx_decoder_set_frame_interval (GstMfxDecoder * decoder,
+    guint frame_interval);
+
 void
 gst_mfx_decoder_should_use_video_memory (GstMfxDecoder * decoder,
     gboolean memtype_is_video);
@@ -117,6 +125,15 @@ gst_mfx_decoder_check_system_memory (GstMfxDecoder * decoder);
 void
 gst_mfx_decoder_reset_async_depth (GstMfxDecoder *decoder, mfxU16 async_depth);
 
+mfxU16
+gst_mfx_decoder_get_async_depth (GstMfxDecoder * decoder);
+
+GstClockTime
+gst_mfx_decoder_get_device_latency (GstMfxDecoder * decoder);
+
+guint
+gst_mfx_decoder_get_surface_waits (GstMfxDecoder * decoder);
+
 G_END_DECLS
 
 #endif /* GST_MFX_DECODER_H */
@@ -128,6 +128,8 @@ gst_mfx_display_get_type (void)
     {GST_MFX_DISPLAY_TYPE_EGL,
         "EGL X11/Wayland display", "egl"},
 #endif
+    {GST_MFX_DISPLAY_TYPE_NULL,
+        "Headless display (no presentation)", "null"},
     {0, NULL, NULL},
   };
 
@@ -246,16 +248,14 @@ gst_mfx_display_create (GstMfxDisplay * display,
  * gst_mfx_display_lock:
  * @display: a #GstMfxDisplay
  *
- * Locks @display. If @display is already locked by another thread,
- * the current thread will block until @display is unlocked by the
- * other thread.
+ * Locks @display for calls into the native window system. This takes
+ * the VA lock of @display exclusively, so these calls neither overlap
+ * each other nor VA calls of other threads. The lock is recursive.
  */
 void
 gst_mfx_display_lock (GstMfxDisplay * display)
 {
-  GstMfxDisplayPrivate *priv = GST_MFX_DISPLAY_GET_PRIVATE (display);
-
-  g_rec_mutex_lock (&priv->mutex);
+  gst_mfx_display_va_lock (display, TRUE);
 }
 
 /**
@@ -268,10 +268,66 @@ gst_mfx_display_lock (GstMfxDisplay * display)
  */
 void
 gst_mfx_display_unlock (GstMfxDisplay * display)
+{
+  gst_mfx_display_va_unlock (display, TRUE);
+}
+
+/**
+ * gst_mfx_display_va_lock:
+ * @display: a #GstMfxDisplay
+ * @exclusive: whether the VA call must not overlap any other VA call
+ *
+ * Locks the VA display of @display. libva lets surfaces, images and
+ * buffers be created, mapped and destroyed from several threads at
+ * once, so these calls share the lock. Imports and exports of buffer
+ * handles, derived images, vendor extensions and queries of the driver
+ * state are not thread-safe and take it exclusively, as does
+ * gst_mfx_display_lock().
+ *
+ * A thread holding the lock exclusively may lock it again in any mode.
+ * A thread holding it shared must not lock it exclusively.
+ */
+void
+gst_mfx_display_va_lock (GstMfxDisplay * display, gboolean exclusive)
+{
+  GstMfxDisplayPrivate *priv = GST_MFX_DISPLAY_GET_PRIVATE (display);
+
+  gst_mfx_va_lock_acquire (&priv->va_lock, exclusive);
+}
+
+/**
+ * gst_mfx_display_va_unlock:
+ * @display: a #GstMfxDisplay
+ * @exclusive: the value passed to gst_mfx_display_va_lock()
+ *
+ * Unlocks the VA display of @display.
+ */
+void
+gst_mfx_display_va_unlock (GstMfxDisplay * display, gboolean exclusive)
 {
   GstMfxDisplayPrivate *priv = GST_MFX_DISPLAY_GET_PRIVATE (display);
 
-  g_rec_mutex_unlock (&priv->mutex);
+  gst_mfx_va_lock_release (&priv->va_lock);
+}
+
+/**
+ * gst_mfx_display_get_lock_contention:
+ * @display: a #GstMfxDisplay
+ *
+ * Returns the number of times a thread had to wait for the display
+ * lock or the VA lock of @display since it was created.
+ *
+ * Return value: the number of contended lock acquisitions
+ */
+guint
+gst_mfx_display_get_lock_contention (GstMfxDisplay * display)
+{
+  GstMfxDisplayPrivate *priv;
+
+  g_return_val_if_fail (display != NULL, 0);
+
+  priv = GST_MFX_DISPLAY_GET_PRIVATE (display);
+  return gst_mfx_va_lock_get_contention (&priv->va_lock);
 }
 
 static void
@@ -286,7 +342,7 @@ gst_mfx_display_init (GstMfxDisplay * display)
   priv->par_d = 1;
   priv->is_opengl = FALSE;
 
-  g_rec_mutex_init (&priv->mutex);
+  gst_mfx_va_lock_init (&priv->va_lock);
 
   if (dpy_class->init)
     dpy_class->init (display);
@@ -299,8 +355,11 @@ gst_mfx_display_finalize (GstMfxDisplay * display)
 {
   GstMfxDisplayPrivate *const priv = GST_MFX_DISPLAY_GET_PRIVATE (display);
 
+  GST_DEBUG ("display lock contended %u times",
+      gst_mfx_va_lock_get_contention (&priv->va_lock));
+
   gst_mfx_display_destroy (display);
-  g_rec_mutex_clear (&priv->mutex);
+  gst_mfx_va_lock_clear (&priv->va_lock);
 }
 
 void
@@ -486,13 +545,13 @@ ensure_vendor_string (GstMfxDisplay * display)
   GstMfxDisplayPrivate *const priv = GST_MFX_DISPLAY_GET_PRIVATE (display);
   const gchar *vendor_string;
 
-  GST_MFX_DISPLAY_LOCK (display);
+  GST_MFX_DISPLAY_VA_LOCK_EXCLUSIVE (display);
   if (!priv->vendor_string) {
     vendor_string = vaQueryVendorString (priv->va_display);
     if (vendor_string)
       priv->vendor_string = g_strdup (vendor_string);
   }
-  GST_MFX_DISPLAY_UNLOCK (display);
+  GST_MFX_DISPLAY_VA_UNLOCK_EXCLUSIVE (display);
   return priv->vendor_string != NULL;
 }
 
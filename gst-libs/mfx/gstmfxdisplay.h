@@ -54,7 +54,8 @@ G_BEGIN_DECLS
  * GST_MFX_DISPLAY_LOCK:
  * @display: a #GstMfxDisplay
  *
- * Locks @display
+ * Locks @display for calls into the native window system, and for VA
+ * calls that are bound to it. This takes the VA lock exclusively.
  */
 #define GST_MFX_DISPLAY_LOCK(display) \
   gst_mfx_display_lock (GST_MFX_DISPLAY (display))
@@ -68,6 +69,44 @@ G_BEGIN_DECLS
 #define GST_MFX_DISPLAY_UNLOCK(display) \
   gst_mfx_display_unlock (GST_MFX_DISPLAY (display))
 
+/**
+ * GST_MFX_DISPLAY_VA_LOCK:
+ * @display: a #GstMfxDisplay
+ *
+ * Locks the VA display of @display for VA calls that may run
+ * concurrently on distinct resources
+ */
+#define GST_MFX_DISPLAY_VA_LOCK(display) \
+  gst_mfx_display_va_lock (GST_MFX_DISPLAY (display), FALSE)
+
+/**
+ * GST_MFX_DISPLAY_VA_UNLOCK:
+ * @display: a #GstMfxDisplay
+ *
+ * Unlocks the VA display of @display
+ */
+#define GST_MFX_DISPLAY_VA_UNLOCK(display) \
+  gst_mfx_display_va_unlock (GST_MFX_DISPLAY (display), FALSE)
+
+/**
+ * GST_MFX_DISPLAY_VA_LOCK_EXCLUSIVE:
+ * @display: a #GstMfxDisplay
+ *
+ * Locks the VA display of @display for VA calls that must not overlap
+ * any other VA call
+ */
+#define GST_MFX_DISPLAY_VA_LOCK_EXCLUSIVE(display) \
+  gst_mfx_display_va_lock (GST_MFX_DISPLAY (display), TRUE)
+
+/**
+ * GST_MFX_DISPLAY_VA_UNLOCK_EXCLUSIVE:
+ * @display: a #GstMfxDisplay
+ *
+ * Unlocks the VA display of @display after an exclusive VA call
+ */
+#define GST_MFX_DISPLAY_VA_UNLOCK_EXCLUSIVE(display) \
+  gst_mfx_display_va_unlock (GST_MFX_DISPLAY (display), TRUE)
+
 typedef struct _GstMfxDisplay                 GstMfxDisplay;
 
 typedef enum
@@ -76,6 +115,7 @@ typedef enum
   GST_MFX_DISPLAY_TYPE_X11,
   GST_MFX_DISPLAY_TYPE_WAYLAND,
   GST_MFX_DISPLAY_TYPE_EGL,
+  GST_MFX_DISPLAY_TYPE_NULL,
 } GstMfxDisplayType;
 
 #define GST_MFX_TYPE_DISPLAY_TYPE (gst_mfx_display_get_type())
@@ -102,6 +142,15 @@ gst_mfx_display_lock (GstMfxDisplay * display);
 void
 gst_mfx_display_unlock (GstMfxDisplay * display);
 
+void
+gst_mfx_display_va_lock (GstMfxDisplay * display, gboolean exclusive);
+
+void
+gst_mfx_display_va_unlock (GstMfxDisplay * display, gboolean exclusive);
+
+guint
+gst_mfx_display_get_lock_contention (GstMfxDisplay * display);
+
 GstMfxDisplayType
 gst_mfx_display_get_display_type (GstMfxDisplay * display);
 
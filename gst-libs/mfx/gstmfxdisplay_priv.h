@@ -27,6 +27,7 @@
 #include "gstmfxwindow.h"
 #include "gstmfxwindow_priv.h"
 #include "gstmfxminiobject.h"
+#include "gstmfxvalock.h"
 
 G_BEGIN_DECLS
 
@@ -91,7 +92,7 @@ typedef GstMfxWindow *(*GstMfxDisplayCreateWindowFunc) (
 
 struct _GstMfxDisplayPrivate
 {
-  GRecMutex mutex;
+  GstMfxVaLock va_lock;
   GstMfxDisplayType display_type;
   int display_fd;
   VADisplay va_display;
@@ -141,7 +141,8 @@ gst_mfx_encoder_properties_get_default (const GstMfxEncoderClass * klass)
       g_param_spec_uint ("bitrate",
           "Bitrate (kbps)",
           "The desired bitrate expressed in kbps (0: auto-calculate)",
-          0, G_MAXUINT16, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, G_MAXUINT16, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
 
  /**
   * GstMfxEncoder:brc-multiplier
@@ -177,7 +178,8 @@ gst_mfx_encoder_properties_get_default (const GstMfxEncoderClass * klass)
       g_param_spec_uint ("max-bitrate",
           "VBV maximum bit rate (Kbps)",
           "Maximum bit rate at which encoded data enters the VBV",
-          0, G_MAXUINT16, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, G_MAXUINT16, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
 
  /**
   * GstMfxEncoder:idr-interval
@@ -448,6 +450,21 @@ gst_mfx_encoder_set_frame_info (GstMfxEncoder * encoder)
       encoder->frame_info = encoder->params.mfx.FrameInfo;
       encoder->frame_info.FourCC =
           gst_video_format_to_mfx_fourcc (GST_VIDEO_INFO_FORMAT (&encoder->info));
+      encoder->frame_info.BitDepthChroma = encoder->frame_info.BitDepthLuma =
+          gst_mfx_video_format_get_bit_depth (encoder->frame_info.FourCC);
+      encoder->frame_info.Shift =
+          gst_mfx_video_format_get_shift (encoder->frame_info.FourCC);
+    }
+
+    /* HEVC encodes P010 input at 10 bits, everything else goes through
+     * a VPP conversion to NV12 first */
+    if (MFX_CODEC_HEVC == encoder->codec
+        && MFX_FOURCC_P010 == encoder->frame_info.FourCC) {
+      encoder->params.mfx.FrameInfo.FourCC = encoder->frame_info.FourCC;
+      encoder->params.mfx.FrameInfo.BitDepthChroma =
+          encoder->params.mfx.FrameInfo.BitDepthLuma =
+          encoder->frame_info.BitDepthLuma;
+      encoder->params.mfx.FrameInfo.Shift = encoder->frame_info.Shift;
     }
   }
   else {
@@ -532,12 +549,18 @@ gst_mfx_encoder_init_properties (GstMfxEncoder * encoder,
   encoder->bs.Data = encoder->bitstream->data;
   encoder->async_depth = DEFAULT_ASYNC_DEPTH;
 
+  /* Per-frame control for key frame requests. It is never modified, so
+   * it stays valid for frames still queued in the encoder */
+  encoder->force_idr_ctrl.FrameType =
+      MFX_FRAMETYPE_I | MFX_FRAMETYPE_REF | MFX_FRAMETYPE_IDR;
+
   encoder->info = *info;
   if (!encoder->info.fps_n)
     encoder->info.fps_n = 30;
   encoder->duration =
       (encoder->info.fps_d / (gdouble)encoder->info.fps_n) * 1000000000;
   encoder->current_pts = GST_CLOCK_TIME_NONE;
+  encoder->device_latency = GST_CLOCK_TIME_NONE;
 
   encoder->memtype_is_system = memtype_is_system;
 
@@ -661,6 +684,69 @@ gst_mfx_encoder_set_async_depth (GstMfxEncoder * encoder, mfxU16 async_depth)
   return TRUE;
 }
 
+/* AsyncDepth the session runs with, which the SDK may pick itself when
+ * it was left at 0 */
+mfxU16
+gst_mfx_encoder_get_async_depth (GstMfxEncoder * encoder)
+{
+  g_return_val_if_fail (encoder != NULL, 0);
+
+  return encoder->initialized ?
+      encoder->params.AsyncDepth : encoder->async_depth;
+}
+
+/* Smoothed time between the device accepting a frame and its
+ * synchronization, or GST_CLOCK_TIME_NONE if no frame was synchronized
+ * yet. Retries on a busy device are left out, as they depend on the
+ * async depth and are counted as surface waits instead */
+GstClockTime
+gst_mfx_encoder_get_device_latency (GstMfxEncoder * encoder)
+{
+  g_return_val_if_fail (encoder != NULL, GST_CLOCK_TIME_NONE);
+
+  return encoder->device_latency;
+}
+
+/* GOP size the session runs with, 0 if unknown */
+guint
+gst_mfx_encoder_get_gop_size (GstMfxEncoder * encoder)
+{
+  g_return_val_if_fail (encoder != NULL, 0);
+
+  return encoder->initialized ?
+      encoder->params.mfx.GopPicSize : encoder->gop_size;
+}
+
+/* Number of frame retries on a busy device */
+guint
+gst_mfx_encoder_get_surface_waits (GstMfxEncoder * encoder)
+{
+  g_return_val_if_fail (encoder != NULL, 0);
+
+  return encoder->surface_waits;
+}
+
+gboolean
+gst_mfx_encoder_set_subframe_func (GstMfxEncoder * encoder,
+    GstMfxEncoderSubframeFunc func, gpointer user_data)
+{
+  g_return_val_if_fail (encoder != NULL, FALSE);
+
+#if MSDK_CHECK_VERSION(1,31)
+  if (func && MFX_CODEC_AVC != encoder->codec
+      && MFX_CODEC_HEVC != encoder->codec)
+    return FALSE;
+
+  encoder->subframe_func = func;
+  encoder->subframe_data = user_data;
+  return TRUE;
+#else
+  if (func)
+    GST_WARNING ("Partial bitstream output requires MSDK API 1.31");
+  return func == NULL;
+#endif
+}
+
 gboolean
 gst_mfx_encoder_set_gop_refdist (GstMfxEncoder * encoder, gint gop_refdist)
 {
@@ -795,6 +881,26 @@ set_extended_coding_options (GstMfxEncoder * encoder)
     encoder->extco2.Trellis = encoder->trellis;
   }
 
+  if (encoder->intra_refresh != GST_MFX_ENCODER_INTRA_REFRESH_OFF) {
+    mfxU16 cycle_size = encoder->intra_refresh_cycle_size;
+
+    /* Default to refreshing the whole picture once per second */
+    if (!cycle_size) {
+      gdouble frame_rate;
+
+      gst_util_fraction_to_double (encoder->info.fps_n,
+        encoder->info.fps_d, &frame_rate);
+      cycle_size = (guint16)(frame_rate + 0.5);
+    }
+
+    encoder->extco2.IntRefType = encoder->intra_refresh;
+    encoder->extco2.IntRefCycleSize = MAX (cycle_size, 2);
+    encoder->extco2.IntRefQPDelta = encoder->intra_refresh_qp_delta;
+
+    /* Let decoders start at any refresh cycle boundary */
+    encoder->extco.RecoveryPointSEI = MFX_CODINGOPTION_ON;
+  }
+
   switch (encoder->rc_method) {
     case GST_MFX_RATECONTROL_LA_BRC:
     case GST_MFX_RATECONTROL_LA_ICQ:
@@ -825,7 +931,19 @@ set_extended_coding_options (GstMfxEncoder * encoder)
   encoder->extparam_internal[encoder->params.NumExtParam++] =
       (mfxExtBuffer *) &encoder->extco2;
 
+#if MSDK_CHECK_VERSION(1,31)
+  if (encoder->subframe_func) {
+    encoder->extpartial.Header.BufferId = MFX_EXTBUFF_PARTIAL_BITSTREAM_PARAM;
+    encoder->extpartial.Header.BufferSz = sizeof (encoder->extpartial);
+    encoder->extpartial.Granularity = MFX_PARTIAL_BITSTREAM_SLICE;
+
+    encoder->extparam_internal[encoder->params.NumExtParam++] =
+        (mfxExtBuffer *) &encoder->extpartial;
+  }
+#endif
+
   encoder->params.ExtParam = encoder->extparam_internal;
+  encoder->nb_extparam_internal = encoder->params.NumExtParam;
 }
 
 /* Many of the default settings here are inspired by Handbrake */
@@ -836,6 +954,25 @@ gst_mfx_encoder_set_encoding_params (GstMfxEncoder * encoder)
   encoder->params.AsyncDepth = encoder->async_depth;
 
   if (encoder->codec != MFX_CODEC_JPEG) {
+    /* With rolling intra refresh, recovery points replace periodic key
+     * frames, so use a single open-ended GOP of P-frames unless the user
+     * explicitly asked for something else */
+    if (encoder->intra_refresh != GST_MFX_ENCODER_INTRA_REFRESH_OFF) {
+      if (!encoder->gop_size)
+        encoder->gop_size = G_MAXUINT16;
+      if (encoder->gop_refdist < 0)
+        encoder->gop_refdist = 1;
+    }
+
+    /* Slices can only be output ahead of the frame if it is not held
+     * back for reordering */
+    if (encoder->subframe_func && encoder->gop_refdist != 1) {
+      if (encoder->gop_refdist > 1)
+        GST_WARNING ("B-frames are not supported with subframe output, "
+            "disabling them");
+      encoder->gop_refdist = 1;
+    }
+
     switch (encoder->rc_method) {
       case GST_MFX_RATECONTROL_CQP:
         encoder->params.mfx.QPI =
@@ -992,7 +1129,7 @@ gst_mfx_encoder_start (GstMfxEncoder *encoder)
     gst_mfx_task_set_request(encoder->encode, request);
   }
 
-  if (MFX_FOURCC_NV12 != encoder->frame_info.FourCC) {
+  if (encoder->params.mfx.FrameInfo.FourCC != encoder->frame_info.FourCC) {
     encoder->filter = gst_mfx_filter_new_with_task (encoder->aggregator,
         encoder->encode, GST_MFX_TASK_VPP_OUT,
         encoder->memtype_is_system, memtype_is_system);
@@ -1019,6 +1156,7 @@ gst_mfx_encoder_start (GstMfxEncoder *encoder)
 
   memset (&encoder->params, 0, sizeof(mfxVideoParam));
   MFXVideoENCODE_GetVideoParam (encoder->session, &encoder->params);
+  encoder->initialized = TRUE;
 
   GST_INFO ("Initialized MFX encoder task using input %s memory surfaces",
     memtype_is_system ? "system" : "video");
@@ -1026,6 +1164,172 @@ gst_mfx_encoder_start (GstMfxEncoder *encoder)
   return GST_MFX_ENCODER_STATUS_SUCCESS;
 }
 
+/* Checks whether the input format no longer matches the surfaces the
+ * encoder was started with, which only a new encoder can handle */
+static gboolean
+input_format_changed (GstMfxEncoder * encoder)
+{
+  const GstVideoFormatInfo *const finfo = encoder->info.finfo;
+  const mfxFrameInfo *const frame_info = &encoder->frame_info;
+  mfxU16 chroma_format;
+
+  if (gst_video_format_to_mfx_fourcc (GST_VIDEO_INFO_FORMAT (&encoder->info))
+      != frame_info->FourCC)
+    return TRUE;
+
+  if (frame_info->BitDepthLuma
+      && frame_info->BitDepthLuma != GST_VIDEO_FORMAT_INFO_DEPTH (finfo, 0))
+    return TRUE;
+
+  if (GST_VIDEO_FORMAT_INFO_W_SUB (finfo, 1)
+      && GST_VIDEO_FORMAT_INFO_H_SUB (finfo, 1))
+    chroma_format = MFX_CHROMAFORMAT_YUV420;
+  else if (GST_VIDEO_FORMAT_INFO_W_SUB (finfo, 1))
+    chroma_format = MFX_CHROMAFORMAT_YUV422;
+  else
+    chroma_format = MFX_CHROMAFORMAT_YUV444;
+
+  return frame_info->ChromaFormat && frame_info->ChromaFormat != chroma_format;
+}
+
+/**
+ * gst_mfx_encoder_reset_starts_new_sequence:
+ * @encoder: a #GstMfxEncoder
+ *
+ * Checks whether gst_mfx_encoder_reset () would start a new sequence
+ * with the current parameters, which is the case when the resolution
+ * changed. A change of the input FourCC, chroma format or bit depth
+ * can't be applied by a reset at all, and is reported as a new sequence
+ * too, so that the frames in flight are flushed before the encoder is
+ * re-created.
+ *
+ * Return value: %TRUE if the next reset starts a new sequence
+ */
+gboolean
+gst_mfx_encoder_reset_starts_new_sequence (GstMfxEncoder * encoder)
+{
+  mfxFrameInfo *frame_info;
+
+  g_return_val_if_fail (encoder != NULL, FALSE);
+
+  frame_info = &encoder->params.mfx.FrameInfo;
+  return encoder->info.width != frame_info->CropW
+      || encoder->info.height != frame_info->CropH
+      || input_format_changed (encoder);
+}
+
+/**
+ * gst_mfx_encoder_reset:
+ * @encoder: a #GstMfxEncoder
+ *
+ * Applies the current bitrate, maximum bitrate, framerate and
+ * resolution to a running encoder through MFXVideoENCODE_Reset (),
+ * without re-creating the session or reallocating surfaces. Bitrate
+ * and framerate changes continue the current sequence, so no IDR frame
+ * is inserted. A new sequence is only started on resolution changes.
+ *
+ * When gst_mfx_encoder_reset_starts_new_sequence () returns %TRUE, all
+ * frames buffered by the encoder must have been flushed with
+ * gst_mfx_encoder_flush () beforehand. Otherwise they stay in flight and
+ * are output by the following calls.
+ *
+ * The coding options the encoder was started with are passed again, so
+ * that the reset doesn't fall back to their defaults.
+ *
+ * Return value: %GST_MFX_ENCODER_STATUS_SUCCESS if the new parameters
+ *   were applied, %GST_MFX_ENCODER_STATUS_ERROR_INVALID_PARAMETER if
+ *   they cannot be applied without re-creating the encoder.
+ */
+GstMfxEncoderStatus
+gst_mfx_encoder_reset (GstMfxEncoder * encoder)
+{
+  mfxVideoParam params;
+  mfxFrameInfo *const frame_info = &encoder->params.mfx.FrameInfo;
+  gboolean new_sequence;
+  mfxStatus sts;
+  gint i;
+
+  g_return_val_if_fail (encoder != NULL,
+      GST_MFX_ENCODER_STATUS_ERROR_INVALID_PARAMETER);
+
+  if (!encoder->initialized)
+    return GST_MFX_ENCODER_STATUS_ERROR_INVALID_PARAMETER;
+
+  if (input_format_changed (encoder)) {
+    GST_INFO ("input format %s cannot be applied with an encoder reset",
+        GST_VIDEO_INFO_NAME (&encoder->info));
+    return GST_MFX_ENCODER_STATUS_ERROR_INVALID_PARAMETER;
+  }
+
+  new_sequence = gst_mfx_encoder_reset_starts_new_sequence (encoder);
+
+  /* Input surfaces are allocated once, by us or by the upstream task we
+   * share them with, so only shrinking within them is possible here */
+  if (new_sequence && (encoder->shared || encoder->filter
+          || encoder->info.width > frame_info->Width
+          || encoder->info.height > frame_info->Height)) {
+    GST_INFO ("resolution %dx%d cannot be applied with an encoder reset",
+        encoder->info.width, encoder->info.height);
+    return GST_MFX_ENCODER_STATUS_ERROR_INVALID_PARAMETER;
+  }
+
+  params = encoder->params;
+  params.mfx.FrameInfo.CropW = encoder->info.width;
+  params.mfx.FrameInfo.CropH = encoder->info.height;
+  if (encoder->info.fps_n) {
+    params.mfx.FrameInfo.FrameRateExtN = encoder->info.fps_n;
+    params.mfx.FrameInfo.FrameRateExtD = encoder->info.fps_d;
+  }
+
+  if (MFX_CODEC_JPEG != encoder->codec) {
+    if (encoder->bitrate)
+      params.mfx.TargetKbps = encoder->bitrate;
+    if (encoder->vbv_max_bitrate > encoder->bitrate)
+      params.mfx.MaxKbps = encoder->vbv_max_bitrate;
+    else if (params.mfx.MaxKbps && params.mfx.MaxKbps < params.mfx.TargetKbps)
+      params.mfx.MaxKbps = params.mfx.TargetKbps;
+  }
+
+  memset (&encoder->extreset, 0, sizeof (encoder->extreset));
+  encoder->extreset.Header.BufferId = MFX_EXTBUFF_ENCODER_RESET_OPTION;
+  encoder->extreset.Header.BufferSz = sizeof (encoder->extreset);
+  encoder->extreset.StartNewSequence =
+      new_sequence ? MFX_CODINGOPTION_ON : MFX_CODINGOPTION_OFF;
+
+  for (i = 0; i < encoder->nb_extparam_internal; i++)
+    encoder->extparam_reset[i] = encoder->extparam_internal[i];
+  encoder->extparam_reset[i++] = (mfxExtBuffer *) &encoder->extreset;
+  params.ExtParam = encoder->extparam_reset;
+  params.NumExtParam = i;
+
+  sts = MFXVideoENCODE_Reset (encoder->session, &params);
+  if (sts < 0) {
+    GST_ERROR ("Error resetting the MFX video encoder %d", sts);
+    return GST_MFX_ENCODER_STATUS_ERROR_INVALID_PARAMETER;
+  }
+  else if (MFX_WRN_INCOMPATIBLE_VIDEO_PARAM == sts) {
+    GST_WARNING ("Incompatible video params adjusted on reset %d", sts);
+  }
+
+  /* Keep the parameters that were applied, with the coding options of
+   * the running encoder, for the next reset */
+  encoder->params = params;
+  encoder->params.ExtParam = encoder->extparam_internal;
+  encoder->params.NumExtParam = encoder->nb_extparam_internal;
+
+  if (encoder->info.fps_n)
+    encoder->duration =
+        (encoder->info.fps_d / (gdouble)encoder->info.fps_n) * 1000000000;
+
+  GST_INFO ("Reset MFX encoder to %dx%d, %d/%d fps, %u kbps%s",
+      encoder->info.width, encoder->info.height,
+      encoder->info.fps_n, encoder->info.fps_d,
+      encoder->params.mfx.TargetKbps,
+      new_sequence ? ", new sequence" : "");
+
+  return GST_MFX_ENCODER_STATUS_SUCCESS;
+}
+
 static void
 calculate_new_pts_and_dts (GstMfxEncoder * encoder, GstVideoCodecFrame * frame)
 {
@@ -1034,14 +1338,59 @@ calculate_new_pts_and_dts (GstMfxEncoder * encoder, GstVideoCodecFrame * frame)
   frame->dts = (encoder->bs.DecodeTimeStamp / (gdouble) 90000) * 1000000000;
 }
 
+static void
+set_sync_point (GstMfxEncoder * encoder, GstVideoCodecFrame * frame)
+{
+  if (encoder->bs.FrameType & MFX_FRAMETYPE_IDR
+      || encoder->bs.FrameType & MFX_FRAMETYPE_xIDR)
+    GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (frame);
+  else
+    GST_VIDEO_CODEC_FRAME_UNSET_SYNC_POINT (frame);
+}
+
+#if MSDK_CHECK_VERSION(1,31)
+static void
+push_partial_output (GstMfxEncoder * encoder, GstVideoCodecFrame * frame)
+{
+  GstBuffer *buffer;
+  mfxU32 ready;
+
+  /* The latest slices are held back until more of them come, so that
+   * the frame buffer always ends the access unit with some slices */
+  ready = encoder->subframe_ready;
+  encoder->subframe_ready = encoder->bs.DataLength;
+
+  if (!encoder->subframe_func || encoder->subframe_stopped
+      || ready <= encoder->subframe_offset)
+    return;
+
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      encoder->bs.Data, encoder->bs.MaxLength,
+      encoder->bs.DataOffset + encoder->subframe_offset,
+      ready - encoder->subframe_offset, NULL, NULL);
+
+  calculate_new_pts_and_dts (encoder, frame);
+  set_sync_point (encoder, frame);
+
+  /* Once refused, the rest of the frame goes out with the frame buffer */
+  if (encoder->subframe_func (frame, buffer, encoder->subframe_data))
+    encoder->subframe_offset = ready;
+  else
+    encoder->subframe_stopped = TRUE;
+}
+#endif
+
 GstMfxEncoderStatus
 gst_mfx_encoder_encode (GstMfxEncoder * encoder, GstVideoCodecFrame * frame)
 {
   GstMfxSurface *surface, *filter_surface;
   GstMfxFilterStatus filter_sts;
   mfxFrameSurface1 *insurf;
+  mfxEncodeCtrl *ctrl = NULL;
   mfxSyncPoint syncp;
   mfxStatus sts = MFX_ERR_NONE;
+  GstClockTime latency;
+  gint64 start_time;
 
   surface = gst_video_codec_frame_get_user_data (frame);
 
@@ -1067,12 +1416,22 @@ gst_mfx_encoder_encode (GstMfxEncoder * encoder, GstVideoCodecFrame * frame)
       gst_util_uint64_scale (encoder->current_pts, 90000, GST_SECOND);
   encoder->current_pts += encoder->duration;
 
+  /* Encode this very frame as an IDR, without resetting the session */
+  if (GST_VIDEO_CODEC_FRAME_IS_FORCE_KEYFRAME (frame)
+      && encoder->codec != MFX_CODEC_JPEG) {
+    GST_DEBUG ("forcing key frame %u", frame->system_frame_number);
+    ctrl = &encoder->force_idr_ctrl;
+  }
+
   do {
+    start_time = g_get_monotonic_time ();
     sts = MFXVideoENCODE_EncodeFrameAsync (encoder->session,
-            NULL, insurf, &encoder->bs, &syncp);
+            ctrl, insurf, &encoder->bs, &syncp);
 
-    if (MFX_WRN_DEVICE_BUSY == sts)
+    if (MFX_WRN_DEVICE_BUSY == sts) {
+      encoder->surface_waits++;
       g_usleep (500);
+    }
     else if (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
       encoder->bs.MaxLength += 1024 * 16;
       encoder->bitstream = g_byte_array_set_size (encoder->bitstream,
@@ -1094,25 +1453,40 @@ gst_mfx_encoder_encode (GstMfxEncoder * encoder, GstVideoCodecFrame * frame)
   }
 
   if (syncp) {
+    encoder->subframe_offset = 0;
+    encoder->subframe_ready = 0;
+    encoder->subframe_stopped = FALSE;
+
     do {
       sts = MFXVideoCORE_SyncOperation (encoder->session, syncp, 1000);
+#if MSDK_CHECK_VERSION(1,31)
+      if (MFX_ERR_NONE_PARTIAL_OUTPUT == sts)
+        push_partial_output (encoder, frame);
+    } while (MFX_WRN_IN_EXECUTION == sts
+        || MFX_ERR_NONE_PARTIAL_OUTPUT == sts);
+#else
     } while (MFX_WRN_IN_EXECUTION == sts);
+#endif
 
+    latency = (g_get_monotonic_time () - start_time) * GST_USECOND;
+    if (GST_CLOCK_TIME_IS_VALID (encoder->device_latency))
+      encoder->device_latency = (3 * encoder->device_latency + latency) / 4;
+    else
+      encoder->device_latency = latency;
+
+    /* Only the slices not already output belong to the frame buffer */
     frame->output_buffer =
         gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
           encoder->bs.Data, encoder->bs.MaxLength,
-          encoder->bs.DataOffset, encoder->bs.DataLength, NULL, NULL);
+          encoder->bs.DataOffset + encoder->subframe_offset,
+          encoder->bs.DataLength - encoder->subframe_offset, NULL, NULL);
 
     calculate_new_pts_and_dts (encoder, frame);
 
     encoder->bs.DataLength = 0;
   }
 
-  if (encoder->bs.FrameType & MFX_FRAMETYPE_IDR
-      || encoder->bs.FrameType & MFX_FRAMETYPE_xIDR)
-    GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (frame);
-  else
-    GST_VIDEO_CODEC_FRAME_UNSET_SYNC_POINT (frame);
+  set_sync_point (encoder, frame);
 
   return GST_MFX_ENCODER_STATUS_SUCCESS;
 }
@@ -1160,11 +1534,7 @@ gst_mfx_encoder_flush (GstMfxEncoder * encoder, GstVideoCodecFrame ** frame)
     encoder->bs.DataLength = 0;
   }
 
-  if (encoder->bs.FrameType & MFX_FRAMETYPE_IDR
-      || encoder->bs.FrameType & MFX_FRAMETYPE_xIDR)
-    GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (*frame);
-  else
-    GST_VIDEO_CODEC_FRAME_UNSET_SYNC_POINT (*frame);
+  set_sync_point (encoder, *frame);
 
   return GST_MFX_ENCODER_STATUS_SUCCESS;
 }
@@ -1472,3 +1842,26 @@ gst_mfx_encoder_lookahead_ds_get_type (void)
   }
   return g_type;
 }
+
+GType
+gst_mfx_encoder_intra_refresh_get_type (void)
+{
+  static volatile gsize g_type = 0;
+
+  static const GEnumValue intra_refresh_values[] = {
+    {GST_MFX_ENCODER_INTRA_REFRESH_OFF,
+        "Disable intra refresh", "off"},
+    {GST_MFX_ENCODER_INTRA_REFRESH_VERTICAL,
+        "Refresh by vertical columns of macroblocks", "vertical"},
+    {GST_MFX_ENCODER_INTRA_REFRESH_HORIZONTAL,
+        "Refresh by horizontal rows of macroblocks", "horizontal"},
+    {0, NULL, NULL},
+  };
+
+  if (g_once_init_enter (&g_type)) {
+    GType type = g_enum_register_static ("GstMfxEncoderIntraRefresh",
+        intra_refresh_values);
+    g_once_init_leave (&g_type, type);
+  }
+  return g_type;
+}
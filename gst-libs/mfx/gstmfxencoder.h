@@ -86,6 +86,12 @@ typedef enum {
   GST_MFX_ENCODER_TRELLIS_IPB = MFX_TRELLIS_I|MFX_TRELLIS_P|MFX_TRELLIS_B,
 } GstMfxEncoderTrellis;
 
+typedef enum {
+  GST_MFX_ENCODER_INTRA_REFRESH_OFF = 0,
+  GST_MFX_ENCODER_INTRA_REFRESH_VERTICAL = 1,
+  GST_MFX_ENCODER_INTRA_REFRESH_HORIZONTAL = 2,
+} GstMfxEncoderIntraRefresh;
+
 typedef enum {
   GST_MFX_ENCODER_PRESET_VERY_SLOW = MFX_TARGETUSAGE_BEST_QUALITY,
   GST_MFX_ENCODER_PRESET_SLOWER = MFX_TARGETUSAGE_2,
@@ -134,6 +140,23 @@ typedef struct {
   GParamSpec *const pspec;
 } GstMfxEncoderPropInfo;
 
+/**
+ * GstMfxEncoderSubframeFunc:
+ * @frame: the #GstVideoCodecFrame being encoded
+ * @buffer: (transfer full): the slices of @frame completed so far
+ * @user_data: the data passed to gst_mfx_encoder_set_subframe_func ()
+ *
+ * Called from gst_mfx_encoder_encode () for each group of slices of
+ * @frame that is ready before the whole frame has been encoded. The
+ * last group is held back, so the output buffer of @frame always
+ * carries the end of the access unit.
+ *
+ * Return value: %TRUE if @buffer was consumed, %FALSE to stop partial
+ *   output for the rest of @frame.
+ */
+typedef gboolean (*GstMfxEncoderSubframeFunc) (GstVideoCodecFrame * frame,
+    GstBuffer * buffer, gpointer user_data);
+
 GType
 gst_mfx_encoder_preset_get_type (void);
 
@@ -143,6 +166,9 @@ gst_mfx_encoder_trellis_get_type (void);
 GType
 gst_mfx_encoder_lookahead_ds_get_type (void);
 
+GType
+gst_mfx_encoder_intra_refresh_get_type (void);
+
 GstMfxEncoder *
 gst_mfx_encoder_ref (GstMfxEncoder * encoder);
 
@@ -186,9 +212,31 @@ gst_mfx_encoder_set_qpb_offset (GstMfxEncoder * encoder, mfxU16 offset);
 gboolean
 gst_mfx_encoder_set_async_depth (GstMfxEncoder * encoder, mfxU16 async_depth);
 
+mfxU16
+gst_mfx_encoder_get_async_depth (GstMfxEncoder * encoder);
+
+GstClockTime
+gst_mfx_encoder_get_device_latency (GstMfxEncoder * encoder);
+
+guint
+gst_mfx_encoder_get_surface_waits (GstMfxEncoder * encoder);
+
+guint
+gst_mfx_encoder_get_gop_size (GstMfxEncoder * encoder);
+
+gboolean
+gst_mfx_encoder_set_subframe_func (GstMfxEncoder * encoder,
+    GstMfxEncoderSubframeFunc func, gpointer user_data);
+
 GstMfxEncoderStatus
 gst_mfx_encoder_start (GstMfxEncoder * encoder);
 
+GstMfxEncoderStatus
+gst_mfx_encoder_reset (GstMfxEncoder * encoder);
+
+gboolean
+gst_mfx_encoder_reset_starts_new_sequence (GstMfxEncoder * encoder);
+
 GstMfxEncoderStatus
 gst_mfx_encoder_encode (GstMfxEncoder * encoder, GstVideoCodecFrame * frame);
 
@@ -40,6 +40,9 @@ typedef struct _GstMfxEncoderH264 GstMfxEncoderH264;
  * @GST_MFX_ENCODER_H264_PROP_CABAC: Enable CABAC entropy coding mode (bool).
  * @GST_MFX_ENCODER_H264_PROP_TRELLIS:
  * @GST_MFX_ENCODER_H264_PROP_LOOKAHEAD_DS:
+ * @GST_MFX_ENCODER_H264_PROP_INTRA_REFRESH: Rolling intra refresh mode.
+ * @GST_MFX_ENCODER_H264_PROP_INTRA_REFRESH_CYCLE: Intra refresh cycle (uint).
+ * @GST_MFX_ENCODER_H264_PROP_INTRA_REFRESH_QP_DELTA: Intra refresh QP delta.
  *
  * The set of H.264 encoder specific configurable properties.
  */
@@ -49,6 +52,9 @@ typedef enum {
   GST_MFX_ENCODER_H264_PROP_CABAC = -3,
   GST_MFX_ENCODER_H264_PROP_TRELLIS = -5,
   GST_MFX_ENCODER_H264_PROP_LOOKAHEAD_DS = -6,
+  GST_MFX_ENCODER_H264_PROP_INTRA_REFRESH = -7,
+  GST_MFX_ENCODER_H264_PROP_INTRA_REFRESH_CYCLE = -8,
+  GST_MFX_ENCODER_H264_PROP_INTRA_REFRESH_QP_DELTA = -9,
 } GstMfxEncoderH264Prop;
 
 GstMfxEncoder *
@@ -106,6 +106,11 @@ gst_mfx_encoder_h265_reconfigure (GstMfxEncoder * base_encoder)
   GST_DEBUG ("resolution: %dx%d", GST_MFX_ENCODER_WIDTH (encoder),
       GST_MFX_ENCODER_HEIGHT (encoder));
 
+  /* P010 input is encoded as is, see gst_mfx_encoder_set_frame_info() */
+  base_encoder->profile =
+      MFX_FOURCC_P010 == base_encoder->params.mfx.FrameInfo.FourCC ?
+      MFX_PROFILE_HEVC_MAIN10 : MFX_PROFILE_UNKNOWN;
+
   /* Ensure bitrate if not set */
   ensure_bitrate (encoder);
 
@@ -333,6 +338,15 @@ gst_mfx_encoder_h265_set_property (GstMfxEncoder * base_encoder,
     case GST_MFX_ENCODER_H265_PROP_LOOKAHEAD_DS:
       base_encoder->look_ahead_downsampling = g_value_get_enum (value);
       break;
+    case GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH:
+      base_encoder->intra_refresh = g_value_get_enum (value);
+      break;
+    case GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH_CYCLE:
+      base_encoder->intra_refresh_cycle_size = g_value_get_uint (value);
+      break;
+    case GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH_QP_DELTA:
+      base_encoder->intra_refresh_qp_delta = g_value_get_int (value);
+      break;
     default:
       return GST_MFX_ENCODER_STATUS_ERROR_INVALID_PARAMETER;
   }
@@ -406,5 +420,47 @@ gst_mfx_encoder_h265_get_default_properties (void)
           GST_MFX_ENCODER_LOOKAHEAD_DS_AUTO,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMfxEncoderH265:intra-refresh
+   *
+   * Rolling intra refresh mode. Instead of periodic key frames, a
+   * column or row of intra coded blocks sweeps across consecutive
+   * frames, keeping the encoded frame sizes steady for low-latency
+   * streaming.
+   */
+  GST_MFX_ENCODER_PROPERTIES_APPEND (props,
+      GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH,
+      g_param_spec_enum ("intra-refresh",
+          "Intra refresh",
+          "Rolling intra refresh mode",
+          gst_mfx_encoder_intra_refresh_get_type (),
+          GST_MFX_ENCODER_INTRA_REFRESH_OFF,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMfxEncoderH265:intra-refresh-cycle
+   *
+   * Number of frames over which the whole picture is refreshed
+   * (0: one second worth of frames).
+   */
+  GST_MFX_ENCODER_PROPERTIES_APPEND (props,
+      GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH_CYCLE,
+      g_param_spec_uint ("intra-refresh-cycle",
+          "Intra refresh cycle",
+          "Number of frames in an intra refresh cycle (0: auto)",
+          0, G_MAXUINT16, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMfxEncoderH265:intra-refresh-qp-delta
+   *
+   * QP delta applied to the intra refreshed blocks.
+   */
+  GST_MFX_ENCODER_PROPERTIES_APPEND (props,
+      GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH_QP_DELTA,
+      g_param_spec_int ("intra-refresh-qp-delta",
+          "Intra refresh QP delta",
+          "QP delta for intra refreshed blocks",
+          -51, 51, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   return props;
 }
@@ -34,12 +34,18 @@ typedef struct _GstMfxEncoderH265 GstMfxEncoderH265;
  * GstMfxEncoderH265Prop:
  * @GST_MFX_ENCODER_H265_PROP_LA_DEPTH:
  * @GST_MFX_ENCODER_H265_PROP_LOOKAHEAD_DS:
+ * @GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH: Rolling intra refresh mode.
+ * @GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH_CYCLE: Intra refresh cycle (uint).
+ * @GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH_QP_DELTA: Intra refresh QP delta.
  *
  * The set of H.265 encoder specific configurable properties.
  */
 typedef enum {
   GST_MFX_ENCODER_H265_PROP_LA_DEPTH = -1,
   GST_MFX_ENCODER_H265_PROP_LOOKAHEAD_DS = -2,
+  GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH = -3,
+  GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH_CYCLE = -4,
+  GST_MFX_ENCODER_H265_PROP_INTRA_REFRESH_QP_DELTA = -5,
 } GstMfxEncoderH265Prop;
 
 GstMfxEncoder *
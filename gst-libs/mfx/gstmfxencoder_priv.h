@@ -163,6 +163,9 @@ struct _GstMfxEncoder
   mfxVideoParam           params;
   mfxFrameInfo            frame_info;
   mfxBitstream            bs;
+  mfxEncodeCtrl           force_idr_ctrl;
+  mfxExtEncoderResetOption extreset;
+  gboolean                initialized;
   mfxU32                  codec;
   gchar                  *plugin_uid;
   GstVideoInfo            info;
@@ -170,6 +173,18 @@ struct _GstMfxEncoder
   GstClockTime            current_pts;
   GstClockTime            duration;
 
+  /* Smoothed submit-to-sync time of a frame, and the number of times
+   * the device held a frame back */
+  GstClockTime            device_latency;
+  guint                   surface_waits;
+
+  /* Slice-level output of the frame being synced */
+  GstMfxEncoderSubframeFunc subframe_func;
+  gpointer                subframe_data;
+  mfxU32                  subframe_offset;
+  mfxU32                  subframe_ready;
+  gboolean                subframe_stopped;
+
   /* Encoder params */
   GstMfxEncoderPreset     preset;
   GstMfxRateControl       rc_method;
@@ -195,8 +210,13 @@ struct _GstMfxEncoder
   mfxExtCodingOption      extco;
   mfxExtCodingOption2     extco2;
   mfxExtHEVCParam         exthevc;
-  mfxExtBuffer           *extparam_internal[3];
+#if MSDK_CHECK_VERSION(1,31)
+  mfxExtPartialBitstreamParam extpartial;
+#endif
+  mfxExtBuffer           *extparam_internal[4];
   int                     nb_extparam_internal;
+  /* Coding options followed by the reset option, for encoder resets */
+  mfxExtBuffer           *extparam_reset[5];
 
   /* H264 specific coding options */
   gboolean                use_cabac;
@@ -210,6 +230,11 @@ struct _GstMfxEncoder
 
   mfxU16                  look_ahead_downsampling;
   mfxU16                  trellis;
+
+  /* H264 / H265 rolling intra refresh */
+  GstMfxEncoderIntraRefresh intra_refresh;
+  mfxU16                  intra_refresh_cycle_size;
+  mfxI16                  intra_refresh_qp_delta;
 };
 
 struct _GstMfxEncoderClassData
@@ -140,8 +140,10 @@ gst_mfx_filter_set_frame_info_from_gst_video_info (GstMfxFilter * filter,
   filter->frame_info.FrameRateExtD = info->fps_d;
   filter->frame_info.AspectRatioW = info->par_n;
   filter->frame_info.AspectRatioH = info->par_d;
-  filter->frame_info.BitDepthChroma = 8;
-  filter->frame_info.BitDepthLuma = 8;
+  filter->frame_info.BitDepthChroma = filter->frame_info.BitDepthLuma =
+      gst_mfx_video_format_get_bit_depth (filter->frame_info.FourCC);
+  filter->frame_info.Shift =
+      gst_mfx_video_format_get_shift (filter->frame_info.FourCC);
 
   filter->frame_info.Width = GST_ROUND_UP_16 (info->width);
   filter->frame_info.Height =
@@ -255,8 +257,14 @@ init_params (GstMfxFilter * filter)
   }
   filter->params.vpp.Out = filter->frame_info;
 
-  if (filter->fourcc)
+  if (filter->fourcc) {
     filter->params.vpp.Out.FourCC = filter->fourcc;
+    filter->params.vpp.Out.BitDepthChroma =
+        filter->params.vpp.Out.BitDepthLuma =
+        gst_mfx_video_format_get_bit_depth (filter->fourcc);
+    filter->params.vpp.Out.Shift =
+        gst_mfx_video_format_get_shift (filter->fourcc);
+  }
 
   if (filter->width) {
     filter->params.vpp.Out.CropW = filter->width;
@@ -551,7 +559,8 @@ gst_mfx_filter_set_format (GstMfxFilter * filter, mfxU32 fourcc)
 {
   g_return_val_if_fail (filter != NULL, FALSE);
 
-  if (MFX_FOURCC_NV12 == fourcc || MFX_FOURCC_RGB4 == fourcc)
+  if (MFX_FOURCC_NV12 == fourcc || MFX_FOURCC_RGB4 == fourcc
+      || MFX_FOURCC_P010 == fourcc)
     filter->fourcc = fourcc;
   else
     return FALSE;
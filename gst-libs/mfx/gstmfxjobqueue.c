@@ -0,0 +1,100 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "sysdeps.h"
+#include "gstmfxjobqueue.h"
+
+void
+gst_mfx_job_queue_init (GstMfxJobQueue * queue)
+{
+  g_return_if_fail (queue != NULL);
+
+  g_queue_init (&queue->jobs);
+  g_mutex_init (&queue->lock);
+  g_cond_init (&queue->cond);
+}
+
+void
+gst_mfx_job_queue_clear (GstMfxJobQueue * queue)
+{
+  g_return_if_fail (queue != NULL);
+  g_return_if_fail (g_queue_is_empty (&queue->jobs));
+
+  g_mutex_clear (&queue->lock);
+  g_cond_clear (&queue->cond);
+}
+
+/* Appends @job, before it is handed to a worker */
+void
+gst_mfx_job_queue_push (GstMfxJobQueue * queue, GstMfxJob * job)
+{
+  g_return_if_fail (queue != NULL);
+  g_return_if_fail (job != NULL);
+
+  job->done = FALSE;
+
+  g_mutex_lock (&queue->lock);
+  g_queue_push_tail (&queue->jobs, job);
+  g_mutex_unlock (&queue->lock);
+}
+
+/* Called by the worker once it no longer touches @job. Whatever the
+ * worker stored in the job is visible to the thread that pops it */
+void
+gst_mfx_job_queue_complete (GstMfxJobQueue * queue, GstMfxJob * job)
+{
+  g_return_if_fail (queue != NULL);
+  g_return_if_fail (job != NULL);
+
+  g_mutex_lock (&queue->lock);
+  job->done = TRUE;
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->lock);
+}
+
+/**
+ * gst_mfx_job_queue_pop:
+ * @queue: a #GstMfxJobQueue
+ * @max_pending: the number of jobs that may be left in flight
+ *
+ * Removes the oldest job of @queue once it is complete. While more
+ * than @max_pending jobs are queued, this waits for the oldest one, so
+ * %0 waits for every job and %G_MAXUINT never blocks.
+ *
+ * Returns: the oldest job if it is complete, %NULL otherwise
+ */
+GstMfxJob *
+gst_mfx_job_queue_pop (GstMfxJobQueue * queue, guint max_pending)
+{
+  GstMfxJob *job;
+
+  g_return_val_if_fail (queue != NULL, NULL);
+
+  g_mutex_lock (&queue->lock);
+  while ((job = g_queue_peek_head (&queue->jobs)) && !job->done
+      && g_queue_get_length (&queue->jobs) > max_pending)
+    g_cond_wait (&queue->cond, &queue->lock);
+  if (job && job->done)
+    g_queue_pop_head (&queue->jobs);
+  else
+    job = NULL;
+  g_mutex_unlock (&queue->lock);
+
+  return job;
+}
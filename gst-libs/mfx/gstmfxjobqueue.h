@@ -0,0 +1,65 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef GST_MFX_JOB_QUEUE_H
+#define GST_MFX_JOB_QUEUE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstMfxJob GstMfxJob;
+typedef struct _GstMfxJobQueue GstMfxJobQueue;
+
+/* Header of a job run by a worker thread, to be embedded as the first
+ * member of the caller's own job structure */
+struct _GstMfxJob
+{
+  /*< private > */
+  gboolean done;
+};
+
+/* Jobs in submission order. Workers complete them in any order, while
+ * they are handed back to the streaming thread in submission order */
+struct _GstMfxJobQueue
+{
+  /*< private > */
+  GQueue jobs;
+  GMutex lock;
+  GCond cond;
+};
+
+void
+gst_mfx_job_queue_init (GstMfxJobQueue * queue);
+
+void
+gst_mfx_job_queue_clear (GstMfxJobQueue * queue);
+
+void
+gst_mfx_job_queue_push (GstMfxJobQueue * queue, GstMfxJob * job);
+
+void
+gst_mfx_job_queue_complete (GstMfxJobQueue * queue, GstMfxJob * job);
+
+GstMfxJob *
+gst_mfx_job_queue_pop (GstMfxJobQueue * queue, guint max_pending);
+
+G_END_DECLS
+
+#endif /* GST_MFX_JOB_QUEUE_H */
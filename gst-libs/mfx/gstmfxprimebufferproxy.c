@@ -92,18 +92,19 @@ gst_mfx_prime_buffer_proxy_acquire_handle (GstMfxPrimeBufferProxy * proxy)
   vaapi_image_get_image (proxy->image, &va_img);
 
   if (vpg_load_symbol ("vpgExtGetSurfaceHandle")) {
-    GST_MFX_DISPLAY_LOCK (proxy->display);
+    GST_MFX_DISPLAY_VA_LOCK_EXCLUSIVE (proxy->display);
     va_status = g_va_get_surface_handle (GST_MFX_DISPLAY_VADISPLAY (proxy->display),
         &surf, (int *) &proxy->fd);
-    GST_MFX_DISPLAY_UNLOCK (proxy->display);
+    GST_MFX_DISPLAY_VA_UNLOCK_EXCLUSIVE (proxy->display);
     if (!vaapi_check_status (va_status, "vpgExtGetSurfaceHandle ()"))
       return FALSE;
   } else {
     proxy->buf_info.mem_type = VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME;
-    GST_MFX_DISPLAY_LOCK (proxy->display);
+    /* Buffer handle exports are not thread-safe */
+    GST_MFX_DISPLAY_VA_LOCK_EXCLUSIVE (proxy->display);
     va_status = vaAcquireBufferHandle (GST_MFX_DISPLAY_VADISPLAY (proxy->display),
         va_img.buf, &proxy->buf_info);
-    GST_MFX_DISPLAY_UNLOCK (proxy->display);
+    GST_MFX_DISPLAY_VA_UNLOCK_EXCLUSIVE (proxy->display);
     if (!vaapi_check_status (va_status, "vaAcquireBufferHandle ()"))
       return FALSE;
     proxy->fd = proxy->buf_info.handle;
@@ -125,9 +126,9 @@ gst_mfx_prime_buffer_proxy_finalize (GstMfxPrimeBufferProxy * proxy)
 
     vaapi_image_get_image (proxy->image, &va_img);
 
-    GST_MFX_DISPLAY_LOCK (proxy->display);
+    GST_MFX_DISPLAY_VA_LOCK_EXCLUSIVE (proxy->display);
     vaReleaseBufferHandle (GST_MFX_DISPLAY_VADISPLAY (proxy->display), va_img.buf);
-    GST_MFX_DISPLAY_UNLOCK (proxy->display);
+    GST_MFX_DISPLAY_VA_UNLOCK_EXCLUSIVE (proxy->display);
   }
 
   vaapi_image_replace (&proxy->image, NULL);
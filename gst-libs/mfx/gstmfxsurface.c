@@ -20,6 +20,7 @@
 
 #include "gstmfxsurface.h"
 #include "gstmfxsurface_priv.h"
+#include "gstmfxarena.h"
 #include "gstmfxsurfacepool.h"
 #include "gstmfxtask.h"
 #include "gstmfxdisplay.h"
@@ -37,10 +38,7 @@ gst_mfx_surface_allocate_default (GstMfxSurface * surface, GstMfxTask * task)
 {
   mfxFrameData *ptr = &surface->surface.Data;
   mfxFrameInfo *info = &surface->surface.Info;
-  guint frame_size, offset = 0;
-  gboolean success = TRUE;
-
-  frame_size = info->Width * info->Height;
+  guint pitch, frame_size = 0, offset = 0;
 
 #ifdef WITH_MSS_2016
   /* This offset value is required for Haswell when using MFX surfaces in
@@ -48,25 +46,54 @@ gst_mfx_surface_allocate_default (GstMfxSurface * surface, GstMfxTask * task)
   offset = 1;
 #endif
 
+  /* Pitches are kept a multiple of the arena alignment so that every
+   * plane starts aligned, YV12 halving it for its chroma planes */
   switch (info->FourCC) {
   case MFX_FOURCC_NV12:
+    pitch = GST_ROUND_UP_N (info->Width, GST_MFX_ARENA_ALIGNMENT);
+    frame_size = pitch * info->Height;
+    surface->data_size = frame_size * 3 / 2 + offset;
+    break;
+  case MFX_FOURCC_YV12:
+    pitch = GST_ROUND_UP_N (info->Width, 2 * GST_MFX_ARENA_ALIGNMENT);
+    frame_size = pitch * info->Height;
     surface->data_size = frame_size * 3 / 2;
-    surface->data = g_slice_alloc(surface->data_size + offset);
-    if (!surface->data)
-      goto error;
-    ptr->Pitch = surface->pitches[0] = surface->pitches[1] = info->Width;
+    break;
+  case MFX_FOURCC_YUY2:
+    pitch = GST_ROUND_UP_N (info->Width * 2, GST_MFX_ARENA_ALIGNMENT);
+    surface->data_size = pitch * info->Height + offset;
+    break;
+  case MFX_FOURCC_UYVY:
+    pitch = GST_ROUND_UP_N (info->Width * 2, GST_MFX_ARENA_ALIGNMENT);
+    surface->data_size = pitch * info->Height;
+    break;
+  case MFX_FOURCC_RGB4:
+    pitch = GST_ROUND_UP_N (info->Width * 4, GST_MFX_ARENA_ALIGNMENT);
+    surface->data_size = pitch * info->Height + offset;
+    break;
+  case MFX_FOURCC_P010:
+    pitch = GST_ROUND_UP_N (info->Width * 2, GST_MFX_ARENA_ALIGNMENT);
+    frame_size = pitch * info->Height;
+    surface->data_size = frame_size * 3 / 2 + offset;
+    break;
+  default:
+    goto error;
+  }
 
+  surface->data = gst_mfx_arena_alloc (surface->data_size);
+  if (!surface->data)
+    goto error;
+  ptr->Pitch = surface->pitches[0] = pitch;
+
+  switch (info->FourCC) {
+  case MFX_FOURCC_NV12:
+    surface->pitches[1] = pitch;
     surface->planes[0] = ptr->Y = surface->data + offset;
     surface->planes[1] = ptr->UV = ptr->Y + frame_size;
 
     break;
   case MFX_FOURCC_YV12:
-    surface->data_size = frame_size * 3 / 2;
-    surface->data = g_slice_alloc(surface->data_size);
-    if (!surface->data)
-      goto error;
-    ptr->Pitch = surface->pitches[0] = info->Width;
-    surface->pitches[1] = surface->pitches[2] = ptr->Pitch / 2;
+    surface->pitches[1] = surface->pitches[2] = pitch / 2;
 
     surface->planes[0] = ptr->Y = surface->data;
     if (surface->format == GST_VIDEO_FORMAT_I420) {
@@ -80,36 +107,18 @@ gst_mfx_surface_allocate_default (GstMfxSurface * surface, GstMfxTask * task)
 
     break;
   case MFX_FOURCC_YUY2:
-    surface->data_size = frame_size * 2;
-    surface->data = g_slice_alloc(surface->data_size + offset);
-    if (!surface->data)
-      goto error;
-    ptr->Pitch = surface->pitches[0] = info->Width * 2;
-
     surface->planes[0] = ptr->Y = surface->data + offset;
     ptr->U = ptr->Y + 1;
     ptr->V = ptr->Y + 3;
 
     break;
   case MFX_FOURCC_UYVY:
-    surface->data_size = frame_size * 2;
-    surface->data = g_slice_alloc(surface->data_size);
-    if (!surface->data)
-      goto error;
-    ptr->Pitch = surface->pitches[0] = info->Width * 2;
-
     surface->planes[0] = ptr->U = surface->data;
     ptr->Y = ptr->U + 1;
     ptr->V = ptr->U + 2;
 
     break;
   case MFX_FOURCC_RGB4:
-    surface->data_size = frame_size * 4;
-    surface->data = g_slice_alloc(surface->data_size + offset);
-    if (!surface->data)
-      goto error;
-    ptr->Pitch = surface->pitches[0] = info->Width * 4;
-
     surface->planes[0] = ptr->B = surface->data + offset;
     ptr->G = ptr->B + 1;
     ptr->R = ptr->B + 2;
@@ -117,25 +126,20 @@ gst_mfx_surface_allocate_default (GstMfxSurface * surface, GstMfxTask * task)
 
     break;
   case MFX_FOURCC_P010:
-    surface->data_size = frame_size * 3;
-    surface->data = g_slice_alloc(surface->data_size + offset);
-    if (!surface->data)
-      goto error;
-    ptr->Pitch = surface->pitches[0] = surface->pitches[1] = info->Width * 2;
-
+    surface->pitches[1] = pitch;
     surface->planes[0] = ptr->Y = surface->data + offset;
-    surface->planes[1] = ptr->UV = ptr->Y + frame_size * 2;
+    surface->planes[1] = ptr->UV = ptr->Y + frame_size;
 
     break;
-  default:
-error:
-      GST_ERROR("Failed to create surface.");
-      success = FALSE;
-      break;
   }
 
   surface->has_video_memory = FALSE;
-  return success;
+  return TRUE;
+
+error:
+  GST_ERROR("Failed to create surface.");
+  surface->has_video_memory = FALSE;
+  return FALSE;
 }
 
 static void
@@ -146,7 +150,7 @@ gst_mfx_surface_release_default (GstMfxSurface * surface)
   if (NULL != ptr) {
     ptr->Pitch = 0;
     if (surface->data)
-      g_slice_free1(surface->data_size, surface->data);
+      gst_mfx_arena_free(surface->data, surface->data_size);
     ptr->Y = NULL;
     ptr->U = NULL;
     ptr->V = NULL;
@@ -172,6 +176,11 @@ gst_mfx_surface_derive_mfx_frame_info(GstMfxSurface * surface,
     case GST_VIDEO_FORMAT_NV12:
     case GST_VIDEO_FORMAT_YV12:
     case GST_VIDEO_FORMAT_I420:
+#if GST_CHECK_VERSION(1,10,0)
+    case GST_VIDEO_FORMAT_P010_10LE:
+    case GST_VIDEO_FORMAT_I420_10LE:
+    case GST_VIDEO_FORMAT_v210:
+#endif
       frame_info->ChromaFormat = MFX_CHROMAFORMAT_YUV420;
       break;
     case GST_VIDEO_FORMAT_YUY2:
@@ -195,8 +204,9 @@ gst_mfx_surface_derive_mfx_frame_info(GstMfxSurface * surface,
   frame_info->FrameRateExtD = info->fps_d;
   frame_info->AspectRatioW = info->par_n;
   frame_info->AspectRatioH = info->par_d;
-  frame_info->BitDepthChroma = 8;
-  frame_info->BitDepthLuma = 8;
+  frame_info->BitDepthChroma = frame_info->BitDepthLuma =
+    gst_mfx_video_format_get_bit_depth(frame_info->FourCC);
+  frame_info->Shift = gst_mfx_video_format_get_shift(frame_info->FourCC);
 
   frame_info->Width = GST_ROUND_UP_16(info->width);
   frame_info->Height =
@@ -240,9 +250,10 @@ gst_mfx_surface_init_properties(GstMfxSurface * surface)
 #endif
 
   surface->queued = 0;
+  surface->shared = 0;
 }
 
-static gboolean
+gboolean
 gst_mfx_surface_create(GstMfxSurface * surface, const GstVideoInfo * info,
     GstMfxTask * task)
 {
@@ -376,6 +387,10 @@ gst_mfx_surface_copy(GstMfxSurface * surface)
   copy->gem_bo_handle = -1;
   copy->is_gem_linear = FALSE;
 
+  /* Both now point to the same video memory */
+  g_atomic_int_set(&copy->shared, 1);
+  g_atomic_int_set(&surface->shared, 1);
+
   return copy;
 }
 
@@ -523,6 +538,14 @@ gst_mfx_surface_is_queued(GstMfxSurface * surface)
   return g_atomic_int_get(&surface->queued)? TRUE : FALSE;
 }
 
+gboolean
+gst_mfx_surface_is_shared(GstMfxSurface * surface)
+{
+  g_return_val_if_fail(surface != NULL, FALSE);
+
+  return g_atomic_int_get(&surface->shared)? TRUE : FALSE;
+}
+
 void
 gst_mfx_surface_queue(GstMfxSurface * surface)
 {
@@ -533,6 +556,38 @@ gst_mfx_surface_queue(GstMfxSurface * surface)
 void
 gst_mfx_surface_dequeue(GstMfxSurface * surface)
 {
-  if (surface)
+  GstMfxWaitQueue *queue;
+
+  if (!surface)
+    return;
+
+  queue = gst_mfx_surface_get_wait_queue(surface);
+  if (queue)
+    gst_mfx_wait_queue_clear_flag(queue, &surface->queued);
+  else
     g_atomic_int_set(&surface->queued, 0);
 }
+
+gboolean
+gst_mfx_surface_wait_dequeued(GstMfxSurface * surface, gint64 end_time,
+    volatile gint * cancel)
+{
+  GstMfxWaitQueue *queue;
+
+  g_return_val_if_fail(surface != NULL, TRUE);
+
+  /* Nothing signals surfaces without a session, don't block on them */
+  queue = gst_mfx_surface_get_wait_queue(surface);
+  if (!queue)
+    return !g_atomic_int_get(&surface->queued);
+
+  return gst_mfx_wait_queue_wait(queue, &surface->queued, end_time, cancel);
+}
+
+GstMfxWaitQueue *
+gst_mfx_surface_get_wait_queue(GstMfxSurface * surface)
+{
+  g_return_val_if_fail(surface != NULL, NULL);
+
+  return surface->task ? gst_mfx_task_get_wait_queue(surface->task) : NULL;
+}
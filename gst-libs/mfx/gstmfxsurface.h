@@ -116,12 +116,29 @@ gst_mfx_surface_unmap (GstMfxSurface * surface);
 gboolean
 gst_mfx_surface_is_queued(GstMfxSurface * surface);
 
+/* Returns %TRUE if @surface was soft-copied with gst_mfx_surface_copy()
+ * or is such a copy, i.e. its contents may be visible elsewhere */
+gboolean
+gst_mfx_surface_is_shared(GstMfxSurface * surface);
+
 void
 gst_mfx_surface_queue(GstMfxSurface * surface);
 
 void
 gst_mfx_surface_dequeue(GstMfxSurface * surface);
 
+/* Blocks until @surface is dequeued, @end_time (monotonic) is reached
+ * or @cancel is set. Returns %TRUE if the surface was dequeued */
+gboolean
+gst_mfx_surface_wait_dequeued(GstMfxSurface * surface, gint64 end_time,
+    volatile gint * cancel);
+
+/* Returns the wait queue that gst_mfx_surface_wait_dequeued() sleeps on,
+ * shared by the surfaces of a session, or %NULL without a session. Wake
+ * it up with gst_mfx_wait_queue_wake() after setting the cancel flag */
+GstMfxWaitQueue *
+gst_mfx_surface_get_wait_queue(GstMfxSurface * surface);
+
 G_END_DECLS
 
 #endif /* GST_MFX_SURFACE_H */
@@ -61,6 +61,7 @@ struct _GstMfxSurface
   mfxExtVPPVideoSignalInfo siginfo;
   mfxExtBuffer **ext_buf;
   guint queued;
+  gint shared;
 
   gint gem_bo_handle;
   gboolean is_gem_linear;
@@ -86,6 +87,10 @@ gst_mfx_surface_new_internal(const GstMfxSurfaceClass * klass,
     GstMfxDisplay * display, const GstVideoInfo * info, GstMfxTask * task,
     gboolean is_linear);
 
+gboolean
+gst_mfx_surface_create(GstMfxSurface * surface, const GstVideoInfo * info,
+    GstMfxTask * task);
+
 #define gst_mfx_surface_ref_internal(surface) \
   ((gpointer)gst_mfx_mini_object_ref(GST_MFX_MINI_OBJECT(surface)))
 
@@ -42,6 +42,11 @@ struct _GstMfxSurfaceVaapi
   GstMfxSurface parent_instance;
 
   VaapiImage *image;
+
+  /* Upstream memory wrapped by the VA surface, if any */
+  guint external_mem_type;
+  unsigned long external_buffer;
+  VASurfaceAttribExternalBuffers external;
 };
 
 struct _GstMfxSurfaceVaapiClass
@@ -63,6 +68,49 @@ gst_mfx_surface_vaapi_from_task(GstMfxSurface * surface,
   return TRUE;
 }
 
+static gboolean
+gst_mfx_surface_vaapi_import_external(GstMfxSurface * surface)
+{
+  GstMfxSurfaceVaapi *vaapi_surface = GST_MFX_SURFACE_VAAPI(surface);
+  mfxFrameInfo *frame_info = &surface->surface.Info;
+  VASurfaceAttribExternalBuffers *external = &vaapi_surface->external;
+  VASurfaceAttrib attribs[2];
+  VAStatus sts;
+
+  external->pixel_format =
+      gst_mfx_video_format_to_va_fourcc(frame_info->FourCC);
+  external->width = frame_info->Width;
+  external->height = frame_info->Height;
+  external->num_buffers = 1;
+  external->buffers = &vaapi_surface->external_buffer;
+
+  memset (&attribs, 0, sizeof(attribs));
+  attribs[0].flags = VA_SURFACE_ATTRIB_SETTABLE;
+  attribs[0].type = VASurfaceAttribMemoryType;
+  attribs[0].value.type = VAGenericValueTypeInteger;
+  attribs[0].value.value.i = vaapi_surface->external_mem_type;
+
+  attribs[1].flags = VA_SURFACE_ATTRIB_SETTABLE;
+  attribs[1].type = VASurfaceAttribExternalBufferDescriptor;
+  attribs[1].value.type = VAGenericValueTypePointer;
+  attribs[1].value.value.p = external;
+
+  GST_MFX_DISPLAY_VA_LOCK(surface->display);
+  sts = vaCreateSurfaces(GST_MFX_DISPLAY_VADISPLAY(surface->display),
+      gst_mfx_video_format_to_va_format(frame_info->FourCC),
+      frame_info->Width, frame_info->Height,
+      (VASurfaceID *) &surface->surface_id, 1, attribs, 2);
+  GST_MFX_DISPLAY_VA_UNLOCK(surface->display);
+  if (!vaapi_check_status(sts, "vaCreateSurfaces ()"))
+    return FALSE;
+
+  surface->mem_id.mid = &surface->surface_id;
+  surface->mem_id.info = frame_info;
+  surface->surface.Data.MemId = &surface->mem_id;
+
+  return TRUE;
+}
+
 static gboolean
 gst_mfx_surface_vaapi_allocate(GstMfxSurface * surface, GstMfxTask * task)
 {
@@ -72,6 +120,9 @@ gst_mfx_surface_vaapi_allocate(GstMfxSurface * surface, GstMfxTask * task)
     surface->display = gst_mfx_task_get_display (task);
     return gst_mfx_surface_vaapi_from_task(surface, task);
   }
+  else if (GST_MFX_SURFACE_VAAPI(surface)->external_mem_type) {
+    return gst_mfx_surface_vaapi_import_external(surface);
+  }
   else {
     mfxFrameInfo *frame_info = &surface->surface.Info;
     guint fourcc = gst_mfx_video_format_to_va_fourcc(frame_info->FourCC);
@@ -141,12 +192,14 @@ gst_mfx_surface_vaapi_allocate(GstMfxSurface * surface, GstMfxTask * task)
       attribs[1].value.type = VAGenericValueTypePointer;
       attribs[1].value.value.p = &external;
 
-      GST_MFX_DISPLAY_LOCK(surface->display);
+      /* PRIME imports go through the GEM handle table of the driver,
+       * which libva doesn't serialize */
+      GST_MFX_DISPLAY_VA_LOCK_EXCLUSIVE(surface->display);
       sts = vaCreateSurfaces(GST_MFX_DISPLAY_VADISPLAY(surface->display),
        gst_mfx_video_format_to_va_format(frame_info->FourCC),
        frame_info->Width, frame_info->Height,
        (VASurfaceID *) &surface->surface_id, 1, attribs, 2);
-      GST_MFX_DISPLAY_UNLOCK(surface->display);
+      GST_MFX_DISPLAY_VA_UNLOCK_EXCLUSIVE(surface->display);
       if (!vaapi_check_status(sts, "vaCreateSurfaces ()"))
         goto done;
 
@@ -163,12 +216,12 @@ gst_mfx_surface_vaapi_allocate(GstMfxSurface * surface, GstMfxTask * task)
       attrib.value.type = VAGenericValueTypeInteger;
       attrib.value.value.i = fourcc;
 
-      GST_MFX_DISPLAY_LOCK(surface->display);
+      GST_MFX_DISPLAY_VA_LOCK(surface->display);
       sts = vaCreateSurfaces(GST_MFX_DISPLAY_VADISPLAY(surface->display),
         gst_mfx_video_format_to_va_format(frame_info->FourCC),
         frame_info->Width, frame_info->Height,
         (VASurfaceID *) &surface->surface_id, 1, &attrib, 1);
-      GST_MFX_DISPLAY_UNLOCK(surface->display);
+      GST_MFX_DISPLAY_VA_UNLOCK(surface->display);
       if (!vaapi_check_status(sts, "vaCreateSurfaces ()"))
         return FALSE;
 
@@ -194,22 +247,23 @@ static void
 gst_mfx_surface_vaapi_release(GstMfxSurface * surface)
 {
   VAStatus status;
+  /* Imported surfaces release their GEM handle, like PRIME imports */
+  const gboolean exclusive = surface->bo != NULL;
+
   /* Don't destroy the underlying VASurface if originally from the task allocator*/
   if (!surface->task) {
-    GST_MFX_DISPLAY_LOCK(surface->display);
+    gst_mfx_display_va_lock(surface->display, exclusive);
     status = vaDestroySurfaces(GST_MFX_DISPLAY_VADISPLAY(surface->display),
         (VASurfaceID *) &surface->surface_id, 1);
-    if (!vaapi_check_status(status, "vaDestroySurfaces ()")) {
-      GST_MFX_DISPLAY_UNLOCK(surface->display);
+    gst_mfx_display_va_unlock(surface->display, exclusive);
+    if (!vaapi_check_status(status, "vaDestroySurfaces ()"))
       return;
-    }
 
     if (surface->bo) {
       drm_intel_bo_unreference(surface->bo);
       if (surface->gem_bo_handle > -1)
         close(surface->gem_bo_handle);
     }
-    GST_MFX_DISPLAY_UNLOCK(surface->display);
   }
 }
 
@@ -230,6 +284,9 @@ gst_mfx_surface_vaapi_map(GstMfxSurface * surface)
     goto done;
   }
 
+  /* The derived image is kept until unmap so that the planes stay valid
+   * and CPU writes to them land in the surface */
+
   num_planes = vaapi_image_get_plane_count(vaapi_surface->image);
   for (i = 0; i < num_planes; i++) {
     surface->planes[i] = vaapi_image_get_plane(vaapi_surface->image, i);
@@ -244,7 +301,8 @@ gst_mfx_surface_vaapi_map(GstMfxSurface * surface)
   }
 
 done:
-  vaapi_image_unref (vaapi_surface->image);
+  if (!success)
+    vaapi_image_replace (&vaapi_surface->image, NULL);
   return success;
 }
 
@@ -260,6 +318,7 @@ gst_mfx_surface_vaapi_unmap(GstMfxSurface * surface)
     surface->pitches[i] = 0;
   }
   vaapi_image_unmap(vaapi_surface->image);
+  vaapi_image_replace(&vaapi_surface->image, NULL);
 }
 
 void
@@ -316,6 +375,97 @@ gst_mfx_surface_vaapi_new_from_task(GstMfxTask * task)
         NULL, NULL, task, is_linear);
 }
 
+static GstMfxSurface *
+gst_mfx_surface_vaapi_new_external(GstMfxDisplay * display,
+    const GstVideoInfo * info, guint mem_type, unsigned long buffer,
+    gsize size)
+{
+  GstMfxSurface *surface;
+  GstMfxSurfaceVaapi *vaapi_surface;
+  guint i;
+
+  surface = (GstMfxSurface *)
+    gst_mfx_mini_object_new0(GST_MFX_MINI_OBJECT_CLASS(
+        gst_mfx_surface_vaapi_class()));
+  if (!surface)
+    return NULL;
+
+  vaapi_surface = GST_MFX_SURFACE_VAAPI(surface);
+  vaapi_surface->external_mem_type = mem_type;
+  vaapi_surface->external_buffer = buffer;
+  vaapi_surface->external.data_size = size;
+  vaapi_surface->external.num_planes = GST_VIDEO_INFO_N_PLANES(info);
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES(info); i++) {
+    vaapi_surface->external.pitches[i] = GST_VIDEO_INFO_PLANE_STRIDE(info, i);
+    vaapi_surface->external.offsets[i] = GST_VIDEO_INFO_PLANE_OFFSET(info, i);
+  }
+
+  surface->gem_bo_handle = -1;
+  surface->surface_id = GST_MFX_ID_INVALID;
+  surface->display = gst_mfx_display_ref(display);
+
+  if (!gst_mfx_surface_create(surface, info, NULL))
+    goto error;
+  return surface;
+
+error:
+  gst_mfx_surface_unref_internal(surface);
+  return NULL;
+}
+
+GstMfxSurface *
+gst_mfx_surface_vaapi_new_from_userptr(GstMfxDisplay * display,
+    const GstVideoInfo * info, gpointer data, gsize size)
+{
+  guint pitch, height;
+  gsize uv_offset;
+
+  g_return_val_if_fail(display != NULL, NULL);
+  g_return_val_if_fail(info != NULL, NULL);
+
+  if (GST_VIDEO_INFO_FORMAT(info) != GST_VIDEO_FORMAT_NV12)
+    return NULL;
+
+  pitch = GST_VIDEO_INFO_PLANE_STRIDE(info, 0);
+  uv_offset = GST_VIDEO_INFO_PLANE_OFFSET(info, 1);
+  if (GST_VIDEO_INFO_PLANE_STRIDE(info, 1) != pitch
+      || pitch % GST_MFX_SURFACE_USERPTR_PITCH_ALIGNMENT
+      || uv_offset % pitch
+      || GPOINTER_TO_SIZE(data) % GST_MFX_SURFACE_USERPTR_ALIGNMENT)
+    return NULL;
+
+  /* The VA surface spans the 16-aligned MFX frame height, make sure the
+   * driver never reads past the end of the upstream memory */
+  height = GST_VIDEO_INFO_IS_INTERLACED(info) ?
+      GST_ROUND_UP_32(GST_VIDEO_INFO_HEIGHT(info)) :
+      GST_ROUND_UP_16(GST_VIDEO_INFO_HEIGHT(info));
+  if (uv_offset / pitch < height || size < uv_offset + pitch * height / 2)
+    return NULL;
+
+  return gst_mfx_surface_vaapi_new_external(display, info,
+      VA_SURFACE_ATTRIB_MEM_TYPE_USER_PTR, (unsigned long) data, size);
+}
+
+GstMfxSurface *
+gst_mfx_surface_vaapi_new_from_dmabuf(GstMfxDisplay * display,
+    const GstVideoInfo * info, gint fd, gsize size)
+{
+  g_return_val_if_fail(display != NULL, NULL);
+  g_return_val_if_fail(info != NULL, NULL);
+  g_return_val_if_fail(fd >= 0, NULL);
+
+  switch (GST_VIDEO_INFO_FORMAT(info)) {
+    case GST_VIDEO_FORMAT_NV12:
+    case GST_VIDEO_FORMAT_BGRA:
+      break;
+    default:
+      return NULL;
+  }
+
+  return gst_mfx_surface_vaapi_new_external(display, info,
+      VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME, (unsigned long) fd, size);
+}
+
 GstMfxDisplay *
 gst_mfx_surface_vaapi_get_display(GstMfxSurface * surface)
 {
@@ -335,10 +485,11 @@ gst_mfx_surface_vaapi_derive_image(GstMfxSurface * surface)
   va_image.image_id = VA_INVALID_ID;
   va_image.buf = VA_INVALID_ID;
 
-  GST_MFX_DISPLAY_LOCK(surface->display);
+  /* The driver tracks a single derived image per surface */
+  GST_MFX_DISPLAY_VA_LOCK_EXCLUSIVE(surface->display);
   status = vaDeriveImage(GST_MFX_DISPLAY_VADISPLAY(surface->display),
     surface->surface_id, &va_image);
-  GST_MFX_DISPLAY_UNLOCK(surface->display);
+  GST_MFX_DISPLAY_VA_UNLOCK_EXCLUSIVE(surface->display);
   if (!vaapi_check_status(status, "vaDeriveImage ()"))
     return NULL;
 
@@ -31,6 +31,10 @@ G_BEGIN_DECLS
 
 #define GST_MFX_SURFACE_VAAPI(obj) ((GstMfxSurfaceVaapi *) (obj))
 
+/* Constraints on upstream memory wrapped as a user-pointer VA surface */
+#define GST_MFX_SURFACE_USERPTR_ALIGNMENT 4096
+#define GST_MFX_SURFACE_USERPTR_PITCH_ALIGNMENT 64
+
 typedef struct _GstMfxSurfaceVaapi GstMfxSurfaceVaapi;
 
 GstMfxSurface *
@@ -40,6 +44,14 @@ gst_mfx_surface_vaapi_new (GstMfxDisplay * display, const GstVideoInfo * info,
 GstMfxSurface *
 gst_mfx_surface_vaapi_new_from_task(GstMfxTask * task);
 
+GstMfxSurface *
+gst_mfx_surface_vaapi_new_from_userptr(GstMfxDisplay * display,
+   const GstVideoInfo * info, gpointer data, gsize size);
+
+GstMfxSurface *
+gst_mfx_surface_vaapi_new_from_dmabuf(GstMfxDisplay * display,
+   const GstVideoInfo * info, gint fd, gsize size);
+
 GstMfxDisplay *
 gst_mfx_surface_vaapi_get_display(GstMfxSurface * surface);
 
@@ -36,6 +36,9 @@ struct _GstMfxSurfaceComposition
 
   GPtrArray *subpictures;
   GstMfxSurface *base_surface;
+  GstMfxRectangle base_rect;
+  gboolean has_base_rect;
+  gfloat base_alpha;
 };
 
 static void
@@ -45,6 +48,104 @@ destroy_subpicture (GstMfxSubpicture * subpicture)
   g_slice_free(GstMfxSubpicture, subpicture);
 }
 
+/* Subpicture surfaces are cached across frames by the seqnum and size of
+ * the overlay rectangle they were uploaded from, since the rectangle
+ * pixels only change along with its seqnum */
+typedef struct
+{
+  guint seqnum;
+  guint width;
+  guint height;
+} SubpictureKey;
+
+static guint
+subpicture_key_hash (gconstpointer data)
+{
+  const SubpictureKey *const key = data;
+
+  return key->seqnum ^ (key->width << 16) ^ key->height;
+}
+
+static gboolean
+subpicture_key_equal (gconstpointer a, gconstpointer b)
+{
+  const SubpictureKey *const key_a = a;
+  const SubpictureKey *const key_b = b;
+
+  return key_a->seqnum == key_b->seqnum &&
+      key_a->width == key_b->width && key_a->height == key_b->height;
+}
+
+static void
+subpicture_key_free (gpointer key)
+{
+  g_slice_free (SubpictureKey, key);
+}
+
+static void
+subpicture_key_init (SubpictureKey * key, guint seqnum,
+  const GstMfxRectangle * sub_rect)
+{
+  key->seqnum = seqnum;
+  key->width = sub_rect->width;
+  key->height = sub_rect->height;
+}
+
+static gboolean
+reuse_subpicture (GstMfxSurfaceComposition * composition,
+  GstVideoOverlayRectangle * rect, GHashTable * cache)
+{
+  GstMfxSubpicture *subpicture;
+  GstMfxSurface *surface;
+  GstMfxRectangle sub_rect;
+  SubpictureKey key;
+
+  if (!cache)
+    return FALSE;
+
+  gst_video_overlay_rectangle_get_render_rectangle(rect,
+    (gint *)& sub_rect.x, (gint *)& sub_rect.y,
+    &sub_rect.width, &sub_rect.height);
+
+  subpicture_key_init (&key, gst_video_overlay_rectangle_get_seqnum (rect),
+      &sub_rect);
+  surface = g_hash_table_lookup (cache, &key);
+  if (!surface)
+    return FALSE;
+
+  subpicture = g_slice_new0(GstMfxSubpicture);
+  subpicture->surface = gst_mfx_surface_ref (surface);
+  subpicture->sub_rect = sub_rect;
+  subpicture->seqnum = key.seqnum;
+  subpicture->global_alpha = gst_video_overlay_rectangle_get_global_alpha(rect);
+
+  g_ptr_array_add(composition->subpictures, subpicture);
+
+  return TRUE;
+}
+
+/* Replaces the contents of @cache with the subpicture surfaces of
+ * @composition, so that surfaces of rectangles that went away are
+ * released */
+static void
+update_subpicture_cache (GstMfxSurfaceComposition * composition,
+  GHashTable * cache)
+{
+  GstMfxSubpicture *subpicture;
+  SubpictureKey *key;
+  guint i;
+
+  g_hash_table_remove_all (cache);
+
+  for (i = 0; i < composition->subpictures->len; i++) {
+    subpicture = g_ptr_array_index (composition->subpictures, i);
+    key = g_slice_new (SubpictureKey);
+    subpicture_key_init (key, subpicture->seqnum, &subpicture->sub_rect);
+    g_hash_table_replace (cache, key,
+        gst_mfx_surface_ref (subpicture->surface));
+  }
+}
+
 static gboolean
 create_subpicture (GstMfxSurfaceComposition * composition,
   GstVideoOverlayRectangle * rect)
@@ -113,6 +214,7 @@ create_subpicture (GstMfxSurfaceComposition * composition,
   gst_video_meta_unmap(vmeta, 0, &map_info);
 
   subpicture->global_alpha = gst_video_overlay_rectangle_get_global_alpha(rect);
+  subpicture->seqnum = gst_video_overlay_rectangle_get_seqnum (rect);
 
   g_ptr_array_add(composition->subpictures, subpicture);
 
@@ -125,7 +227,8 @@ error:
 static gboolean
 gst_mfx_create_surfaces_from_composition(
   GstMfxSurfaceComposition * composition,
-  GstVideoOverlayComposition * overlay)
+  GstVideoOverlayComposition * overlay,
+  GHashTable * cache)
 {
   guint n, nb_rectangles;
 
@@ -142,6 +245,10 @@ gst_mfx_create_surfaces_from_composition(
     if (!GST_IS_VIDEO_OVERLAY_RECTANGLE(rect))
       continue;
 
+    /* Skip the upload when the previous frame already had these pixels */
+    if (reuse_subpicture(composition, rect, cache))
+      continue;
+
     if (!create_subpicture(composition, rect)) {
       GST_WARNING("could not create subpicture %p", rect);
       return FALSE;
@@ -167,9 +274,23 @@ gst_mfx_surface_composition_class(void)
   return &GstMfxSubpictureCompositionClass;
 }
 
+/**
+ * gst_mfx_surface_composition_new:
+ * @base_surface: the #GstMfxSurface the overlay is blended onto
+ * @overlay: a #GstVideoOverlayComposition
+ * @cache: (allow-none): a subpicture cache from
+ *   gst_mfx_surface_composition_cache_new(), or %NULL
+ *
+ * Creates the subpictures for all the rectangles of @overlay. Subpicture
+ * surfaces in @cache that were uploaded from unchanged rectangles are
+ * shared instead of being uploaded again, and @cache is then updated to
+ * hold the subpicture surfaces of the new composition only.
+ *
+ * Return value: the newly allocated #GstMfxSurfaceComposition object
+ */
 GstMfxSurfaceComposition *
 gst_mfx_surface_composition_new (GstMfxSurface * base_surface,
-  GstVideoOverlayComposition * overlay)
+  GstVideoOverlayComposition * overlay, GHashTable * cache)
 {
   GstMfxSurfaceComposition *composition;
 
@@ -182,17 +303,113 @@ gst_mfx_surface_composition_new (GstMfxSurface * base_surface,
     return NULL;
 
   composition->base_surface = gst_mfx_surface_ref (base_surface);
+  composition->base_alpha = 1.0;
   composition->subpictures =
       g_ptr_array_new_with_free_func((GDestroyNotify)destroy_subpicture);
-  if (!gst_mfx_create_surfaces_from_composition(composition, overlay))
+  if (!gst_mfx_create_surfaces_from_composition(composition, overlay, cache))
     goto error;
 
+  if (cache)
+    update_subpicture_cache (composition, cache);
+
   return composition;
 error:
   gst_mfx_mini_object_unref(GST_MFX_MINI_OBJECT(composition));
   return NULL;
 }
 
+/**
+ * gst_mfx_surface_composition_cache_new:
+ *
+ * Creates a cache of overlay subpicture surfaces to be passed to
+ * gst_mfx_surface_composition_new() for consecutive frames. The cache
+ * only references subpicture surfaces, never the base surfaces.
+ *
+ * Return value: a new #GHashTable, free it with g_hash_table_unref()
+ */
+GHashTable *
+gst_mfx_surface_composition_cache_new (void)
+{
+  return g_hash_table_new_full (subpicture_key_hash, subpicture_key_equal,
+      subpicture_key_free, (GDestroyNotify) gst_mfx_surface_unref);
+}
+
+/**
+ * gst_mfx_surface_composition_new_with_base_rect:
+ * @base_surface: the bottom-most #GstMfxSurface of the composition
+ * @base_rect: (allow-none): where @base_surface is placed in the output
+ * @global_alpha: the opacity of @base_surface, from 0.0 to 1.0
+ *
+ * Creates an empty composition, to be filled in with
+ * gst_mfx_surface_composition_add_surface(). If @base_rect is %NULL, the
+ * base surface covers its own cropped area of the output.
+ *
+ * Return value: the newly allocated #GstMfxSurfaceComposition object
+ */
+GstMfxSurfaceComposition *
+gst_mfx_surface_composition_new_with_base_rect (GstMfxSurface * base_surface,
+  const GstMfxRectangle * base_rect, gfloat global_alpha)
+{
+  GstMfxSurfaceComposition *composition;
+
+  g_return_val_if_fail(base_surface != NULL, NULL);
+
+  composition = (GstMfxSurfaceComposition *)
+                  gst_mfx_mini_object_new0(gst_mfx_surface_composition_class());
+  if (!composition)
+    return NULL;
+
+  composition->base_surface = gst_mfx_surface_ref (base_surface);
+  composition->subpictures =
+      g_ptr_array_new_with_free_func((GDestroyNotify)destroy_subpicture);
+  if (base_rect) {
+    composition->base_rect = *base_rect;
+    composition->has_base_rect = TRUE;
+  }
+  composition->base_alpha = CLAMP (global_alpha, 0.0, 1.0);
+  return composition;
+}
+
+/**
+ * gst_mfx_surface_composition_add_surface:
+ * @composition: a #GstMfxSurfaceComposition
+ * @surface: the #GstMfxSurface to blend
+ * @dst_rect: where @surface is placed in the output
+ * @global_alpha: the opacity of @surface, from 0.0 to 1.0
+ *
+ * Stacks @surface on top of the surfaces already in @composition.
+ * @surface must use the same memory type as the base surface.
+ *
+ * Return value: %TRUE on success
+ */
+gboolean
+gst_mfx_surface_composition_add_surface (
+  GstMfxSurfaceComposition * composition, GstMfxSurface * surface,
+  const GstMfxRectangle * dst_rect, gfloat global_alpha)
+{
+  GstMfxSubpicture *subpicture;
+
+  g_return_val_if_fail(composition != NULL, FALSE);
+  g_return_val_if_fail(surface != NULL, FALSE);
+  g_return_val_if_fail(dst_rect != NULL, FALSE);
+
+  if (gst_mfx_surface_has_video_memory (surface) !=
+      gst_mfx_surface_has_video_memory (composition->base_surface)) {
+    GST_ERROR("surface %p and base surface use different memory types",
+        surface);
+    return FALSE;
+  }
+
+  subpicture = g_slice_new0(GstMfxSubpicture);
+  subpicture->surface = gst_mfx_surface_ref (surface);
+  subpicture->sub_rect = *dst_rect;
+  subpicture->global_alpha = CLAMP (global_alpha, 0.0, 1.0);
+
+  g_ptr_array_add(composition->subpictures, subpicture);
+
+  return TRUE;
+}
+
 GstMfxSurfaceComposition *
 gst_mfx_surface_composition_ref (GstMfxSurfaceComposition * composition)
 {
@@ -235,6 +452,22 @@ gst_mfx_surface_composition_get_base_surface (
   return composition->base_surface;
 }
 
+const GstMfxRectangle *
+gst_mfx_surface_composition_get_base_rect (
+  GstMfxSurfaceComposition * composition)
+{
+  g_return_val_if_fail(composition != NULL, NULL);
+  return composition->has_base_rect ? &composition->base_rect : NULL;
+}
+
+gfloat
+gst_mfx_surface_composition_get_base_alpha (
+  GstMfxSurfaceComposition * composition)
+{
+  g_return_val_if_fail(composition != NULL, 1.0);
+  return composition->base_alpha;
+}
+
 guint
 gst_mfx_surface_composition_get_num_subpictures(
   GstMfxSurfaceComposition * composition)
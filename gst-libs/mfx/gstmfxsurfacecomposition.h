@@ -40,11 +40,24 @@ struct _GstMfxSubpicture
   GstMfxSurface *surface;
   gfloat global_alpha;
   GstMfxRectangle sub_rect;
+  guint seqnum;
 };
 
 GstMfxSurfaceComposition *
 gst_mfx_surface_composition_new (GstMfxSurface * base_surface,
-  GstVideoOverlayComposition * overlay);
+  GstVideoOverlayComposition * overlay, GHashTable * cache);
+
+GHashTable *
+gst_mfx_surface_composition_cache_new (void);
+
+GstMfxSurfaceComposition *
+gst_mfx_surface_composition_new_with_base_rect (GstMfxSurface * base_surface,
+  const GstMfxRectangle * base_rect, gfloat global_alpha);
+
+gboolean
+gst_mfx_surface_composition_add_surface (
+  GstMfxSurfaceComposition * composition, GstMfxSurface * surface,
+  const GstMfxRectangle * dst_rect, gfloat global_alpha);
 
 GstMfxSurfaceComposition *
 gst_mfx_surface_composition_ref (GstMfxSurfaceComposition * composition);
@@ -60,6 +73,12 @@ gst_mfx_surface_composition_replace(
 GstMfxSurface *
 gst_mfx_surface_composition_get_base_surface (GstMfxSurfaceComposition * composition);
 
+const GstMfxRectangle *
+gst_mfx_surface_composition_get_base_rect (GstMfxSurfaceComposition * composition);
+
+gfloat
+gst_mfx_surface_composition_get_base_alpha (GstMfxSurfaceComposition * composition);
+
 guint
 gst_mfx_surface_composition_get_num_subpictures(GstMfxSurfaceComposition * composition);
 
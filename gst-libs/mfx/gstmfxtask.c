@@ -54,6 +54,9 @@ struct _GstMfxTask
   gboolean memtype_is_system;
   gboolean is_joined;
 
+  /* Wakes up the threads waiting for surfaces of this session */
+  GstMfxWaitQueue *wait_queue;
+
   /* This variable use to handle re-use back VASurfaces */
   gboolean soft_reinit;
   mfxU16 backup_num_surfaces;
@@ -156,12 +159,12 @@ gst_mfx_task_frame_alloc (mfxHDL pthis, mfxFrameAllocRequest * req,
       attrib.value.type = VAGenericValueTypeInteger;
       attrib.value.value.i = fourcc;
 
-      GST_MFX_DISPLAY_LOCK (task->display);
+      GST_MFX_DISPLAY_VA_LOCK (task->display);
       sts = vaCreateSurfaces (GST_MFX_DISPLAY_VADISPLAY (task->display),
           gst_mfx_video_format_to_va_format (info->FourCC),
           req->Info.Width, req->Info.Height,
           response_data->surfaces, num_surfaces, &attrib, 1);
-      GST_MFX_DISPLAY_UNLOCK (task->display);
+      GST_MFX_DISPLAY_VA_UNLOCK (task->display);
       if (!vaapi_check_status (sts, "vaCreateSurfaces ()")) {
         GST_ERROR ("Error allocating VA surfaces %d", sts);
         goto error_allocate_memory;
@@ -251,20 +254,20 @@ gst_mfx_task_frame_free (mfxHDL pthis, mfxFrameAllocResponse * resp)
       task->backup_num_surfaces = num_surfaces;
       task->backup_surfaces = response_data->surfaces;
     } else {
-      GST_MFX_DISPLAY_LOCK (task->display);
+      GST_MFX_DISPLAY_VA_LOCK (task->display);
       vaDestroySurfaces (GST_MFX_DISPLAY_VADISPLAY (task->display),
           response_data->surfaces, num_surfaces);
-      GST_MFX_DISPLAY_UNLOCK (task->display);
+      GST_MFX_DISPLAY_VA_UNLOCK (task->display);
 
       g_slice_free1 (num_surfaces * sizeof (VASurfaceID),
           response_data->surfaces);
     }
   } else {
     for (i = 0; i < num_surfaces; i++) {
-      GST_MFX_DISPLAY_LOCK (task->display);
+      GST_MFX_DISPLAY_VA_LOCK (task->display);
       vaDestroyBuffer (GST_MFX_DISPLAY_VADISPLAY (task->display),
           response_data->coded_buf[i]);
-      GST_MFX_DISPLAY_UNLOCK (task->display);
+      GST_MFX_DISPLAY_VA_UNLOCK (task->display);
     }
     g_slice_free1 (num_surfaces * sizeof (VABufferID),
         response_data->coded_buf);
@@ -290,10 +293,10 @@ gst_mfx_task_frame_lock (mfxHDL pthis, mfxMemId mid, mfxFrameData * ptr)
   if (mem_id->info->FourCC == MFX_FOURCC_P8) {
     VACodedBufferSegment *coded_buffer_segment;
 
-    GST_MFX_DISPLAY_LOCK (task->display);
+    GST_MFX_DISPLAY_VA_LOCK (task->display);
     sts = vaMapBuffer (GST_MFX_DISPLAY_VADISPLAY (task->display),
         *(VABufferID *) mem_id->mid, (void **) &coded_buffer_segment);
-    GST_MFX_DISPLAY_UNLOCK (task->display);
+    GST_MFX_DISPLAY_VA_UNLOCK (task->display);
     if (!vaapi_check_status (sts, "vaMapBuffer ()")) {
       GST_ERROR ("Error mapping VA buffers %d", sts);
       return MFX_ERR_LOCK_MEMORY;
@@ -312,10 +315,10 @@ gst_mfx_task_frame_unlock (mfxHDL pthis, mfxMemId mid, mfxFrameData * ptr)
   GstMfxMemoryId *mem_id = (GstMfxMemoryId *) mid;
 
   if (mem_id->info->FourCC == MFX_FOURCC_P8) {
-    GST_MFX_DISPLAY_LOCK (task->display);
+    GST_MFX_DISPLAY_VA_LOCK (task->display);
     vaUnmapBuffer (GST_MFX_DISPLAY_VADISPLAY (task->display),
         *(VABufferID *) mem_id->mid);
-    GST_MFX_DISPLAY_UNLOCK (task->display);
+    GST_MFX_DISPLAY_VA_UNLOCK (task->display);
   } else
     return MFX_ERR_UNSUPPORTED;
 
@@ -342,6 +345,15 @@ gst_mfx_task_get_display (GstMfxTask * task)
   return gst_mfx_display_ref(task->display);
 }
 
+/* Returns the wait queue of the session, without a new reference */
+GstMfxWaitQueue *
+gst_mfx_task_get_wait_queue (GstMfxTask * task)
+{
+  g_return_val_if_fail (task != NULL, NULL);
+
+  return task->wait_queue;
+}
+
 mfxSession
 gst_mfx_task_get_session (GstMfxTask * task)
 {
@@ -496,6 +508,7 @@ gst_mfx_task_finalize (GstMfxTask * task)
   gst_mfx_task_aggregator_remove_task (task->aggregator, task);
   gst_mfx_task_aggregator_unref (task->aggregator);
   gst_mfx_display_unref (task->display);
+  gst_mfx_wait_queue_replace (&task->wait_queue, NULL);
   g_list_free_full (task->saved_responses, g_free);
 }
 
@@ -519,6 +532,7 @@ gst_mfx_task_init (GstMfxTask * task, GstMfxTaskAggregator * aggregator,
   task->display = gst_mfx_task_aggregator_get_display(aggregator);
   task->session = session;
   task->aggregator = gst_mfx_task_aggregator_ref (aggregator);
+  task->wait_queue = gst_mfx_wait_queue_new ();
 
   gst_mfx_task_aggregator_add_task (aggregator, task);
 
@@ -24,6 +24,7 @@
 #include "sysdeps.h"
 #include "gstmfxminiobject.h"
 #include "gstmfxdisplay.h"
+#include "gstmfxwaitqueue.h"
 
 #include <mfxvideo.h>
 #include <va/va.h>
@@ -106,6 +107,9 @@ gst_mfx_task_ensure_memtype_is_system (GstMfxTask * task);
 GstMfxDisplay *
 gst_mfx_task_get_display (GstMfxTask * task);
 
+GstMfxWaitQueue *
+gst_mfx_task_get_wait_queue (GstMfxTask * task);
+
 GstMfxMemoryId *
 gst_mfx_task_get_memory_id (GstMfxTask * task);
 
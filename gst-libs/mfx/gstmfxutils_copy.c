@@ -0,0 +1,169 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "sysdeps.h"
+#include "gstmfxutils_copy.h"
+
+#define DEBUG 1
+#include "gstmfxdebug.h"
+
+/* Below this many bytes, waking up workers costs more than it saves */
+#define MIN_THREADED_COPY_SIZE (4 * 1024 * 1024)
+#define MAX_COPY_THREADS 4
+#define MAX_COPY_PLANES 4
+#define MAX_COPY_BANDS (MAX_COPY_PLANES * MAX_COPY_THREADS)
+
+typedef struct _CopyJob CopyJob;
+typedef struct _CopyBand CopyBand;
+
+struct _CopyBand
+{
+  CopyJob *job;
+  GstMfxPlaneCopy rows;
+};
+
+struct _CopyJob
+{
+  CopyBand bands[MAX_COPY_BANDS];
+  guint n_bands;
+  guint pending;
+  GMutex lock;
+  GCond cond;
+};
+
+static void
+copy_rows (const GstMfxPlaneCopy * p)
+{
+  guint i;
+
+  if (p->dst_stride == p->src_stride && p->row_size == p->src_stride) {
+    memcpy (p->dst, p->src, (gsize) p->row_size * p->height);
+    return;
+  }
+
+  for (i = 0; i < p->height; i++)
+    memcpy (p->dst + (gsize) i * p->dst_stride,
+        p->src + (gsize) i * p->src_stride, p->row_size);
+}
+
+static void
+copy_band_worker (gpointer data, gpointer user_data)
+{
+  CopyBand *const band = data;
+  CopyJob *const job = band->job;
+
+  copy_rows (&band->rows);
+
+  g_mutex_lock (&job->lock);
+  if (!--job->pending)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->lock);
+}
+
+static GThreadPool *
+get_copy_pool (void)
+{
+  static gsize init = 0;
+  static GThreadPool *pool;
+
+  if (g_once_init_enter (&init)) {
+    const guint n_threads = MIN (g_get_num_processors (), MAX_COPY_THREADS);
+
+    /* The streaming thread copies one band itself */
+    if (n_threads > 1)
+      pool = g_thread_pool_new (copy_band_worker, NULL, n_threads - 1,
+          FALSE, NULL);
+    g_once_init_leave (&init, 1);
+  }
+  return pool;
+}
+
+/* Splits every plane in row bands of about @band_size bytes */
+static void
+split_bands (CopyJob * job, const GstMfxPlaneCopy * planes, guint n_planes,
+    gsize band_size)
+{
+  guint i, j, n, rows, row;
+
+  for (i = 0; i < n_planes; i++) {
+    const GstMfxPlaneCopy *const p = &planes[i];
+    const gsize size = (gsize) p->row_size * p->height;
+
+    n = CLAMP ((size + band_size / 2) / band_size, 1, MAX_COPY_THREADS);
+
+    for (j = 0, row = 0; j < n; j++, row += rows) {
+      CopyBand *const band = &job->bands[job->n_bands++];
+
+      rows = (p->height - row) / (n - j);
+      band->job = job;
+      band->rows = *p;
+      band->rows.dst = p->dst + (gsize) row * p->dst_stride;
+      band->rows.src = p->src + (gsize) row * p->src_stride;
+      band->rows.height = rows;
+    }
+  }
+}
+
+void
+gst_mfx_utils_copy_planes (const GstMfxPlaneCopy * planes, guint n_planes)
+{
+  GThreadPool *const pool = get_copy_pool ();
+  gint64 start = 0;
+  gsize size = 0;
+  CopyJob job;
+  guint i;
+
+  g_return_if_fail (n_planes <= MAX_COPY_PLANES);
+
+  for (i = 0; i < n_planes; i++)
+    size += (gsize) planes[i].row_size * planes[i].height;
+
+  if (!pool || size < MIN_THREADED_COPY_SIZE) {
+    for (i = 0; i < n_planes; i++)
+      copy_rows (&planes[i]);
+    return;
+  }
+
+  if (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >= GST_LEVEL_LOG)
+    start = g_get_monotonic_time ();
+
+  job.n_bands = 0;
+  split_bands (&job, planes, n_planes,
+      size / (g_thread_pool_get_max_threads (pool) + 1));
+  job.pending = job.n_bands - 1;
+  g_mutex_init (&job.lock);
+  g_cond_init (&job.cond);
+
+  for (i = 1; i < job.n_bands; i++)
+    g_thread_pool_push (pool, &job.bands[i], NULL);
+  copy_rows (&job.bands[0].rows);
+
+  g_mutex_lock (&job.lock);
+  while (job.pending)
+    g_cond_wait (&job.cond, &job.lock);
+  g_mutex_unlock (&job.lock);
+
+  g_mutex_clear (&job.lock);
+  g_cond_clear (&job.cond);
+
+  if (start)
+    GST_LOG ("copied %" G_GSIZE_FORMAT " bytes in %u bands in %"
+        G_GINT64_FORMAT " us", size, job.n_bands,
+        g_get_monotonic_time () - start);
+}
@@ -0,0 +1,48 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef GST_MFX_UTILS_COPY_H
+#define GST_MFX_UTILS_COPY_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstMfxPlaneCopy GstMfxPlaneCopy;
+
+/* Copy of @height rows of @row_size bytes between two planes */
+struct _GstMfxPlaneCopy
+{
+  guint8 *dst;
+  const guint8 *src;
+  guint dst_stride;
+  guint src_stride;
+  guint row_size;
+  guint height;
+};
+
+/* Copies all @n_planes planes, splitting frames too large for a single
+ * core to copy at memory speed into row bands spread over a small pool
+ * of worker threads shared by all elements */
+void
+gst_mfx_utils_copy_planes (const GstMfxPlaneCopy * planes, guint n_planes);
+
+G_END_DECLS
+
+#endif /* GST_MFX_UTILS_COPY_H */
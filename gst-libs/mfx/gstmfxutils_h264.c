@@ -99,54 +99,150 @@ gst_mfx_utils_h264_get_profile_string (mfxU16 profile)
   return m ? m->name : NULL;
 }
 
-static guint16 read_ue(const guint8 *slice_buf, gint *nbits, gint size)
+/* Bit reader over the RBSP of a NAL unit. Bytes are loaded a word at a
+ * time into a 64-bit cache, MSB first, dropping emulation prevention
+ * bytes on the fly so the payload never has to be copied. Words that
+ * may hold part of an emulation prevention sequence are loaded byte by
+ * byte */
+typedef struct
 {
-  if (!slice_buf || !nbits)
-    return 0;
-
-  guint16 res = 0;
-  gint offset = *nbits / 8, c = *nbits, i;
-  guint8 bit = 0x80 >> (*nbits % 8);
-
-  while (!(slice_buf[offset] & bit)) {
-    bit >>= 1;
-    ++(*nbits);
-    if (!(*nbits % 8)) {
-      ++offset;
-      bit = 0x80;
-    }
+  const guint8 *data;
+  gint size;
+  gint pos;
+  guint64 cache;
+  gint cache_bits;
+  guint zeros;
+} NalReader;
+
+static void
+nal_reader_init (NalReader * reader, const guint8 * data, gint size)
+{
+  reader->data = data;
+  reader->size = data ? MAX (size, 0) : 0;
+  reader->pos = 0;
+  reader->cache = 0;
+  reader->cache_bits = 0;
+  reader->zeros = 0;
+}
+
+/* Whether any byte of a 32-bit word is zero */
+#define HAS_ZERO_BYTE(word) \
+  (((word) - 0x01010101U) & ~(word) & 0x80808080U)
+
+static void
+nal_reader_refill (NalReader * reader)
+{
+  guint32 word;
+  guint8 byte;
+
+  /* Without zero bytes, neither in the word nor right before it, there
+   * is no emulation prevention byte to drop */
+  while (reader->cache_bits <= 32 && reader->size - reader->pos >= 4
+      && !reader->zeros) {
+    word = GST_READ_UINT32_BE (reader->data + reader->pos);
+    if (HAS_ZERO_BYTE (word))
+      break;
+    reader->cache |= (guint64) word << (32 - reader->cache_bits);
+    reader->cache_bits += 32;
+    reader->pos += 4;
   }
 
-  i = c = *nbits - c;
-  while (c) {
-    bit >>= 1;
-    ++(*nbits);
-    if (!(*nbits % 8)) {
-      ++offset;
-      bit = 0x80;
+  while (reader->cache_bits <= 56 && reader->pos < reader->size) {
+    byte = reader->data[reader->pos++];
+    if (reader->zeros >= 2 && 0x03 == byte) {
+      reader->zeros = 0;
+      continue;
     }
-    res <<= 1;
-    res |= (slice_buf[offset] & bit) ? 1 : 0;
-    --c;
+    reader->zeros = byte ? 0 : reader->zeros + 1;
+    reader->cache |= (guint64) byte << (56 - reader->cache_bits);
+    reader->cache_bits += 8;
   }
+}
 
-  ++(*nbits);
-  res = res + (1 << i) - 1;
+static inline guint
+count_leading_zeros64 (guint64 value)
+{
+#if defined(__GNUC__)
+  return __builtin_clzll (value);
+#else
+  guint n = 0;
+
+  while (!(value & G_GUINT64_CONSTANT (0x8000000000000000))) {
+    value <<= 1;
+    n++;
+  }
+  return n;
+#endif
+}
 
-  return res;
+/* Reads an unsigned Exp-Golomb code. Codes longer than what the cache
+ * can hold after a refill (values >= 2^28) are rejected, they do not
+ * occur in the slice header fields parsed here */
+static gboolean
+nal_reader_get_ue (NalReader * reader, guint32 * value)
+{
+  guint leading_zeros, len;
+
+  nal_reader_refill (reader);
+  if (!reader->cache)
+    return FALSE;
+
+  leading_zeros = count_leading_zeros64 (reader->cache);
+  len = 2 * leading_zeros + 1;
+  if (leading_zeros > 28 || len > reader->cache_bits)
+    return FALSE;
+
+  *value = (guint32) (reader->cache >> (64 - len)) - 1;
+  reader->cache <<= len;
+  reader->cache_bits -= len;
+  return TRUE;
 }
 
 gboolean
 gst_mfx_utils_h264_is_slice_intra (const guint8 *slice_buf, gint size)
 {
-  gint nbits = 8;
+  NalReader reader;
+  guint32 first_mb_in_slice, slice_type;
+
+  if (!slice_buf || size < 2)
+    return FALSE;
+
+  /* Skip the NAL unit header */
+  nal_reader_init (&reader, slice_buf + 1, size - 1);
 
-  /* First UE value is fist_mb_in_slice */
-  read_ue(slice_buf, &nbits, size);
+  if (!nal_reader_get_ue (&reader, &first_mb_in_slice) ||
+      !nal_reader_get_ue (&reader, &slice_type))
+    return FALSE;
 
-  /* Second UE value is slice type */
-  if ((read_ue(slice_buf, &nbits, size) % 5) == GST_H264_I_SLICE)
-    return TRUE;
+  return (slice_type % 5) == GST_H264_I_SLICE;
+}
 
+gboolean
+gst_mfx_utils_h264_avc_has_intra (const guint8 * data, gint size)
+{
+  guint32 nal_size;
+  gint offset = 0;
+
+  if (!data)
+    return FALSE;
+
+  while (size - offset > 4) {
+    nal_size = GST_READ_UINT32_BE (data + offset);
+    offset += 4;
+
+    /* A corrupt length must not take us out of the buffer */
+    if (!nal_size || nal_size > (guint32) (size - offset))
+      return FALSE;
+
+    switch (data[offset] & 0x1f) {
+      case GST_H264_NAL_SLICE:
+        if (gst_mfx_utils_h264_is_slice_intra (data + offset, nal_size))
+          return TRUE;
+        break;
+      case GST_H264_NAL_SLICE_IDR:
+        return TRUE;
+    }
+    offset += nal_size;
+  }
   return FALSE;
 }
@@ -43,6 +43,11 @@ gst_mfx_utils_h264_get_profile_string (mfxU16 profile);
 gboolean
 gst_mfx_utils_h264_is_slice_intra (const guint8 *slice_buf, gint size);
 
+/* Check if an AVC (length-prefixed) access unit contains an IDR or an I
+ * slice. Units whose length runs past @size end the search */
+gboolean
+gst_mfx_utils_h264_avc_has_intra (const guint8 * data, gint size);
+
 G_END_DECLS
 
 #endif /* GST_MFX_UTILS_H264_H */
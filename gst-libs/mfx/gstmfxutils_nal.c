@@ -0,0 +1,162 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "sysdeps.h"
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
+#include "gstmfxutils_nal.h"
+
+/* Access unit boundaries as of H.264 7.4.1.2.3 and H.265 7.4.2.4.4. A new
+ * picture is detected from first_mb_in_slice == 0, respectively from
+ * first_slice_segment_in_pic_flag, which both sit in the first bit after
+ * the NAL unit header and can never be preceded by an emulation
+ * prevention byte */
+gboolean
+gst_mfx_utils_nal_parse_header (mfxU32 codec, const guint8 * data,
+    gsize size, GstMfxNalUnitInfo * info)
+{
+  g_return_val_if_fail (info != NULL, FALSE);
+
+  memset (info, 0, sizeof (*info));
+
+  if (MFX_CODEC_AVC == codec) {
+    if (size < 2)
+      return FALSE;
+
+    info->type = data[0] & 0x1f;
+    switch (info->type) {
+      case GST_H264_NAL_SLICE:
+      case GST_H264_NAL_SLICE_DPA:
+      case GST_H264_NAL_SLICE_IDR:
+        info->is_vcl = TRUE;
+        info->is_keyframe = GST_H264_NAL_SLICE_IDR == info->type;
+        info->starts_au = (data[1] & 0x80) != 0;
+        break;
+      case GST_H264_NAL_SPS:
+        info->is_sps = TRUE;
+        /* fall through */
+      case GST_H264_NAL_SEI:
+      case GST_H264_NAL_PPS:
+      case GST_H264_NAL_AU_DELIMITER:
+        info->starts_au = TRUE;
+        break;
+      default:
+        /* Prefix NAL units and reserved types 14 to 18 open an AU too */
+        info->starts_au = info->type >= 14 && info->type <= 18;
+        break;
+    }
+    return TRUE;
+  }
+
+  if (MFX_CODEC_HEVC == codec) {
+    if (size < 3)
+      return FALSE;
+
+    info->type = (data[0] >> 1) & 0x3f;
+
+    /* Only the base layer delimits access units */
+    if ((((data[0] & 0x01) << 5) | (data[1] >> 3)) != 0)
+      return TRUE;
+
+    if (info->type <= GST_H265_NAL_SLICE_CRA_NUT) {
+      info->is_vcl = TRUE;
+      info->is_keyframe = info->type >= GST_H265_NAL_SLICE_BLA_W_LP;
+      info->starts_au = (data[2] & 0x80) != 0;
+    } else if (info->type < 32) {
+      /* Reserved VCL types */
+      info->is_vcl = TRUE;
+    } else {
+      info->is_sps = GST_H265_NAL_SPS == info->type;
+      info->starts_au = info->type <= GST_H265_NAL_AUD
+          || GST_H265_NAL_PREFIX_SEI == info->type
+          || (info->type >= 41 && info->type <= 44)
+          || (info->type >= 48 && info->type <= 55);
+    }
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+gboolean
+gst_mfx_utils_nal_au_add (GstMfxNalAu * au, const GstMfxNalUnitInfo * info)
+{
+  g_return_val_if_fail (au != NULL && info != NULL, FALSE);
+
+  /* Only a picture closes an access unit, whatever leads it stays with
+   * the picture that follows */
+  if (info->starts_au && au->has_vcl)
+    return FALSE;
+
+  au->has_nal = TRUE;
+  au->has_vcl |= info->is_vcl;
+  au->is_keyframe |= info->is_keyframe;
+  return TRUE;
+}
+
+gboolean
+gst_mfx_utils_nal_parse_sps_size (mfxU32 codec, const guint8 * data,
+    gsize size, guint * width, guint * height)
+{
+  g_return_val_if_fail (width != NULL && height != NULL, FALSE);
+
+  if (MFX_CODEC_AVC == codec) {
+    GstH264NalUnit nalu;
+    GstH264SPS sps;
+
+    memset (&nalu, 0, sizeof (nalu));
+    nalu.type = GST_H264_NAL_SPS;
+    nalu.header_bytes = 1;
+    nalu.data = (guint8 *) data;
+    nalu.size = size;
+
+    if (GST_H264_PARSER_OK != gst_h264_parse_sps (&nalu, &sps, FALSE))
+      return FALSE;
+
+    *width = sps.frame_cropping_flag ? sps.crop_rect_width : sps.width;
+    *height = sps.frame_cropping_flag ? sps.crop_rect_height : sps.height;
+    return *width && *height;
+  }
+
+  if (MFX_CODEC_HEVC == codec) {
+    GstH265Parser *parser;
+    GstH265NalUnit nalu;
+    GstH265SPS sps;
+    GstH265ParserResult res;
+
+    memset (&nalu, 0, sizeof (nalu));
+    nalu.type = GST_H265_NAL_SPS;
+    nalu.header_bytes = 2;
+    nalu.data = (guint8 *) data;
+    nalu.size = size;
+
+    /* The SPS does not depend on the VPS for its picture size */
+    parser = gst_h265_parser_new ();
+    res = gst_h265_parse_sps (parser, &nalu, &sps, FALSE);
+    gst_h265_parser_free (parser);
+    if (GST_H265_PARSER_OK != res)
+      return FALSE;
+
+    *width = sps.conformance_window_flag ? sps.crop_rect_width : sps.width;
+    *height = sps.conformance_window_flag ? sps.crop_rect_height : sps.height;
+    return *width && *height;
+  }
+
+  return FALSE;
+}
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef GST_MFX_UTILS_NAL_H
+#define GST_MFX_UTILS_NAL_H
+
+#include <gst/gst.h>
+#include <mfxvideo.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstMfxNalUnitInfo GstMfxNalUnitInfo;
+typedef struct _GstMfxNalAu GstMfxNalAu;
+
+/* What an access unit splitter needs to know about a NAL unit */
+struct _GstMfxNalUnitInfo
+{
+  guint8 type;
+  gboolean is_vcl;
+  gboolean is_sps;
+  gboolean is_keyframe;
+  /* Starts a new access unit if the current one already holds a picture */
+  gboolean starts_au;
+};
+
+/* Access unit being collected by a byte-stream splitter */
+struct _GstMfxNalAu
+{
+  gboolean has_nal;
+  gboolean has_vcl;
+  gboolean is_keyframe;
+};
+
+/* Classifies the H.264 or H.265 NAL unit starting at its header. Needs
+ * the header and the first byte of the slice header */
+gboolean
+gst_mfx_utils_nal_parse_header (mfxU32 codec, const guint8 * data,
+    gsize size, GstMfxNalUnitInfo * info);
+
+/* Adds the NAL unit described by @info to @au. Returns %FALSE, leaving
+ * @au untouched, if the NAL unit opens the next access unit instead */
+gboolean
+gst_mfx_utils_nal_au_add (GstMfxNalAu * au, const GstMfxNalUnitInfo * info);
+
+/* Gets the cropped picture size from a H.264 or H.265 SPS NAL unit */
+gboolean
+gst_mfx_utils_nal_parse_sps_size (mfxU32 codec, const guint8 * data,
+    gsize size, guint * width, guint * height);
+
+G_END_DECLS
+
+#endif /* GST_MFX_UTILS_NAL_H */
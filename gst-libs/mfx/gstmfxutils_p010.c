@@ -0,0 +1,211 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "sysdeps.h"
+#include "gstmfxutils_p010.h"
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+#define P010_SHIFT 6
+
+void
+gst_mfx_utils_p010_pack_y (const guint16 * src, guint16 * dst, guint width)
+{
+  guint i = 0;
+
+#ifdef __SSE2__
+  for (; i + 16 <= width; i += 16) {
+    const __m128i s0 = _mm_loadu_si128 ((const __m128i *) (src + i));
+    const __m128i s1 = _mm_loadu_si128 ((const __m128i *) (src + i + 8));
+
+    _mm_storeu_si128 ((__m128i *) (dst + i), _mm_slli_epi16 (s0, P010_SHIFT));
+    _mm_storeu_si128 ((__m128i *) (dst + i + 8),
+        _mm_slli_epi16 (s1, P010_SHIFT));
+  }
+#endif
+
+  for (; i < width; i++)
+    dst[i] = src[i] << P010_SHIFT;
+}
+
+void
+gst_mfx_utils_p010_pack_uv (const guint16 * u, const guint16 * v,
+    guint16 * uv, guint width)
+{
+  const guint n = (width + 1) / 2;
+  guint i = 0;
+
+#ifdef __SSE2__
+  /* 8 chroma pairs per iteration */
+  for (; i + 8 <= n; i += 8) {
+    const __m128i su = _mm_slli_epi16 (
+        _mm_loadu_si128 ((const __m128i *) (u + i)), P010_SHIFT);
+    const __m128i sv = _mm_slli_epi16 (
+        _mm_loadu_si128 ((const __m128i *) (v + i)), P010_SHIFT);
+
+    _mm_storeu_si128 ((__m128i *) (uv + 2 * i), _mm_unpacklo_epi16 (su, sv));
+    _mm_storeu_si128 ((__m128i *) (uv + 2 * i + 8),
+        _mm_unpackhi_epi16 (su, sv));
+  }
+#endif
+
+  for (; i < n; i++) {
+    uv[2 * i] = u[i] << P010_SHIFT;
+    uv[2 * i + 1] = v[i] << P010_SHIFT;
+  }
+}
+
+void
+gst_mfx_utils_p010_unpack_y (const guint16 * src, guint16 * dst, guint width)
+{
+  guint i = 0;
+
+#ifdef __SSE2__
+  for (; i + 16 <= width; i += 16) {
+    const __m128i s0 = _mm_loadu_si128 ((const __m128i *) (src + i));
+    const __m128i s1 = _mm_loadu_si128 ((const __m128i *) (src + i + 8));
+
+    _mm_storeu_si128 ((__m128i *) (dst + i), _mm_srli_epi16 (s0, P010_SHIFT));
+    _mm_storeu_si128 ((__m128i *) (dst + i + 8),
+        _mm_srli_epi16 (s1, P010_SHIFT));
+  }
+#endif
+
+  for (; i < width; i++)
+    dst[i] = src[i] >> P010_SHIFT;
+}
+
+void
+gst_mfx_utils_p010_unpack_uv (const guint16 * uv, guint16 * u, guint16 * v,
+    guint width)
+{
+  const guint n = (width + 1) / 2;
+  guint i = 0;
+
+#ifdef __SSE2__
+  const __m128i mask = _mm_set1_epi32 (0xffff);
+
+  /* 8 chroma pairs per iteration. Once shifted down the samples fit in
+   * 10 bits, so the signed saturating packs are exact */
+  for (; i + 8 <= n; i += 8) {
+    const __m128i s0 = _mm_srli_epi16 (
+        _mm_loadu_si128 ((const __m128i *) (uv + 2 * i)), P010_SHIFT);
+    const __m128i s1 = _mm_srli_epi16 (
+        _mm_loadu_si128 ((const __m128i *) (uv + 2 * i + 8)), P010_SHIFT);
+
+    _mm_storeu_si128 ((__m128i *) (u + i),
+        _mm_packs_epi32 (_mm_and_si128 (s0, mask), _mm_and_si128 (s1, mask)));
+    _mm_storeu_si128 ((__m128i *) (v + i),
+        _mm_packs_epi32 (_mm_srli_epi32 (s0, 16), _mm_srli_epi32 (s1, 16)));
+  }
+#endif
+
+  for (; i < n; i++) {
+    u[i] = uv[2 * i] >> P010_SHIFT;
+    v[i] = uv[2 * i + 1] >> P010_SHIFT;
+  }
+}
+
+/* A v210 group holds 6 pixels in 4 little-endian words:
+ *   Cb0 Y0 Cr0 | Y1 Cb1 Y2 | Cr1 Y3 Cb2 | Y4 Cr2 Y5
+ * with the first sample in the low 10 bits of each word. Rows are padded
+ * to 48 pixels, so whole groups can always be read and written */
+#define V210_SAMPLE(w, n) ((((w) >> (10 * (n))) & 0x3ff) << P010_SHIFT)
+
+void
+gst_mfx_utils_p010_from_v210 (const guint8 * src, guint16 * y,
+    guint16 * uv, guint width)
+{
+  guint16 ys[6], cs[6];
+  guint32 w0, w1, w2, w3;
+  guint i, j;
+
+  for (i = 0; i < width; i += 6, src += 16) {
+    w0 = GST_READ_UINT32_LE (src);
+    w1 = GST_READ_UINT32_LE (src + 4);
+    w2 = GST_READ_UINT32_LE (src + 8);
+    w3 = GST_READ_UINT32_LE (src + 12);
+
+    ys[0] = V210_SAMPLE (w0, 1);
+    ys[1] = V210_SAMPLE (w1, 0);
+    ys[2] = V210_SAMPLE (w1, 2);
+    ys[3] = V210_SAMPLE (w2, 1);
+    ys[4] = V210_SAMPLE (w3, 0);
+    ys[5] = V210_SAMPLE (w3, 2);
+
+    if (i + 6 <= width) {
+      memcpy (y + i, ys, sizeof (ys));
+    } else {
+      for (j = 0; i + j < width; j++)
+        y[i + j] = ys[j];
+    }
+
+    if (!uv)
+      continue;
+
+    cs[0] = V210_SAMPLE (w0, 0);
+    cs[1] = V210_SAMPLE (w0, 2);
+    cs[2] = V210_SAMPLE (w1, 1);
+    cs[3] = V210_SAMPLE (w2, 0);
+    cs[4] = V210_SAMPLE (w2, 2);
+    cs[5] = V210_SAMPLE (w3, 1);
+
+    /* One chroma pair for every two pixels, as in P010 */
+    if (i + 6 <= width) {
+      memcpy (uv + i, cs, sizeof (cs));
+    } else {
+      for (j = 0; i + j < width; j += 2) {
+        uv[i + j] = cs[j];
+        uv[i + j + 1] = cs[j + 1];
+      }
+    }
+  }
+}
+
+void
+gst_mfx_utils_p010_to_v210 (const guint16 * y, const guint16 * uv,
+    guint8 * dst, guint width)
+{
+  guint16 ys[6], cs[6];
+  guint i, j;
+
+  for (i = 0; i < width; i += 6, dst += 16) {
+    if (i + 6 <= width) {
+      for (j = 0; j < 6; j++) {
+        ys[j] = y[i + j] >> P010_SHIFT;
+        cs[j] = uv[i + j] >> P010_SHIFT;
+      }
+    } else {
+      /* Replicate the last pixel into the padding */
+      for (j = 0; j < 6; j++) {
+        const guint k = MIN (i + j, width - 1);
+
+        ys[j] = y[k] >> P010_SHIFT;
+        cs[j] = uv[(k & ~1) + (j & 1)] >> P010_SHIFT;
+      }
+    }
+
+    GST_WRITE_UINT32_LE (dst, cs[0] | (ys[0] << 10) | (cs[1] << 20));
+    GST_WRITE_UINT32_LE (dst + 4, ys[1] | (cs[2] << 10) | (ys[2] << 20));
+    GST_WRITE_UINT32_LE (dst + 8, cs[3] | (ys[3] << 10) | (cs[4] << 20));
+    GST_WRITE_UINT32_LE (dst + 12, ys[4] | (cs[5] << 10) | (ys[5] << 20));
+  }
+}
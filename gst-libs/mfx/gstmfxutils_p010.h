@@ -0,0 +1,67 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef GST_MFX_UTILS_P010_H
+#define GST_MFX_UTILS_P010_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* P010 keeps its 10-bit samples in the high bits of 16-bit words, while
+ * I420_10LE keeps them in the low bits and v210 packs three of them
+ * into each 32-bit word. All helpers below convert a single row of
+ * @width luma samples */
+
+/* Shifts a row of I420_10LE luma into P010 luma */
+void
+gst_mfx_utils_p010_pack_y (const guint16 * src, guint16 * dst, guint width);
+
+/* Interleaves a row of I420_10LE chroma planes into P010 chroma, @width
+ * being the number of luma samples */
+void
+gst_mfx_utils_p010_pack_uv (const guint16 * u, const guint16 * v,
+    guint16 * uv, guint width);
+
+/* Shifts a row of P010 luma into I420_10LE luma */
+void
+gst_mfx_utils_p010_unpack_y (const guint16 * src, guint16 * dst,
+    guint width);
+
+/* Splits a row of P010 chroma into I420_10LE chroma planes */
+void
+gst_mfx_utils_p010_unpack_uv (const guint16 * uv, guint16 * u, guint16 * v,
+    guint width);
+
+/* Unpacks a row of v210 into P010 luma and, unless @uv is %NULL, into
+ * P010 chroma. Only every other row carries chroma in 4:2:0, so callers
+ * pass %NULL for the rows whose chroma is dropped */
+void
+gst_mfx_utils_p010_from_v210 (const guint8 * src, guint16 * y,
+    guint16 * uv, guint width);
+
+/* Packs a row of P010 luma and chroma into v210, the chroma row being
+ * repeated for the two luma rows sharing it */
+void
+gst_mfx_utils_p010_to_v210 (const guint16 * y, const guint16 * uv,
+    guint8 * dst, guint width);
+
+G_END_DECLS
+
+#endif /* GST_MFX_UTILS_P010_H */
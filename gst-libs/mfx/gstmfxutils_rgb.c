@@ -0,0 +1,71 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "sysdeps.h"
+#include "gstmfxutils_rgb.h"
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+void
+gst_mfx_utils_rgb_bgra_to_planar (const guint8 * src, guint8 * r,
+    guint8 * g, guint8 * b, guint width)
+{
+  guint i = 0;
+
+#ifdef __SSE2__
+  const __m128i mask = _mm_set1_epi32 (0xff);
+
+  /* 16 pixels per iteration. Each 32-bit lane holds one pixel with blue
+   * in its low byte, so every channel is a shift and a mask away. The
+   * lanes never exceed 255, so the saturating packs are exact */
+  for (; i + 16 <= width; i += 16) {
+    const __m128i p0 = _mm_loadu_si128 ((const __m128i *) (src + 4 * i));
+    const __m128i p1 = _mm_loadu_si128 ((const __m128i *) (src + 4 * i + 16));
+    const __m128i p2 = _mm_loadu_si128 ((const __m128i *) (src + 4 * i + 32));
+    const __m128i p3 = _mm_loadu_si128 ((const __m128i *) (src + 4 * i + 48));
+    __m128i lo, hi;
+
+    lo = _mm_packs_epi32 (_mm_and_si128 (p0, mask),
+        _mm_and_si128 (p1, mask));
+    hi = _mm_packs_epi32 (_mm_and_si128 (p2, mask),
+        _mm_and_si128 (p3, mask));
+    _mm_storeu_si128 ((__m128i *) (b + i), _mm_packus_epi16 (lo, hi));
+
+    lo = _mm_packs_epi32 (_mm_and_si128 (_mm_srli_epi32 (p0, 8), mask),
+        _mm_and_si128 (_mm_srli_epi32 (p1, 8), mask));
+    hi = _mm_packs_epi32 (_mm_and_si128 (_mm_srli_epi32 (p2, 8), mask),
+        _mm_and_si128 (_mm_srli_epi32 (p3, 8), mask));
+    _mm_storeu_si128 ((__m128i *) (g + i), _mm_packus_epi16 (lo, hi));
+
+    lo = _mm_packs_epi32 (_mm_and_si128 (_mm_srli_epi32 (p0, 16), mask),
+        _mm_and_si128 (_mm_srli_epi32 (p1, 16), mask));
+    hi = _mm_packs_epi32 (_mm_and_si128 (_mm_srli_epi32 (p2, 16), mask),
+        _mm_and_si128 (_mm_srli_epi32 (p3, 16), mask));
+    _mm_storeu_si128 ((__m128i *) (r + i), _mm_packus_epi16 (lo, hi));
+  }
+#endif
+
+  for (; i < width; i++) {
+    b[i] = src[4 * i];
+    g[i] = src[4 * i + 1];
+    r[i] = src[4 * i + 2];
+  }
+}
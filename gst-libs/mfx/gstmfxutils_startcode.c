@@ -0,0 +1,88 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "sysdeps.h"
+#include "gstmfxutils_startcode.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Returns the offset of the first 0x000001xx start code in data, or -1.
+ * Candidate positions are computed 16 or 32 bytes at a time by matching
+ * the two zero bytes and the 0x01 byte with three unaligned loads, the
+ * tail of the buffer is scanned byte by byte */
+gint
+gst_mfx_utils_find_start_code (const guint8 * data, gsize size)
+{
+  gsize i = 0;
+
+#if defined(__AVX2__)
+  {
+    const __m256i zero = _mm256_setzero_si256 ();
+    const __m256i one = _mm256_set1_epi8 (1);
+    guint32 mask;
+
+    for (; i + 32 + 3 <= size; i += 32) {
+      __m256i b0 = _mm256_loadu_si256 ((const __m256i *) (data + i));
+      __m256i b1 = _mm256_loadu_si256 ((const __m256i *) (data + i + 1));
+      __m256i b2 = _mm256_loadu_si256 ((const __m256i *) (data + i + 2));
+
+      mask = _mm256_movemask_epi8 (_mm256_and_si256 (_mm256_and_si256
+              (_mm256_cmpeq_epi8 (b0, zero), _mm256_cmpeq_epi8 (b1, zero)),
+              _mm256_cmpeq_epi8 (b2, one)));
+      if (mask)
+        return i + g_bit_nth_lsf (mask, -1);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  {
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i one = _mm_set1_epi8 (1);
+    guint32 mask;
+
+    for (; i + 16 + 3 <= size; i += 16) {
+      __m128i b0 = _mm_loadu_si128 ((const __m128i *) (data + i));
+      __m128i b1 = _mm_loadu_si128 ((const __m128i *) (data + i + 1));
+      __m128i b2 = _mm_loadu_si128 ((const __m128i *) (data + i + 2));
+
+      mask = _mm_movemask_epi8 (_mm_and_si128 (_mm_and_si128
+              (_mm_cmpeq_epi8 (b0, zero), _mm_cmpeq_epi8 (b1, zero)),
+              _mm_cmpeq_epi8 (b2, one)));
+      if (mask)
+        return i + g_bit_nth_lsf (mask, -1);
+    }
+  }
+#endif
+
+  for (; i + 4 <= size; i++) {
+    /* The third byte rules out most positions without looking further */
+    if (data[i + 2] > 1) {
+      i += 2;
+      continue;
+    }
+    if (!data[i] && !data[i + 1] && data[i + 2] == 1)
+      return i;
+  }
+  return -1;
+}
@@ -34,6 +34,7 @@ struct _VaapiImage
   GstMfxMiniObject parent_instance;
   GstMfxDisplay *display;
   GstVideoFormat format;
+  GMutex map_lock;
   guchar *image_data;
   guint width;
   guint height;
@@ -55,14 +56,15 @@ vaapi_image_finalize (VaapiImage * image)
   GST_DEBUG ("image %" GST_MFX_ID_FORMAT, GST_MFX_ID_ARGS (image_id));
 
   if (image_id != VA_INVALID_ID) {
-    GST_MFX_DISPLAY_LOCK (image->display);
+    GST_MFX_DISPLAY_VA_LOCK (image->display);
     status =
         vaDestroyImage (GST_MFX_DISPLAY_VADISPLAY (image->display), image_id);
-    GST_MFX_DISPLAY_UNLOCK (image->display);
+    GST_MFX_DISPLAY_VA_UNLOCK (image->display);
     if (!vaapi_check_status (status, "vaDestroyImage ()"))
       GST_WARNING ("failed to destroy image %" GST_MFX_ID_FORMAT,
           GST_MFX_ID_ARGS (image_id));
   }
+  g_mutex_clear (&image->map_lock);
   gst_mfx_display_unref (image->display);
 }
 
@@ -78,10 +80,10 @@ vaapi_image_create (VaapiImage * image,
     .depth = 8,
   };
 
-  GST_MFX_DISPLAY_LOCK (image->display);
+  GST_MFX_DISPLAY_VA_LOCK (image->display);
   status = vaCreateImage (GST_MFX_DISPLAY_VADISPLAY (image->display),
       &va_format, width, height, &image->image);
-  GST_MFX_DISPLAY_UNLOCK (image->display);
+  GST_MFX_DISPLAY_VA_UNLOCK (image->display);
 
   if (status != VA_STATUS_SUCCESS)
     return FALSE;
@@ -132,6 +134,7 @@ vaapi_image_new (GstMfxDisplay * display, guint width, guint height,
     return NULL;
 
   image->display = gst_mfx_display_ref (display);
+  g_mutex_init (&image->map_lock);
   image->image.image_id = VA_INVALID_ID;
   image->image.buf = VA_INVALID_ID;
   if (!vaapi_image_create (image, width, height, format))
@@ -171,6 +174,7 @@ vaapi_image_new_with_image (GstMfxDisplay * display, VAImage * va_image)
     return NULL;
 
   image->display = gst_mfx_display_ref (display);
+  g_mutex_init (&image->map_lock);
   _vaapi_image_set_image (image, va_image);
   return image;
 }
@@ -323,22 +327,22 @@ _vaapi_image_is_mapped (VaapiImage * image)
 gboolean
 vaapi_image_map (VaapiImage * image)
 {
-  VAStatus status;
+  VAStatus status = VA_STATUS_SUCCESS;
 
   g_return_val_if_fail (image != NULL, FALSE);
 
-  if (_vaapi_image_is_mapped (image))
-    goto map_success;
-
-  GST_MFX_DISPLAY_LOCK (image->display);
-  status = vaMapBuffer (GST_MFX_DISPLAY_VADISPLAY (image->display),
-      image->image.buf, (void **) &image->image_data);
-  GST_MFX_DISPLAY_UNLOCK (image->display);
-  if (!vaapi_check_status (status, "vaMapBuffer ()"))
-    return FALSE;
+  /* The mapping is shared by all users of the image, so only the first
+   * of them maps the buffer */
+  g_mutex_lock (&image->map_lock);
+  if (!_vaapi_image_is_mapped (image)) {
+    GST_MFX_DISPLAY_VA_LOCK (image->display);
+    status = vaMapBuffer (GST_MFX_DISPLAY_VADISPLAY (image->display),
+        image->image.buf, (void **) &image->image_data);
+    GST_MFX_DISPLAY_VA_UNLOCK (image->display);
+  }
+  g_mutex_unlock (&image->map_lock);
 
-map_success:
-  return TRUE;
+  return vaapi_check_status (status, "vaMapBuffer ()");
 }
 
 /**
@@ -357,18 +361,21 @@ vaapi_image_unmap (VaapiImage * image)
 
   g_return_val_if_fail (image != NULL, FALSE);
 
-  if (!_vaapi_image_is_mapped (image))
+  g_mutex_lock (&image->map_lock);
+  if (!_vaapi_image_is_mapped (image)) {
+    g_mutex_unlock (&image->map_lock);
     return TRUE;
+  }
 
-  GST_MFX_DISPLAY_LOCK (image->display);
+  GST_MFX_DISPLAY_VA_LOCK (image->display);
   status = vaUnmapBuffer (GST_MFX_DISPLAY_VADISPLAY (image->display),
       image->image.buf);
-  GST_MFX_DISPLAY_UNLOCK (image->display);
-  if (!vaapi_check_status (status, "vaUnmapBuffer ()"))
-    return FALSE;
+  GST_MFX_DISPLAY_VA_UNLOCK (image->display);
+  if (vaapi_check_status (status, "vaUnmapBuffer ()"))
+    image->image_data = NULL;
+  g_mutex_unlock (&image->map_lock);
 
-  image->image_data = NULL;
-  return TRUE;
+  return status == VA_STATUS_SUCCESS;
 }
 
 /**
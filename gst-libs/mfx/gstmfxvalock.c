@@ -0,0 +1,98 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "sysdeps.h"
+#include "gstmfxvalock.h"
+
+void
+gst_mfx_va_lock_init (GstMfxVaLock * lock)
+{
+  g_return_if_fail (lock != NULL);
+
+  g_rw_lock_init (&lock->lock);
+  lock->owner = NULL;
+  lock->depth = 0;
+  lock->contention = 0;
+}
+
+void
+gst_mfx_va_lock_clear (GstMfxVaLock * lock)
+{
+  g_return_if_fail (lock != NULL);
+
+  g_rw_lock_clear (&lock->lock);
+}
+
+/**
+ * gst_mfx_va_lock_acquire:
+ * @lock: a #GstMfxVaLock
+ * @exclusive: whether the call must not overlap any other VA call
+ *
+ * Locks @lock, shared with other threads or exclusively. A thread that
+ * holds @lock exclusively may acquire it again in either mode, which
+ * lets window system code call the surface helpers. Upgrading a shared
+ * lock to an exclusive one is not possible and deadlocks.
+ */
+void
+gst_mfx_va_lock_acquire (GstMfxVaLock * lock, gboolean exclusive)
+{
+  GThread *const self = g_thread_self ();
+
+  /* Only this thread may have stored itself as the owner */
+  if (g_atomic_pointer_get (&lock->owner) == self) {
+    lock->depth++;
+    return;
+  }
+
+  if (exclusive) {
+    if (!g_rw_lock_writer_trylock (&lock->lock)) {
+      g_atomic_int_inc (&lock->contention);
+      g_rw_lock_writer_lock (&lock->lock);
+    }
+    g_atomic_pointer_set (&lock->owner, self);
+    lock->depth = 1;
+  }
+  else if (!g_rw_lock_reader_trylock (&lock->lock)) {
+    g_atomic_int_inc (&lock->contention);
+    g_rw_lock_reader_lock (&lock->lock);
+  }
+}
+
+/* Releases one gst_mfx_va_lock_acquire () of the calling thread */
+void
+gst_mfx_va_lock_release (GstMfxVaLock * lock)
+{
+  if (g_atomic_pointer_get (&lock->owner) == g_thread_self ()) {
+    if (--lock->depth > 0)
+      return;
+    g_atomic_pointer_set (&lock->owner, NULL);
+    g_rw_lock_writer_unlock (&lock->lock);
+  }
+  else
+    g_rw_lock_reader_unlock (&lock->lock);
+}
+
+/* Number of times a thread had to wait for @lock */
+guint
+gst_mfx_va_lock_get_contention (GstMfxVaLock * lock)
+{
+  g_return_val_if_fail (lock != NULL, 0);
+
+  return g_atomic_int_get (&lock->contention);
+}
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef GST_MFX_VA_LOCK_H
+#define GST_MFX_VA_LOCK_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstMfxVaLock GstMfxVaLock;
+
+/* Reader/writer lock of a display. VA calls that libva runs safely in
+ * parallel take it shared. VA calls that are not thread-safe and calls
+ * into the native window system take it exclusively. The exclusive
+ * owner may lock it again in either mode */
+struct _GstMfxVaLock
+{
+  /*< private > */
+  GRWLock lock;
+  GThread *owner;
+  guint depth;
+  volatile gint contention;
+};
+
+void
+gst_mfx_va_lock_init (GstMfxVaLock * lock);
+
+void
+gst_mfx_va_lock_clear (GstMfxVaLock * lock);
+
+void
+gst_mfx_va_lock_acquire (GstMfxVaLock * lock, gboolean exclusive);
+
+void
+gst_mfx_va_lock_release (GstMfxVaLock * lock);
+
+guint
+gst_mfx_va_lock_get_contention (GstMfxVaLock * lock);
+
+G_END_DECLS
+
+#endif /* GST_MFX_VA_LOCK_H */
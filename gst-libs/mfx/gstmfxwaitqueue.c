@@ -0,0 +1,151 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "sysdeps.h"
+#include "gstmfxwaitqueue.h"
+#include "gstmfxminiobject.h"
+
+/* A condition that threads of one session wait on until a flag, such as
+ * the queued state of a surface, is cleared by a peer element. Each
+ * session has its own, so that a surface released by one pipeline
+ * doesn't wake up the decoders of all the others */
+struct _GstMfxWaitQueue
+{
+  /*< private > */
+  GstMfxMiniObject parent_instance;
+
+  GMutex lock;
+  GCond cond;
+};
+
+static void
+gst_mfx_wait_queue_finalize (GstMfxWaitQueue * queue)
+{
+  g_cond_clear (&queue->cond);
+  g_mutex_clear (&queue->lock);
+}
+
+static inline const GstMfxMiniObjectClass *
+gst_mfx_wait_queue_class (void)
+{
+  static const GstMfxMiniObjectClass GstMfxWaitQueueClass = {
+    sizeof (GstMfxWaitQueue),
+    (GDestroyNotify) gst_mfx_wait_queue_finalize
+  };
+  return &GstMfxWaitQueueClass;
+}
+
+GstMfxWaitQueue *
+gst_mfx_wait_queue_new (void)
+{
+  GstMfxWaitQueue *queue;
+
+  queue = (GstMfxWaitQueue *)
+      gst_mfx_mini_object_new0 (gst_mfx_wait_queue_class ());
+  if (!queue)
+    return NULL;
+
+  g_mutex_init (&queue->lock);
+  g_cond_init (&queue->cond);
+  return queue;
+}
+
+GstMfxWaitQueue *
+gst_mfx_wait_queue_ref (GstMfxWaitQueue * queue)
+{
+  g_return_val_if_fail (queue != NULL, NULL);
+
+  return (GstMfxWaitQueue *)
+      gst_mfx_mini_object_ref (GST_MFX_MINI_OBJECT (queue));
+}
+
+void
+gst_mfx_wait_queue_unref (GstMfxWaitQueue * queue)
+{
+  gst_mfx_mini_object_unref (GST_MFX_MINI_OBJECT (queue));
+}
+
+void
+gst_mfx_wait_queue_replace (GstMfxWaitQueue ** old_queue_ptr,
+    GstMfxWaitQueue * new_queue)
+{
+  g_return_if_fail (old_queue_ptr != NULL);
+
+  gst_mfx_mini_object_replace ((GstMfxMiniObject **) old_queue_ptr,
+      GST_MFX_MINI_OBJECT (new_queue));
+}
+
+/**
+ * gst_mfx_wait_queue_wait:
+ * @queue: a #GstMfxWaitQueue
+ * @flag: the flag to wait for
+ * @end_time: the monotonic time to give up at
+ * @cancel: (allow-none): a flag that aborts the wait when set
+ *
+ * Blocks until @flag is cleared with gst_mfx_wait_queue_clear_flag (),
+ * @end_time is reached or @cancel is set. Whoever sets @cancel has to
+ * call gst_mfx_wait_queue_wake () afterwards.
+ *
+ * Return value: %TRUE if @flag was cleared
+ */
+gboolean
+gst_mfx_wait_queue_wait (GstMfxWaitQueue * queue, volatile guint * flag,
+    gint64 end_time, volatile gint * cancel)
+{
+  gboolean set;
+
+  g_return_val_if_fail (queue != NULL, TRUE);
+  g_return_val_if_fail (flag != NULL, TRUE);
+
+  g_mutex_lock (&queue->lock);
+  while ((set = g_atomic_int_get (flag))
+      && !(cancel && g_atomic_int_get (cancel)))
+    if (!g_cond_wait_until (&queue->cond, &queue->lock, end_time)) {
+      set = g_atomic_int_get (flag);
+      break;
+    }
+  g_mutex_unlock (&queue->lock);
+
+  return !set;
+}
+
+/* Clears @flag and wakes up the threads waiting on it */
+void
+gst_mfx_wait_queue_clear_flag (GstMfxWaitQueue * queue,
+    volatile guint * flag)
+{
+  g_return_if_fail (queue != NULL);
+  g_return_if_fail (flag != NULL);
+
+  g_mutex_lock (&queue->lock);
+  g_atomic_int_set (flag, 0);
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->lock);
+}
+
+/* Wakes up the waiting threads so that they check their cancel flag */
+void
+gst_mfx_wait_queue_wake (GstMfxWaitQueue * queue)
+{
+  g_return_if_fail (queue != NULL);
+
+  g_mutex_lock (&queue->lock);
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->lock);
+}
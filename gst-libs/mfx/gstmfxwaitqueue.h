@@ -0,0 +1,58 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef GST_MFX_WAIT_QUEUE_H
+#define GST_MFX_WAIT_QUEUE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define GST_MFX_WAIT_QUEUE(obj) \
+  ((GstMfxWaitQueue *)(obj))
+
+typedef struct _GstMfxWaitQueue GstMfxWaitQueue;
+
+GstMfxWaitQueue *
+gst_mfx_wait_queue_new (void);
+
+GstMfxWaitQueue *
+gst_mfx_wait_queue_ref (GstMfxWaitQueue * queue);
+
+void
+gst_mfx_wait_queue_unref (GstMfxWaitQueue * queue);
+
+void
+gst_mfx_wait_queue_replace (GstMfxWaitQueue ** old_queue_ptr,
+    GstMfxWaitQueue * new_queue);
+
+gboolean
+gst_mfx_wait_queue_wait (GstMfxWaitQueue * queue, volatile guint * flag,
+    gint64 end_time, volatile gint * cancel);
+
+void
+gst_mfx_wait_queue_clear_flag (GstMfxWaitQueue * queue,
+    volatile guint * flag);
+
+void
+gst_mfx_wait_queue_wake (GstMfxWaitQueue * queue);
+
+G_END_DECLS
+
+#endif /* GST_MFX_WAIT_QUEUE_H */
@@ -0,0 +1,148 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "sysdeps.h"
+#include "gstmfxwindow_null.h"
+#include "gstmfxwindow_priv.h"
+#include "gstmfxdisplay_priv.h"
+#include "gstmfxsurface.h"
+#include "gstmfxutils_vaapi.h"
+
+#define DEBUG 1
+#include "gstmfxdebug.h"
+
+/**
+ * GstMfxWindowNull:
+ *
+ * A window that is never presented. Rendering waits for the surface
+ * to be ready on the GPU, so that sink timings still account for the
+ * work that a real presentation would have to wait for.
+ */
+typedef struct _GstMfxWindowNull GstMfxWindowNull;
+typedef struct _GstMfxWindowNullClass GstMfxWindowNullClass;
+
+struct _GstMfxWindowNull
+{
+  /*< private > */
+  GstMfxWindow parent_instance;
+};
+
+struct _GstMfxWindowNullClass
+{
+  /*< private > */
+  GstMfxWindowClass parent_class;
+};
+
+static gboolean
+gst_mfx_window_null_create (GstMfxWindow * window,
+    guint * width, guint * height)
+{
+  GST_DEBUG ("create null window, size %ux%u", *width, *height);
+  return TRUE;
+}
+
+static gboolean
+gst_mfx_window_null_show (GstMfxWindow * window)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_mfx_window_null_hide (GstMfxWindow * window)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_mfx_window_null_resize (GstMfxWindow * window, guint width, guint height)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_mfx_window_null_render (GstMfxWindow * window,
+    GstMfxSurface * surface,
+    const GstMfxRectangle * src_rect, const GstMfxRectangle * dst_rect)
+{
+  GstMfxDisplay *const display = GST_MFX_WINDOW_DISPLAY (window);
+  VADisplay va_display = GST_MFX_DISPLAY_VADISPLAY (display);
+  VAStatus status;
+
+  if (!gst_mfx_surface_has_video_memory (surface) || !va_display)
+    return TRUE;
+
+  GST_MFX_DISPLAY_VA_LOCK (display);
+  status = vaSyncSurface (va_display, GST_MFX_SURFACE_ID (surface));
+  GST_MFX_DISPLAY_VA_UNLOCK (display);
+  if (!vaapi_check_status (status, "vaSyncSurface()"))
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gst_mfx_window_null_class_init (GstMfxWindowNullClass * klass)
+{
+  GstMfxMiniObjectClass *const object_class = GST_MFX_MINI_OBJECT_CLASS (klass);
+  GstMfxWindowClass *const window_class = GST_MFX_WINDOW_CLASS (klass);
+
+  gst_mfx_window_class_init (&klass->parent_class);
+
+  object_class->size = sizeof (GstMfxWindowNull);
+  window_class->create = gst_mfx_window_null_create;
+  window_class->show = gst_mfx_window_null_show;
+  window_class->hide = gst_mfx_window_null_hide;
+  window_class->resize = gst_mfx_window_null_resize;
+  window_class->render = gst_mfx_window_null_render;
+}
+
+static inline const GstMfxWindowClass *
+gst_mfx_window_null_class (void)
+{
+  static GstMfxWindowNullClass g_class;
+  static gsize g_class_init = FALSE;
+
+  if (g_once_init_enter (&g_class_init)) {
+    gst_mfx_window_null_class_init (&g_class);
+    g_once_init_leave (&g_class_init, TRUE);
+  }
+  return GST_MFX_WINDOW_CLASS (&g_class);
+}
+
+/**
+ * gst_mfx_window_null_new:
+ * @display: a #GstMfxDisplay
+ * @width: the requested window width, in pixels
+ * @height: the requested window height, in pixels
+ *
+ * Creates a headless window with the specified @width and @height.
+ * Surfaces rendered into it are synchronized but never displayed.
+ *
+ * Return value: the newly allocated #GstMfxWindow object
+ */
+GstMfxWindow *
+gst_mfx_window_null_new (GstMfxDisplay * display, guint width, guint height)
+{
+  GST_DEBUG ("new null window, size %ux%u", width, height);
+
+  g_return_val_if_fail (display != NULL, NULL);
+
+  return gst_mfx_window_new_internal (gst_mfx_window_null_class (),
+      display, GST_MFX_ID_INVALID, width, height);
+}
@@ -46,6 +46,15 @@ GstMfxFormatMap format_map[] = {
       VA_FOURCC_ARGB, VA_RT_FORMAT_RGB32},
   {GST_VIDEO_FORMAT_BGRx, MFX_FOURCC_RGB4,
       VA_FOURCC_ARGB, VA_RT_FORMAT_RGB32},
+#if GST_CHECK_VERSION(1,10,0)
+  {GST_VIDEO_FORMAT_P010_10LE, MFX_FOURCC_P010,
+      VA_FOURCC_P010, VA_RT_FORMAT_YUV420_10BPP},
+  /* Other 10-bit layouts are repacked into P010 surfaces on upload */
+  {GST_VIDEO_FORMAT_I420_10LE, MFX_FOURCC_P010,
+      VA_FOURCC_P010, VA_RT_FORMAT_YUV420_10BPP},
+  {GST_VIDEO_FORMAT_v210, MFX_FOURCC_P010,
+      VA_FOURCC_P010, VA_RT_FORMAT_YUV420_10BPP},
+#endif
   {0,}
 };
 
@@ -132,3 +141,27 @@ gst_mfx_video_format_to_va_format (mfxU32 fourcc)
   }
   return 0;
 }
+
+guint
+gst_mfx_video_format_get_bit_depth (mfxU32 fourcc)
+{
+  return MFX_FOURCC_P010 == fourcc ? 10 : 8;
+}
+
+/* P010 of GStreamer and VA keeps its samples in the upper 10 bits */
+guint
+gst_mfx_video_format_get_shift (mfxU32 fourcc)
+{
+  return MFX_FOURCC_P010 == fourcc;
+}
+
+gboolean
+gst_mfx_video_format_is_repacked (GstVideoFormat format)
+{
+#if GST_CHECK_VERSION(1,10,0)
+  return GST_VIDEO_FORMAT_I420_10LE == format
+      || GST_VIDEO_FORMAT_v210 == format;
+#else
+  return FALSE;
+#endif
+}
@@ -53,6 +53,15 @@ gst_mfx_video_format_to_va_fourcc (mfxU32 fourcc);
 guint
 gst_mfx_video_format_to_va_format (mfxU32 fourcc);
 
+guint
+gst_mfx_video_format_get_bit_depth (mfxU32 fourcc);
+
+guint
+gst_mfx_video_format_get_shift (mfxU32 fourcc);
+
+gboolean
+gst_mfx_video_format_is_repacked (GstVideoFormat format);
+
 G_END_DECLS
 
 #endif /* GST_MFX_VIDEO_FORMAT_H */
@@ -26,6 +26,9 @@
 #ifdef MFX_VPP
 # include "gstmfxpostproc.h"
 #endif
+#ifdef MFX_COMPOSITOR
+# include "gstmfxcompositor.h"
+#endif
 #ifdef MFX_SINK
 # include "gstmfxsink.h"
 #endif
@@ -44,6 +47,12 @@
 #ifdef MFX_JPEG_ENCODER
 # include "gstmfxenc_jpeg.h"
 #endif
+#ifdef MFX_ABR_ENCODER
+# include "gstmfxabrenc.h"
+#endif
+#ifdef MFX_GOP_TRANSCODER
+# include "gstmfxgoptranscode.h"
+#endif
 
 #ifdef MFX_VC1_PARSER
 # include "parsers/gstvc1parse.h"
@@ -63,6 +72,11 @@ plugin_init (GstPlugin * plugin)
       GST_RANK_NONE, GST_TYPE_MFXPOSTPROC);
 #endif
 
+#ifdef MFX_COMPOSITOR
+  ret |= gst_element_register (plugin, "mfxcompositor",
+      GST_RANK_NONE, GST_TYPE_MFXCOMPOSITOR);
+#endif
+
 #ifdef MFX_SINK
   ret |= gst_element_register (plugin, "mfxsinkelement",
       GST_RANK_NONE, GST_TYPE_MFXSINK);
@@ -93,6 +107,16 @@ plugin_init (GstPlugin * plugin)
       GST_RANK_NONE, GST_TYPE_MFXENC_JPEG);
 #endif
 
+#ifdef MFX_ABR_ENCODER
+  ret |= gst_element_register (plugin, "mfxabrenc",
+      GST_RANK_NONE, GST_TYPE_MFXABRENC);
+#endif
+
+#ifdef MFX_GOP_TRANSCODER
+  ret |= gst_element_register (plugin, "mfxgoptranscode",
+      GST_RANK_NONE, GST_TYPE_MFXGOPTRANSCODE);
+#endif
+
 #ifdef MFX_VC1_PARSER
   ret |= gst_element_register (plugin, "mfxvc1parse",
       GST_RANK_MARGINAL, GST_MFX_TYPE_VC1_PARSE);
@@ -0,0 +1,1112 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "gst-libs/mfx/sysdeps.h"
+#include <gst/video/video.h>
+
+#include "gstmfxabrenc.h"
+#include "gstmfxpluginutil.h"
+#include "gstmfxvideometa.h"
+
+#ifdef MFX_H264_ENCODER
+# include <gst-libs/mfx/gstmfxencoder_h264.h>
+#endif
+#ifdef MFX_H265_ENCODER
+# include <gst-libs/mfx/gstmfxencoder_h265.h>
+#endif
+#ifdef MFX_MPEG2_ENCODER
+# include <gst-libs/mfx/gstmfxencoder_mpeg2.h>
+#endif
+
+#define GST_PLUGIN_NAME "mfxabrenc"
+#define GST_PLUGIN_DESC "A MFX-based multi-rendition video encoder"
+
+GST_DEBUG_CATEGORY_STATIC (gst_debug_mfxabrenc);
+#define GST_CAT_DEFAULT gst_debug_mfxabrenc
+
+/* Each "src_%u" pad produces one rendition of the input with its own
+ * size, codec and bitrate. All renditions are scaled by their own VPP
+ * straight from the input surfaces, and the encoder of a rendition shares
+ * the VPP task, so every session ends up joined to the one of the
+ * upstream decoder. The renditions of a frame are processed concurrently
+ * and the input surface is released once they are all done with it. */
+
+/* Default templates */
+static const char gst_mfxabrenc_sink_caps_str[] =
+    GST_MFX_MAKE_SURFACE_CAPS "; "
+    GST_MFX_MAKE_DMABUF_CAPS "; "
+    GST_VIDEO_CAPS_MAKE (GST_MFX_SUPPORTED_8BIT_INPUT_FORMATS);
+
+static const char gst_mfxabrenc_src_caps_str[] =
+    "video/x-h264, "
+    "stream-format = (string) byte-stream, alignment = (string) au; "
+    "video/x-h265, "
+    "stream-format = (string) byte-stream, alignment = (string) au; "
+    "video/mpeg, mpegversion = (int) 2, systemstream = (boolean) false";
+
+static GstStaticPadTemplate gst_mfxabrenc_sink_factory =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (gst_mfxabrenc_sink_caps_str));
+
+static GstStaticPadTemplate gst_mfxabrenc_src_factory =
+GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (gst_mfxabrenc_src_caps_str));
+
+GType
+gst_mfxabrenc_codec_get_type (void)
+{
+  static volatile gsize g_type = 0;
+
+  static const GEnumValue codec_values[] = {
+    {GST_MFXABRENC_CODEC_H264,
+        "H.264", "h264"},
+    {GST_MFXABRENC_CODEC_H265,
+        "H.265", "h265"},
+    {GST_MFXABRENC_CODEC_MPEG2,
+        "MPEG-2", "mpeg2"},
+    {0, NULL, NULL},
+  };
+
+  if (g_once_init_enter (&g_type)) {
+    GType type =
+        g_enum_register_static ("GstMfxAbrEncCodec", codec_values);
+    g_once_init_leave (&g_type, type);
+  }
+  return g_type;
+}
+
+/* ------------------------------------------------------------------------ */
+/* --- Source pad                                                       --- */
+/* ------------------------------------------------------------------------ */
+
+enum
+{
+  PROP_PAD_0,
+
+  PROP_PAD_CODEC,
+  PROP_PAD_WIDTH,
+  PROP_PAD_HEIGHT,
+  PROP_PAD_BITRATE,
+  PROP_PAD_RATE_CONTROL,
+  PROP_PAD_GOP_SIZE,
+};
+
+#define DEFAULT_PAD_CODEC               GST_MFXABRENC_CODEC_H264
+#define DEFAULT_PAD_WIDTH               0
+#define DEFAULT_PAD_HEIGHT              0
+#define DEFAULT_PAD_BITRATE             0
+#define DEFAULT_PAD_RATE_CONTROL        GST_MFX_RATECONTROL_VBR
+#define DEFAULT_PAD_GOP_SIZE            0
+
+G_DEFINE_TYPE (GstMfxAbrEncPad, gst_mfxabrenc_pad, GST_TYPE_PAD);
+
+static void
+gst_mfxabrenc_pad_reset (GstMfxAbrEncPad * pad)
+{
+  /* The encoder shares the VPP task, release it first */
+  gst_mfx_encoder_replace (&pad->encoder, NULL);
+  gst_mfx_filter_replace (&pad->filter, NULL);
+  gst_video_info_init (&pad->info);
+  pad->surface = NULL;
+  pad->flow_ret = GST_FLOW_OK;
+}
+
+static void
+gst_mfxabrenc_pad_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+  GstMfxAbrEncPad *const pad = GST_MFXABRENC_PAD (object);
+
+  GST_OBJECT_LOCK (pad);
+  switch (prop_id) {
+    case PROP_PAD_CODEC:
+      pad->codec = g_value_get_enum (value);
+      break;
+    case PROP_PAD_WIDTH:
+      pad->width = g_value_get_uint (value);
+      break;
+    case PROP_PAD_HEIGHT:
+      pad->height = g_value_get_uint (value);
+      break;
+    case PROP_PAD_BITRATE:
+      pad->bitrate = g_value_get_uint (value);
+      break;
+    case PROP_PAD_RATE_CONTROL:
+      pad->rate_control = g_value_get_enum (value);
+      break;
+    case PROP_PAD_GOP_SIZE:
+      pad->gop_size = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_mfxabrenc_pad_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  GstMfxAbrEncPad *const pad = GST_MFXABRENC_PAD (object);
+
+  GST_OBJECT_LOCK (pad);
+  switch (prop_id) {
+    case PROP_PAD_CODEC:
+      g_value_set_enum (value, pad->codec);
+      break;
+    case PROP_PAD_WIDTH:
+      g_value_set_uint (value, pad->width);
+      break;
+    case PROP_PAD_HEIGHT:
+      g_value_set_uint (value, pad->height);
+      break;
+    case PROP_PAD_BITRATE:
+      g_value_set_uint (value, pad->bitrate);
+      break;
+    case PROP_PAD_RATE_CONTROL:
+      g_value_set_enum (value, pad->rate_control);
+      break;
+    case PROP_PAD_GOP_SIZE:
+      g_value_set_uint (value, pad->gop_size);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_mfxabrenc_pad_finalize (GObject * object)
+{
+  gst_mfxabrenc_pad_reset (GST_MFXABRENC_PAD (object));
+  G_OBJECT_CLASS (gst_mfxabrenc_pad_parent_class)->finalize (object);
+}
+
+static void
+gst_mfxabrenc_pad_class_init (GstMfxAbrEncPadClass * klass)
+{
+  GObjectClass *const object_class = G_OBJECT_CLASS (klass);
+
+  object_class->set_property = gst_mfxabrenc_pad_set_property;
+  object_class->get_property = gst_mfxabrenc_pad_get_property;
+  object_class->finalize = gst_mfxabrenc_pad_finalize;
+
+  /**
+   * GstMfxAbrEncPad:codec
+   *
+   * The codec of the rendition. Rendition settings are applied when
+   * the input caps are set.
+   */
+  g_object_class_install_property (object_class, PROP_PAD_CODEC,
+      g_param_spec_enum ("codec", "Codec",
+          "Codec of the rendition", GST_TYPE_MFXABRENC_CODEC,
+          DEFAULT_PAD_CODEC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMfxAbrEncPad:width
+   *
+   * The width of the rendition. If set to zero, it is derived from the
+   * height and the input aspect ratio, or the input width is used.
+   */
+  g_object_class_install_property (object_class, PROP_PAD_WIDTH,
+      g_param_spec_uint ("width", "Width",
+          "Width of the rendition",
+          0, G_MAXUINT16, DEFAULT_PAD_WIDTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMfxAbrEncPad:height
+   *
+   * The height of the rendition. If set to zero, it is derived from the
+   * width and the input aspect ratio, or the input height is used.
+   */
+  g_object_class_install_property (object_class, PROP_PAD_HEIGHT,
+      g_param_spec_uint ("height", "Height",
+          "Height of the rendition",
+          0, G_MAXUINT16, DEFAULT_PAD_HEIGHT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PAD_BITRATE,
+      g_param_spec_uint ("bitrate", "Bitrate (kbps)",
+          "The desired bitrate expressed in kbps (0: auto-calculate)",
+          0, G_MAXUINT16, DEFAULT_PAD_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PAD_RATE_CONTROL,
+      g_param_spec_enum ("rate-control", "Rate control",
+          "Rate control mode", GST_MFX_TYPE_RATE_CONTROL,
+          DEFAULT_PAD_RATE_CONTROL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PAD_GOP_SIZE,
+      g_param_spec_uint ("gop-size", "GOP size",
+          "Number of pictures within the current GOP (0: auto-calculate)",
+          0, G_MAXUINT16, DEFAULT_PAD_GOP_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_mfxabrenc_pad_init (GstMfxAbrEncPad * pad)
+{
+  pad->codec = DEFAULT_PAD_CODEC;
+  pad->width = DEFAULT_PAD_WIDTH;
+  pad->height = DEFAULT_PAD_HEIGHT;
+  pad->bitrate = DEFAULT_PAD_BITRATE;
+  pad->rate_control = DEFAULT_PAD_RATE_CONTROL;
+  pad->gop_size = DEFAULT_PAD_GOP_SIZE;
+  gst_video_info_init (&pad->info);
+  pad->flow_ret = GST_FLOW_OK;
+}
+
+static GstCaps *
+gst_mfxabrenc_pad_get_caps (GstMfxAbrEncPad * pad, GstMfxAbrEncCodec codec)
+{
+  const GstVideoInfo *const info = &pad->info;
+  GstCaps *caps;
+
+  switch (codec) {
+    case GST_MFXABRENC_CODEC_H264:
+      caps = gst_caps_new_simple ("video/x-h264",
+          "stream-format", G_TYPE_STRING, "byte-stream",
+          "alignment", G_TYPE_STRING, "au", NULL);
+      break;
+    case GST_MFXABRENC_CODEC_H265:
+      caps = gst_caps_new_simple ("video/x-h265",
+          "stream-format", G_TYPE_STRING, "byte-stream",
+          "alignment", G_TYPE_STRING, "au", NULL);
+      break;
+    case GST_MFXABRENC_CODEC_MPEG2:
+      caps = gst_caps_new_simple ("video/mpeg",
+          "mpegversion", G_TYPE_INT, 2,
+          "systemstream", G_TYPE_BOOLEAN, FALSE, NULL);
+      break;
+    default:
+      return NULL;
+  }
+
+  gst_caps_set_simple (caps,
+      "width", G_TYPE_INT, GST_VIDEO_INFO_WIDTH (info),
+      "height", G_TYPE_INT, GST_VIDEO_INFO_HEIGHT (info),
+      "framerate", GST_TYPE_FRACTION, GST_VIDEO_INFO_FPS_N (info),
+      GST_VIDEO_INFO_FPS_D (info),
+      "pixel-aspect-ratio", GST_TYPE_FRACTION, GST_VIDEO_INFO_PAR_N (info),
+      GST_VIDEO_INFO_PAR_D (info), NULL);
+  return caps;
+}
+
+static GstMfxEncoder *
+gst_mfxabrenc_pad_create_encoder (GstMfxAbrEncPad * pad,
+    GstMfxTaskAggregator * aggregator, GstMfxAbrEncCodec codec)
+{
+  switch (codec) {
+#ifdef MFX_H264_ENCODER
+    case GST_MFXABRENC_CODEC_H264:
+      return gst_mfx_encoder_h264_new (aggregator, &pad->info, FALSE);
+#endif
+#ifdef MFX_H265_ENCODER
+    case GST_MFXABRENC_CODEC_H265:
+      return gst_mfx_encoder_h265_new (aggregator, &pad->info, FALSE);
+#endif
+#ifdef MFX_MPEG2_ENCODER
+    case GST_MFXABRENC_CODEC_MPEG2:
+      return gst_mfx_encoder_mpeg2_new (aggregator, &pad->info, FALSE);
+#endif
+    default:
+      GST_ERROR_OBJECT (pad, "codec %d is not supported in this build", codec);
+      return NULL;
+  }
+}
+
+static gboolean
+set_encoder_uint (GstMfxEncoder * encoder, GstMfxEncoderProp prop_id,
+    guint v)
+{
+  GValue value = G_VALUE_INIT;
+  GstMfxEncoderStatus status;
+
+  g_value_init (&value, G_TYPE_UINT);
+  g_value_set_uint (&value, v);
+  status = gst_mfx_encoder_set_property (encoder, prop_id, &value);
+  g_value_unset (&value);
+
+  return status == GST_MFX_ENCODER_STATUS_SUCCESS;
+}
+
+static gboolean
+set_encoder_rate_control (GstMfxEncoder * encoder,
+    GstMfxRateControl rate_control)
+{
+  GValue value = G_VALUE_INIT;
+  GstMfxEncoderStatus status;
+
+  g_value_init (&value, GST_MFX_TYPE_RATE_CONTROL);
+  g_value_set_enum (&value, rate_control);
+  status = gst_mfx_encoder_set_property (encoder,
+      GST_MFX_ENCODER_PROP_RATECONTROL, &value);
+  g_value_unset (&value);
+
+  return status == GST_MFX_ENCODER_STATUS_SUCCESS;
+}
+
+typedef struct
+{
+  GstPad *pad;
+  GstCaps *caps;
+} StickyEventData;
+
+/* Returns @event as it should be pushed on the rendition @pad. Each
+ * rendition is a stream of its own, so its stream-start carries a stream-id
+ * derived from the upstream one and the pad name */
+static GstEvent *
+make_rendition_event (GstPad * pad, GstEvent * event)
+{
+  const gchar *upstream_id;
+  GstStreamFlags flags;
+  GstEvent *new_event;
+  gchar *stream_id;
+  guint group_id;
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_STREAM_START)
+    return gst_event_ref (event);
+
+  gst_event_parse_stream_start (event, &upstream_id);
+  stream_id = g_strdup_printf ("%s/%s", upstream_id, GST_PAD_NAME (pad));
+  new_event = gst_event_new_stream_start (stream_id);
+  g_free (stream_id);
+
+  gst_event_parse_stream_flags (event, &flags);
+  gst_event_set_stream_flags (new_event, flags);
+  if (gst_event_parse_group_id (event, &group_id))
+    gst_event_set_group_id (new_event, group_id);
+
+  return new_event;
+}
+
+/* Replays the sticky events of the sink pad on a newly configured
+ * rendition, with the input caps replaced by the encoded ones */
+static gboolean
+push_sticky_event (GstPad * sinkpad, GstEvent ** event, gpointer user_data)
+{
+  StickyEventData *const data = user_data;
+
+  switch (GST_EVENT_TYPE (*event)) {
+    case GST_EVENT_CAPS:
+      gst_pad_push_event (data->pad, gst_event_new_caps (data->caps));
+      break;
+    case GST_EVENT_EOS:
+      break;
+    default:
+      gst_pad_push_event (data->pad, make_rendition_event (data->pad, *event));
+      break;
+  }
+  return TRUE;
+}
+
+/* ------------------------------------------------------------------------ */
+/* --- Encoder                                                          --- */
+/* ------------------------------------------------------------------------ */
+
+G_DEFINE_TYPE_WITH_CODE (GstMfxAbrEnc,
+    gst_mfxabrenc,
+    GST_TYPE_ELEMENT,
+    GST_MFX_PLUGIN_BASE_INIT_INTERFACES);
+
+/* Called with the sink pad stream lock held */
+static gboolean
+gst_mfxabrenc_configure_rendition (GstMfxAbrEnc * abrenc,
+    GstMfxAbrEncPad * pad)
+{
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (abrenc);
+  const GstVideoInfo *const in_info = &plugin->sinkpad_info;
+  GstVideoCodecState state = { 0, };
+  StickyEventData data;
+  GstMfxEncoderStatus status;
+  GstMfxAbrEncCodec codec;
+  GstMfxRateControl rate_control;
+  guint width, height, bitrate, gop_size;
+  GstCaps *caps;
+
+  GST_OBJECT_LOCK (pad);
+  codec = pad->codec;
+  width = pad->width;
+  height = pad->height;
+  bitrate = pad->bitrate;
+  rate_control = pad->rate_control;
+  gop_size = pad->gop_size;
+  GST_OBJECT_UNLOCK (pad);
+
+  /* Keep the input aspect ratio when only one dimension is given */
+  if (!width && !height) {
+    width = GST_VIDEO_INFO_WIDTH (in_info);
+    height = GST_VIDEO_INFO_HEIGHT (in_info);
+  } else if (!height) {
+    height = GST_ROUND_UP_2 (gst_util_uint64_scale_int (width,
+            GST_VIDEO_INFO_HEIGHT (in_info), GST_VIDEO_INFO_WIDTH (in_info)));
+  } else if (!width) {
+    width = GST_ROUND_UP_2 (gst_util_uint64_scale_int (height,
+            GST_VIDEO_INFO_WIDTH (in_info), GST_VIDEO_INFO_HEIGHT (in_info)));
+  }
+
+  gst_video_info_set_format (&pad->info, GST_VIDEO_FORMAT_NV12, width, height);
+  GST_VIDEO_INFO_FPS_N (&pad->info) = GST_VIDEO_INFO_FPS_N (in_info);
+  GST_VIDEO_INFO_FPS_D (&pad->info) = GST_VIDEO_INFO_FPS_D (in_info);
+  GST_VIDEO_INFO_PAR_N (&pad->info) = GST_VIDEO_INFO_PAR_N (in_info);
+  GST_VIDEO_INFO_PAR_D (&pad->info) = GST_VIDEO_INFO_PAR_D (in_info);
+
+  pad->filter = gst_mfx_filter_new (plugin->aggregator,
+      abrenc->upstream_is_system, FALSE);
+  if (!pad->filter)
+    goto error_create_filter;
+
+  gst_mfx_filter_set_frame_info_from_gst_video_info (pad->filter, in_info);
+  gst_mfx_filter_set_size (pad->filter, width, height);
+  if (GST_VIDEO_INFO_FORMAT (in_info) != GST_VIDEO_FORMAT_NV12)
+    gst_mfx_filter_set_format (pad->filter, MFX_FOURCC_NV12);
+  if (!gst_mfx_filter_prepare (pad->filter))
+    goto error_create_filter;
+
+  /* The VPP task of this rendition is now the current one, so the encoder
+   * shares it and encodes the VPP output surfaces in place */
+  pad->encoder = gst_mfxabrenc_pad_create_encoder (pad, plugin->aggregator,
+      codec);
+  if (!pad->encoder)
+    goto error_create_encoder;
+
+  if (!set_encoder_rate_control (pad->encoder, rate_control)
+      || !set_encoder_uint (pad->encoder, GST_MFX_ENCODER_PROP_BITRATE,
+          bitrate)
+      || !set_encoder_uint (pad->encoder, GST_MFX_ENCODER_PROP_GOP_SIZE,
+          gop_size))
+    goto error_create_encoder;
+
+  state.info = pad->info;
+  status = gst_mfx_encoder_set_codec_state (pad->encoder, &state);
+  if (status != GST_MFX_ENCODER_STATUS_SUCCESS)
+    goto error_create_encoder;
+
+  status = gst_mfx_encoder_start (pad->encoder);
+  if (status != GST_MFX_ENCODER_STATUS_SUCCESS)
+    goto error_create_encoder;
+
+  caps = gst_mfxabrenc_pad_get_caps (pad, codec);
+  if (!caps)
+    goto error_create_encoder;
+
+  GST_INFO_OBJECT (pad, "encoding %ux%u at %u kbps with caps %" GST_PTR_FORMAT,
+      width, height, bitrate, caps);
+
+  data.pad = GST_PAD (pad);
+  data.caps = caps;
+  gst_pad_sticky_events_foreach (plugin->sinkpad, push_sticky_event, &data);
+  gst_caps_unref (caps);
+
+  return TRUE;
+  /* ERRORS */
+error_create_filter:
+  {
+    GST_ERROR_OBJECT (pad, "failed to create VPP for %ux%u rendition",
+        width, height);
+    gst_mfxabrenc_pad_reset (pad);
+    return FALSE;
+  }
+error_create_encoder:
+  {
+    GST_ERROR_OBJECT (pad, "failed to create encoder for %ux%u rendition",
+        width, height);
+    gst_mfxabrenc_pad_reset (pad);
+    return FALSE;
+  }
+}
+
+static GstFlowReturn
+gst_mfxabrenc_push_frame (GstMfxAbrEncPad * pad, GstVideoCodecFrame * frame)
+{
+  GstBuffer *outbuf;
+
+  /* The output buffer wraps the bitstream of the encoder, which is
+   * overwritten by the next frame while downstream may still hold it */
+  outbuf = gst_buffer_copy_deep (frame->output_buffer);
+  gst_buffer_replace (&frame->output_buffer, NULL);
+  if (!outbuf)
+    return GST_FLOW_ERROR;
+
+  GST_BUFFER_PTS (outbuf) = frame->pts;
+  GST_BUFFER_DTS (outbuf) = frame->dts;
+  GST_BUFFER_DURATION (outbuf) = frame->duration;
+  if (!GST_VIDEO_CODEC_FRAME_IS_SYNC_POINT (frame))
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  GST_LOG_OBJECT (pad, "output:%" GST_TIME_FORMAT ", size:%" G_GSIZE_FORMAT,
+      GST_TIME_ARGS (frame->pts), gst_buffer_get_size (outbuf));
+
+  return gst_pad_push (GST_PAD (pad), outbuf);
+}
+
+static GstFlowReturn
+gst_mfxabrenc_encode_rendition (GstMfxAbrEncPad * pad)
+{
+  GstVideoCodecFrame frame = { 0, };
+  GstMfxSurface *out_surface;
+  GstMfxFilterStatus filter_status;
+  GstMfxEncoderStatus status;
+
+  filter_status = gst_mfx_filter_process (pad->filter, pad->surface,
+      &out_surface);
+  if (GST_MFX_FILTER_STATUS_ERROR_MORE_DATA == filter_status)
+    return GST_FLOW_OK;
+  if (GST_MFX_FILTER_STATUS_SUCCESS != filter_status)
+    goto error_process_vpp;
+
+  frame.ref_count = 1;
+  frame.pts = pad->pts;
+  gst_video_codec_frame_set_user_data (&frame, out_surface, NULL);
+
+  status = gst_mfx_encoder_encode (pad->encoder, &frame);
+  if (status < GST_MFX_ENCODER_STATUS_SUCCESS)
+    goto error_encode_frame;
+  else if (status > 0)
+    return GST_FLOW_OK;
+
+  return gst_mfxabrenc_push_frame (pad, &frame);
+  /* ERRORS */
+error_process_vpp:
+  {
+    GST_ERROR_OBJECT (pad, "failed to scale frame (status %d)",
+        filter_status);
+    return GST_FLOW_ERROR;
+  }
+error_encode_frame:
+  {
+    GST_ERROR_OBJECT (pad, "failed to encode frame (status %d)", status);
+    return GST_FLOW_ERROR;
+  }
+}
+
+static void
+gst_mfxabrenc_worker (gpointer data, gpointer user_data)
+{
+  GstMfxAbrEncPad *const pad = data;
+  GstMfxAbrEnc *const abrenc = user_data;
+
+  pad->flow_ret = gst_mfxabrenc_encode_rendition (pad);
+
+  g_mutex_lock (&abrenc->lock);
+  if (--abrenc->pending == 0)
+    g_cond_signal (&abrenc->cond);
+  g_mutex_unlock (&abrenc->lock);
+}
+
+static GstFlowReturn
+gst_mfxabrenc_drain (GstMfxAbrEnc * abrenc)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstMfxEncoderStatus status;
+  GstVideoCodecFrame *frame;
+  GList *pads, *l;
+
+  GST_OBJECT_LOCK (abrenc);
+  pads = g_list_copy_deep (abrenc->srcpads, (GCopyFunc) gst_object_ref, NULL);
+  GST_OBJECT_UNLOCK (abrenc);
+
+  for (l = pads; l; l = l->next) {
+    GstMfxAbrEncPad *const pad = l->data;
+    GstFlowReturn flow_ret = GST_FLOW_OK;
+
+    if (!pad->encoder)
+      continue;
+
+    do {
+      frame = NULL;
+      status = gst_mfx_encoder_flush (pad->encoder, &frame);
+      if (GST_MFX_ENCODER_STATUS_SUCCESS != status || !frame)
+        break;
+      flow_ret = gst_mfxabrenc_push_frame (pad, frame);
+      g_slice_free (GstVideoCodecFrame, frame);
+    } while (GST_FLOW_OK == flow_ret);
+
+    ret = gst_flow_combiner_update_pad_flow (abrenc->flow_combiner,
+        GST_PAD (pad), flow_ret);
+  }
+
+  g_list_free_full (pads, gst_object_unref);
+  return ret;
+}
+
+static void
+gst_mfxabrenc_reset_renditions (GstMfxAbrEnc * abrenc)
+{
+  GList *l;
+
+  GST_OBJECT_LOCK (abrenc);
+  for (l = abrenc->srcpads; l; l = l->next)
+    gst_mfxabrenc_pad_reset (GST_MFXABRENC_PAD (l->data));
+  GST_OBJECT_UNLOCK (abrenc);
+}
+
+static GstFlowReturn
+gst_mfxabrenc_chain (GstPad * sinkpad, GstObject * parent, GstBuffer * inbuf)
+{
+  GstMfxAbrEnc *const abrenc = GST_MFXABRENC (parent);
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (abrenc);
+  GstMfxVideoMeta *meta;
+  GstMfxSurface *surface;
+  GstFlowReturn ret;
+  GstBuffer *buf = NULL;
+  GList *pads, *l;
+  guint num_pads;
+
+  if (!plugin->sinkpad_caps)
+    goto error_not_negotiated;
+
+  ret = gst_mfx_plugin_base_get_input_buffer (plugin, inbuf, &buf);
+  gst_buffer_unref (inbuf);
+  if (GST_FLOW_OK != ret)
+    return ret;
+
+  meta = gst_buffer_get_mfx_video_meta (buf);
+  surface = meta ? gst_mfx_video_meta_get_surface (meta) : NULL;
+  if (!surface)
+    goto error_no_surface;
+
+  GST_OBJECT_LOCK (abrenc);
+  pads = g_list_copy_deep (abrenc->srcpads, (GCopyFunc) gst_object_ref, NULL);
+  GST_OBJECT_UNLOCK (abrenc);
+
+  /* Renditions are set up one after the other, so that each encoder
+   * picks up the VPP task that was created right before it */
+  num_pads = 0;
+  for (l = pads; l; l = l->next) {
+    GstMfxAbrEncPad *const pad = l->data;
+
+    if (!pad->encoder && !gst_mfxabrenc_configure_rendition (abrenc, pad))
+      goto error_configure;
+
+    pad->surface = surface;
+    pad->pts = GST_BUFFER_PTS (buf);
+    pad->flow_ret = GST_FLOW_OK;
+    num_pads++;
+  }
+
+  if (num_pads == 1) {
+    gst_mfxabrenc_worker (pads->data, abrenc);
+  } else if (num_pads > 1) {
+    g_mutex_lock (&abrenc->lock);
+    abrenc->pending = num_pads;
+    g_mutex_unlock (&abrenc->lock);
+
+    for (l = pads; l; l = l->next)
+      g_thread_pool_push (abrenc->workers, l->data, NULL);
+
+    g_mutex_lock (&abrenc->lock);
+    while (abrenc->pending > 0)
+      g_cond_wait (&abrenc->cond, &abrenc->lock);
+    g_mutex_unlock (&abrenc->lock);
+  }
+
+  ret = GST_FLOW_OK;
+  for (l = pads; l; l = l->next) {
+    GstMfxAbrEncPad *const pad = l->data;
+
+    pad->surface = NULL;
+    ret = gst_flow_combiner_update_pad_flow (abrenc->flow_combiner,
+        GST_PAD (pad), pad->flow_ret);
+  }
+
+  /* All renditions are done with the input surface */
+  gst_mfx_surface_dequeue (surface);
+
+  g_list_free_full (pads, gst_object_unref);
+  gst_buffer_unref (buf);
+  return ret;
+  /* ERRORS */
+error_not_negotiated:
+  {
+    GST_ERROR_OBJECT (abrenc, "input caps were not set");
+    gst_buffer_unref (inbuf);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+error_no_surface:
+  {
+    GST_ERROR_OBJECT (abrenc, "failed to get MFX surface from input buffer");
+    gst_buffer_unref (buf);
+    return GST_FLOW_ERROR;
+  }
+error_configure:
+  {
+    GST_ELEMENT_ERROR (abrenc, STREAM, FORMAT, (NULL),
+        ("failed to configure rendition"));
+    g_list_free_full (pads, gst_object_unref);
+    gst_buffer_unref (buf);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+}
+
+static gboolean
+gst_mfxabrenc_set_caps (GstMfxAbrEnc * abrenc, GstCaps * caps)
+{
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (abrenc);
+  GstMfxTask *task;
+
+  /* Renditions are reconfigured on the next frame */
+  gst_mfxabrenc_reset_renditions (abrenc);
+
+  if (!gst_mfx_plugin_base_set_caps (plugin, caps, NULL))
+    return FALSE;
+
+  abrenc->upstream_is_system = plugin->sinkpad_caps_is_raw;
+  if (!abrenc->upstream_is_system) {
+    task = gst_mfx_task_aggregator_get_current_task (plugin->aggregator);
+    if (task) {
+      abrenc->upstream_is_system = !gst_mfx_task_has_video_memory (task);
+      gst_mfx_task_unref (task);
+    }
+  }
+  return TRUE;
+}
+
+static gboolean
+gst_mfxabrenc_sink_event (GstPad * sinkpad, GstObject * parent,
+    GstEvent * event)
+{
+  GstMfxAbrEnc *const abrenc = GST_MFXABRENC (parent);
+  gboolean ret;
+  GList *pads, *l;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:{
+      GstCaps *caps;
+
+      gst_event_parse_caps (event, &caps);
+      ret = gst_mfxabrenc_set_caps (abrenc, caps);
+      gst_event_unref (event);
+      break;
+    }
+    case GST_EVENT_EOS:{
+      GstFlowReturn flow_ret;
+
+      /* Downstream still gets EOS, but a failed drain fails the event */
+      flow_ret = gst_mfxabrenc_drain (abrenc);
+      if (flow_ret != GST_FLOW_OK && flow_ret != GST_FLOW_EOS)
+        GST_ERROR_OBJECT (abrenc, "failed to drain renditions (%s)",
+            gst_flow_get_name (flow_ret));
+      ret = gst_pad_event_default (sinkpad, parent, event);
+      if (flow_ret != GST_FLOW_OK && flow_ret != GST_FLOW_EOS)
+        ret = FALSE;
+      break;
+    }
+    case GST_EVENT_FLUSH_STOP:
+      /* Frames still queued in the encoders belong to the old position,
+       * drop them and configure the renditions again on the next frame */
+      gst_mfxabrenc_reset_renditions (abrenc);
+      gst_flow_combiner_reset (abrenc->flow_combiner);
+      ret = gst_pad_event_default (sinkpad, parent, event);
+      break;
+    default:
+      if (!GST_EVENT_IS_STICKY (event)) {
+        ret = gst_pad_event_default (sinkpad, parent, event);
+        break;
+      }
+
+      /* Renditions that are not configured yet get the sticky events
+       * after their caps, once they are set up */
+      GST_OBJECT_LOCK (abrenc);
+      pads = g_list_copy_deep (abrenc->srcpads, (GCopyFunc) gst_object_ref,
+          NULL);
+      GST_OBJECT_UNLOCK (abrenc);
+
+      for (l = pads; l; l = l->next) {
+        GstMfxAbrEncPad *const pad = l->data;
+
+        if (pad->encoder)
+          gst_pad_push_event (GST_PAD (pad),
+              make_rendition_event (GST_PAD (pad), event));
+      }
+      g_list_free_full (pads, gst_object_unref);
+      gst_event_unref (event);
+      ret = TRUE;
+      break;
+  }
+  return ret;
+}
+
+static gboolean
+gst_mfxabrenc_sink_query (GstPad * sinkpad, GstObject * parent,
+    GstQuery * query)
+{
+  GstMfxAbrEnc *const abrenc = GST_MFXABRENC (parent);
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (abrenc);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+      if (gst_mfx_handle_context_query (query,
+              GST_MFX_PLUGIN_BASE_AGGREGATOR (abrenc))) {
+        GST_DEBUG_OBJECT (abrenc, "sharing tasks %p",
+            GST_MFX_PLUGIN_BASE_AGGREGATOR (abrenc));
+        return TRUE;
+      }
+      break;
+    case GST_QUERY_ALLOCATION:
+      return gst_mfx_plugin_base_propose_allocation (plugin, query);
+    /* Renditions are scaled and encoded here, so the input caps don't
+     * depend on what downstream accepts */
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *caps, *tmp;
+
+      gst_query_parse_caps (query, &filter);
+      caps = gst_pad_get_pad_template_caps (sinkpad);
+      if (filter) {
+        tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    }
+    default:
+      break;
+  }
+
+  return gst_pad_query_default (sinkpad, parent, query);
+}
+
+static gboolean
+gst_mfxabrenc_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstMfxAbrEnc *const abrenc = GST_MFXABRENC (parent);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+      if (gst_mfx_handle_context_query (query,
+              GST_MFX_PLUGIN_BASE_AGGREGATOR (abrenc))) {
+        GST_DEBUG_OBJECT (abrenc, "sharing tasks %p",
+            GST_MFX_PLUGIN_BASE_AGGREGATOR (abrenc));
+        return TRUE;
+      }
+      break;
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *caps, *tmp;
+
+      gst_query_parse_caps (query, &filter);
+      caps = gst_pad_get_current_caps (pad);
+      if (!caps)
+        caps = gst_pad_get_pad_template_caps (pad);
+      if (filter) {
+        tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    }
+    default:
+      break;
+  }
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+static GstPad *
+gst_mfxabrenc_request_new_pad (GstElement * element, GstPadTemplate * templ,
+    const gchar * name, const GstCaps * caps)
+{
+  GstMfxAbrEnc *const abrenc = GST_MFXABRENC (element);
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (abrenc);
+  GstPad *pad;
+  gchar *pad_name;
+  guint id;
+
+  GST_OBJECT_LOCK (abrenc);
+  if (name && sscanf (name, "src_%u", &id) == 1) {
+    if (id >= abrenc->next_pad_id)
+      abrenc->next_pad_id = id + 1;
+  } else {
+    id = abrenc->next_pad_id++;
+  }
+  GST_OBJECT_UNLOCK (abrenc);
+
+  pad_name = g_strdup_printf ("src_%u", id);
+  pad = g_object_new (GST_TYPE_MFXABRENC_PAD, "name", pad_name,
+      "direction", GST_PAD_SRC, "template", templ, NULL);
+  g_free (pad_name);
+
+  gst_pad_set_query_function (pad, GST_DEBUG_FUNCPTR (gst_mfxabrenc_src_query));
+  gst_pad_use_fixed_caps (pad);
+
+  GST_PAD_STREAM_LOCK (plugin->sinkpad);
+  GST_OBJECT_LOCK (abrenc);
+  abrenc->srcpads = g_list_append (abrenc->srcpads, pad);
+  GST_OBJECT_UNLOCK (abrenc);
+  gst_flow_combiner_add_pad (abrenc->flow_combiner, pad);
+  GST_PAD_STREAM_UNLOCK (plugin->sinkpad);
+
+  if (!gst_element_add_pad (element, pad))
+    goto error_add_pad;
+
+  return pad;
+  /* ERRORS */
+error_add_pad:
+  {
+    GST_ERROR_OBJECT (abrenc, "failed to add pad %s", GST_PAD_NAME (pad));
+    GST_PAD_STREAM_LOCK (plugin->sinkpad);
+    GST_OBJECT_LOCK (abrenc);
+    abrenc->srcpads = g_list_remove (abrenc->srcpads, pad);
+    GST_OBJECT_UNLOCK (abrenc);
+    gst_flow_combiner_remove_pad (abrenc->flow_combiner, pad);
+    GST_PAD_STREAM_UNLOCK (plugin->sinkpad);
+    gst_object_unref (pad);
+    return NULL;
+  }
+}
+
+static void
+gst_mfxabrenc_release_pad (GstElement * element, GstPad * pad)
+{
+  GstMfxAbrEnc *const abrenc = GST_MFXABRENC (element);
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (abrenc);
+
+  /* Wait for the rendition to be done with the current frame */
+  GST_PAD_STREAM_LOCK (plugin->sinkpad);
+  GST_OBJECT_LOCK (abrenc);
+  abrenc->srcpads = g_list_remove (abrenc->srcpads, pad);
+  GST_OBJECT_UNLOCK (abrenc);
+  gst_flow_combiner_remove_pad (abrenc->flow_combiner, pad);
+  gst_mfxabrenc_pad_reset (GST_MFXABRENC_PAD (pad));
+  GST_PAD_STREAM_UNLOCK (plugin->sinkpad);
+
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+}
+
+static GstStateChangeReturn
+gst_mfxabrenc_change_state (GstElement * element, GstStateChange transition)
+{
+  GstMfxAbrEnc *const abrenc = GST_MFXABRENC (element);
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (abrenc);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_mfx_plugin_base_ensure_aggregator (plugin))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      abrenc->workers = g_thread_pool_new (gst_mfxabrenc_worker, abrenc,
+          -1, FALSE, NULL);
+      if (!abrenc->workers)
+        return GST_STATE_CHANGE_FAILURE;
+      gst_flow_combiner_reset (abrenc->flow_combiner);
+      break;
+    default:
+      break;
+  }
+
+  ret =
+      GST_ELEMENT_CLASS (gst_mfxabrenc_parent_class)->change_state (element,
+      transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_mfxabrenc_reset_renditions (abrenc);
+      if (abrenc->workers) {
+        g_thread_pool_free (abrenc->workers, FALSE, TRUE);
+        abrenc->workers = NULL;
+      }
+      break;
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_mfx_plugin_base_close (plugin);
+      break;
+    default:
+      break;
+  }
+  return ret;
+}
+
+static void
+gst_mfxabrenc_finalize (GObject * object)
+{
+  GstMfxAbrEnc *const abrenc = GST_MFXABRENC (object);
+
+  g_list_free (abrenc->srcpads);
+  gst_flow_combiner_free (abrenc->flow_combiner);
+  g_mutex_clear (&abrenc->lock);
+  g_cond_clear (&abrenc->cond);
+
+  gst_mfx_plugin_base_finalize (GST_MFX_PLUGIN_BASE (abrenc));
+  G_OBJECT_CLASS (gst_mfxabrenc_parent_class)->finalize (object);
+}
+
+static void
+gst_mfxabrenc_class_init (GstMfxAbrEncClass * klass)
+{
+  GObjectClass *const object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *const element_class = GST_ELEMENT_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (gst_debug_mfxabrenc,
+      GST_PLUGIN_NAME, 0, GST_PLUGIN_DESC);
+
+  gst_mfx_plugin_base_class_init (GST_MFX_PLUGIN_BASE_CLASS (klass));
+
+  object_class->finalize = gst_mfxabrenc_finalize;
+  element_class->change_state = GST_DEBUG_FUNCPTR (gst_mfxabrenc_change_state);
+  element_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_mfxabrenc_request_new_pad);
+  element_class->release_pad = GST_DEBUG_FUNCPTR (gst_mfxabrenc_release_pad);
+
+  gst_element_class_set_static_metadata (element_class,
+      "MFX multi-rendition encoder",
+      "Codec/Encoder/Video",
+      GST_PLUGIN_DESC, "Ishmael Sameen <ishmael.visayana.sameen@intel.com>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_mfxabrenc_sink_factory));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_mfxabrenc_src_factory));
+}
+
+static void
+gst_mfxabrenc_init (GstMfxAbrEnc * abrenc)
+{
+  GstPad *sinkpad;
+
+  sinkpad =
+      gst_pad_new_from_static_template (&gst_mfxabrenc_sink_factory, "sink");
+  gst_pad_set_chain_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_mfxabrenc_chain));
+  gst_pad_set_event_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_mfxabrenc_sink_event));
+  gst_pad_set_query_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_mfxabrenc_sink_query));
+  gst_element_add_pad (GST_ELEMENT (abrenc), sinkpad);
+
+  gst_mfx_plugin_base_init (GST_MFX_PLUGIN_BASE (abrenc), GST_CAT_DEFAULT);
+
+  abrenc->flow_combiner = gst_flow_combiner_new ();
+  g_mutex_init (&abrenc->lock);
+  g_cond_init (&abrenc->cond);
+}
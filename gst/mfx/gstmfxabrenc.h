@@ -0,0 +1,130 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef GST_MFXABRENC_H
+#define GST_MFXABRENC_H
+
+#include "gstmfxpluginbase.h"
+
+#include <gst/base/gstflowcombiner.h>
+#include <gst-libs/mfx/gstmfxfilter.h>
+#include <gst-libs/mfx/gstmfxencoder.h>
+#include <gst-libs/mfx/gstmfxvalue.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_MFXABRENC \
+  (gst_mfxabrenc_get_type ())
+#define GST_MFXABRENC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_MFXABRENC, GstMfxAbrEnc))
+#define GST_MFXABRENC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_MFXABRENC, GstMfxAbrEncClass))
+#define GST_IS_MFXABRENC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_MFXABRENC))
+#define GST_IS_MFXABRENC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_MFXABRENC))
+
+#define GST_TYPE_MFXABRENC_PAD \
+  (gst_mfxabrenc_pad_get_type ())
+#define GST_MFXABRENC_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_MFXABRENC_PAD, \
+  GstMfxAbrEncPad))
+#define GST_IS_MFXABRENC_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_MFXABRENC_PAD))
+
+#define GST_TYPE_MFXABRENC_CODEC \
+  (gst_mfxabrenc_codec_get_type ())
+
+typedef struct _GstMfxAbrEnc GstMfxAbrEnc;
+typedef struct _GstMfxAbrEncClass GstMfxAbrEncClass;
+typedef struct _GstMfxAbrEncPad GstMfxAbrEncPad;
+typedef struct _GstMfxAbrEncPadClass GstMfxAbrEncPadClass;
+
+typedef enum
+{
+  GST_MFXABRENC_CODEC_H264 = 0,
+  GST_MFXABRENC_CODEC_H265,
+  GST_MFXABRENC_CODEC_MPEG2,
+} GstMfxAbrEncCodec;
+
+struct _GstMfxAbrEncPad
+{
+  /*< private >*/
+  GstPad                  parent_instance;
+
+  /* Rendition settings, protected by the object lock */
+  GstMfxAbrEncCodec       codec;
+  guint                   width;
+  guint                   height;
+  guint                   bitrate;
+  GstMfxRateControl       rate_control;
+  guint                   gop_size;
+
+  /* Streaming state, protected by the sink pad stream lock */
+  GstMfxFilter           *filter;
+  GstMfxEncoder          *encoder;
+  GstVideoInfo            info;
+  GstMfxSurface          *surface;
+  GstClockTime            pts;
+  GstFlowReturn           flow_ret;
+};
+
+struct _GstMfxAbrEncPadClass
+{
+  /*< private >*/
+  GstPadClass parent_class;
+};
+
+struct _GstMfxAbrEnc
+{
+  /*< private >*/
+  GstMfxPluginBase        parent_instance;
+
+  /* List of GstMfxAbrEncPad, protected by the object lock */
+  GList                  *srcpads;
+  guint                   next_pad_id;
+
+  GstFlowCombiner        *flow_combiner;
+  gboolean                upstream_is_system;
+
+  /* Per-frame rendition workers */
+  GThreadPool            *workers;
+  GMutex                  lock;
+  GCond                   cond;
+  guint                   pending;
+};
+
+struct _GstMfxAbrEncClass
+{
+  /*< private >*/
+  GstMfxPluginBaseClass parent_class;
+};
+
+GType
+gst_mfxabrenc_get_type (void);
+
+GType
+gst_mfxabrenc_pad_get_type (void);
+
+GType
+gst_mfxabrenc_codec_get_type (void);
+
+G_END_DECLS
+
+#endif /* GST_MFXABRENC_H */
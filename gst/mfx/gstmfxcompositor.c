@@ -0,0 +1,666 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "gst-libs/mfx/sysdeps.h"
+#include <gst/video/video.h>
+
+#include "gstmfxcompositor.h"
+#include "gstmfxpluginutil.h"
+#include "gstmfxvideometa.h"
+
+#define GST_PLUGIN_NAME "mfxcompositor"
+#define GST_PLUGIN_DESC "A video compositor for MFX surfaces"
+
+GST_DEBUG_CATEGORY_STATIC (gst_debug_mfxcompositor);
+#define GST_CAT_DEFAULT gst_debug_mfxcompositor
+
+/* Inputs are placed in the output frame with the "xpos", "ypos", "width"
+ * and "height" pad properties, and stacked by "zorder". They must all be
+ * MFX surfaces of the same memory type, so raw video has to go through
+ * mfxvpp first. Synchronization of live inputs and latency reporting are
+ * left to the aggregator base class, the composition itself adds no
+ * latency since each output frame is synced before being pushed. */
+
+/* Default templates */
+static const char gst_mfxcompositor_sink_caps_str[] =
+    GST_MFX_MAKE_SURFACE_CAPS;
+
+static const char gst_mfxcompositor_src_caps_str[] =
+    GST_MFX_MAKE_SURFACE_CAPS "; "
+    GST_VIDEO_CAPS_MAKE ("{ NV12, BGRA }");
+
+static GstStaticPadTemplate gst_mfxcompositor_sink_factory =
+GST_STATIC_PAD_TEMPLATE ("sink_%u",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (gst_mfxcompositor_sink_caps_str));
+
+static GstStaticPadTemplate gst_mfxcompositor_src_factory =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (gst_mfxcompositor_src_caps_str));
+
+/* ------------------------------------------------------------------------ */
+/* --- Sink pad                                                         --- */
+/* ------------------------------------------------------------------------ */
+
+enum
+{
+  PROP_PAD_0,
+
+  PROP_PAD_XPOS,
+  PROP_PAD_YPOS,
+  PROP_PAD_WIDTH,
+  PROP_PAD_HEIGHT,
+  PROP_PAD_ALPHA,
+};
+
+#define DEFAULT_PAD_XPOS                0
+#define DEFAULT_PAD_YPOS                0
+#define DEFAULT_PAD_WIDTH               0
+#define DEFAULT_PAD_HEIGHT              0
+#define DEFAULT_PAD_ALPHA               1.0
+
+G_DEFINE_TYPE (GstMfxCompositorPad, gst_mfxcompositor_pad,
+    GST_TYPE_VIDEO_AGGREGATOR_PAD);
+
+static void
+gst_mfxcompositor_pad_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+  GstMfxCompositorPad *const pad = GST_MFXCOMPOSITOR_PAD (object);
+
+  GST_OBJECT_LOCK (pad);
+  switch (prop_id) {
+    case PROP_PAD_XPOS:
+      pad->xpos = g_value_get_uint (value);
+      break;
+    case PROP_PAD_YPOS:
+      pad->ypos = g_value_get_uint (value);
+      break;
+    case PROP_PAD_WIDTH:
+      pad->width = g_value_get_uint (value);
+      break;
+    case PROP_PAD_HEIGHT:
+      pad->height = g_value_get_uint (value);
+      break;
+    case PROP_PAD_ALPHA:
+      pad->alpha = g_value_get_double (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_mfxcompositor_pad_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  GstMfxCompositorPad *const pad = GST_MFXCOMPOSITOR_PAD (object);
+
+  GST_OBJECT_LOCK (pad);
+  switch (prop_id) {
+    case PROP_PAD_XPOS:
+      g_value_set_uint (value, pad->xpos);
+      break;
+    case PROP_PAD_YPOS:
+      g_value_set_uint (value, pad->ypos);
+      break;
+    case PROP_PAD_WIDTH:
+      g_value_set_uint (value, pad->width);
+      break;
+    case PROP_PAD_HEIGHT:
+      g_value_set_uint (value, pad->height);
+      break;
+    case PROP_PAD_ALPHA:
+      g_value_set_double (value, pad->alpha);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (pad);
+}
+
+/* Input buffers hold MFX surfaces that are handed over to the VPP as is,
+ * so don't let the base class map them into system memory */
+static gboolean
+gst_mfxcompositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
+    GstVideoAggregator * vagg, GstBuffer * buffer,
+    GstVideoFrame * prepared_frame)
+{
+  return TRUE;
+}
+
+static void
+gst_mfxcompositor_pad_clean_frame (GstVideoAggregatorPad * pad,
+    GstVideoAggregator * vagg, GstVideoFrame * prepared_frame)
+{
+}
+
+/* Input sizes are part of the VPP configuration */
+static void
+gst_mfxcompositor_pad_update_conversion_info (GstVideoAggregatorPad * pad)
+{
+  GstMfxCompositor *const comp =
+      GST_MFXCOMPOSITOR (gst_pad_get_parent_element (GST_PAD (pad)));
+
+  if (!comp)
+    return;
+
+  g_atomic_int_set (&comp->reset_filter, TRUE);
+  gst_object_unref (comp);
+}
+
+static void
+gst_mfxcompositor_pad_class_init (GstMfxCompositorPadClass * klass)
+{
+  GObjectClass *const object_class = G_OBJECT_CLASS (klass);
+  GstVideoAggregatorPadClass *const vpad_class =
+      GST_VIDEO_AGGREGATOR_PAD_CLASS (klass);
+
+  object_class->set_property = gst_mfxcompositor_pad_set_property;
+  object_class->get_property = gst_mfxcompositor_pad_get_property;
+  vpad_class->prepare_frame = gst_mfxcompositor_pad_prepare_frame;
+  vpad_class->clean_frame = gst_mfxcompositor_pad_clean_frame;
+  vpad_class->update_conversion_info =
+      gst_mfxcompositor_pad_update_conversion_info;
+
+  g_object_class_install_property (object_class, PROP_PAD_XPOS,
+      g_param_spec_uint ("xpos", "X Position",
+          "X position of the picture in the output frame",
+          0, G_MAXUINT16, DEFAULT_PAD_XPOS,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PAD_YPOS,
+      g_param_spec_uint ("ypos", "Y Position",
+          "Y position of the picture in the output frame",
+          0, G_MAXUINT16, DEFAULT_PAD_YPOS,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMfxCompositorPad:width
+   *
+   * The width of the picture in the output frame. If set to zero, the
+   * input width is used.
+   */
+  g_object_class_install_property (object_class, PROP_PAD_WIDTH,
+      g_param_spec_uint ("width", "Width",
+          "Width of the picture in the output frame",
+          0, G_MAXUINT16, DEFAULT_PAD_WIDTH,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMfxCompositorPad:height
+   *
+   * The height of the picture in the output frame. If set to zero, the
+   * input height is used.
+   */
+  g_object_class_install_property (object_class, PROP_PAD_HEIGHT,
+      g_param_spec_uint ("height", "Height",
+          "Height of the picture in the output frame",
+          0, G_MAXUINT16, DEFAULT_PAD_HEIGHT,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PAD_ALPHA,
+      g_param_spec_double ("alpha", "Alpha",
+          "Alpha of the picture", 0.0, 1.0, DEFAULT_PAD_ALPHA,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE |
+          G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_mfxcompositor_pad_init (GstMfxCompositorPad * pad)
+{
+  pad->xpos = DEFAULT_PAD_XPOS;
+  pad->ypos = DEFAULT_PAD_YPOS;
+  pad->width = DEFAULT_PAD_WIDTH;
+  pad->height = DEFAULT_PAD_HEIGHT;
+  pad->alpha = DEFAULT_PAD_ALPHA;
+}
+
+/* Computes where the pad picture lands in a frame of @out_width and
+ * @out_height, returns FALSE if it is entirely outside of it */
+static gboolean
+get_pad_rect (GstMfxCompositorPad * pad, guint out_width, guint out_height,
+    GstMfxRectangle * rect)
+{
+  GstVideoInfo *const info = &GST_VIDEO_AGGREGATOR_PAD (pad)->info;
+
+  GST_OBJECT_LOCK (pad);
+  rect->x = pad->xpos;
+  rect->y = pad->ypos;
+  rect->width = pad->width ? pad->width : GST_VIDEO_INFO_WIDTH (info);
+  rect->height = pad->height ? pad->height : GST_VIDEO_INFO_HEIGHT (info);
+  GST_OBJECT_UNLOCK (pad);
+
+  if (rect->x >= out_width || rect->y >= out_height)
+    return FALSE;
+
+  rect->width = MIN (rect->width, out_width - rect->x);
+  rect->height = MIN (rect->height, out_height - rect->y);
+
+  return rect->width > 0 && rect->height > 0;
+}
+
+/* ------------------------------------------------------------------------ */
+/* --- Compositor                                                       --- */
+/* ------------------------------------------------------------------------ */
+
+G_DEFINE_TYPE_WITH_CODE (GstMfxCompositor,
+    gst_mfxcompositor,
+    GST_TYPE_VIDEO_AGGREGATOR,
+    GST_MFX_PLUGIN_BASE_INIT_INTERFACES);
+
+static gboolean
+gst_mfxcompositor_ensure_filter (GstMfxCompositor * comp,
+    GstMfxSurface * base_surface)
+{
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (comp);
+  GstVideoAggregator *const vagg = GST_VIDEO_AGGREGATOR (comp);
+
+  if (g_atomic_int_compare_and_exchange (&comp->reset_filter, TRUE, FALSE))
+    gst_mfx_composite_filter_replace (&comp->filter, NULL);
+
+  if (comp->filter)
+    return TRUE;
+
+  if (!plugin->aggregator && !gst_mfx_plugin_base_ensure_aggregator (plugin))
+    return FALSE;
+
+  comp->filter = gst_mfx_composite_filter_new (plugin->aggregator,
+      !gst_mfx_surface_has_video_memory (base_surface));
+  if (!comp->filter)
+    return FALSE;
+
+  if (!gst_mfx_composite_filter_set_output_info (comp->filter, &vagg->info)) {
+    gst_mfx_composite_filter_replace (&comp->filter, NULL);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_mfxcompositor_aggregate_frames (GstVideoAggregator * vagg,
+    GstBuffer * outbuf)
+{
+  GstMfxCompositor *const comp = GST_MFXCOMPOSITOR (vagg);
+  GstMfxSurfaceComposition *composition = NULL;
+  GstMfxSurface *surface, *out_surface;
+  GstMfxVideoMeta *meta;
+  GstMfxRectangle rect;
+  GPtrArray *surfaces;
+  GstBuffer *buffer;
+  GList *l;
+  gdouble alpha;
+  guint i;
+
+  surfaces = g_ptr_array_new ();
+
+  /* Sink pads are sorted by increasing zorder, so the lowest one is the
+   * base of the composition and the others are stacked on top of it */
+  GST_OBJECT_LOCK (vagg);
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    GstMfxCompositorPad *const pad = GST_MFXCOMPOSITOR_PAD (l->data);
+
+    buffer = gst_video_aggregator_pad_get_current_buffer (
+        GST_VIDEO_AGGREGATOR_PAD (pad));
+    if (!buffer)
+      continue;
+
+    GST_OBJECT_LOCK (pad);
+    alpha = pad->alpha;
+    GST_OBJECT_UNLOCK (pad);
+    if (alpha == 0.0)
+      continue;
+
+    if (!get_pad_rect (pad, GST_VIDEO_INFO_WIDTH (&vagg->info),
+            GST_VIDEO_INFO_HEIGHT (&vagg->info), &rect))
+      continue;
+
+    meta = gst_buffer_get_mfx_video_meta (buffer);
+    surface = meta ? gst_mfx_video_meta_get_surface (meta) : NULL;
+    if (!surface) {
+      GST_WARNING_OBJECT (pad, "input buffer has no MFX surface");
+      continue;
+    }
+
+    if (!composition)
+      composition =
+          gst_mfx_surface_composition_new_with_base_rect (surface, &rect,
+          alpha);
+    else if (!gst_mfx_surface_composition_add_surface (composition,
+            surface, &rect, alpha))
+      goto error_add_surface;
+    if (!composition)
+      goto error_create_composition;
+
+    g_ptr_array_add (surfaces, surface);
+  }
+  GST_OBJECT_UNLOCK (vagg);
+
+  if (!composition) {
+    GST_LOG_OBJECT (comp, "nothing to compose");
+    g_ptr_array_free (surfaces, TRUE);
+    return GST_AGGREGATOR_FLOW_NEED_DATA;
+  }
+
+  if (!gst_mfxcompositor_ensure_filter (comp,
+          gst_mfx_surface_composition_get_base_surface (composition)))
+    goto error_create_filter;
+
+  if (!gst_mfx_composite_filter_apply_composition (comp->filter,
+          composition, &out_surface))
+    goto error_apply_composition;
+
+  meta = gst_buffer_get_mfx_video_meta (outbuf);
+  if (!meta)
+    goto error_create_meta;
+  gst_mfx_video_meta_set_surface (meta, out_surface);
+
+  for (i = 0; i < surfaces->len; i++)
+    gst_mfx_surface_dequeue (g_ptr_array_index (surfaces, i));
+
+#if GST_CHECK_VERSION(1,8,0)
+  gst_mfx_plugin_base_export_dma_buffer (GST_MFX_PLUGIN_BASE (comp), outbuf);
+#endif // GST_CHECK_VERSION
+
+  gst_mfx_surface_composition_unref (composition);
+  g_ptr_array_free (surfaces, TRUE);
+  return GST_FLOW_OK;
+  /* ERRORS */
+error_add_surface:
+  {
+    GST_OBJECT_UNLOCK (vagg);
+    GST_ELEMENT_ERROR (comp, STREAM, FORMAT, (NULL),
+        ("all inputs must use the same memory type"));
+    gst_mfx_surface_composition_unref (composition);
+    g_ptr_array_free (surfaces, TRUE);
+    return GST_FLOW_ERROR;
+  }
+error_create_composition:
+  {
+    GST_OBJECT_UNLOCK (vagg);
+    GST_ERROR_OBJECT (comp, "failed to create surface composition");
+    g_ptr_array_free (surfaces, TRUE);
+    return GST_FLOW_ERROR;
+  }
+error_create_filter:
+  {
+    GST_ERROR_OBJECT (comp, "failed to create composite filter");
+    gst_mfx_surface_composition_unref (composition);
+    g_ptr_array_free (surfaces, TRUE);
+    return GST_FLOW_ERROR;
+  }
+error_apply_composition:
+  {
+    GST_ERROR_OBJECT (comp, "failed to apply composition");
+    gst_mfx_surface_composition_unref (composition);
+    g_ptr_array_free (surfaces, TRUE);
+    return GST_FLOW_ERROR;
+  }
+error_create_meta:
+  {
+    GST_ERROR_OBJECT (comp, "output buffer has no MFX video meta");
+    gst_mfx_surface_composition_unref (composition);
+    g_ptr_array_free (surfaces, TRUE);
+    return GST_FLOW_ERROR;
+  }
+}
+
+/* The output size covers all the inputs at their configured position */
+static GstCaps *
+gst_mfxcompositor_fixate_src_caps (GstAggregator * agg, GstCaps * caps)
+{
+  GstVideoAggregator *const vagg = GST_VIDEO_AGGREGATOR (agg);
+  GstStructure *s;
+  gint best_width = 0, best_height = 0;
+  gint best_fps_n = 0, best_fps_d = 1;
+  gdouble best_fps = 0.0;
+  GList *l;
+
+  caps = gst_caps_make_writable (caps);
+
+  GST_OBJECT_LOCK (vagg);
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *const vpad = l->data;
+    GstMfxCompositorPad *const pad = GST_MFXCOMPOSITOR_PAD (vpad);
+    gint fps_n, fps_d, width, height;
+    gdouble fps;
+
+    if (!GST_VIDEO_INFO_WIDTH (&vpad->info))
+      continue;
+
+    GST_OBJECT_LOCK (pad);
+    width = pad->xpos +
+        (pad->width ? pad->width : GST_VIDEO_INFO_WIDTH (&vpad->info));
+    height = pad->ypos +
+        (pad->height ? pad->height : GST_VIDEO_INFO_HEIGHT (&vpad->info));
+    GST_OBJECT_UNLOCK (pad);
+
+    best_width = MAX (best_width, width);
+    best_height = MAX (best_height, height);
+
+    fps_n = GST_VIDEO_INFO_FPS_N (&vpad->info);
+    fps_d = GST_VIDEO_INFO_FPS_D (&vpad->info);
+    if (fps_n == 0)
+      continue;
+    gst_util_fraction_to_double (fps_n, fps_d, &fps);
+    if (fps > best_fps) {
+      best_fps = fps;
+      best_fps_n = fps_n;
+      best_fps_d = fps_d;
+    }
+  }
+  GST_OBJECT_UNLOCK (vagg);
+
+  if (best_fps_n <= 0 || best_fps_d <= 0 || best_fps == 0.0) {
+    best_fps_n = 25;
+    best_fps_d = 1;
+  }
+
+  s = gst_caps_get_structure (caps, 0);
+  if (best_width > 0 && best_height > 0) {
+    gst_structure_fixate_field_nearest_int (s, "width", best_width);
+    gst_structure_fixate_field_nearest_int (s, "height", best_height);
+  }
+  gst_structure_fixate_field_nearest_fraction (s, "framerate", best_fps_n,
+      best_fps_d);
+  if (gst_structure_has_field (s, "pixel-aspect-ratio"))
+    gst_structure_fixate_field_nearest_fraction (s, "pixel-aspect-ratio", 1,
+        1);
+
+  return gst_caps_fixate (caps);
+}
+
+static gboolean
+gst_mfxcompositor_negotiated_src_caps (GstAggregator * agg, GstCaps * caps)
+{
+  GstMfxCompositor *const comp = GST_MFXCOMPOSITOR (agg);
+
+  /* The output size and format are part of the VPP configuration */
+  g_atomic_int_set (&comp->reset_filter, TRUE);
+
+  return
+      GST_AGGREGATOR_CLASS (gst_mfxcompositor_parent_class)->negotiated_src_caps
+      (agg, caps);
+}
+
+static gboolean
+gst_mfxcompositor_decide_allocation (GstAggregator * agg, GstQuery * query)
+{
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (agg);
+
+  if (!plugin->aggregator && !gst_mfx_plugin_base_ensure_aggregator (plugin))
+    return FALSE;
+
+  return gst_mfx_plugin_base_decide_allocation (plugin, query);
+}
+
+static gboolean
+gst_mfxcompositor_sink_query (GstAggregator * agg, GstAggregatorPad * bpad,
+    GstQuery * query)
+{
+  GstMfxCompositor *const comp = GST_MFXCOMPOSITOR (agg);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+      if (gst_mfx_handle_context_query (query,
+              GST_MFX_PLUGIN_BASE_AGGREGATOR (comp))) {
+        GST_DEBUG_OBJECT (comp, "sharing tasks %p",
+            GST_MFX_PLUGIN_BASE_AGGREGATOR (comp));
+        return TRUE;
+      }
+      break;
+    /* Sink caps don't depend on the downstream memory type, since raw
+     * output is read back from the composed surfaces */
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *caps, *tmp;
+
+      gst_query_parse_caps (query, &filter);
+      caps = gst_pad_get_pad_template_caps (GST_PAD (bpad));
+      if (filter) {
+        tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    }
+    case GST_QUERY_ACCEPT_CAPS:{
+      GstCaps *caps, *template_caps;
+
+      gst_query_parse_accept_caps (query, &caps);
+      template_caps = gst_pad_get_pad_template_caps (GST_PAD (bpad));
+      gst_query_set_accept_caps_result (query,
+          gst_caps_is_subset (caps, template_caps));
+      gst_caps_unref (template_caps);
+      return TRUE;
+    }
+    default:
+      break;
+  }
+
+  return
+      GST_AGGREGATOR_CLASS (gst_mfxcompositor_parent_class)->sink_query (agg,
+      bpad, query);
+}
+
+static gboolean
+gst_mfxcompositor_src_query (GstAggregator * agg, GstQuery * query)
+{
+  GstMfxCompositor *const comp = GST_MFXCOMPOSITOR (agg);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CONTEXT) {
+    if (gst_mfx_handle_context_query (query,
+            GST_MFX_PLUGIN_BASE_AGGREGATOR (comp))) {
+      GST_DEBUG_OBJECT (comp, "sharing tasks %p",
+          GST_MFX_PLUGIN_BASE_AGGREGATOR (comp));
+      return TRUE;
+    }
+  }
+
+  return
+      GST_AGGREGATOR_CLASS (gst_mfxcompositor_parent_class)->src_query (agg,
+      query);
+}
+
+/* Upstream elements reach READY after this element does, so make the
+ * task aggregator available to their context queries early, otherwise
+ * each input would end up with its own */
+static gboolean
+gst_mfxcompositor_start (GstAggregator * agg)
+{
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (agg);
+
+  if (!plugin->aggregator && !gst_mfx_plugin_base_ensure_aggregator (plugin))
+    return FALSE;
+
+  return GST_AGGREGATOR_CLASS (gst_mfxcompositor_parent_class)->start (agg);
+}
+
+static gboolean
+gst_mfxcompositor_stop (GstAggregator * agg)
+{
+  GstMfxCompositor *const comp = GST_MFXCOMPOSITOR (agg);
+
+  gst_mfx_composite_filter_replace (&comp->filter, NULL);
+  g_atomic_int_set (&comp->reset_filter, FALSE);
+  gst_mfx_plugin_base_close (GST_MFX_PLUGIN_BASE (comp));
+
+  return GST_AGGREGATOR_CLASS (gst_mfxcompositor_parent_class)->stop (agg);
+}
+
+static void
+gst_mfxcompositor_finalize (GObject * object)
+{
+  GstMfxCompositor *const comp = GST_MFXCOMPOSITOR (object);
+
+  gst_mfx_plugin_base_finalize (GST_MFX_PLUGIN_BASE (comp));
+  G_OBJECT_CLASS (gst_mfxcompositor_parent_class)->finalize (object);
+}
+
+static void
+gst_mfxcompositor_class_init (GstMfxCompositorClass * klass)
+{
+  GObjectClass *const object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *const element_class = GST_ELEMENT_CLASS (klass);
+  GstAggregatorClass *const agg_class = GST_AGGREGATOR_CLASS (klass);
+  GstVideoAggregatorClass *const vagg_class =
+      GST_VIDEO_AGGREGATOR_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (gst_debug_mfxcompositor,
+      GST_PLUGIN_NAME, 0, GST_PLUGIN_DESC);
+
+  gst_mfx_plugin_base_class_init (GST_MFX_PLUGIN_BASE_CLASS (klass));
+
+  object_class->finalize = gst_mfxcompositor_finalize;
+  agg_class->start = gst_mfxcompositor_start;
+  agg_class->stop = gst_mfxcompositor_stop;
+  agg_class->sink_query = gst_mfxcompositor_sink_query;
+  agg_class->src_query = gst_mfxcompositor_src_query;
+  agg_class->fixate_src_caps = gst_mfxcompositor_fixate_src_caps;
+  agg_class->negotiated_src_caps = gst_mfxcompositor_negotiated_src_caps;
+  agg_class->decide_allocation = gst_mfxcompositor_decide_allocation;
+  vagg_class->aggregate_frames = gst_mfxcompositor_aggregate_frames;
+
+  gst_element_class_set_static_metadata (element_class,
+      "MFX video compositor",
+      "Filter/Editor/Video/Compositor",
+      GST_PLUGIN_DESC, "Ishmael Sameen <ishmael.visayana.sameen@intel.com>");
+
+  gst_element_class_add_static_pad_template_with_gtype (element_class,
+      &gst_mfxcompositor_sink_factory, GST_TYPE_MFXCOMPOSITOR_PAD);
+  gst_element_class_add_static_pad_template_with_gtype (element_class,
+      &gst_mfxcompositor_src_factory, GST_TYPE_AGGREGATOR_PAD);
+}
+
+static void
+gst_mfxcompositor_init (GstMfxCompositor * comp)
+{
+  gst_mfx_plugin_base_init (GST_MFX_PLUGIN_BASE (comp), GST_CAT_DEFAULT);
+}
@@ -0,0 +1,97 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef GST_MFXCOMPOSITOR_H
+#define GST_MFXCOMPOSITOR_H
+
+#include "gstmfxpluginbase.h"
+
+#include <gst-libs/mfx/gstmfxcompositefilter.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_MFXCOMPOSITOR \
+  (gst_mfxcompositor_get_type ())
+#define GST_MFXCOMPOSITOR(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_MFXCOMPOSITOR, \
+  GstMfxCompositor))
+#define GST_MFXCOMPOSITOR_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_MFXCOMPOSITOR, \
+  GstMfxCompositorClass))
+#define GST_IS_MFXCOMPOSITOR(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_MFXCOMPOSITOR))
+#define GST_IS_MFXCOMPOSITOR_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_MFXCOMPOSITOR))
+
+#define GST_TYPE_MFXCOMPOSITOR_PAD \
+  (gst_mfxcompositor_pad_get_type ())
+#define GST_MFXCOMPOSITOR_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_MFXCOMPOSITOR_PAD, \
+  GstMfxCompositorPad))
+#define GST_IS_MFXCOMPOSITOR_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_MFXCOMPOSITOR_PAD))
+
+typedef struct _GstMfxCompositor GstMfxCompositor;
+typedef struct _GstMfxCompositorClass GstMfxCompositorClass;
+typedef struct _GstMfxCompositorPad GstMfxCompositorPad;
+typedef struct _GstMfxCompositorPadClass GstMfxCompositorPadClass;
+
+struct _GstMfxCompositorPad
+{
+  /*< private >*/
+  GstVideoAggregatorPad   parent_instance;
+
+  /* Placement in the output frame, protected by the object lock */
+  guint                   xpos;
+  guint                   ypos;
+  guint                   width;
+  guint                   height;
+  gdouble                 alpha;
+};
+
+struct _GstMfxCompositorPadClass
+{
+  /*< private >*/
+  GstVideoAggregatorPadClass parent_class;
+};
+
+struct _GstMfxCompositor
+{
+  /*< private >*/
+  GstMfxPluginBase        parent_instance;
+
+  GstMfxCompositeFilter  *filter;
+  volatile gint           reset_filter;
+};
+
+struct _GstMfxCompositorClass
+{
+  /*< private >*/
+  GstMfxPluginBaseClass parent_class;
+};
+
+GType
+gst_mfxcompositor_get_type (void);
+
+GType
+gst_mfxcompositor_pad_get_type (void);
+
+G_END_DECLS
+
+#endif /* GST_MFXCOMPOSITOR_H */
@@ -28,6 +28,8 @@
 
 #include <gst-libs/mfx/gstmfxsurface.h>
 #include <gst-libs/mfx/gstmfxprofile.h>
+#include <gst-libs/mfx/gstmfxutils_nal.h>
+#include <gst-libs/mfx/gstmfxutils_startcode.h>
 
 #define GST_PLUGIN_NAME "mfxdecode"
 #define GST_PLUGIN_DESC "MFX Video Decoder"
@@ -43,25 +45,29 @@ GST_DEBUG_CATEGORY_STATIC (mfxdec_debug);
 
 #define DEFAULT_ASYNC_DEPTH 4
 #define ASYNC_DEPTH_VIDEO_MEM 16;
+#define DEFAULT_NUM_SESSIONS 1
+#define DEFAULT_FRAME_INTERVAL 1
+
+/* Frames to measure the device over before retuning the async depth */
+#define ASYNC_DEPTH_TUNE_FRAMES 60
 
 /* Default templates */
 #define GST_CAPS_CODEC(CODEC) CODEC "; "
 
 static const char gst_mfxdecode_sink_caps_str[] =
     GST_CAPS_CODEC ("video/x-h264, \
-        parsed = true, \
-        alignment = (string) au, \
+        alignment = (string) { au, nal }, \
         profile = (string) { constrained-baseline, baseline, main, high }, \
         stream-format = (string) { avc, byte-stream }")
 #ifdef USE_HEVC_10BIT_DECODER
     GST_CAPS_CODEC ("video/x-h265, \
-        alignment = (string) au, \
+        alignment = (string) { au, nal }, \
         profile = (string) { main, main-10 }, \
         profile = (string) { main }, \
         stream-format = (string) byte-stream")
 #else
     GST_CAPS_CODEC ("video/x-h265, \
-        alignment = (string) au, \
+        alignment = (string) { au, nal }, \
         profile = (string) { main }, \
         stream-format = (string) byte-stream")
 #endif
@@ -78,14 +84,33 @@ static const char gst_mfxdecode_sink_caps_str[] =
 
 static const char gst_mfxdecode_src_caps_str[] =
   GST_MFX_MAKE_SURFACE_CAPS ";"
+#if GST_CHECK_VERSION(1,10,0)
+  GST_VIDEO_CAPS_MAKE ("{ NV12, BGRA, P010_10LE }");
+#else
   GST_VIDEO_CAPS_MAKE ("{ NV12, BGRA }");
+#endif
 
 enum
 {
   PROP_0,
   PROP_ASYNC_DEPTH,
+  PROP_AUTO_ASYNC_DEPTH,
   PROP_LIVE_MODE,
-  PROP_SKIP_CORRUPTED_FRAMES
+  PROP_SKIP_CORRUPTED_FRAMES,
+  PROP_NUM_SESSIONS,
+  PROP_KEY_FRAMES_ONLY,
+  PROP_FRAME_INTERVAL,
+  PROP_DECODE_STATS
+};
+
+struct _GstMfxDecJob
+{
+  GstMfxJob               job;
+  GstVideoCodecFrame     *frame;
+  GstMfxDecoder          *decoder;
+  GstMfxDecoderStatus     status;
+  GQueue                  decoded_frames;
+  GQueue                  discarded_frames;
 };
 
 static GstStaticPadTemplate src_template_factory =
@@ -106,21 +131,20 @@ struct _GstMfxCodecMap
 static const GstMfxCodecMap mfx_codec_map[] = {
   {"h264", GST_RANK_PRIMARY + 3,
       "video/x-h264, \
-       parsed = true, \
-       alignment = (string) au, \
+       alignment = (string) { au, nal }, \
        profile = (string) { constrained-baseline, baseline, main, high }, \
        stream-format = (string) { avc, byte-stream }"},
 #ifdef USE_HEVC_10BIT_DECODER
   {"hevc", GST_RANK_PRIMARY + 3,
       "video/x-h265, \
-       alignment = (string) au, \
+       alignment = (string) { au, nal }, \
        profile = (string) { main, main-10 }, \
        stream-format = (string) byte-stream"},
 #else
 #ifdef USE_HEVC_DECODER
   {"hevc", GST_RANK_PRIMARY + 3,
       "video/x-h265, \
-       alignment = (string) au, \
+       alignment = (string) { au, nal }, \
        profile = (string) main, \
        stream-format = (string) byte-stream"},
 #endif
@@ -195,6 +219,31 @@ gst_mfxdec_update_sink_caps (GstMfxDec * mfxdec, GstCaps * caps)
   return TRUE;
 }
 
+#if GST_CHECK_VERSION(1,10,0)
+/* Main-10 streams are decoded into P010 surfaces, which are handed
+ * over as is when downstream takes 10-bit system memory rather than
+ * being converted down to NV12 */
+static gboolean
+gst_mfxdec_can_output_p010 (GstMfxDec * mfxdec)
+{
+  GstCaps *caps, *peer_caps;
+  gboolean ret;
+
+  if (GST_MFX_PROFILE_HEVC_MAIN10 !=
+      gst_mfx_profile_from_caps (mfxdec->input_state->caps))
+    return FALSE;
+
+  caps = gst_caps_from_string (GST_VIDEO_CAPS_MAKE ("P010_10LE"));
+  peer_caps = gst_pad_peer_query_caps (GST_VIDEO_DECODER_SRC_PAD (mfxdec),
+      caps);
+  ret = peer_caps && !gst_caps_is_empty (peer_caps);
+
+  gst_caps_replace (&peer_caps, NULL);
+  gst_caps_unref (caps);
+  return ret;
+}
+#endif
+
 static gboolean
 gst_mfxdec_update_src_caps (GstMfxDec * mfxdec)
 {
@@ -236,6 +285,10 @@ gst_mfxdec_update_src_caps (GstMfxDec * mfxdec)
     features =
         gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_MFX_SURFACE, NULL);
   }
+#if GST_CHECK_VERSION(1,10,0)
+  else if (gst_mfxdec_can_output_p010 (mfxdec))
+    format = GST_VIDEO_FORMAT_P010_10LE;
+#endif
 
   state = gst_video_decoder_set_output_state (vdec, format,
       ref_state->info.width, ref_state->info.height, ref_state);
@@ -297,7 +350,9 @@ redo:
 
   if ( (mem_is_system != gst_mfx_decoder_check_system_memory(mfxdec->decoder)) &&
        (mem_is_system == TRUE))
-    gst_mfx_decoder_reset_async_depth (mfxdec->decoder, DEFAULT_ASYNC_DEPTH);
+    gst_mfx_decoder_reset_async_depth (mfxdec->decoder,
+        mfxdec->auto_async_depth ?
+        mfxdec->cur_async_depth : DEFAULT_ASYNC_DEPTH);
 
   return TRUE;
 }
@@ -312,12 +367,30 @@ gst_mfxdec_set_property (GObject * object, guint prop_id,
   case PROP_ASYNC_DEPTH:
     dec->async_depth = g_value_get_uint (value);
     break;
+  case PROP_AUTO_ASYNC_DEPTH:
+    dec->auto_async_depth = g_value_get_boolean (value);
+    break;
   case PROP_LIVE_MODE:
     dec->live_mode = g_value_get_boolean (value);
     break;
   case PROP_SKIP_CORRUPTED_FRAMES:
     dec->skip_corrupted_frames = g_value_get_boolean (value);
     break;
+  case PROP_NUM_SESSIONS:
+    GST_OBJECT_LOCK (dec);
+    dec->num_sessions = g_value_get_uint (value);
+    GST_OBJECT_UNLOCK (dec);
+    break;
+  case PROP_KEY_FRAMES_ONLY:
+    GST_OBJECT_LOCK (dec);
+    dec->key_frames_only = g_value_get_boolean (value);
+    GST_OBJECT_UNLOCK (dec);
+    break;
+  case PROP_FRAME_INTERVAL:
+    GST_OBJECT_LOCK (dec);
+    dec->frame_interval = g_value_get_uint (value);
+    GST_OBJECT_UNLOCK (dec);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     break;
@@ -334,12 +407,38 @@ gst_mfxdec_get_property (GObject * object, guint prop_id, GValue * value,
   case PROP_ASYNC_DEPTH:
     g_value_set_uint (value, dec->async_depth);
     break;
+  case PROP_AUTO_ASYNC_DEPTH:
+    g_value_set_boolean (value, dec->auto_async_depth);
+    break;
   case PROP_LIVE_MODE:
     g_value_set_boolean (value, dec->live_mode);
     break;
   case PROP_SKIP_CORRUPTED_FRAMES:
     g_value_set_boolean (value, dec->skip_corrupted_frames);
     break;
+  case PROP_NUM_SESSIONS:
+    GST_OBJECT_LOCK (dec);
+    g_value_set_uint (value, dec->num_sessions);
+    GST_OBJECT_UNLOCK (dec);
+    break;
+  case PROP_KEY_FRAMES_ONLY:
+    GST_OBJECT_LOCK (dec);
+    g_value_set_boolean (value, dec->key_frames_only);
+    GST_OBJECT_UNLOCK (dec);
+    break;
+  case PROP_FRAME_INTERVAL:
+    GST_OBJECT_LOCK (dec);
+    g_value_set_uint (value, dec->frame_interval);
+    GST_OBJECT_UNLOCK (dec);
+    break;
+  case PROP_DECODE_STATS:
+    GST_OBJECT_LOCK (dec);
+    g_value_take_boxed (value, gst_structure_new ("GstMfxDecStats",
+            "async-depth", G_TYPE_UINT, dec->stats_async_depth,
+            "device-latency", G_TYPE_UINT64, dec->stats_device_latency,
+            NULL));
+    GST_OBJECT_UNLOCK (dec);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     break;
@@ -353,22 +452,15 @@ gst_mfxdec_decide_allocation (GstVideoDecoder * vdec, GstQuery * query)
             query);
 }
 
-static gboolean
-gst_mfxdec_create (GstMfxDec * mfxdec, GstCaps * caps)
+static GstMfxDecoder *
+gst_mfxdec_new_decoder (GstMfxDec * mfxdec, GstMfxProfile profile,
+    const GstVideoInfo * info)
 {
   GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (mfxdec);
-  GstMfxProfile profile = gst_mfx_profile_from_caps (caps);
-  GstVideoInfo info;
-  GstObject *parent;
+  GstMfxDecoder *decoder;
   GstBuffer *codec_data = NULL;
   gboolean is_in_avc = FALSE;
 
-  if (!gst_mfxdec_update_src_caps (mfxdec))
-    return FALSE;
-
-  if (!gst_video_info_from_caps (&info, mfxdec->srcpad_caps))
-    return FALSE;
-
   if (mfxdec->input_state) {
     GstStructure *structure = gst_caps_get_structure (mfxdec->input_state->caps, 0);
     if (structure && gst_structure_has_field_typed(structure, "stream-format",
@@ -379,20 +471,93 @@ gst_mfxdec_create (GstMfxDec * mfxdec, GstCaps * caps)
     codec_data = mfxdec->input_state->codec_data;
   }
 
-  /* Increase async depth considerably when using decodebin to avoid
-   * jerky video playback resulting from threading issues */
-  parent = gst_object_get_parent(GST_OBJECT(mfxdec));
-  if (parent && !GST_IS_PIPELINE (GST_ELEMENT(parent)))
-    mfxdec->async_depth = ASYNC_DEPTH_VIDEO_MEM;
-  gst_object_replace (&parent, NULL);
+  decoder = gst_mfx_decoder_new (plugin->aggregator, profile, info,
+      mfxdec->cur_async_depth, mfxdec->live_mode, is_in_avc, codec_data);
+  if (!decoder)
+    return NULL;
+
+  if (mfxdec->skip_corrupted_frames)
+    gst_mfx_decoder_skip_corrupted_frames (decoder);
+  GST_OBJECT_LOCK (mfxdec);
+  gst_mfx_decoder_set_key_frames_only (decoder, mfxdec->key_frames_only);
+  gst_mfx_decoder_set_frame_interval (decoder, mfxdec->frame_interval);
+  GST_OBJECT_UNLOCK (mfxdec);
+
+  return decoder;
+}
+
+static inline GstClockTime
+get_frame_duration (const GstVideoInfo * info)
+{
+  if (!info->fps_n || !info->fps_d)
+    return GST_CLOCK_TIME_NONE;
+  return gst_util_uint64_scale (GST_SECOND, info->fps_d, info->fps_n);
+}
 
-  mfxdec->decoder = gst_mfx_decoder_new (plugin->aggregator, profile, &info,
-      mfxdec->async_depth, mfxdec->live_mode, is_in_avc, codec_data);
+/* Reports the frames the automatic async depth keeps in flight as
+ * decoder latency */
+static void
+gst_mfxdec_update_latency (GstMfxDec * mfxdec, GstClockTime duration)
+{
+  GstClockTime latency;
+
+  GST_OBJECT_LOCK (mfxdec);
+  mfxdec->stats_async_depth = mfxdec->cur_async_depth;
+  GST_OBJECT_UNLOCK (mfxdec);
+
+  if (!mfxdec->auto_async_depth || !GST_CLOCK_TIME_IS_VALID (duration))
+    return;
+
+  latency = mfxdec->cur_async_depth * duration;
+  gst_video_decoder_set_latency (GST_VIDEO_DECODER (mfxdec), latency, latency);
+}
+
+static gboolean
+gst_mfxdec_create (GstMfxDec * mfxdec, GstCaps * caps)
+{
+  GstMfxProfile profile = gst_mfx_profile_from_caps (caps);
+  GstVideoInfo info;
+  GstObject *parent;
+
+  if (!gst_mfxdec_update_src_caps (mfxdec))
+    return FALSE;
+
+  if (!gst_video_info_from_caps (&info, mfxdec->srcpad_caps))
+    return FALSE;
+
+  if (!mfxdec->auto_async_depth) {
+    mfxdec->cur_async_depth = mfxdec->async_depth;
+
+    /* Increase async depth considerably when using decodebin to avoid
+     * jerky video playback resulting from threading issues */
+    parent = gst_object_get_parent(GST_OBJECT(mfxdec));
+    if (parent && !GST_IS_PIPELINE (GST_ELEMENT(parent)))
+      mfxdec->cur_async_depth = ASYNC_DEPTH_VIDEO_MEM;
+    gst_object_replace (&parent, NULL);
+  }
+  else if (!mfxdec->cur_async_depth) {
+    gboolean have_latency;
+
+    GST_OBJECT_LOCK (mfxdec);
+    have_latency = mfxdec->upstream_latency.valid;
+    GST_OBJECT_UNLOCK (mfxdec);
+
+    /* A depth tuned while decoding is kept across seeks and new caps */
+    if (!have_latency)
+      gst_mfx_upstream_latency_update (&mfxdec->upstream_latency,
+          GST_ELEMENT_CAST (mfxdec), GST_VIDEO_DECODER_SINK_PAD (mfxdec));
+    mfxdec->cur_async_depth = gst_mfx_select_async_depth (
+        &mfxdec->upstream_latency, GST_ELEMENT_CAST (mfxdec),
+        get_frame_duration (&info), GST_CLOCK_TIME_NONE, FALSE, 0);
+  }
+  mfxdec->tune_frames = 0;
+  mfxdec->last_surface_waits = 0;
+
+  mfxdec->decoder = gst_mfxdec_new_decoder (mfxdec, profile, &info);
   if (!mfxdec->decoder)
     return FALSE;
 
-  if (mfxdec->skip_corrupted_frames)
-    gst_mfx_decoder_skip_corrupted_frames (mfxdec->decoder);
+  gst_mfxdec_update_latency (mfxdec, get_frame_duration (&info));
 
   mfxdec->do_renego = TRUE;
   mfxdec->do_reconfigure = FALSE;
@@ -415,12 +580,73 @@ gst_mfxdec_flush_discarded_frames (GstMfxDec * mfxdec)
   }
 }
 
+static void
+job_free (GstMfxDec * mfxdec, GstMfxDecJob * job)
+{
+  GstVideoCodecFrame *frame;
+
+  while ((frame = g_queue_pop_head (&job->discarded_frames)))
+    gst_video_decoder_release_frame (GST_VIDEO_DECODER (mfxdec), frame);
+  while ((frame = g_queue_pop_head (&job->decoded_frames)))
+    gst_video_decoder_release_frame (GST_VIDEO_DECODER (mfxdec), frame);
+  g_slice_free (GstMfxDecJob, job);
+}
+
+/* Runs in a worker thread. Every decoder of the pool is used by one
+ * frame at a time, since at most num_sessions frames are in flight */
+static void
+decode_job (GstMfxDecJob * job, GstMfxDec * mfxdec)
+{
+  GstVideoCodecFrame *frame;
+  GstMfxDecoderStatus status;
+
+  status = gst_mfx_decoder_decode (job->decoder, job->frame);
+
+  while ((frame = gst_mfx_decoder_get_discarded_frame (job->decoder)))
+    g_queue_push_tail (&job->discarded_frames, frame);
+  if (GST_MFX_DECODER_STATUS_SUCCESS == status)
+    while (gst_mfx_decoder_get_decoded_frames (job->decoder, &frame))
+      g_queue_push_tail (&job->decoded_frames, frame);
+
+  job->status = status;
+  gst_mfx_job_queue_complete (&mfxdec->jobs, &job->job);
+}
+
+/* Waits for the frames in flight and drops them */
+static void
+discard_jobs (GstMfxDec * mfxdec)
+{
+  GstMfxDecJob *job;
+
+  while ((job = (GstMfxDecJob *) gst_mfx_job_queue_pop (&mfxdec->jobs, 0)))
+    job_free (mfxdec, job);
+}
+
+static void
+destroy_pool (GstMfxDec * mfxdec)
+{
+  discard_jobs (mfxdec);
+
+  if (mfxdec->workers) {
+    g_thread_pool_free (mfxdec->workers, FALSE, TRUE);
+    mfxdec->workers = NULL;
+  }
+  if (mfxdec->decoders) {
+    g_ptr_array_unref (mfxdec->decoders);
+    mfxdec->decoders = NULL;
+  }
+  mfxdec->next_decoder = 0;
+}
+
 static gboolean
 gst_mfxdec_reset_full (GstMfxDec * mfxdec, GstCaps * caps,
   gboolean hard)
 {
   GstMfxProfile profile;
 
+  /* The extra sessions are set up again on the next frame */
+  destroy_pool (mfxdec);
+
   mfxdec->prev_surf = NULL;
   mfxdec->dequeuing = FALSE;
   mfxdec->flushing = 0;
@@ -445,6 +671,8 @@ gst_mfxdec_finalize (GObject * object)
 
   gst_caps_replace (&mfxdec->sinkpad_caps, NULL);
   gst_caps_replace (&mfxdec->srcpad_caps, NULL);
+  gst_mfx_wait_queue_replace (&mfxdec->wait_queue, NULL);
+  gst_mfx_job_queue_clear (&mfxdec->jobs);
 
   gst_mfx_plugin_base_finalize (GST_MFX_PLUGIN_BASE (object));
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -461,21 +689,43 @@ gst_mfxdec_close (GstVideoDecoder * vdec)
 {
   GstMfxDec *const mfxdec = GST_MFXDEC (vdec);
 
+  destroy_pool (mfxdec);
   gst_mfxdec_input_state_replace (mfxdec, NULL);
   gst_mfx_decoder_replace (&mfxdec->decoder, NULL);
+  mfxdec->cur_async_depth = 0;
+  GST_OBJECT_LOCK (mfxdec);
+  mfxdec->upstream_latency.valid = FALSE;
+  GST_OBJECT_UNLOCK (mfxdec);
   gst_mfx_plugin_base_close (GST_MFX_PLUGIN_BASE (mfxdec));
 
   return TRUE;
 }
 
+static void
+gst_mfxdec_reset_au_state (GstMfxDec * mfxdec)
+{
+  mfxdec->au_scan_offset = 0;
+  mfxdec->au_nal_offset = 0;
+  memset (&mfxdec->au, 0, sizeof (mfxdec->au));
+  mfxdec->au_prev_is_sps = FALSE;
+}
+
 static gboolean
 gst_mfxdec_flush (GstVideoDecoder * vdec)
 {
   GstMfxDec *const mfxdec = GST_MFXDEC (vdec);
-  GstMfxProfile profile = gst_mfx_decoder_get_profile (mfxdec->decoder);
-  GstVideoInfo *info = gst_mfx_decoder_get_video_info (mfxdec->decoder);
+  GstMfxProfile profile;
+  GstVideoInfo *info;
   gboolean hard = FALSE;
 
+  gst_mfxdec_reset_au_state (mfxdec);
+
+  /* Still waiting for the first SPS of unaligned input */
+  if (!mfxdec->decoder)
+    return TRUE;
+
+  profile = gst_mfx_decoder_get_profile (mfxdec->decoder);
+  info = gst_mfx_decoder_get_video_info (mfxdec->decoder);
   g_return_val_if_fail (info != NULL, FALSE);
 
   if (info->interlace_mode == GST_VIDEO_INTERLACE_MODE_MIXED
@@ -485,6 +735,25 @@ gst_mfxdec_flush (GstVideoDecoder * vdec)
   return gst_mfxdec_reset_full (mfxdec, mfxdec->sinkpad_caps, hard);
 }
 
+/* Returns the codec to split into access units for caps that do not
+ * come from a parser, or 0 */
+static mfxU32
+gst_mfxdec_get_split_codec (GstCaps * caps)
+{
+  GstStructure *const structure = gst_caps_get_structure (caps, 0);
+  mfxU32 codec =
+      gst_mfx_profile_get_codec (gst_mfx_profile_from_caps (caps));
+
+  if (MFX_CODEC_AVC != codec && MFX_CODEC_HEVC != codec)
+    return 0;
+  if (!g_strcmp0 (gst_structure_get_string (structure, "stream-format"),
+          "avc"))
+    return 0;
+  if (!g_strcmp0 (gst_structure_get_string (structure, "alignment"), "au"))
+    return 0;
+  return codec;
+}
+
 static gboolean
 gst_mfxdec_set_format (GstVideoDecoder * vdec, GstVideoCodecState * state)
 {
@@ -498,6 +767,18 @@ gst_mfxdec_set_format (GstVideoDecoder * vdec, GstVideoCodecState * state)
   if (!gst_mfx_plugin_base_set_caps (plugin, mfxdec->sinkpad_caps, NULL))
     return FALSE;
 
+  /* Split unaligned H.264 / H.265 byte-streams into access units here
+   * rather than requiring a parser upstream. Without one, the picture
+   * size may only be known once the first SPS went through */
+  mfxdec->split_codec = gst_mfxdec_get_split_codec (state->caps);
+  gst_video_decoder_set_packetized (vdec, !mfxdec->split_codec);
+  gst_mfxdec_reset_au_state (mfxdec);
+  if (mfxdec->split_codec && (!state->info.width || !state->info.height)) {
+    destroy_pool (mfxdec);
+    gst_mfx_decoder_replace (&mfxdec->decoder, NULL);
+    return TRUE;
+  }
+
   if (mfxdec->srcpad_caps != NULL && mfxdec->sinkpad_caps != NULL) {
 	  if (!gst_caps_is_equal(mfxdec->srcpad_caps, mfxdec->sinkpad_caps)) {
 	    if (!gst_mfxdec_update_src_caps(mfxdec))
@@ -534,6 +815,10 @@ gst_mfxdec_push_decoded_frame (GstMfxDec *mfxdec, GstVideoCodecFrame * frame)
     return GST_FLOW_OK;
   }
 
+  /* Decoded only as a reference for the frames that are output */
+  if (GST_VIDEO_CODEC_FRAME_IS_DECODE_ONLY (frame))
+    return gst_video_decoder_finish_frame (GST_VIDEO_DECODER (mfxdec), frame);
+
   frame->output_buffer =
       gst_video_decoder_allocate_output_buffer (GST_VIDEO_DECODER (mfxdec));
   if (!frame->output_buffer)
@@ -562,6 +847,11 @@ gst_mfxdec_push_decoded_frame (GstMfxDec *mfxdec, GstVideoCodecFrame * frame)
   gst_mfx_surface_queue(surface);
   mfxdec->prev_surf = surface;
 
+  GST_OBJECT_LOCK (mfxdec);
+  gst_mfx_wait_queue_replace (&mfxdec->wait_queue,
+      gst_mfx_surface_get_wait_queue (surface));
+  GST_OBJECT_UNLOCK (mfxdec);
+
   return gst_video_decoder_finish_frame (GST_VIDEO_DECODER (mfxdec), frame);
   /* ERRORS */
 error_create_buffer:
@@ -578,6 +868,228 @@ error_get_meta:
   }
 }
 
+/* Pushes decoded frames in input order, waiting for the oldest ones
+ * until no more than @max_pending frames are left in flight */
+static GstFlowReturn
+push_jobs (GstMfxDec * mfxdec, guint max_pending)
+{
+  GstVideoDecoder *const vdec = GST_VIDEO_DECODER (mfxdec);
+  GstVideoCodecFrame *frame;
+  GstMfxDecJob *job;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (GST_FLOW_OK == ret) {
+    job = (GstMfxDecJob *) gst_mfx_job_queue_pop (&mfxdec->jobs,
+        max_pending);
+    if (!job)
+      break;
+
+    while ((frame = g_queue_pop_head (&job->discarded_frames))) {
+      GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY (frame);
+      gst_video_decoder_finish_frame (vdec, frame);
+    }
+
+    switch (job->status) {
+      case GST_MFX_DECODER_STATUS_ERROR_MORE_DATA:
+        break;
+      case GST_MFX_DECODER_STATUS_SUCCESS:
+        while (GST_FLOW_OK == ret
+            && (frame = g_queue_pop_head (&job->decoded_frames)))
+          ret = gst_mfxdec_push_decoded_frame (mfxdec, frame);
+        break;
+      case GST_MFX_DECODER_STATUS_ERROR_INIT_FAILED:
+      case GST_MFX_DECODER_STATUS_ERROR_BITSTREAM_PARSER:
+        GST_ERROR_OBJECT (mfxdec, "MFX decode error %d", job->status);
+        ret = GST_FLOW_NOT_SUPPORTED;
+        break;
+      default:
+        ret = GST_FLOW_ERROR;
+        break;
+    }
+    job_free (mfxdec, job);
+  }
+  return ret;
+}
+
+/* JPEG frames have no references between them and are output as soon
+ * as they are decoded, so each frame can be decoded by any session of
+ * the pool. All-intra H.264 / HEVC streams are left to a single session,
+ * since their decoders may still hold frames back for output */
+static gboolean
+gst_mfxdec_can_decode_parallel (GstMfxDec * mfxdec)
+{
+  GstMfxProfile profile = gst_mfx_decoder_get_profile (mfxdec->decoder);
+
+  return MFX_CODEC_JPEG == gst_mfx_profile_get_codec (profile);
+}
+
+static gboolean
+ensure_pool (GstMfxDec * mfxdec, guint num_sessions)
+{
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (mfxdec);
+  GstMfxProfile profile = gst_mfx_decoder_get_profile (mfxdec->decoder);
+  GstMfxTask *current_task;
+  GstMfxDecoder *decoder;
+  GstVideoInfo info;
+  guint i;
+
+  if (mfxdec->workers)
+    return TRUE;
+
+  if (!gst_video_info_from_caps (&info, mfxdec->srcpad_caps))
+    return FALSE;
+
+  /* A new decoder becomes the task that downstream MFX elements join,
+   * so hand that role back to the first session afterwards */
+  current_task =
+      gst_mfx_task_aggregator_get_current_task (plugin->aggregator);
+
+  mfxdec->decoders = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) gst_mfx_decoder_unref);
+  g_ptr_array_add (mfxdec->decoders, gst_mfx_decoder_ref (mfxdec->decoder));
+
+  for (i = 1; i < num_sessions; i++) {
+    decoder = gst_mfxdec_new_decoder (mfxdec, profile, &info);
+    if (!decoder)
+      break;
+    gst_mfx_decoder_should_use_video_memory (decoder, FALSE);
+    g_ptr_array_add (mfxdec->decoders, decoder);
+  }
+
+  if (current_task) {
+    gst_mfx_task_aggregator_set_current_task (plugin->aggregator,
+        current_task);
+    gst_mfx_task_unref (current_task);
+  }
+
+  if (i < num_sessions)
+    goto error_create_decoder;
+
+  mfxdec->workers = g_thread_pool_new ((GFunc) decode_job, mfxdec,
+      num_sessions, FALSE, NULL);
+  if (!mfxdec->workers)
+    goto error_create_decoder;
+
+  GST_INFO_OBJECT (mfxdec, "decoding with %u sessions", num_sessions);
+  return TRUE;
+
+  /* ERRORS */
+error_create_decoder:
+  {
+    GST_ERROR_OBJECT (mfxdec, "failed to create decoder session %u", i);
+    destroy_pool (mfxdec);
+    return FALSE;
+  }
+}
+
+static GstFlowReturn
+gst_mfxdec_handle_frame_parallel (GstMfxDec * mfxdec,
+    GstVideoCodecFrame * frame, guint num_sessions)
+{
+  GstMfxDecJob *job;
+  GstFlowReturn ret;
+
+  if (!ensure_pool (mfxdec, num_sessions))
+    goto error_pool;
+
+  /* Make room for this frame in the pool */
+  ret = push_jobs (mfxdec, mfxdec->decoders->len - 1);
+  if (GST_FLOW_OK != ret)
+    return ret;
+
+  job = g_slice_new0 (GstMfxDecJob);
+  job->frame = frame;
+  job->decoder = g_ptr_array_index (mfxdec->decoders,
+      mfxdec->next_decoder++ % mfxdec->decoders->len);
+  g_queue_init (&job->decoded_frames);
+  g_queue_init (&job->discarded_frames);
+
+  gst_mfx_job_queue_push (&mfxdec->jobs, &job->job);
+  g_thread_pool_push (mfxdec->workers, job, NULL);
+
+  /* Output whatever is already done without blocking */
+  return push_jobs (mfxdec, G_MAXUINT);
+
+  /* ERRORS */
+error_pool:
+  {
+    gst_video_decoder_drop_frame (GST_VIDEO_DECODER (mfxdec), frame);
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_mfxdec_drain_decoder (GstMfxDec * mfxdec, GstMfxDecoder * decoder)
+{
+  GstMfxDecoderStatus sts;
+  GstVideoCodecFrame *out_frame;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  do {
+    sts = gst_mfx_decoder_flush (decoder);
+    if (GST_MFX_DECODER_STATUS_FLUSHED == sts)
+      break;
+    while (gst_mfx_decoder_get_decoded_frames(decoder, &out_frame)) {
+      ret = gst_mfxdec_push_decoded_frame (mfxdec, out_frame);
+      if (ret != GST_FLOW_OK)
+        break;
+    }
+  } while (GST_MFX_DECODER_STATUS_SUCCESS == sts);
+
+  while ((out_frame = gst_mfx_decoder_get_discarded_frame (decoder))) {
+    GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY (out_frame);
+    gst_video_decoder_finish_frame (GST_VIDEO_DECODER (mfxdec), out_frame);
+  }
+
+  return ret;
+}
+
+/* Picks a new automatic async depth from what the decoder measured since
+ * it was created. Changing it means re-initializing the session, so it
+ * is only done ahead of a key frame, once the decoder was drained */
+static GstFlowReturn
+gst_mfxdec_tune_async_depth (GstMfxDec * mfxdec)
+{
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (mfxdec);
+  GstClockTime duration, device_latency;
+  guint surface_waits, depth;
+  GstFlowReturn ret;
+
+  if (mfxdec->tune_frames < ASYNC_DEPTH_TUNE_FRAMES)
+    return GST_FLOW_OK;
+  mfxdec->tune_frames = 0;
+
+  duration =
+      get_frame_duration (gst_mfx_decoder_get_video_info (mfxdec->decoder));
+  device_latency = gst_mfx_decoder_get_device_latency (mfxdec->decoder);
+  surface_waits = gst_mfx_decoder_get_surface_waits (mfxdec->decoder);
+
+  depth = gst_mfx_select_async_depth (&mfxdec->upstream_latency,
+      GST_ELEMENT_CAST (mfxdec), duration, device_latency,
+      surface_waits > mfxdec->last_surface_waits, mfxdec->cur_async_depth);
+  mfxdec->last_surface_waits = surface_waits;
+
+  /* Surfaces handed to a downstream MFX task are bound to the session of
+   * the decoder, which must then outlive them */
+  if (depth == mfxdec->cur_async_depth || !plugin->srcpad_caps_is_raw)
+    return GST_FLOW_OK;
+
+  ret = gst_mfxdec_drain_decoder (mfxdec, mfxdec->decoder);
+  if (GST_FLOW_OK != ret)
+    return ret;
+
+  GST_INFO_OBJECT (mfxdec, "device latency %" GST_TIME_FORMAT
+      ", changing async depth from %u to %u", GST_TIME_ARGS (device_latency),
+      mfxdec->cur_async_depth, depth);
+
+  mfxdec->cur_async_depth = depth;
+  gst_mfx_decoder_replace (&mfxdec->decoder, NULL);
+  if (!gst_mfxdec_create (mfxdec, mfxdec->sinkpad_caps))
+    return GST_FLOW_ERROR;
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 gst_mfxdec_handle_frame (GstVideoDecoder *vdec, GstVideoCodecFrame * frame)
 {
@@ -585,11 +1097,37 @@ gst_mfxdec_handle_frame (GstVideoDecoder *vdec, GstVideoCodecFrame * frame)
   GstMfxDecoderStatus sts;
   GstFlowReturn ret = GST_FLOW_OK;
   GstVideoCodecFrame *out_frame = NULL;
-  gint cnt = 0;
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (vdec);
+  guint num_sessions, frame_interval;
+  gboolean key_frames_only;
+
+  if (!mfxdec->decoder)
+    goto not_negotiated;
+
+  /* Live mode always runs a single operation deep */
+  if (mfxdec->auto_async_depth && !mfxdec->live_mode
+      && !mfxdec->decoders && GST_VIDEO_CODEC_FRAME_IS_SYNC_POINT (frame)) {
+    ret = gst_mfxdec_tune_async_depth (mfxdec);
+    if (GST_FLOW_OK != ret) {
+      gst_video_decoder_release_frame (vdec, frame);
+      return ret;
+    }
+  }
 
   if (!gst_mfxdec_negotiate (mfxdec))
       goto not_negotiated;
 
+  GST_OBJECT_LOCK (mfxdec);
+  num_sessions = mfxdec->num_sessions;
+  key_frames_only = mfxdec->key_frames_only;
+  frame_interval = mfxdec->frame_interval;
+  GST_OBJECT_UNLOCK (mfxdec);
+
+  /* Output selection may change while playing, it applies from this
+   * frame on */
+  gst_mfx_decoder_set_key_frames_only (mfxdec->decoder, key_frames_only);
+  gst_mfx_decoder_set_frame_interval (mfxdec->decoder, frame_interval);
+
   GST_LOG_OBJECT (mfxdec, "Received new data of size %" G_GSIZE_FORMAT
       ", dts %" GST_TIME_FORMAT
       ", pts:%" GST_TIME_FORMAT
@@ -599,17 +1137,39 @@ gst_mfxdec_handle_frame (GstVideoDecoder *vdec, GstVideoCodecFrame * frame)
       GST_TIME_ARGS (frame->pts),
       GST_TIME_ARGS (frame->duration));
 
-  if (mfxdec->prev_surf && mfxdec->dequeuing) {
-    cnt = frame->duration / 100000;
-    while (!g_atomic_int_get(&mfxdec->flushing) && (cnt > 0) &&
-        gst_mfx_surface_is_queued(mfxdec->prev_surf)) {
-      g_usleep(100);
-      --cnt;
+  /* Wait for the sink to release the previous surface, for at most
+   * a frame duration */
+  if (mfxdec->prev_surf && mfxdec->dequeuing
+      && GST_CLOCK_TIME_IS_VALID (frame->duration))
+    gst_mfx_surface_wait_dequeued (mfxdec->prev_surf,
+        g_get_monotonic_time () + frame->duration / GST_USECOND,
+        &mfxdec->flushing);
+
+  /* Surfaces handed to a downstream MFX task belong to a single session,
+   * so only spread frames that are output in system memory. Decimation
+   * counts frames per session, so it keeps to a single one as well */
+  if (num_sessions > 1 && plugin->srcpad_caps_is_raw
+      && frame_interval <= 1 && gst_mfxdec_can_decode_parallel (mfxdec))
+    return gst_mfxdec_handle_frame_parallel (mfxdec, frame, num_sessions);
+
+  /* Decimation was turned on while playing, the first session of the
+   * pool may still be busy with a frame */
+  if (mfxdec->decoders) {
+    ret = push_jobs (mfxdec, 0);
+    if (GST_FLOW_OK != ret) {
+      gst_video_decoder_release_frame (vdec, frame);
+      return ret;
     }
   }
 
   sts = gst_mfx_decoder_decode (mfxdec->decoder, frame);
 
+  mfxdec->tune_frames++;
+  GST_OBJECT_LOCK (mfxdec);
+  mfxdec->stats_device_latency =
+      gst_mfx_decoder_get_device_latency (mfxdec->decoder);
+  GST_OBJECT_UNLOCK (mfxdec);
+
   gst_mfxdec_flush_discarded_frames (mfxdec);
 
   switch (sts) {
@@ -651,24 +1211,166 @@ static GstFlowReturn
 gst_mfxdec_finish (GstVideoDecoder *vdec)
 {
   GstMfxDec *mfxdec = GST_MFXDEC (vdec);
-  GstMfxDecoderStatus sts;
-  GstVideoCodecFrame *out_frame;
-  GstFlowReturn ret = GST_FLOW_OK;
+  GstFlowReturn ret;
+  guint i;
 
-  do {
-    sts = gst_mfx_decoder_flush (mfxdec->decoder);
-    if (GST_MFX_DECODER_STATUS_FLUSHED == sts)
-      break;
-    while (gst_mfx_decoder_get_decoded_frames(mfxdec->decoder, &out_frame)) {
-      ret = gst_mfxdec_push_decoded_frame (mfxdec, out_frame);
-      if (ret != GST_FLOW_OK)
+  if (!mfxdec->decoder)
+    return GST_FLOW_OK;
+  if (!mfxdec->decoders)
+    return gst_mfxdec_drain_decoder (mfxdec, mfxdec->decoder);
+
+  /* Sessions were handed frames in turn, so the one after the last
+   * used session holds the oldest frames */
+  ret = push_jobs (mfxdec, 0);
+  for (i = 0; i < mfxdec->decoders->len && GST_FLOW_OK == ret; i++)
+    ret = gst_mfxdec_drain_decoder (mfxdec, g_ptr_array_index (
+            mfxdec->decoders, (mfxdec->next_decoder + i) %
+            mfxdec->decoders->len));
+
+  return ret;
+}
+
+/* Returns the adapter offset of the next start code at or after offset,
+ * or -1. The adapter is copied out in chunks for scanning, so that the
+ * input buffers of a large access unit are not merged again every time
+ * more of it arrives */
+static gssize
+gst_mfxdec_find_start_code (GstAdapter * adapter, gsize offset, gsize avail)
+{
+  guint8 chunk[4096];
+  gsize len;
+  gint pos;
+
+  while (offset + 4 <= avail) {
+    len = MIN (sizeof (chunk), avail - offset);
+    gst_adapter_copy (adapter, chunk, offset, len);
+    pos = gst_mfx_utils_find_start_code (chunk, len);
+    if (pos >= 0)
+      return offset + pos;
+    offset += len - 3;
+  }
+  return -1;
+}
+
+/* Takes the picture size from the SPS when the caps did not carry it,
+ * and creates the decoder that was put off until then */
+static gboolean
+gst_mfxdec_handle_sps (GstMfxDec * mfxdec, GstAdapter * adapter,
+    gsize offset, gsize size)
+{
+  GstVideoInfo *const info = &mfxdec->input_state->info;
+  guint8 *sps;
+  guint width, height;
+  gboolean success;
+
+  if (mfxdec->decoder || !size)
+    return TRUE;
+
+  sps = g_malloc (size);
+  gst_adapter_copy (adapter, sps, offset, size);
+  success = gst_mfx_utils_nal_parse_sps_size (mfxdec->split_codec, sps, size,
+      &width, &height);
+  g_free (sps);
+  if (!success) {
+    GST_WARNING_OBJECT (mfxdec, "failed to parse SPS");
+    return TRUE;
+  }
+
+  GST_INFO_OBJECT (mfxdec, "picture size %ux%u from SPS", width, height);
+  info->width = width;
+  info->height = height;
+
+  return gst_mfxdec_reset_full (mfxdec, mfxdec->sinkpad_caps, TRUE);
+}
+
+static GstFlowReturn
+gst_mfxdec_finish_au (GstMfxDec * mfxdec, GstVideoCodecFrame * frame,
+    gsize size)
+{
+  GstVideoDecoder *const vdec = GST_VIDEO_DECODER (mfxdec);
+
+  gst_video_decoder_add_to_frame (vdec, size);
+  if (mfxdec->au.is_keyframe)
+    GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (frame);
+  gst_mfxdec_reset_au_state (mfxdec);
+
+  return gst_video_decoder_have_frame (vdec);
+}
+
+/* Splits unaligned byte-stream input into access units. Only the NAL
+ * unit headers and the first bit of the slice headers are looked at,
+ * plus the first SPS when the picture size is needed */
+static GstFlowReturn
+gst_mfxdec_parse (GstVideoDecoder * vdec, GstVideoCodecFrame * frame,
+    GstAdapter * adapter, gboolean at_eos)
+{
+  GstMfxDec *const mfxdec = GST_MFXDEC (vdec);
+  gsize avail = gst_adapter_available (adapter);
+  GstMfxNalUnitInfo nal;
+  guint8 header[3];
+  gssize pos;
+
+  for (;;) {
+    pos = gst_mfxdec_find_start_code (adapter, mfxdec->au_scan_offset,
+        avail);
+
+    /* The next NAL unit is needed up to its first slice header byte to
+     * tell whether it belongs to the current access unit */
+    if (pos < 0 || pos + 6 > avail) {
+      if (at_eos)
         break;
+
+      if (pos >= 0)
+        mfxdec->au_scan_offset = pos;
+      else if (avail > 3)
+        mfxdec->au_scan_offset = MAX (mfxdec->au_scan_offset, avail - 3);
+
+      /* Drop whatever comes in front of the first start code */
+      if (!mfxdec->au.has_nal && mfxdec->au_scan_offset) {
+        gst_adapter_flush (adapter, mfxdec->au_scan_offset);
+        mfxdec->au_scan_offset = 0;
+      }
+      return GST_VIDEO_DECODER_FLOW_NEED_DATA;
     }
-  } while (GST_MFX_DECODER_STATUS_SUCCESS == sts);
 
-  gst_mfxdec_flush_discarded_frames (mfxdec);
+    if (!mfxdec->au.has_nal && pos) {
+      gst_adapter_flush (adapter, pos);
+      avail -= pos;
+      pos = 0;
+    }
 
-  return ret;
+    /* The previous NAL unit ends at this start code */
+    if (mfxdec->au_prev_is_sps) {
+      mfxdec->au_prev_is_sps = FALSE;
+      if (!gst_mfxdec_handle_sps (mfxdec, adapter, mfxdec->au_nal_offset + 3,
+              pos - mfxdec->au_nal_offset - 3))
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    gst_adapter_copy (adapter, header, pos + 3, sizeof (header));
+    gst_mfx_utils_nal_parse_header (mfxdec->split_codec, header,
+        sizeof (header), &nal);
+    if (!gst_mfx_utils_nal_au_add (&mfxdec->au, &nal))
+      return gst_mfxdec_finish_au (mfxdec, frame, pos);
+
+    mfxdec->au_nal_offset = pos;
+    mfxdec->au_prev_is_sps = nal.is_sps;
+    mfxdec->au_scan_offset = pos + 3;
+  }
+
+  /* At EOS, whatever is left makes up the last access unit */
+  if (mfxdec->au_prev_is_sps) {
+    mfxdec->au_prev_is_sps = FALSE;
+    if (!gst_mfxdec_handle_sps (mfxdec, adapter, mfxdec->au_nal_offset + 3,
+            avail - mfxdec->au_nal_offset - 3))
+      return GST_FLOW_NOT_NEGOTIATED;
+  }
+  if (!mfxdec->au.has_vcl) {
+    gst_adapter_flush (adapter, avail);
+    gst_mfxdec_reset_au_state (mfxdec);
+    return GST_VIDEO_DECODER_FLOW_NEED_DATA;
+  }
+  return gst_mfxdec_finish_au (mfxdec, frame, avail);
 }
 
 static gboolean
@@ -691,14 +1393,26 @@ gst_mfxdec_sink_query (GstVideoDecoder * vdec, GstQuery * query)
   return ret;
 }
 
+/* Makes handle_frame() give up waiting for the previous surface */
+static void
+gst_mfxdec_cancel_wait (GstMfxDec * mfxdec)
+{
+  g_atomic_int_set (&mfxdec->flushing, 1);
+
+  GST_OBJECT_LOCK (mfxdec);
+  if (mfxdec->wait_queue)
+    gst_mfx_wait_queue_wake (mfxdec->wait_queue);
+  GST_OBJECT_UNLOCK (mfxdec);
+}
+
 static gboolean
 gst_mfxdec_sink_event (GstVideoDecoder * vdec, GstEvent * event)
 {
   GstMfxDec *mfxdec = GST_MFXDEC (vdec);
 
   if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_START) {
-    g_atomic_int_set(&mfxdec->flushing, 1);
     mfxdec->dequeuing = TRUE;
+    gst_mfxdec_cancel_wait (mfxdec);
   }
 
   if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP) {
@@ -716,6 +1430,12 @@ gst_mfxdec_src_event (GstVideoDecoder * vdec, GstEvent * event)
   if (GST_EVENT_TYPE(event) == GST_EVENT_RECONFIGURE)
     mfxdec->do_reconfigure = TRUE;
 
+  /* Cache the upstream latency for the automatic async depth, so that it
+   * needs no query from the streaming thread */
+  if (GST_EVENT_TYPE(event) == GST_EVENT_LATENCY)
+    gst_mfx_upstream_latency_update (&mfxdec->upstream_latency,
+        GST_ELEMENT_CAST (mfxdec), GST_VIDEO_DECODER_SINK_PAD (mfxdec));
+
   return GST_VIDEO_DECODER_CLASS (parent_class)->src_event (vdec, event);
 }
 
@@ -756,6 +1476,26 @@ gst_mfxdec_src_query (GstVideoDecoder * vdec, GstQuery * query)
   return ret;
 }
 
+static GstStateChangeReturn
+gst_mfxdec_change_state (GstElement * element, GstStateChange transition)
+{
+  GstMfxDec *const mfxdec = GST_MFXDEC (element);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      g_atomic_int_set (&mfxdec->flushing, 0);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* Deactivating the pads waits for handle_frame() to return */
+      gst_mfxdec_cancel_wait (mfxdec);
+      break;
+    default:
+      break;
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
 static void
 gst_mfxdec_class_init (GstMfxDecClass *klass)
 {
@@ -777,6 +1517,7 @@ gst_mfxdec_class_init (GstMfxDecClass *klass)
   gobject_class->set_property = gst_mfxdec_set_property;
   gobject_class->get_property = gst_mfxdec_get_property;
   gobject_class->finalize = gst_mfxdec_finalize;
+  element_class->change_state = GST_DEBUG_FUNCPTR (gst_mfxdec_change_state);
 
   g_object_class_install_property (gobject_class, PROP_ASYNC_DEPTH,
   g_param_spec_uint ("async-depth", "Asynchronous Depth",
@@ -784,6 +1525,13 @@ gst_mfxdec_class_init (GstMfxDecClass *klass)
       0, 20, DEFAULT_ASYNC_DEPTH,
       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_AUTO_ASYNC_DEPTH,
+  g_param_spec_boolean ("auto-async-depth",
+      "Automatic async depth",
+      "Adjust the async depth to the pipeline latency and the measured "
+      "device latency, ignoring async-depth",
+      FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class, PROP_LIVE_MODE,
   g_param_spec_boolean ("live-mode",
       "Live Streaming Mode",
@@ -796,12 +1544,45 @@ gst_mfxdec_class_init (GstMfxDecClass *klass)
       "Skip decoded frames that have major corruption",
       FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_NUM_SESSIONS,
+  g_param_spec_uint ("num-sessions",
+      "Number of sessions",
+      "Number of MFX sessions decoding JPEG streams in parallel",
+      1, 16, DEFAULT_NUM_SESSIONS,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+      GST_PARAM_MUTABLE_READY));
+
+  g_object_class_install_property (gobject_class, PROP_KEY_FRAMES_ONLY,
+  g_param_spec_boolean ("key-frames-only",
+      "Key frames only",
+      "Only decode and output intra frames, dropping all others unparsed. "
+      "When turned off while playing, decoding resumes at the next intra "
+      "frame",
+      FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+      GST_PARAM_MUTABLE_PLAYING));
+
+  g_object_class_install_property (gobject_class, PROP_FRAME_INTERVAL,
+  g_param_spec_uint ("frame-interval",
+      "Frame interval",
+      "Output every Nth frame, skipping the decode of non-reference frames "
+      "that are not output",
+      1, G_MAXUINT, DEFAULT_FRAME_INTERVAL,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+      GST_PARAM_MUTABLE_PLAYING));
+
+  g_object_class_install_property (gobject_class, PROP_DECODE_STATS,
+  g_param_spec_boxed ("decode-stats",
+      "Decode statistics",
+      "Async depth in use and smoothed device latency in nanoseconds",
+      GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   vdec_class->open = GST_DEBUG_FUNCPTR (gst_mfxdec_open);
   vdec_class->close = GST_DEBUG_FUNCPTR (gst_mfxdec_close);
   vdec_class->flush = GST_DEBUG_FUNCPTR (gst_mfxdec_flush);
   vdec_class->finish = GST_DEBUG_FUNCPTR (gst_mfxdec_finish);
   vdec_class->set_format = GST_DEBUG_FUNCPTR (gst_mfxdec_set_format);
   vdec_class->handle_frame = GST_DEBUG_FUNCPTR (gst_mfxdec_handle_frame);
+  vdec_class->parse = GST_DEBUG_FUNCPTR (gst_mfxdec_parse);
   vdec_class->decide_allocation =
       GST_DEBUG_FUNCPTR (gst_mfxdec_decide_allocation);
   vdec_class->src_query = GST_DEBUG_FUNCPTR (gst_mfxdec_src_query);
@@ -847,10 +1628,16 @@ gst_mfxdec_init (GstMfxDec *mfxdec)
 {
   mfxdec->async_depth = DEFAULT_ASYNC_DEPTH;
   mfxdec->live_mode = FALSE;
+  mfxdec->auto_async_depth = FALSE;
   mfxdec->skip_corrupted_frames = FALSE;
   mfxdec->prev_surf = NULL;
   mfxdec->dequeuing = FALSE;
   mfxdec->flushing = 0;
+  mfxdec->num_sessions = DEFAULT_NUM_SESSIONS;
+  mfxdec->key_frames_only = FALSE;
+  mfxdec->frame_interval = DEFAULT_FRAME_INTERVAL;
+  mfxdec->stats_device_latency = GST_CLOCK_TIME_NONE;
+  gst_mfx_job_queue_init (&mfxdec->jobs);
 
   gst_video_decoder_set_packetized (GST_VIDEO_DECODER (mfxdec), TRUE);
   gst_video_decoder_set_needs_format (GST_VIDEO_DECODER (mfxdec), TRUE);
@@ -22,7 +22,10 @@
 #define __GST_MFX_DEC_H__
 
 #include "gstmfxpluginbase.h"
+#include "gstmfxpluginutil.h"
 #include <gst-libs/mfx/gstmfxdecoder.h>
+#include <gst-libs/mfx/gstmfxjobqueue.h>
+#include <gst-libs/mfx/gstmfxutils_nal.h>
 
 G_BEGIN_DECLS
 
@@ -30,6 +33,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstMfxDec GstMfxDec;
 typedef struct _GstMfxDecClass GstMfxDecClass;
+typedef struct _GstMfxDecJob GstMfxDecJob;
 
 struct _GstMfxDec {
   /*< private >*/
@@ -39,11 +43,21 @@ struct _GstMfxDec {
   GstCaps             *srcpad_caps;
   GstMfxDecoder       *decoder;
   guint                async_depth;
+  guint                cur_async_depth;
+  gboolean             auto_async_depth;
+  GstMfxUpstreamLatency upstream_latency;
+  guint                tune_frames;
+  guint                last_surface_waits;
   gboolean             live_mode;
   gboolean             skip_corrupted_frames;
+  gboolean             key_frames_only;
+  guint                frame_interval;
   GstMfxSurface*       prev_surf;
   gboolean             dequeuing;
   gint                 flushing;
+  /* Wait queue of the session of prev_surf, protected by the object lock
+   * since flushes and state changes wake it up from other threads */
+  GstMfxWaitQueue     *wait_queue;
 
   GstVideoCodecState  *input_state;
   volatile gboolean    do_renego;
@@ -51,6 +65,24 @@ struct _GstMfxDec {
   volatile gboolean    mfxsurface_incompatibility;
   volatile gboolean    mfxsink;
 
+  /* Frame-parallel decoding of JPEG streams */
+  guint                num_sessions;
+  GPtrArray           *decoders;
+  guint                next_decoder;
+  GThreadPool         *workers;
+  GstMfxJobQueue       jobs;
+
+  /* Access unit splitting of unaligned byte-stream input, offsets are
+   * relative to the start of the input adapter */
+  mfxU32               split_codec;
+  gsize                au_scan_offset;
+  gsize                au_nal_offset;
+  GstMfxNalAu          au;
+  gboolean             au_prev_is_sps;
+
+  /* Decode statistics, protected by the object lock */
+  guint                stats_async_depth;
+  GstClockTime         stats_device_latency;
 };
 
 struct _GstMfxDecClass {
@@ -45,6 +45,15 @@ enum
   PROP_BASE,
 };
 
+/* Properties of the base class itself. They are dispatched to the base
+ * class handlers, so their ids don't clash with the codec ones above */
+enum
+{
+  PROP_ENCODE_STATS = 1,
+  PROP_SUBFRAME_OUTPUT,
+  PROP_AUTO_ASYNC_DEPTH,
+};
+
 static gboolean
 gst_mfxenc_sink_query (GstVideoEncoder * encoder, GstQuery * query)
 {
@@ -83,6 +92,21 @@ gst_mfxenc_src_query (GstVideoEncoder * encoder, GstQuery * query)
   return ret;
 }
 
+static gboolean
+gst_mfxenc_src_event (GstVideoEncoder * encoder, GstEvent * event)
+{
+  GstMfxEnc *const encode = GST_MFXENC_CAST (encoder);
+
+  /* Keep the upstream latency for the automatic async depth at hand,
+   * the streaming thread must not query it while encoding */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_LATENCY)
+    gst_mfx_upstream_latency_update (&encode->upstream_latency,
+        GST_ELEMENT_CAST (encode), GST_VIDEO_ENCODER_SINK_PAD (encode));
+
+  return GST_VIDEO_ENCODER_CLASS (gst_mfxenc_parent_class)->src_event
+      (encoder, event);
+}
+
 typedef struct
 {
   GstMfxEncoderProp id;
@@ -152,6 +176,14 @@ gst_mfxenc_default_get_property (GstMfxEnc * encode, guint prop_id,
   return FALSE;
 }
 
+/* Properties that a running encoder picks up through an encoder reset */
+static inline gboolean
+prop_is_live (GstMfxEncoderProp prop)
+{
+  return prop == GST_MFX_ENCODER_PROP_BITRATE
+      || prop == GST_MFX_ENCODER_PROP_VBV_MAX_BITRATE;
+}
+
 static gboolean
 gst_mfxenc_default_set_property (GstMfxEnc * encode, guint prop_id,
     const GValue * value)
@@ -159,7 +191,11 @@ gst_mfxenc_default_set_property (GstMfxEnc * encode, guint prop_id,
   PropValue *const prop_value = prop_value_lookup (encode, prop_id);
 
   if (prop_value) {
+    GST_OBJECT_LOCK (encode);
     g_value_copy (value, &prop_value->value);
+    if (prop_is_live (prop_value->id))
+      encode->reset_pending = TRUE;
+    GST_OBJECT_UNLOCK (encode);
     return TRUE;
   }
   return FALSE;
@@ -199,7 +235,7 @@ ensure_output_state (GstMfxEnc * encode)
   return TRUE;
 }
 
-static GstFlowReturn
+GstFlowReturn
 gst_mfxenc_push_frame (GstMfxEnc * encode, GstVideoCodecFrame * out_frame)
 {
   GstVideoEncoder *const venc = GST_VIDEO_ENCODER_CAST (encode);
@@ -225,6 +261,20 @@ gst_mfxenc_push_frame (GstMfxEnc * encode, GstVideoCodecFrame * out_frame)
       GST_TIME_ARGS (out_frame->pts),
       gst_buffer_get_size (out_frame->output_buffer));
 
+#if GST_CHECK_VERSION(1,18,0)
+  /* The encoder always holds back the last slices of the frame, so this
+   * buffer is the one that completes the access unit */
+  if (encode->subframe_active)
+    GST_BUFFER_FLAG_SET (out_frame->output_buffer,
+        GST_VIDEO_BUFFER_FLAG_MARKER);
+#endif
+
+  GST_OBJECT_LOCK (encode);
+  encode->frames_encoded++;
+  if (GST_VIDEO_CODEC_FRAME_IS_SYNC_POINT (out_frame))
+    encode->keyframes++;
+  GST_OBJECT_UNLOCK (encode);
+
   return gst_video_encoder_finish_frame (venc, out_frame);
   /* ERRORS */
 error_format_buffer:
@@ -243,6 +293,177 @@ error_output_state:
   }
 }
 
+/* Outputs all frames still buffered in the encoder */
+static GstFlowReturn
+gst_mfxenc_drain (GstMfxEnc * encode)
+{
+  GstMfxEncoderStatus status;
+  GstVideoCodecFrame *frame;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  do {
+    status = gst_mfx_encoder_flush (encode->encoder, &frame);
+    if (GST_MFX_ENCODER_STATUS_SUCCESS != status)
+      break;
+    ret = gst_mfxenc_push_frame (encode, gst_video_codec_frame_ref (frame));
+  } while (GST_FLOW_OK == ret);
+
+  return ret;
+}
+
+/* Applies bitrate changes made while playing to the running encoder */
+static GstFlowReturn
+apply_live_properties (GstMfxEnc * encode)
+{
+  GPtrArray *const prop_values = encode->prop_values;
+  GstFlowReturn ret;
+  gboolean reset_pending;
+  guint i;
+
+  GST_OBJECT_LOCK (encode);
+  reset_pending = encode->reset_pending;
+  encode->reset_pending = FALSE;
+  if (reset_pending && prop_values) {
+    for (i = 0; i < prop_values->len; i++) {
+      PropValue *const prop_value = g_ptr_array_index (prop_values, i);
+      if (prop_is_live (prop_value->id))
+        gst_mfx_encoder_set_property (encode->encoder, prop_value->id,
+            &prop_value->value);
+    }
+  }
+  GST_OBJECT_UNLOCK (encode);
+
+  if (!reset_pending)
+    return GST_FLOW_OK;
+
+  /* Bitrate changes continue the current sequence, so the frames in
+   * flight don't have to be output first */
+  if (gst_mfx_encoder_reset_starts_new_sequence (encode->encoder)) {
+    ret = gst_mfxenc_drain (encode);
+    if (GST_FLOW_OK != ret)
+      return ret;
+  }
+
+  /* The new bitrate still has to be applied, at the cost of a new
+   * sequence, but only where the encoder inserts a key frame anyway */
+  if (GST_MFX_ENCODER_STATUS_SUCCESS !=
+      gst_mfx_encoder_reset (encode->encoder)) {
+    GST_ELEMENT_WARNING (encode, LIBRARY, SETTINGS,
+        ("Failed to apply the new bitrate to the running encoder"),
+        ("re-creating the encoder at the next key frame"));
+    encode->recreate_pending = TRUE;
+  }
+  return GST_FLOW_OK;
+}
+
+/* Frames to measure the device over before retuning the async depth */
+#define ASYNC_DEPTH_TUNE_FRAMES 60
+
+static inline GstClockTime
+get_frame_duration (const GstVideoInfo * info)
+{
+  if (!info->fps_n || !info->fps_d)
+    return GST_CLOCK_TIME_NONE;
+  return gst_util_uint64_scale (GST_SECOND, info->fps_d, info->fps_n);
+}
+
+static void
+update_device_stats (GstMfxEnc * encode)
+{
+  GST_OBJECT_LOCK (encode);
+  encode->stats_async_depth = gst_mfx_encoder_get_async_depth (encode->encoder);
+  encode->stats_device_latency =
+      gst_mfx_encoder_get_device_latency (encode->encoder);
+  GST_OBJECT_UNLOCK (encode);
+}
+
+/* Reports the frames the encoder keeps in flight as encoder latency */
+static void
+set_async_depth_latency (GstMfxEnc * encode, const GstVideoInfo * info)
+{
+  GstClockTime duration = get_frame_duration (info);
+  GstClockTime latency;
+
+  if (GST_CLOCK_TIME_IS_VALID (duration)) {
+    latency = encode->async_depth * duration;
+    gst_video_encoder_set_latency (GST_VIDEO_ENCODER_CAST (encode),
+        latency, latency);
+  }
+}
+
+/* Hands the automatic async depth to a new encoder, starting from the
+ * pipeline latency when none was tuned yet */
+static void
+ensure_async_depth (GstMfxEnc * encode, const GstVideoInfo * info)
+{
+  GstElement *const element = GST_ELEMENT_CAST (encode);
+  gboolean have_latency;
+
+  encode->gop_frames = 0;
+  encode->pending_async_depth = 0;
+  GST_OBJECT_LOCK (encode);
+  encode->tuning_async_depth = encode->auto_async_depth;
+  have_latency = encode->upstream_latency.valid;
+  GST_OBJECT_UNLOCK (encode);
+
+  if (!encode->tuning_async_depth)
+    return;
+
+  if (!have_latency)
+    gst_mfx_upstream_latency_update (&encode->upstream_latency, element,
+        GST_VIDEO_ENCODER_SINK_PAD (encode));
+  if (!encode->async_depth)
+    encode->async_depth = gst_mfx_select_async_depth (
+        &encode->upstream_latency, element, get_frame_duration (info),
+        GST_CLOCK_TIME_NONE, FALSE, 0);
+  gst_mfx_encoder_set_async_depth (encode->encoder, encode->async_depth);
+  encode->tune_frames = 0;
+  encode->last_surface_waits = 0;
+  set_async_depth_latency (encode, info);
+}
+
+#if GST_CHECK_VERSION(1,18,0)
+static gboolean
+gst_mfxenc_push_subframe (GstVideoCodecFrame * frame, GstBuffer * buffer,
+    gpointer user_data)
+{
+  GstMfxEnc *const encode = GST_MFXENC_CAST (user_data);
+  GstVideoEncoder *const venc = GST_VIDEO_ENCODER_CAST (encode);
+  GstMfxEncClass *const klass = GST_MFXENC_GET_CLASS (encode);
+  GstBuffer *outbuf = NULL;
+
+  if (!ensure_output_state (encode)) {
+    encode->subframe_ret = GST_FLOW_NOT_NEGOTIATED;
+    goto error;
+  }
+
+  if (klass->format_buffer) {
+    encode->subframe_ret = klass->format_buffer (encode, buffer, &outbuf);
+    if (GST_FLOW_OK != encode->subframe_ret)
+      goto error;
+    if (outbuf) {
+      gst_buffer_replace (&buffer, outbuf);
+      gst_buffer_unref (outbuf);
+    }
+  }
+
+  GST_LOG ("subframe:%" GST_TIME_FORMAT ", size:%zu",
+      GST_TIME_ARGS (frame->pts), gst_buffer_get_size (buffer));
+
+  /* The base class pushes and then releases the output buffer. A failed
+   * push stops partial output for the frame, and handle_frame returns
+   * the flow once the encoder is done with it */
+  gst_buffer_replace (&frame->output_buffer, buffer);
+  gst_buffer_unref (buffer);
+  encode->subframe_ret = gst_video_encoder_finish_subframe (venc, frame);
+  return GST_FLOW_OK == encode->subframe_ret;
+
+error:
+  gst_buffer_unref (buffer);
+  return FALSE;
+}
+#endif
+
 static GstCaps *
 gst_mfxenc_get_caps_impl (GstVideoEncoder * venc)
 {
@@ -286,13 +507,44 @@ gst_mfxenc_destroy (GstMfxEnc * encode)
   return TRUE;
 }
 
+/**
+ * gst_mfxenc_apply_properties:
+ * @encode: a #GstMfxEnc
+ * @encoder: a #GstMfxEncoder allocated by @encode
+ *
+ * Configures @encoder with the current values of the encoder properties
+ * of @encode.
+ *
+ * Returns: %TRUE if all property values were accepted by @encoder
+ */
+gboolean
+gst_mfxenc_apply_properties (GstMfxEnc * encode, GstMfxEncoder * encoder)
+{
+  GPtrArray *const prop_values = encode->prop_values;
+  GstMfxEncoderStatus status = GST_MFX_ENCODER_STATUS_SUCCESS;
+  guint i;
+
+  if (!prop_values)
+    return TRUE;
+
+  GST_OBJECT_LOCK (encode);
+  for (i = 0; i < prop_values->len; i++) {
+    PropValue *const prop_value = g_ptr_array_index (prop_values, i);
+    status = gst_mfx_encoder_set_property (encoder, prop_value->id,
+        &prop_value->value);
+    if (status != GST_MFX_ENCODER_STATUS_SUCCESS)
+      break;
+  }
+  GST_OBJECT_UNLOCK (encode);
+
+  return status == GST_MFX_ENCODER_STATUS_SUCCESS;
+}
+
 static gboolean
 ensure_encoder (GstMfxEnc * encode)
 {
   GstMfxEncClass *klass = GST_MFXENC_GET_CLASS (encode);
-  GstMfxEncoderStatus status;
-  GPtrArray *const prop_values = encode->prop_values;
-  guint i;
+  gboolean subframe_output;
 
   g_return_val_if_fail (klass->alloc_encoder, FALSE);
 
@@ -303,14 +555,24 @@ ensure_encoder (GstMfxEnc * encode)
   if (!encode->encoder)
     return FALSE;
 
-  if (prop_values) {
-    for (i = 0; i < prop_values->len; i++) {
-      PropValue *const prop_value = g_ptr_array_index (prop_values, i);
-      status = gst_mfx_encoder_set_property (encode->encoder, prop_value->id,
-          &prop_value->value);
-      if (status != GST_MFX_ENCODER_STATUS_SUCCESS)
-        return FALSE;
-    }
+  if (!gst_mfxenc_apply_properties (encode, encode->encoder))
+    return FALSE;
+
+  GST_OBJECT_LOCK (encode);
+  encode->reset_pending = FALSE;
+  subframe_output = encode->subframe_output;
+  GST_OBJECT_UNLOCK (encode);
+  encode->recreate_pending = FALSE;
+
+  encode->subframe_active = FALSE;
+  if (subframe_output) {
+#if GST_CHECK_VERSION(1,18,0)
+    encode->subframe_active =
+        gst_mfx_encoder_set_subframe_func (encode->encoder,
+        gst_mfxenc_push_subframe, encode);
+#endif
+    if (!encode->subframe_active)
+      GST_WARNING_OBJECT (encode, "slice-level output is not supported");
   }
   return TRUE;
 }
@@ -328,6 +590,23 @@ gst_mfxenc_close (GstVideoEncoder * venc)
   return TRUE;
 }
 
+static gboolean
+gst_mfxenc_start (GstVideoEncoder * venc)
+{
+  GstMfxEnc *const encode = GST_MFXENC_CAST (venc);
+
+  GST_OBJECT_LOCK (encode);
+  encode->frames_encoded = 0;
+  encode->keyframes = 0;
+  encode->forced_keyframes = 0;
+  encode->stats_async_depth = 0;
+  encode->stats_device_latency = GST_CLOCK_TIME_NONE;
+  encode->upstream_latency.valid = FALSE;
+  GST_OBJECT_UNLOCK (encode);
+  encode->async_depth = 0;
+  return TRUE;
+}
+
 static gboolean
 gst_mfxenc_stop (GstVideoEncoder * venc)
 {
@@ -352,14 +631,111 @@ set_codec_state (GstMfxEnc * encode, GstVideoCodecState * state)
   return TRUE;
 }
 
+/* Drains the running encoder and replaces it with one for the current
+ * input state and properties, which starts a new sequence */
+static GstFlowReturn
+recreate_encoder (GstMfxEnc * encode)
+{
+  GstFlowReturn ret;
+
+  ret = gst_mfxenc_drain (encode);
+  if (GST_FLOW_OK != ret)
+    return ret;
+
+  gst_mfx_encoder_replace (&encode->encoder, NULL);
+  if (!ensure_encoder (encode))
+    return GST_FLOW_ERROR;
+  ensure_async_depth (encode, &encode->input_state->info);
+  if (!set_codec_state (encode, encode->input_state)
+      || GST_MFX_ENCODER_STATUS_SUCCESS !=
+          gst_mfx_encoder_start (encode->encoder))
+    return GST_FLOW_ERROR;
+
+  /* Codec data of the new sequence has to be sent again */
+  encode->input_state_changed = TRUE;
+  update_device_stats (encode);
+  return GST_FLOW_OK;
+}
+
+/* Picks a new automatic async depth every ASYNC_DEPTH_TUNE_FRAMES frames
+ * from what the encoder measured. The SDK can't change the depth of a
+ * running session, so the encoder is drained and re-created, which is
+ * put off until a frame that starts a GOP or is forced to be a key frame,
+ * where the encoder would insert a key frame anyway */
+static GstFlowReturn
+tune_async_depth (GstMfxEnc * encode, GstVideoCodecFrame * frame)
+{
+  GstVideoInfo *const info = &encode->input_state->info;
+  GstClockTime device_latency;
+  guint surface_waits, depth;
+
+  if (encode->tune_frames >= ASYNC_DEPTH_TUNE_FRAMES) {
+    encode->tune_frames = 0;
+
+    device_latency = gst_mfx_encoder_get_device_latency (encode->encoder);
+    surface_waits = gst_mfx_encoder_get_surface_waits (encode->encoder);
+
+    depth = gst_mfx_select_async_depth (&encode->upstream_latency,
+        GST_ELEMENT_CAST (encode), get_frame_duration (info), device_latency,
+        surface_waits > encode->last_surface_waits, encode->async_depth);
+    encode->last_surface_waits = surface_waits;
+    encode->pending_async_depth = 0;
+
+    if (depth != encode->async_depth) {
+      GST_INFO_OBJECT (encode, "device latency %" GST_TIME_FORMAT
+          ", changing async depth from %u to %u",
+          GST_TIME_ARGS (device_latency), encode->async_depth, depth);
+      encode->pending_async_depth = depth;
+    }
+  }
+
+  if (!encode->pending_async_depth || (encode->gop_frames
+          && !GST_VIDEO_CODEC_FRAME_IS_FORCE_KEYFRAME (frame)))
+    return GST_FLOW_OK;
+
+  GST_INFO_OBJECT (encode, "re-creating encoder for async depth %u",
+      encode->pending_async_depth);
+
+  encode->async_depth = encode->pending_async_depth;
+  return recreate_encoder (encode);
+}
+
 static gboolean
 gst_mfxenc_set_format (GstVideoEncoder * venc, GstVideoCodecState * state)
 {
   GstMfxEnc *const encode = GST_MFXENC_CAST (venc);
   GstMfxEncoderStatus status;
+  GstFlowReturn ret;
 
   g_return_val_if_fail (state->caps != NULL, FALSE);
 
+  /* Try to carry a running encoder over to the new format, which avoids
+   * re-creating the session and forcing a new IDR frame */
+  if (encode->encoder && encode->input_state) {
+    ret = gst_mfxenc_drain (encode);
+    if (GST_FLOW_OK != ret) {
+      GST_WARNING_OBJECT (encode, "failed to drain before new format: %s",
+          gst_flow_get_name (ret));
+      return FALSE;
+    }
+
+    /* The sink pad pool and the upstream task have to follow the new
+     * caps as well, or frames would still come in the old format */
+    if (gst_mfx_plugin_base_set_caps (GST_MFX_PLUGIN_BASE (encode),
+            state->caps, NULL)
+        && set_codec_state (encode, state)
+        && GST_MFX_ENCODER_STATUS_SUCCESS ==
+            gst_mfx_encoder_reset (encode->encoder)) {
+      gst_video_codec_state_unref (encode->input_state);
+      encode->input_state = gst_video_codec_state_ref (state);
+      encode->input_state_changed = TRUE;
+      return TRUE;
+    }
+
+    GST_INFO_OBJECT (encode, "re-creating encoder for new format");
+    gst_mfx_encoder_replace (&encode->encoder, NULL);
+  }
+
   if (!gst_mfx_plugin_base_set_caps (GST_MFX_PLUGIN_BASE (encode),
           state->caps, NULL))
     return FALSE;
@@ -369,9 +745,12 @@ gst_mfxenc_set_format (GstVideoEncoder * venc, GstVideoCodecState * state)
   if (!set_codec_state (encode, state))
     return FALSE;
 
+  ensure_async_depth (encode, &state->info);
+
   status = gst_mfx_encoder_start (encode->encoder);
   if (GST_MFX_ENCODER_STATUS_SUCCESS != status)
     return FALSE;
+  update_device_stats (encode);
 
   if (encode->input_state)
     gst_video_codec_state_unref (encode->input_state);
@@ -391,6 +770,20 @@ gst_mfxenc_handle_frame (GstVideoEncoder * venc, GstVideoCodecFrame * frame)
   GstFlowReturn ret;
   GstBuffer *buf;
 
+  if (encode->tuning_async_depth) {
+    ret = tune_async_depth (encode, frame);
+    if (GST_FLOW_OK != ret)
+      goto error_drain;
+  }
+
+  if (encode->recreate_pending && (!encode->gop_frames
+          || GST_VIDEO_CODEC_FRAME_IS_FORCE_KEYFRAME (frame))) {
+    GST_INFO_OBJECT (encode, "re-creating encoder for new bitrate");
+    ret = recreate_encoder (encode);
+    if (GST_FLOW_OK != ret)
+      goto error_drain;
+  }
+
   ret = gst_mfx_plugin_base_get_input_buffer (GST_MFX_PLUGIN_BASE (encode),
       frame->input_buffer, &buf);
   if (ret != GST_FLOW_OK)
@@ -410,7 +803,25 @@ gst_mfxenc_handle_frame (GstVideoEncoder * venc, GstVideoCodecFrame * frame)
   gst_video_codec_frame_set_user_data (frame,
       gst_mfx_surface_ref (surface), (GDestroyNotify) gst_mfx_surface_unref);
 
+  /* Key unit requests are honoured through per-frame encode control */
+  if (GST_VIDEO_CODEC_FRAME_IS_FORCE_KEYFRAME (frame)) {
+    GST_OBJECT_LOCK (encode);
+    encode->forced_keyframes++;
+    GST_OBJECT_UNLOCK (encode);
+    encode->gop_frames = 0;
+  }
+
+  ret = apply_live_properties (encode);
+  if (GST_FLOW_OK != ret)
+    goto error_drain;
+
+  encode->subframe_ret = GST_FLOW_OK;
   status = gst_mfx_encoder_encode (encode->encoder, frame);
+  encode->tune_frames++;
+  encode->gop_frames++;
+  if (encode->gop_frames >= gst_mfx_encoder_get_gop_size (encode->encoder))
+    encode->gop_frames = 0;
+  update_device_stats (encode);
   if (status < GST_MFX_ENCODER_STATUS_SUCCESS)
     goto error_encode_frame;
   else if (status > 0) {
@@ -419,6 +830,8 @@ gst_mfxenc_handle_frame (GstVideoEncoder * venc, GstVideoCodecFrame * frame)
   }
   ret = gst_mfxenc_push_frame (encode, frame);
   gst_mfx_surface_dequeue(surface);
+  if (GST_FLOW_OK == ret)
+    ret = encode->subframe_ret;
 
 done:
   return ret;
@@ -442,6 +855,11 @@ error_buffer_no_surface:
     gst_video_codec_frame_unref (frame);
     return GST_FLOW_ERROR;
   }
+error_drain:
+  {
+    gst_video_codec_frame_unref (frame);
+    return ret;
+  }
 error_encode_frame:
   {
     GST_ERROR ("failed to encode frame %d (status %d)",
@@ -485,6 +903,72 @@ gst_mfxenc_propose_allocation (GstVideoEncoder * venc, GstQuery * query)
   return TRUE;
 }
 
+static GstStructure *
+gst_mfxenc_get_encode_stats (GstMfxEnc * encode)
+{
+  GstStructure *stats;
+
+  GST_OBJECT_LOCK (encode);
+  stats = gst_structure_new ("GstMfxEncStats",
+      "encoded", G_TYPE_UINT64, encode->frames_encoded,
+      "keyframes", G_TYPE_UINT64, encode->keyframes,
+      "forced-keyframes", G_TYPE_UINT64, encode->forced_keyframes,
+      "async-depth", G_TYPE_UINT, encode->stats_async_depth,
+      "device-latency", G_TYPE_UINT64, encode->stats_device_latency, NULL);
+  GST_OBJECT_UNLOCK (encode);
+
+  return stats;
+}
+
+static void
+gst_mfxenc_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  GstMfxEnc *const encode = GST_MFXENC_CAST (object);
+
+  switch (prop_id) {
+    case PROP_ENCODE_STATS:
+      g_value_take_boxed (value, gst_mfxenc_get_encode_stats (encode));
+      break;
+    case PROP_SUBFRAME_OUTPUT:
+      GST_OBJECT_LOCK (encode);
+      g_value_set_boolean (value, encode->subframe_output);
+      GST_OBJECT_UNLOCK (encode);
+      break;
+    case PROP_AUTO_ASYNC_DEPTH:
+      GST_OBJECT_LOCK (encode);
+      g_value_set_boolean (value, encode->auto_async_depth);
+      GST_OBJECT_UNLOCK (encode);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mfxenc_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+  GstMfxEnc *const encode = GST_MFXENC_CAST (object);
+
+  switch (prop_id) {
+    case PROP_SUBFRAME_OUTPUT:
+      GST_OBJECT_LOCK (encode);
+      encode->subframe_output = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (encode);
+      break;
+    case PROP_AUTO_ASYNC_DEPTH:
+      GST_OBJECT_LOCK (encode);
+      encode->auto_async_depth = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (encode);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_mfxenc_finalize (GObject * object)
 {
@@ -523,8 +1007,11 @@ gst_mfxenc_class_init (GstMfxEncClass * klass)
   gst_mfx_plugin_base_class_init (GST_MFX_PLUGIN_BASE_CLASS (klass));
 
   object_class->finalize = gst_mfxenc_finalize;
+  object_class->get_property = gst_mfxenc_get_property;
+  object_class->set_property = gst_mfxenc_set_property;
 
   venc_class->open = GST_DEBUG_FUNCPTR (gst_mfxenc_open);
+  venc_class->start = GST_DEBUG_FUNCPTR (gst_mfxenc_start);
   venc_class->stop = GST_DEBUG_FUNCPTR (gst_mfxenc_stop);
   venc_class->close = GST_DEBUG_FUNCPTR (gst_mfxenc_close);
   venc_class->set_format = GST_DEBUG_FUNCPTR (gst_mfxenc_set_format);
@@ -538,7 +1025,55 @@ gst_mfxenc_class_init (GstMfxEncClass * klass)
   klass->set_property = gst_mfxenc_default_set_property;
 
   venc_class->src_query = GST_DEBUG_FUNCPTR (gst_mfxenc_src_query);
+  venc_class->src_event = GST_DEBUG_FUNCPTR (gst_mfxenc_src_event);
   venc_class->sink_query = GST_DEBUG_FUNCPTR (gst_mfxenc_sink_query);
+
+  /**
+   * GstMfxEnc:encode-stats:
+   *
+   * Frames encoded since the encoder was started, together with the
+   * number of key frames among them and the number of key frames that
+   * were forced by upstream or downstream key unit requests. Also holds
+   * the async depth the session runs with and the smoothed time the
+   * device takes to encode a frame, in nanoseconds.
+   */
+  g_object_class_install_property (object_class, PROP_ENCODE_STATS,
+      g_param_spec_boxed ("encode-stats",
+          "Encode statistics",
+          "Encoded frames, key frames, forced key frames and device latency",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMfxEnc:subframe-output:
+   *
+   * Push each group of completed slices downstream as soon as it is
+   * available instead of waiting for the whole frame. The buffer that
+   * completes an access unit carries the GST_VIDEO_BUFFER_FLAG_MARKER
+   * flag. Since frames can't be reordered, B-frames are turned off.
+   * Only H.264 and H.265 support partial output, which requires MSDK API
+   * 1.31 and GStreamer 1.18.
+   */
+  g_object_class_install_property (object_class, PROP_SUBFRAME_OUTPUT,
+      g_param_spec_boolean ("subframe-output",
+          "Subframe output",
+          "Output slices before the whole frame is encoded",
+          FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstMfxEnc:auto-async-depth:
+   *
+   * Pick the async depth from the upstream latency, and adjust it while
+   * encoding to the latency measured on the device. The async-depth
+   * property is ignored then. Each change re-creates the encoder on the
+   * next key frame.
+   */
+  g_object_class_install_property (object_class, PROP_AUTO_ASYNC_DEPTH,
+      g_param_spec_boolean ("auto-async-depth",
+          "Automatic async depth",
+          "Adjust the async depth to the pipeline and device latency",
+          FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
 
 static inline GPtrArray *
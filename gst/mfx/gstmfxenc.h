@@ -24,6 +24,7 @@
 #define GST_MFXENCODE_H
 
 #include "gstmfxpluginbase.h"
+#include "gstmfxpluginutil.h"
 #include <gst-libs/mfx/gstmfxencoder.h>
 
 G_BEGIN_DECLS
@@ -59,6 +60,41 @@ struct _GstMfxEnc
   gboolean 						 need_codec_data;
   GstVideoCodecState	*output_state;
   GPtrArray 					*prop_values;
+
+  /* Encode statistics, protected by the object lock */
+  guint64							 frames_encoded;
+  guint64							 keyframes;
+  guint64							 forced_keyframes;
+
+  /* Push slices ahead of the whole frame, protected by the object lock */
+  gboolean						 subframe_output;
+  /* Slices are pushed ahead by the encoder, and the flow return of the
+   * last push for the frame being encoded */
+  gboolean						 subframe_active;
+  GstFlowReturn				 subframe_ret;
+
+  /* Bitrate changed while playing, protected by the object lock */
+  gboolean						 reset_pending;
+  /* The encoder could not be reset and is re-created at the next GOP */
+  gboolean						 recreate_pending;
+
+  /* Pick the async depth while playing, protected by the object lock */
+  gboolean						 auto_async_depth;
+  GstMfxUpstreamLatency	upstream_latency;
+
+  /* Async depth picked while playing, for the current encoder */
+  gboolean						 tuning_async_depth;
+  guint								 async_depth;
+  guint								 tune_frames;
+  guint								 last_surface_waits;
+  /* Raised depth waiting for the next GOP to re-create the encoder */
+  guint								 pending_async_depth;
+  /* Frames since the encoder started its last GOP */
+  guint								 gop_frames;
+
+  /* Device statistics, protected by the object lock */
+  guint								 stats_async_depth;
+  GstClockTime				 stats_device_latency;
 };
 
 struct _GstMfxEncClass
@@ -85,6 +121,12 @@ gst_mfxenc_init_properties (GstMfxEnc * encode);
 gboolean
 gst_mfxenc_class_init_properties (GstMfxEncClass * encode_class);
 
+gboolean
+gst_mfxenc_apply_properties (GstMfxEnc * encode, GstMfxEncoder * encoder);
+
+GstFlowReturn
+gst_mfxenc_push_frame (GstMfxEnc * encode, GstVideoCodecFrame * out_frame);
+
 G_END_DECLS
 
 #endif /* GST_MFXENC_H */
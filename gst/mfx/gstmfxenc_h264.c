@@ -41,7 +41,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_mfx_h264_enc_debug);
 
 static const char gst_mfxenc_h264_sink_caps_str[] =
     GST_MFX_MAKE_SURFACE_CAPS "; "
-    GST_VIDEO_CAPS_MAKE (GST_MFX_SUPPORTED_INPUT_FORMATS);
+    GST_MFX_MAKE_DMABUF_CAPS "; "
+    GST_VIDEO_CAPS_MAKE (GST_MFX_SUPPORTED_8BIT_INPUT_FORMATS);
 
 static const char gst_mfxenc_h264_src_caps_str[] =
     GST_CODEC_CAPS ", " "profile = (string) { baseline, main, high }";
@@ -38,9 +38,11 @@ GST_DEBUG_CATEGORY_STATIC (gst_mfx_h265_enc_debug);
 
 static const char gst_mfxenc_h265_sink_caps_str[] =
     GST_MFX_MAKE_SURFACE_CAPS "; "
+    GST_MFX_MAKE_DMABUF_CAPS "; "
     GST_VIDEO_CAPS_MAKE (GST_MFX_SUPPORTED_INPUT_FORMATS);
 
-static const char gst_mfxenc_h265_src_caps_str[] = GST_CODEC_CAPS;
+static const char gst_mfxenc_h265_src_caps_str[] =
+    GST_CODEC_CAPS ", " "profile = (string) { main, main-10 }";
 
 static GstStaticPadTemplate gst_mfxenc_h265_sink_factory =
 GST_STATIC_PAD_TEMPLATE ("sink",
@@ -103,6 +105,7 @@ static GstCaps *
 gst_mfxenc_h265_get_caps (GstMfxEnc * base_encode)
 {
   GstMfxEncH265 *const encode = GST_MFXENC_H265_CAST (base_encode);
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (base_encode);
   GstCaps *caps, *allowed_caps;
 
   caps = gst_caps_from_string (GST_CODEC_CAPS);
@@ -129,6 +132,11 @@ gst_mfxenc_h265_get_caps (GstMfxEnc * base_encode)
   gst_caps_set_simple (caps, "stream-format", G_TYPE_STRING,
       encode->is_hvc ? "hvc1" : "byte-stream", NULL);
 
+  /* 10-bit input is encoded at 10 bits, see gst_mfx_encoder_set_frame_info() */
+  gst_caps_set_simple (caps, "profile", G_TYPE_STRING,
+      GST_VIDEO_INFO_COMP_DEPTH (&plugin->sinkpad_info, 0) > 8 ?
+      "main-10" : "main", NULL);
+
   base_encode->need_codec_data = encode->is_hvc;
 
   return caps;
@@ -22,8 +22,10 @@
 #include "gstmfxenc_jpeg.h"
 #include "gstmfxpluginutil.h"
 #include "gstmfxvideomemory.h"
+#include "gstmfxvideometa.h"
 
 #include <gst-libs/mfx/gstmfxencoder_jpeg.h>
+#include <gst-libs/mfx/gstmfxjobqueue.h>
 
 #define GST_PLUGIN_NAME "mfxjpegenc"
 #define GST_PLUGIN_DESC "An MFX-based JPEG encoder"
@@ -35,7 +37,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_mfx_jpeg_encode_debug);
 
 static const char gst_mfxenc_jpeg_sink_caps_str[] =
     GST_MFX_MAKE_SURFACE_CAPS "; "
-    GST_VIDEO_CAPS_MAKE (GST_MFX_SUPPORTED_INPUT_FORMATS);
+    GST_MFX_MAKE_DMABUF_CAPS "; "
+    GST_VIDEO_CAPS_MAKE (GST_MFX_SUPPORTED_8BIT_INPUT_FORMATS);
 
 static const char gst_mfxenc_jpeg_src_caps_str[] = GST_CODEC_CAPS;
 
@@ -52,6 +55,24 @@ GST_STATIC_PAD_TEMPLATE ("src",
     GST_STATIC_CAPS (gst_mfxenc_jpeg_src_caps_str));
 
 
+#define DEFAULT_NUM_SESSIONS 1
+
+/* Element properties. They are numbered past the encoder properties
+ * that the base class installs from its own PROP_BASE */
+enum
+{
+  PROP_NUM_SESSIONS = 0x100,
+};
+
+struct _GstMfxEncJpegJob
+{
+  GstMfxJob               job;
+  GstVideoCodecFrame     *frame;
+  GstMfxEncoder          *encoder;
+  GstMfxSurface          *surface;
+  GstMfxEncoderStatus     status;
+};
+
 /* jpeg encode */
 G_DEFINE_TYPE (GstMfxEncJpeg, gst_mfxenc_jpeg, GST_TYPE_MFXENC);
 
@@ -59,11 +80,19 @@ static void
 gst_mfxenc_jpeg_init (GstMfxEncJpeg * encode)
 {
   gst_mfxenc_init_properties (GST_MFXENC_CAST (encode));
+
+  encode->num_sessions = DEFAULT_NUM_SESSIONS;
+  encode->next_pts = GST_CLOCK_TIME_NONE;
+  gst_mfx_job_queue_init (&encode->jobs);
 }
 
 static void
 gst_mfxenc_jpeg_finalize (GObject * object)
 {
+  GstMfxEncJpeg *const encode = GST_MFXENC_JPEG_CAST (object);
+
+  gst_mfx_job_queue_clear (&encode->jobs);
+
   G_OBJECT_CLASS (gst_mfxenc_jpeg_parent_class)->finalize (object);
 }
 
@@ -73,8 +102,14 @@ gst_mfxenc_jpeg_set_property (GObject * object,
 {
   GstMfxEncClass *const encode_class = GST_MFXENC_GET_CLASS (object);
   GstMfxEnc *const base_encode = GST_MFXENC_CAST (object);
+  GstMfxEncJpeg *const encode = GST_MFXENC_JPEG_CAST (object);
 
   switch (prop_id) {
+    case PROP_NUM_SESSIONS:
+      GST_OBJECT_LOCK (encode);
+      encode->num_sessions = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (encode);
+      break;
     default:
       if (!encode_class->set_property (base_encode, prop_id, value))
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -88,8 +123,14 @@ gst_mfxenc_jpeg_get_property (GObject * object,
 {
   GstMfxEncClass *const encode_class = GST_MFXENC_GET_CLASS (object);
   GstMfxEnc *const base_encode = GST_MFXENC_CAST (object);
+  GstMfxEncJpeg *const encode = GST_MFXENC_JPEG_CAST (object);
 
   switch (prop_id) {
+    case PROP_NUM_SESSIONS:
+      GST_OBJECT_LOCK (encode);
+      g_value_set_uint (value, encode->num_sessions);
+      GST_OBJECT_UNLOCK (encode);
+      break;
     default:
       if (!encode_class->get_property (base_encode, prop_id, value))
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -97,6 +138,273 @@ gst_mfxenc_jpeg_get_property (GObject * object,
   }
 }
 
+static void
+job_free (GstMfxEncJpegJob * job)
+{
+  gst_mfx_surface_dequeue (job->surface);
+  gst_mfx_surface_unref (job->surface);
+  if (job->frame)
+    gst_video_codec_frame_unref (job->frame);
+  g_slice_free (GstMfxEncJpegJob, job);
+}
+
+/* Runs in a worker thread. Every encoder of the pool is used by one
+ * frame at a time, since at most num_sessions frames are in flight */
+static void
+encode_job (GstMfxEncJpegJob * job, GstMfxEncJpeg * encode)
+{
+  job->status = gst_mfx_encoder_encode (job->encoder, job->frame);
+
+  gst_mfx_job_queue_complete (&encode->jobs, &job->job);
+}
+
+/* Pushes encoded frames in input order, waiting for the oldest ones
+ * until no more than @max_pending frames are left in flight. Frames
+ * that produced no output are released, so the base class doesn't
+ * keep them around */
+static GstFlowReturn
+push_jobs (GstMfxEncJpeg * encode, guint max_pending)
+{
+  GstVideoEncoder *const venc = GST_VIDEO_ENCODER_CAST (encode);
+  GstMfxEncJpegJob *job;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (GST_FLOW_OK == ret) {
+    job = (GstMfxEncJpegJob *) gst_mfx_job_queue_pop (&encode->jobs,
+        max_pending);
+    if (!job)
+      break;
+
+    if (GST_MFX_ENCODER_STATUS_SUCCESS == job->status) {
+      ret = gst_mfxenc_push_frame (GST_MFXENC_CAST (encode), job->frame);
+    } else {
+      if (job->status < GST_MFX_ENCODER_STATUS_SUCCESS) {
+        GST_ERROR ("failed to encode frame %d (status %d)",
+            job->frame->system_frame_number, job->status);
+        ret = GST_FLOW_ERROR;
+      }
+      gst_video_encoder_finish_frame (venc, job->frame);
+    }
+    job->frame = NULL;
+    job_free (job);
+  }
+  return ret;
+}
+
+/* Waits for the frames in flight and drops them */
+static void
+discard_jobs (GstMfxEncJpeg * encode)
+{
+  GstMfxEncJpegJob *job;
+
+  while ((job = (GstMfxEncJpegJob *) gst_mfx_job_queue_pop (&encode->jobs,
+              0)))
+    job_free (job);
+}
+
+static void
+destroy_pool (GstMfxEncJpeg * encode)
+{
+  discard_jobs (encode);
+
+  if (encode->workers) {
+    g_thread_pool_free (encode->workers, FALSE, TRUE);
+    encode->workers = NULL;
+  }
+  if (encode->encoders) {
+    g_ptr_array_unref (encode->encoders);
+    encode->encoders = NULL;
+  }
+  encode->next_encoder = 0;
+  encode->next_pts = GST_CLOCK_TIME_NONE;
+}
+
+static gboolean
+ensure_pool (GstMfxEncJpeg * encode, guint num_sessions)
+{
+  GstMfxEnc *const base_encode = GST_MFXENC_CAST (encode);
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (encode);
+  GstVideoInfo *const info = &base_encode->input_state->info;
+  GstMfxEncoder *encoder;
+  guint i;
+
+  if (encode->workers)
+    return TRUE;
+
+  /* The first session is the one the base class already started */
+  encode->encoders = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) gst_mfx_encoder_unref);
+  g_ptr_array_add (encode->encoders,
+      gst_mfx_encoder_ref (base_encode->encoder));
+
+  for (i = 1; i < num_sessions; i++) {
+    encoder = gst_mfx_encoder_jpeg_new (plugin->aggregator,
+        &plugin->sinkpad_info, plugin->sinkpad_caps_is_raw);
+    if (!encoder)
+      goto error_create_encoder;
+    g_ptr_array_add (encode->encoders, encoder);
+
+    if (!gst_mfxenc_apply_properties (base_encode, encoder)
+        || GST_MFX_ENCODER_STATUS_SUCCESS !=
+            gst_mfx_encoder_set_codec_state (encoder, base_encode->input_state)
+        || GST_MFX_ENCODER_STATUS_SUCCESS != gst_mfx_encoder_start (encoder))
+      goto error_create_encoder;
+  }
+
+  /* Same frame duration as the encoder computes for its timestamps */
+  encode->duration = (info->fps_d / (gdouble) (info->fps_n ? info->fps_n : 30))
+      * 1000000000;
+
+  encode->workers = g_thread_pool_new ((GFunc) encode_job, encode,
+      num_sessions, FALSE, NULL);
+  if (!encode->workers)
+    goto error_create_encoder;
+
+  GST_INFO_OBJECT (encode, "encoding with %u sessions", num_sessions);
+  return TRUE;
+
+  /* ERRORS */
+error_create_encoder:
+  {
+    GST_ERROR_OBJECT (encode, "failed to create JPEG encoder session %u", i);
+    destroy_pool (encode);
+    return FALSE;
+  }
+}
+
+static GstFlowReturn
+gst_mfxenc_jpeg_handle_frame (GstVideoEncoder * venc,
+    GstVideoCodecFrame * frame)
+{
+  GstMfxEncJpeg *const encode = GST_MFXENC_JPEG_CAST (venc);
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (venc);
+  GstMfxEncJpegJob *job;
+  GstMfxVideoMeta *meta;
+  GstMfxSurface *surface;
+  GstFlowReturn ret;
+  GstBuffer *buf;
+  guint num_sessions;
+
+  GST_OBJECT_LOCK (encode);
+  num_sessions = encode->num_sessions;
+  GST_OBJECT_UNLOCK (encode);
+
+  /* Surfaces shared with an upstream MFX task belong to a single
+   * session, so only frames uploaded from system memory are spread */
+  if (num_sessions <= 1 || !plugin->sinkpad_caps_is_raw)
+    return GST_VIDEO_ENCODER_CLASS (gst_mfxenc_jpeg_parent_class)->handle_frame
+        (venc, frame);
+
+  if (!ensure_pool (encode, num_sessions))
+    goto error_pool;
+
+  /* Make room for this frame in the pool */
+  ret = push_jobs (encode, encode->encoders->len - 1);
+  if (GST_FLOW_OK != ret)
+    goto error_push;
+
+  ret = gst_mfx_plugin_base_get_input_buffer (plugin, frame->input_buffer,
+      &buf);
+  if (GST_FLOW_OK != ret)
+    goto error_push;
+
+  gst_buffer_replace (&frame->input_buffer, buf);
+  gst_buffer_unref (buf);
+
+  meta = gst_buffer_get_mfx_video_meta (frame->input_buffer);
+  surface = meta ? gst_mfx_video_meta_get_surface (meta) : NULL;
+  if (!surface)
+    goto error_buffer_no_surface;
+
+  gst_video_codec_frame_set_user_data (frame,
+      gst_mfx_surface_ref (surface), (GDestroyNotify) gst_mfx_surface_unref);
+
+  /* Each session keeps its own timestamp counter, so keep them in step
+   * with what a single session would have produced */
+  if (!GST_CLOCK_TIME_IS_VALID (encode->next_pts))
+    encode->next_pts = 0;
+  if (GST_CLOCK_TIME_IS_VALID (frame->pts) && frame->pts > encode->next_pts)
+    encode->next_pts = frame->pts;
+  frame->pts = encode->next_pts;
+  encode->next_pts += encode->duration;
+
+  job = g_slice_new0 (GstMfxEncJpegJob);
+  job->frame = frame;
+  job->surface = gst_mfx_surface_ref (surface);
+  job->encoder = g_ptr_array_index (encode->encoders,
+      encode->next_encoder++ % encode->encoders->len);
+
+  gst_mfx_job_queue_push (&encode->jobs, &job->job);
+  g_thread_pool_push (encode->workers, job, NULL);
+
+  /* Output whatever is already done without blocking */
+  return push_jobs (encode, G_MAXUINT);
+
+  /* ERRORS */
+error_pool:
+  {
+    gst_video_codec_frame_unref (frame);
+    return GST_FLOW_ERROR;
+  }
+error_push:
+  {
+    gst_video_codec_frame_unref (frame);
+    return ret;
+  }
+error_buffer_no_surface:
+  {
+    GST_ERROR ("failed to get VA surface");
+    gst_video_codec_frame_unref (frame);
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_mfxenc_jpeg_finish (GstVideoEncoder * venc)
+{
+  GstMfxEncJpeg *const encode = GST_MFXENC_JPEG_CAST (venc);
+  GstFlowReturn ret;
+
+  ret = push_jobs (encode, 0);
+  if (GST_FLOW_OK != ret)
+    return ret;
+
+  return GST_VIDEO_ENCODER_CLASS (gst_mfxenc_jpeg_parent_class)->finish
+      (venc);
+}
+
+static gboolean
+gst_mfxenc_jpeg_set_format (GstVideoEncoder * venc,
+    GstVideoCodecState * state)
+{
+  GstMfxEncJpeg *const encode = GST_MFXENC_JPEG_CAST (venc);
+
+  /* The pool sessions are set up for the previous format */
+  push_jobs (encode, 0);
+  destroy_pool (encode);
+
+  return GST_VIDEO_ENCODER_CLASS (gst_mfxenc_jpeg_parent_class)->set_format
+      (venc, state);
+}
+
+static gboolean
+gst_mfxenc_jpeg_flush (GstVideoEncoder * venc)
+{
+  GstMfxEncJpeg *const encode = GST_MFXENC_JPEG_CAST (venc);
+
+  discard_jobs (encode);
+  encode->next_pts = GST_CLOCK_TIME_NONE;
+  return TRUE;
+}
+
+static gboolean
+gst_mfxenc_jpeg_stop (GstVideoEncoder * venc)
+{
+  destroy_pool (GST_MFXENC_JPEG_CAST (venc));
+
+  return GST_VIDEO_ENCODER_CLASS (gst_mfxenc_jpeg_parent_class)->stop (venc);
+}
+
 static GstCaps *
 gst_mfxenc_jpeg_get_caps (GstMfxEnc * base_encode)
 {
@@ -124,6 +432,7 @@ gst_mfxenc_jpeg_class_init (GstMfxEncJpegClass * klass)
 {
   GObjectClass *const object_class = G_OBJECT_CLASS (klass);
   GstElementClass *const element_class = GST_ELEMENT_CLASS (klass);
+  GstVideoEncoderClass *const venc_class = GST_VIDEO_ENCODER_CLASS (klass);
   GstMfxEncClass *const encode_class = GST_MFXENC_CLASS (klass);
 
   GST_DEBUG_CATEGORY_INIT (gst_mfx_jpeg_encode_debug,
@@ -137,6 +446,12 @@ gst_mfxenc_jpeg_class_init (GstMfxEncJpegClass * klass)
   encode_class->get_caps = gst_mfxenc_jpeg_get_caps;
   encode_class->alloc_encoder = gst_mfxenc_jpeg_alloc_encoder;
 
+  venc_class->set_format = GST_DEBUG_FUNCPTR (gst_mfxenc_jpeg_set_format);
+  venc_class->handle_frame = GST_DEBUG_FUNCPTR (gst_mfxenc_jpeg_handle_frame);
+  venc_class->finish = GST_DEBUG_FUNCPTR (gst_mfxenc_jpeg_finish);
+  venc_class->flush = GST_DEBUG_FUNCPTR (gst_mfxenc_jpeg_flush);
+  venc_class->stop = GST_DEBUG_FUNCPTR (gst_mfxenc_jpeg_stop);
+
   gst_element_class_set_static_metadata (element_class,
       "MFX JPEG encoder",
       "Codec/Encoder/Video",
@@ -151,4 +466,19 @@ gst_mfxenc_jpeg_class_init (GstMfxEncJpegClass * klass)
       gst_static_pad_template_get (&gst_mfxenc_jpeg_src_factory));
 
   gst_mfxenc_class_init_properties (encode_class);
+
+  /**
+   * GstMfxEncJpeg:num-sessions:
+   *
+   * Number of joined MFX sessions that frames are distributed over.
+   * JPEG frames are independent, so they are encoded in parallel and
+   * output in input order. Only applies to input in system memory.
+   */
+  g_object_class_install_property (object_class, PROP_NUM_SESSIONS,
+      g_param_spec_uint ("num-sessions",
+          "Number of sessions",
+          "Number of MFX sessions to encode frames in parallel",
+          1, 16, DEFAULT_NUM_SESSIONS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
@@ -24,6 +24,8 @@
 #include <gst/gst.h>
 #include "gstmfxenc.h"
 
+#include <gst-libs/mfx/gstmfxjobqueue.h>
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_MFXENC_JPEG \
@@ -47,10 +49,25 @@ G_BEGIN_DECLS
 typedef struct _GstMfxEncJpeg GstMfxEncJpeg;
 typedef struct _GstMfxEncJpegClass GstMfxEncJpegClass;
 
+typedef struct _GstMfxEncJpegJob GstMfxEncJpegJob;
+
 struct _GstMfxEncJpeg
 {
   /*< private >*/
   GstMfxEnc parent_instance;
+
+  /* Settings, protected by the object lock */
+  guint                   num_sessions;
+
+  /* Encoder pool, protected by the sink pad stream lock */
+  GPtrArray              *encoders;
+  guint                   next_encoder;
+  GstClockTime            next_pts;
+  GstClockTime            duration;
+
+  /* Frames being encoded, in input order */
+  GThreadPool            *workers;
+  GstMfxJobQueue          jobs;
 };
 
 struct _GstMfxEncJpegClass
@@ -0,0 +1,1288 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "gst-libs/mfx/sysdeps.h"
+#include <gst/base/gstbytereader.h>
+
+#include "gstmfxgoptranscode.h"
+#include "gstmfxpluginutil.h"
+
+#include <gst-libs/mfx/gstmfxdecoder.h>
+#include <gst-libs/mfx/gstmfxencoder.h>
+#ifdef MFX_H264_ENCODER
+# include <gst-libs/mfx/gstmfxencoder_h264.h>
+#endif
+#ifdef MFX_H265_ENCODER
+# include <gst-libs/mfx/gstmfxencoder_h265.h>
+#endif
+
+#define GST_PLUGIN_NAME "mfxgoptranscode"
+#define GST_PLUGIN_DESC "A MFX-based GOP-parallel video transcoder"
+
+GST_DEBUG_CATEGORY_STATIC (gst_debug_mfxgoptranscode);
+#define GST_CAT_DEFAULT gst_debug_mfxgoptranscode
+
+/* The input stream is cut into segments at IDR access units. Each
+ * segment is decoded and encoded from scratch on its own pair of MFX
+ * sessions, and up to num-sessions segments are transcoded at the same
+ * time. The encoded segments are pushed downstream in input order. Since
+ * every segment starts with an IDR picture and all the encoders share the
+ * same settings, the concatenated output is a single conforming stream.
+ * This is meant for offline transcoding of files, where the added latency
+ * of several segments doesn't matter.
+ *
+ * Streams with very long or no GOPs would have whole segments buffered
+ * in memory, so a segment that grows past max-segment-frames without
+ * meeting an IDR access unit is transcoded serially instead: the earlier
+ * segments are pushed out, and its input goes through one pair of
+ * sessions in the streaming thread as it comes in, until the next IDR
+ * access unit starts a parallel segment again. */
+
+#define DEFAULT_ASYNC_DEPTH             4
+
+/* Default templates */
+static const char gst_mfxgoptranscode_sink_caps_str[] =
+    "video/x-h264, "
+    "stream-format = (string) byte-stream, alignment = (string) au; "
+    "video/x-h265, "
+    "stream-format = (string) byte-stream, alignment = (string) au";
+
+static const char gst_mfxgoptranscode_src_caps_str[] =
+    "video/x-h264, "
+    "stream-format = (string) byte-stream, alignment = (string) au; "
+    "video/x-h265, "
+    "stream-format = (string) byte-stream, alignment = (string) au";
+
+static GstStaticPadTemplate gst_mfxgoptranscode_sink_factory =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (gst_mfxgoptranscode_sink_caps_str));
+
+static GstStaticPadTemplate gst_mfxgoptranscode_src_factory =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (gst_mfxgoptranscode_src_caps_str));
+
+G_DEFINE_TYPE_WITH_CODE (GstMfxGopTranscode,
+    gst_mfxgoptranscode,
+    GST_TYPE_ELEMENT,
+    GST_MFX_PLUGIN_BASE_INIT_INTERFACES);
+
+enum
+{
+  PROP_0,
+
+  PROP_CODEC,
+  PROP_BITRATE,
+  PROP_RATE_CONTROL,
+  PROP_GOP_SIZE,
+  PROP_NUM_SESSIONS,
+  PROP_MIN_SEGMENT_FRAMES,
+  PROP_MAX_SEGMENT_FRAMES,
+};
+
+#define DEFAULT_CODEC                   GST_MFXGOPTRANSCODE_CODEC_H264
+#define DEFAULT_BITRATE                 0
+#define DEFAULT_RATE_CONTROL            GST_MFX_RATECONTROL_VBR
+#define DEFAULT_GOP_SIZE                0
+#define DEFAULT_NUM_SESSIONS            2
+#define DEFAULT_MIN_SEGMENT_FRAMES      60
+#define DEFAULT_MAX_SEGMENT_FRAMES      1200
+
+GType
+gst_mfxgoptranscode_codec_get_type (void)
+{
+  static volatile gsize g_type = 0;
+
+  static const GEnumValue codec_values[] = {
+    {GST_MFXGOPTRANSCODE_CODEC_H264,
+        "H.264", "h264"},
+    {GST_MFXGOPTRANSCODE_CODEC_H265,
+        "H.265", "h265"},
+    {0, NULL, NULL},
+  };
+
+  if (g_once_init_enter (&g_type)) {
+    GType type =
+        g_enum_register_static ("GstMfxGopTranscodeCodec", codec_values);
+    g_once_init_leave (&g_type, type);
+  }
+  return g_type;
+}
+
+/* ------------------------------------------------------------------------ */
+/* --- Segments                                                         --- */
+/* ------------------------------------------------------------------------ */
+
+struct _GstMfxGopSegment
+{
+  guint index;
+  guint num_frames;
+
+  /* Encoded access units, starting with an IDR one */
+  GQueue input;
+  /* Transcoded access units, filled in by the worker */
+  GQueue output;
+
+  /* Stream and encoder settings when the segment was started */
+  GstMfxProfile profile;
+  GstVideoInfo info;
+  GstMfxGopTranscodeCodec codec;
+  guint bitrate;
+  GstMfxRateControl rate_control;
+  guint gop_size;
+
+  GstFlowReturn ret;
+  gboolean done;
+
+  /* Constant DTS shift, computed from the first output access units */
+  GstClockTimeDiff dts_offset;
+  gboolean has_dts_offset;
+
+  /* Sessions of a serial segment, used from the streaming thread */
+  gboolean serial;
+  GstMfxDecoder *decoder;
+  GstMfxEncoder *encoder;
+  guint next_frame;
+};
+
+static GstMfxGopSegment *
+gst_mfx_gop_segment_new (GstMfxGopTranscode * self)
+{
+  GstMfxGopSegment *segment;
+
+  segment = g_slice_new0 (GstMfxGopSegment);
+  if (!segment)
+    return NULL;
+
+  segment->index = self->next_index++;
+  g_queue_init (&segment->input);
+  g_queue_init (&segment->output);
+  segment->profile = self->profile;
+  segment->info = self->info;
+
+  GST_OBJECT_LOCK (self);
+  segment->codec = self->codec;
+  segment->bitrate = self->bitrate;
+  segment->rate_control = self->rate_control;
+  segment->gop_size = self->gop_size;
+  GST_OBJECT_UNLOCK (self);
+
+  segment->ret = GST_FLOW_OK;
+  return segment;
+}
+
+static void
+gst_mfx_gop_segment_free (GstMfxGopSegment * segment)
+{
+  if (!segment)
+    return;
+
+  g_queue_foreach (&segment->input, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&segment->input);
+  g_queue_foreach (&segment->output, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&segment->output);
+  g_slice_free (GstMfxGopSegment, segment);
+}
+
+/* ------------------------------------------------------------------------ */
+/* --- Segment transcoding                                              --- */
+/* ------------------------------------------------------------------------ */
+
+static GstMfxEncoder *
+create_encoder (GstMfxTaskAggregator * aggregator, GstMfxGopSegment * segment)
+{
+  switch (segment->codec) {
+#ifdef MFX_H264_ENCODER
+    case GST_MFXGOPTRANSCODE_CODEC_H264:
+      return gst_mfx_encoder_h264_new (aggregator, &segment->info, FALSE);
+#endif
+#ifdef MFX_H265_ENCODER
+    case GST_MFXGOPTRANSCODE_CODEC_H265:
+      return gst_mfx_encoder_h265_new (aggregator, &segment->info, FALSE);
+#endif
+    default:
+      GST_ERROR ("codec %d is not supported in this build", segment->codec);
+      return NULL;
+  }
+}
+
+static gboolean
+set_encoder_uint (GstMfxEncoder * encoder, GstMfxEncoderProp prop_id,
+    guint v)
+{
+  GValue value = G_VALUE_INIT;
+  GstMfxEncoderStatus status;
+
+  g_value_init (&value, G_TYPE_UINT);
+  g_value_set_uint (&value, v);
+  status = gst_mfx_encoder_set_property (encoder, prop_id, &value);
+  g_value_unset (&value);
+
+  return status == GST_MFX_ENCODER_STATUS_SUCCESS;
+}
+
+static gboolean
+set_encoder_rate_control (GstMfxEncoder * encoder,
+    GstMfxRateControl rate_control)
+{
+  GValue value = G_VALUE_INIT;
+  GstMfxEncoderStatus status;
+
+  g_value_init (&value, GST_MFX_TYPE_RATE_CONTROL);
+  g_value_set_enum (&value, rate_control);
+  status = gst_mfx_encoder_set_property (encoder,
+      GST_MFX_ENCODER_PROP_RATECONTROL, &value);
+  g_value_unset (&value);
+
+  return status == GST_MFX_ENCODER_STATUS_SUCCESS;
+}
+
+/* Creates the decoder and the encoder of a segment. The encoder shares
+ * the decoder task, so that decoded surfaces are encoded in place. */
+static gboolean
+gst_mfxgoptranscode_open_sessions (GstMfxGopTranscode * self,
+    GstMfxGopSegment * segment, GstMfxDecoder ** decoder_ptr,
+    GstMfxEncoder ** encoder_ptr)
+{
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (self);
+  GstVideoCodecState state = { 0, };
+  GstMfxDecoder *decoder = NULL;
+  GstMfxEncoder *encoder = NULL;
+
+  g_mutex_lock (&self->setup_lock);
+  decoder = gst_mfx_decoder_new (plugin->aggregator, segment->profile,
+      &segment->info, DEFAULT_ASYNC_DEPTH, FALSE, FALSE, NULL);
+  if (!decoder)
+    goto error;
+  gst_mfx_decoder_should_use_video_memory (decoder, TRUE);
+
+  encoder = create_encoder (plugin->aggregator, segment);
+  if (!encoder)
+    goto error;
+  g_mutex_unlock (&self->setup_lock);
+
+  if (!set_encoder_rate_control (encoder, segment->rate_control)
+      || !set_encoder_uint (encoder, GST_MFX_ENCODER_PROP_BITRATE,
+          segment->bitrate)
+      || !set_encoder_uint (encoder, GST_MFX_ENCODER_PROP_GOP_SIZE,
+          segment->gop_size))
+    goto error_configure;
+
+  state.info = segment->info;
+  if (gst_mfx_encoder_set_codec_state (encoder, &state)
+      != GST_MFX_ENCODER_STATUS_SUCCESS)
+    goto error_configure;
+  if (gst_mfx_encoder_start (encoder) != GST_MFX_ENCODER_STATUS_SUCCESS)
+    goto error_configure;
+
+  *decoder_ptr = decoder;
+  *encoder_ptr = encoder;
+  return TRUE;
+  /* ERRORS */
+error:
+  {
+    g_mutex_unlock (&self->setup_lock);
+    GST_ERROR_OBJECT (self, "failed to create sessions for segment %u",
+        segment->index);
+    goto error_cleanup;
+  }
+error_configure:
+  {
+    GST_ERROR_OBJECT (self, "failed to configure encoder for segment %u",
+        segment->index);
+    goto error_cleanup;
+  }
+error_cleanup:
+  {
+    g_mutex_lock (&self->setup_lock);
+    gst_mfx_encoder_replace (&encoder, NULL);
+    gst_mfx_decoder_replace (&decoder, NULL);
+    g_mutex_unlock (&self->setup_lock);
+    return FALSE;
+  }
+}
+
+static void
+gst_mfxgoptranscode_close_sessions (GstMfxGopTranscode * self,
+    GstMfxDecoder ** decoder_ptr, GstMfxEncoder ** encoder_ptr)
+{
+  /* Tasks are removed from the shared aggregator on destruction */
+  g_mutex_lock (&self->setup_lock);
+  gst_mfx_encoder_replace (encoder_ptr, NULL);
+  gst_mfx_decoder_replace (decoder_ptr, NULL);
+  g_mutex_unlock (&self->setup_lock);
+}
+
+static void
+queue_output_buffer (GstMfxGopSegment * segment, GstVideoCodecFrame * frame)
+{
+  GstBuffer *outbuf;
+
+  /* The output buffer wraps the bitstream of the encoder, which is
+   * overwritten by the next frame */
+  outbuf = gst_buffer_copy_deep (frame->output_buffer);
+  gst_buffer_replace (&frame->output_buffer, NULL);
+  if (!outbuf)
+    return;
+
+  GST_BUFFER_PTS (outbuf) = frame->pts;
+  GST_BUFFER_DTS (outbuf) = frame->dts;
+  GST_BUFFER_DURATION (outbuf) = frame->duration;
+  if (!GST_VIDEO_CODEC_FRAME_IS_SYNC_POINT (frame))
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  g_queue_push_tail (&segment->output, outbuf);
+}
+
+static void
+release_discarded_frames (GstMfxDecoder * decoder)
+{
+  GstVideoCodecFrame *frame;
+
+  while ((frame = gst_mfx_decoder_get_discarded_frame (decoder)))
+    gst_video_codec_frame_unref (frame);
+}
+
+static GstFlowReturn
+encode_decoded_frames (GstMfxGopSegment * segment, GstMfxDecoder * decoder,
+    GstMfxEncoder * encoder)
+{
+  GstVideoCodecFrame *frame;
+  GstMfxEncoderStatus status;
+
+  while (gst_mfx_decoder_get_decoded_frames (decoder, &frame)) {
+    /* Decode-only frames carry no surface */
+    if (!gst_video_codec_frame_get_user_data (frame)) {
+      gst_video_codec_frame_unref (frame);
+      continue;
+    }
+
+    status = gst_mfx_encoder_encode (encoder, frame);
+    if (status < GST_MFX_ENCODER_STATUS_SUCCESS) {
+      GST_ERROR ("failed to encode frame of segment %u (status %d)",
+          segment->index, status);
+      gst_video_codec_frame_unref (frame);
+      return GST_FLOW_ERROR;
+    }
+    if (status == GST_MFX_ENCODER_STATUS_SUCCESS && frame->output_buffer)
+      queue_output_buffer (segment, frame);
+    gst_video_codec_frame_unref (frame);
+  }
+  return GST_FLOW_OK;
+}
+
+/* Decodes one access unit of @segment and encodes the decoded frames */
+static GstFlowReturn
+transcode_access_unit (GstMfxGopSegment * segment, GstMfxDecoder * decoder,
+    GstMfxEncoder * encoder, GstBuffer * buf, guint frame_number)
+{
+  GstVideoCodecFrame *frame;
+  GstMfxDecoderStatus sts;
+
+  frame = g_slice_new0 (GstVideoCodecFrame);
+  frame->ref_count = 1;
+  frame->system_frame_number = frame_number;
+  frame->input_buffer = buf;
+  frame->pts = GST_BUFFER_PTS (buf);
+  frame->dts = GST_BUFFER_DTS (buf);
+  frame->duration = GST_BUFFER_DURATION (buf);
+  if (!GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT))
+    GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (frame);
+
+  /* The frame is owned by the decoder from now on */
+  sts = gst_mfx_decoder_decode (decoder, frame);
+  release_discarded_frames (decoder);
+
+  if (GST_MFX_DECODER_STATUS_ERROR_MORE_DATA == sts)
+    return GST_FLOW_OK;
+  if (GST_MFX_DECODER_STATUS_SUCCESS != sts) {
+    GST_ERROR ("failed to decode segment %u (status %d)", segment->index,
+        sts);
+    return GST_FLOW_ERROR;
+  }
+
+  return encode_decoded_frames (segment, decoder, encoder);
+}
+
+/* Drains the decoder and the encoder once all input of @segment is in */
+static GstFlowReturn
+finish_segment (GstMfxGopSegment * segment, GstMfxDecoder * decoder,
+    GstMfxEncoder * encoder)
+{
+  GstMfxDecoderStatus sts;
+  GstMfxEncoderStatus status;
+  GstVideoCodecFrame *frame;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  do {
+    sts = gst_mfx_decoder_flush (decoder);
+    if (GST_MFX_DECODER_STATUS_FLUSHED == sts)
+      break;
+    ret = encode_decoded_frames (segment, decoder, encoder);
+  } while (GST_MFX_DECODER_STATUS_SUCCESS == sts && GST_FLOW_OK == ret);
+  release_discarded_frames (decoder);
+  if (GST_FLOW_OK != ret)
+    return ret;
+
+  do {
+    frame = NULL;
+    status = gst_mfx_encoder_flush (encoder, &frame);
+    if (GST_MFX_ENCODER_STATUS_SUCCESS != status || !frame)
+      break;
+    queue_output_buffer (segment, frame);
+    g_slice_free (GstVideoCodecFrame, frame);
+  } while (TRUE);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_mfxgoptranscode_transcode (GstMfxGopTranscode * self,
+    GstMfxGopSegment * segment)
+{
+  GstMfxDecoder *decoder = NULL;
+  GstMfxEncoder *encoder = NULL;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *buf;
+  guint n = 0;
+
+  if (!gst_mfxgoptranscode_open_sessions (self, segment, &decoder, &encoder))
+    return GST_FLOW_ERROR;
+
+  while ((buf = g_queue_pop_head (&segment->input))) {
+    if (g_atomic_int_get (&self->flushing)) {
+      gst_buffer_unref (buf);
+      ret = GST_FLOW_FLUSHING;
+      goto done;
+    }
+
+    ret = transcode_access_unit (segment, decoder, encoder, buf, n++);
+    if (GST_FLOW_OK != ret)
+      goto done;
+  }
+
+  ret = finish_segment (segment, decoder, encoder);
+  if (GST_FLOW_OK != ret)
+    goto done;
+
+  GST_DEBUG_OBJECT (self, "segment %u: %u frames in, %u frames out",
+      segment->index, segment->num_frames, g_queue_get_length (&segment->output));
+
+done:
+  gst_mfxgoptranscode_close_sessions (self, &decoder, &encoder);
+  return ret;
+}
+
+static void
+gst_mfxgoptranscode_worker (gpointer data, gpointer user_data)
+{
+  GstMfxGopSegment *const segment = data;
+  GstMfxGopTranscode *const self = user_data;
+  GstFlowReturn ret;
+
+  ret = gst_mfxgoptranscode_transcode (self, segment);
+
+  g_mutex_lock (&self->lock);
+  segment->ret = ret;
+  segment->done = TRUE;
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+/* ------------------------------------------------------------------------ */
+/* --- Streaming                                                        --- */
+/* ------------------------------------------------------------------------ */
+
+/* Every segment is encoded from scratch, so its decode timestamps start
+ * one reordering delay before its first presentation timestamp and may
+ * reach back into the previous segment. Returns the constant amount the
+ * whole segment is shifted by, so that it uses the decode delay of the
+ * first segment of the stream and keeps the DTS spacing of the encoder */
+static GstClockTimeDiff
+get_segment_dts_offset (GstMfxGopTranscode * self, GstMfxGopSegment * segment)
+{
+  GstClockTime first_dts, min_pts = GST_CLOCK_TIME_NONE;
+  GstClockTimeDiff delay, offset;
+  GstBuffer *buf;
+  GList *l;
+
+  buf = g_queue_peek_head (&segment->output);
+  if (!buf || !GST_BUFFER_DTS_IS_VALID (buf))
+    return 0;
+  first_dts = GST_BUFFER_DTS (buf);
+
+  for (l = segment->output.head; l; l = l->next) {
+    buf = l->data;
+    if (GST_BUFFER_PTS_IS_VALID (buf) && (!GST_CLOCK_TIME_IS_VALID (min_pts)
+            || GST_BUFFER_PTS (buf) < min_pts))
+      min_pts = GST_BUFFER_PTS (buf);
+  }
+  if (!GST_CLOCK_TIME_IS_VALID (min_pts))
+    return 0;
+
+  delay = MAX (GST_CLOCK_DIFF (first_dts, min_pts), 0);
+  if (!GST_CLOCK_TIME_IS_VALID (self->dts_delay))
+    self->dts_delay = delay;
+  offset = delay - (GstClockTimeDiff) self->dts_delay;
+
+  /* A segment with a longer delay than the first one would otherwise
+   * start decoding before the previous segment is done */
+  if (GST_CLOCK_TIME_IS_VALID (self->last_dts)
+      && (GstClockTimeDiff) first_dts + offset <
+      (GstClockTimeDiff) self->last_dts)
+    offset = GST_CLOCK_DIFF (first_dts, self->last_dts);
+  if ((GstClockTimeDiff) first_dts + offset < 0)
+    offset = -(GstClockTimeDiff) first_dts;
+
+  GST_LOG_OBJECT (self, "segment %u: decode delay %" GST_STIME_FORMAT
+      ", DTS offset %" GST_STIME_FORMAT, segment->index,
+      GST_STIME_ARGS (delay), GST_STIME_ARGS (offset));
+  return offset;
+}
+
+static GstFlowReturn
+gst_mfxgoptranscode_push_segment (GstMfxGopTranscode * self,
+    GstMfxGopSegment * segment)
+{
+  GstPad *const srcpad = GST_MFX_PLUGIN_BASE_SRC_PAD (self);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *buf;
+
+  if (GST_FLOW_OK != segment->ret) {
+    if (GST_FLOW_ERROR == segment->ret)
+      GST_ELEMENT_ERROR (self, STREAM, ENCODE, (NULL),
+          ("failed to transcode segment %u", segment->index));
+    return segment->ret;
+  }
+
+  /* A serial segment is pushed piecewise, with the offset of its first
+   * output access units */
+  if (!segment->has_dts_offset && !g_queue_is_empty (&segment->output)) {
+    segment->dts_offset = get_segment_dts_offset (self, segment);
+    segment->has_dts_offset = TRUE;
+  }
+
+  while (GST_FLOW_OK == ret && (buf = g_queue_pop_head (&segment->output))) {
+    if (GST_BUFFER_DTS_IS_VALID (buf)) {
+      GST_BUFFER_DTS (buf) += segment->dts_offset;
+      self->last_dts = GST_BUFFER_DTS (buf);
+    }
+
+    ret = gst_pad_push (srcpad, buf);
+  }
+  return ret;
+}
+
+/* Pushes the transcoded segments downstream in input order, waiting for
+ * the oldest ones until at most max_pending segments are in flight */
+static GstFlowReturn
+gst_mfxgoptranscode_push_segments (GstMfxGopTranscode * self,
+    guint max_pending)
+{
+  GstMfxGopSegment *segment;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&self->lock);
+  while (GST_FLOW_OK == ret && (segment = g_queue_peek_head (&self->segments))) {
+    if (!segment->done) {
+      if (g_queue_get_length (&self->segments) <= max_pending)
+        break;
+      g_cond_wait (&self->cond, &self->lock);
+      continue;
+    }
+    g_queue_pop_head (&self->segments);
+    g_mutex_unlock (&self->lock);
+
+    ret = gst_mfxgoptranscode_push_segment (self, segment);
+    gst_mfx_gop_segment_free (segment);
+
+    g_mutex_lock (&self->lock);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return ret;
+}
+
+/* Transcodes the input of a serial segment that came in so far and
+ * pushes out whatever the encoder has output */
+static GstFlowReturn
+gst_mfxgoptranscode_transcode_serial (GstMfxGopTranscode * self,
+    GstMfxGopSegment * segment)
+{
+  GstBuffer *buf;
+
+  while (GST_FLOW_OK == segment->ret
+      && (buf = g_queue_pop_head (&segment->input)))
+    segment->ret = transcode_access_unit (segment, segment->decoder,
+        segment->encoder, buf, segment->next_frame++);
+
+  return gst_mfxgoptranscode_push_segment (self, segment);
+}
+
+/* Switches the current segment to serial transcoding, once all earlier
+ * segments are pushed */
+static GstFlowReturn
+gst_mfxgoptranscode_start_serial (GstMfxGopTranscode * self)
+{
+  GstMfxGopSegment *const segment = self->segment;
+  GstFlowReturn ret;
+
+  GST_WARNING_OBJECT (self, "no IDR access unit within %u frames, "
+      "transcoding segment %u serially", segment->num_frames, segment->index);
+
+  ret = gst_mfxgoptranscode_push_segments (self, 0);
+  if (GST_FLOW_OK != ret)
+    return ret;
+
+  if (!gst_mfxgoptranscode_open_sessions (self, segment, &segment->decoder,
+          &segment->encoder)) {
+    GST_ELEMENT_ERROR (self, STREAM, ENCODE, (NULL),
+        ("failed to open sessions for segment %u", segment->index));
+    return GST_FLOW_ERROR;
+  }
+  segment->serial = TRUE;
+
+  return gst_mfxgoptranscode_transcode_serial (self, segment);
+}
+
+/* Drains and pushes the rest of a serial segment, and frees it */
+static GstFlowReturn
+gst_mfxgoptranscode_finish_serial (GstMfxGopTranscode * self,
+    GstMfxGopSegment * segment)
+{
+  GstFlowReturn ret = segment->ret;
+
+  /* Errors were already pushed with the part that failed */
+  if (GST_FLOW_OK == ret) {
+    segment->ret = finish_segment (segment, segment->decoder,
+        segment->encoder);
+    ret = gst_mfxgoptranscode_push_segment (self, segment);
+  }
+
+  gst_mfxgoptranscode_close_sessions (self, &segment->decoder,
+      &segment->encoder);
+  gst_mfx_gop_segment_free (segment);
+  return ret;
+}
+
+static GstFlowReturn
+gst_mfxgoptranscode_dispatch_segment (GstMfxGopTranscode * self)
+{
+  GstMfxGopSegment *const segment = self->segment;
+  guint num_sessions;
+
+  if (!segment)
+    return GST_FLOW_OK;
+  self->segment = NULL;
+
+  if (segment->serial)
+    return gst_mfxgoptranscode_finish_serial (self, segment);
+
+  GST_DEBUG_OBJECT (self, "dispatching segment %u of %u frames",
+      segment->index, segment->num_frames);
+
+  g_mutex_lock (&self->lock);
+  g_queue_push_tail (&self->segments, segment);
+  g_mutex_unlock (&self->lock);
+  g_thread_pool_push (self->workers, segment, NULL);
+
+  GST_OBJECT_LOCK (self);
+  num_sessions = self->num_sessions;
+  GST_OBJECT_UNLOCK (self);
+
+  return gst_mfxgoptranscode_push_segments (self, num_sessions);
+}
+
+/* Waits for all in-flight segments and drops them */
+static void
+gst_mfxgoptranscode_discard_segments (GstMfxGopTranscode * self)
+{
+  GstMfxGopSegment *segment;
+
+  g_mutex_lock (&self->lock);
+  while ((segment = g_queue_peek_head (&self->segments))) {
+    if (!segment->done) {
+      g_cond_wait (&self->cond, &self->lock);
+      continue;
+    }
+    g_queue_pop_head (&self->segments);
+    gst_mfx_gop_segment_free (segment);
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (self->segment && self->segment->serial)
+    gst_mfxgoptranscode_close_sessions (self, &self->segment->decoder,
+        &self->segment->encoder);
+  gst_mfx_gop_segment_free (self->segment);
+  self->segment = NULL;
+  self->last_dts = GST_CLOCK_TIME_NONE;
+  self->dts_delay = GST_CLOCK_TIME_NONE;
+}
+
+static GstBuffer *
+prepend_headers (GstMfxGopTranscode * self, GstBuffer * buf)
+{
+  GstBuffer *outbuf;
+
+  outbuf = gst_buffer_copy (self->headers);
+  gst_buffer_copy_into (outbuf, buf,
+      GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+  return gst_buffer_append (outbuf, buf);
+}
+
+/* Looks for IDR pictures and parameter sets in a byte-stream access unit.
+ * Parameter sets are saved, so that they can be repeated at the start of
+ * segments whose IDR access unit doesn't carry them. */
+static void
+scan_access_unit (GstMfxGopTranscode * self, GstBuffer * buf,
+    gboolean * is_idr_ptr, gboolean * has_headers_ptr)
+{
+  const gboolean is_hevc =
+      gst_mfx_profile_get_codec (self->profile) == MFX_CODEC_HEVC;
+  GByteArray *headers = NULL;
+  GstByteReader br;
+  GstMapInfo minfo;
+  gint offset, next;
+  guint nal_type, size;
+  gboolean is_idr = FALSE, has_headers = FALSE, is_header;
+
+  if (!gst_buffer_map (buf, &minfo, GST_MAP_READ))
+    goto done;
+
+  gst_byte_reader_init (&br, minfo.data, minfo.size);
+  offset = gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
+      0, minfo.size);
+
+  while (offset >= 0) {
+    if (offset + 4 < minfo.size)
+      next = gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00,
+          0x00000100, offset + 4, minfo.size - offset - 4);
+    else
+      next = -1;
+    size = (next >= 0 ? next : minfo.size) - offset;
+
+    if (is_hevc) {
+      nal_type = (minfo.data[offset + 3] >> 1) & 0x3f;
+      is_idr |= (nal_type == 19 || nal_type == 20);
+      is_header = (nal_type >= 32 && nal_type <= 34);
+    } else {
+      nal_type = minfo.data[offset + 3] & 0x1f;
+      is_idr |= (nal_type == 5);
+      is_header = (nal_type == 7 || nal_type == 8);
+    }
+
+    if (is_header) {
+      if (!headers)
+        headers = g_byte_array_new ();
+      g_byte_array_append (headers, minfo.data + offset, size);
+    }
+    offset = next;
+  }
+  gst_buffer_unmap (buf, &minfo);
+
+  if (headers) {
+    gsize len = headers->len;
+
+    gst_buffer_replace (&self->headers, NULL);
+    self->headers = gst_buffer_new_wrapped (g_byte_array_free (headers, FALSE),
+        len);
+    has_headers = TRUE;
+  }
+
+done:
+  *is_idr_ptr = is_idr;
+  *has_headers_ptr = has_headers;
+}
+
+static GstFlowReturn
+gst_mfxgoptranscode_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstMfxGopTranscode *const self = GST_MFXGOPTRANSCODE (parent);
+  GstFlowReturn ret;
+  gboolean is_idr, has_headers;
+  guint min_segment_frames, max_segment_frames;
+
+  if (!self->profile)
+    goto error_not_negotiated;
+
+  scan_access_unit (self, buf, &is_idr, &has_headers);
+
+  GST_OBJECT_LOCK (self);
+  min_segment_frames = self->min_segment_frames;
+  max_segment_frames = self->max_segment_frames;
+  GST_OBJECT_UNLOCK (self);
+
+  if (is_idr && self->segment
+      && self->segment->num_frames >= min_segment_frames) {
+    ret = gst_mfxgoptranscode_dispatch_segment (self);
+    if (GST_FLOW_OK != ret) {
+      gst_buffer_unref (buf);
+      return ret;
+    }
+  }
+
+  if (!self->segment) {
+    if (!is_idr) {
+      GST_DEBUG_OBJECT (self, "dropping access unit before first IDR");
+      gst_buffer_unref (buf);
+      return GST_FLOW_OK;
+    }
+
+    self->segment = gst_mfx_gop_segment_new (self);
+    if (!has_headers && self->headers)
+      buf = prepend_headers (self, buf);
+  }
+
+  g_queue_push_tail (&self->segment->input, buf);
+  self->segment->num_frames++;
+
+  if (self->segment->serial)
+    return gst_mfxgoptranscode_transcode_serial (self, self->segment);
+
+  /* A segment is never cut before min-segment-frames, so the cap only
+   * applies past it */
+  if (max_segment_frames && self->segment->num_frames >
+      MAX (max_segment_frames, min_segment_frames))
+    return gst_mfxgoptranscode_start_serial (self);
+
+  /* Push whatever is done already without waiting */
+  return gst_mfxgoptranscode_push_segments (self, G_MAXUINT);
+  /* ERRORS */
+error_not_negotiated:
+  {
+    GST_ERROR_OBJECT (self, "input caps were not set");
+    gst_buffer_unref (buf);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+}
+
+static GstFlowReturn
+gst_mfxgoptranscode_drain (GstMfxGopTranscode * self)
+{
+  GstFlowReturn ret;
+
+  ret = gst_mfxgoptranscode_dispatch_segment (self);
+  if (GST_FLOW_OK != ret)
+    return ret;
+  return gst_mfxgoptranscode_push_segments (self, 0);
+}
+
+static gboolean
+gst_mfxgoptranscode_set_caps (GstMfxGopTranscode * self, GstCaps * caps)
+{
+  GstStructure *const structure = gst_caps_get_structure (caps, 0);
+  GstMfxGopTranscodeCodec codec;
+  GstCaps *outcaps;
+  gint width, height;
+  gint fps_n = 0, fps_d = 1, par_n = 1, par_d = 1;
+
+  if (!gst_structure_get_int (structure, "width", &width)
+      || !gst_structure_get_int (structure, "height", &height))
+    goto error_invalid_caps;
+  gst_structure_get_fraction (structure, "framerate", &fps_n, &fps_d);
+  gst_structure_get_fraction (structure, "pixel-aspect-ratio", &par_n, &par_d);
+
+  self->profile = gst_mfx_profile_from_caps (caps);
+  if (!self->profile)
+    goto error_invalid_caps;
+
+  gst_video_info_set_format (&self->info, GST_VIDEO_FORMAT_NV12, width,
+      height);
+  GST_VIDEO_INFO_FPS_N (&self->info) = fps_n;
+  GST_VIDEO_INFO_FPS_D (&self->info) = fps_d;
+  GST_VIDEO_INFO_PAR_N (&self->info) = par_n;
+  GST_VIDEO_INFO_PAR_D (&self->info) = par_d;
+  gst_buffer_replace (&self->headers, NULL);
+
+  GST_OBJECT_LOCK (self);
+  codec = self->codec;
+  GST_OBJECT_UNLOCK (self);
+
+  outcaps = gst_caps_new_simple (codec == GST_MFXGOPTRANSCODE_CODEC_H265 ?
+      "video/x-h265" : "video/x-h264",
+      "stream-format", G_TYPE_STRING, "byte-stream",
+      "alignment", G_TYPE_STRING, "au",
+      "width", G_TYPE_INT, width,
+      "height", G_TYPE_INT, height,
+      "framerate", GST_TYPE_FRACTION, fps_n, fps_d,
+      "pixel-aspect-ratio", GST_TYPE_FRACTION, par_n, par_d, NULL);
+
+  GST_INFO_OBJECT (self, "transcoding to %" GST_PTR_FORMAT, outcaps);
+
+  return gst_pad_push_event (GST_MFX_PLUGIN_BASE_SRC_PAD (self),
+      gst_event_new_caps (outcaps));
+  /* ERRORS */
+error_invalid_caps:
+  {
+    GST_ERROR_OBJECT (self, "unsupported input caps %" GST_PTR_FORMAT, caps);
+    self->profile = GST_MFX_PROFILE_UNKNOWN;
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_mfxgoptranscode_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstMfxGopTranscode *const self = GST_MFXGOPTRANSCODE (parent);
+  GstFlowReturn flow_ret;
+  gboolean ret;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:{
+      GstCaps *caps;
+
+      /* Segments of the previous stream go out with the previous caps */
+      flow_ret = gst_mfxgoptranscode_drain (self);
+      if (GST_FLOW_OK != flow_ret) {
+        GST_WARNING_OBJECT (self, "failed to drain before new caps: %s",
+            gst_flow_get_name (flow_ret));
+        gst_event_unref (event);
+        ret = FALSE;
+        break;
+      }
+
+      gst_event_parse_caps (event, &caps);
+      ret = gst_mfxgoptranscode_set_caps (self, caps);
+      gst_event_unref (event);
+      break;
+    }
+    case GST_EVENT_EOS:
+      /* EOS is forwarded in any case, but fails if the last segments
+       * could not be pushed */
+      flow_ret = gst_mfxgoptranscode_drain (self);
+      ret = gst_pad_event_default (pad, parent, event);
+      if (GST_FLOW_OK != flow_ret) {
+        GST_DEBUG_OBJECT (self, "draining on EOS returned %s",
+            gst_flow_get_name (flow_ret));
+        ret = FALSE;
+      }
+      break;
+    case GST_EVENT_FLUSH_START:
+      g_atomic_int_set (&self->flushing, 1);
+      ret = gst_pad_event_default (pad, parent, event);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      gst_mfxgoptranscode_discard_segments (self);
+      g_atomic_int_set (&self->flushing, 0);
+      ret = gst_pad_event_default (pad, parent, event);
+      break;
+    default:
+      ret = gst_pad_event_default (pad, parent, event);
+      break;
+  }
+  return ret;
+}
+
+static gboolean
+gst_mfxgoptranscode_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstMfxGopTranscode *const self = GST_MFXGOPTRANSCODE (parent);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CONTEXT
+      && gst_mfx_handle_context_query (query,
+          GST_MFX_PLUGIN_BASE_AGGREGATOR (self))) {
+    GST_DEBUG_OBJECT (self, "sharing tasks %p",
+        GST_MFX_PLUGIN_BASE_AGGREGATOR (self));
+    return TRUE;
+  }
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+static GstStateChangeReturn
+gst_mfxgoptranscode_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstMfxGopTranscode *const self = GST_MFXGOPTRANSCODE (element);
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (self);
+  GstStateChangeReturn ret;
+  guint num_sessions;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_mfx_plugin_base_ensure_aggregator (plugin))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      GST_OBJECT_LOCK (self);
+      num_sessions = self->num_sessions;
+      GST_OBJECT_UNLOCK (self);
+
+      self->workers = g_thread_pool_new (gst_mfxgoptranscode_worker, self,
+          num_sessions, FALSE, NULL);
+      if (!self->workers)
+        return GST_STATE_CHANGE_FAILURE;
+      g_atomic_int_set (&self->flushing, 0);
+      self->last_dts = GST_CLOCK_TIME_NONE;
+      self->dts_delay = GST_CLOCK_TIME_NONE;
+      self->next_index = 0;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* Have the workers give up on the remaining segments */
+      g_atomic_int_set (&self->flushing, 1);
+      break;
+    default:
+      break;
+  }
+
+  ret =
+      GST_ELEMENT_CLASS (gst_mfxgoptranscode_parent_class)->change_state
+      (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      if (self->workers) {
+        g_thread_pool_free (self->workers, FALSE, TRUE);
+        self->workers = NULL;
+      }
+      gst_mfxgoptranscode_discard_segments (self);
+      gst_buffer_replace (&self->headers, NULL);
+      self->profile = GST_MFX_PROFILE_UNKNOWN;
+      break;
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_mfx_plugin_base_close (plugin);
+      break;
+    default:
+      break;
+  }
+  return ret;
+}
+
+static void
+gst_mfxgoptranscode_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+  GstMfxGopTranscode *const self = GST_MFXGOPTRANSCODE (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_CODEC:
+      self->codec = g_value_get_enum (value);
+      break;
+    case PROP_BITRATE:
+      self->bitrate = g_value_get_uint (value);
+      break;
+    case PROP_RATE_CONTROL:
+      self->rate_control = g_value_get_enum (value);
+      break;
+    case PROP_GOP_SIZE:
+      self->gop_size = g_value_get_uint (value);
+      break;
+    case PROP_NUM_SESSIONS:
+      self->num_sessions = g_value_get_uint (value);
+      break;
+    case PROP_MIN_SEGMENT_FRAMES:
+      self->min_segment_frames = g_value_get_uint (value);
+      break;
+    case PROP_MAX_SEGMENT_FRAMES:
+      self->max_segment_frames = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_mfxgoptranscode_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  GstMfxGopTranscode *const self = GST_MFXGOPTRANSCODE (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_CODEC:
+      g_value_set_enum (value, self->codec);
+      break;
+    case PROP_BITRATE:
+      g_value_set_uint (value, self->bitrate);
+      break;
+    case PROP_RATE_CONTROL:
+      g_value_set_enum (value, self->rate_control);
+      break;
+    case PROP_GOP_SIZE:
+      g_value_set_uint (value, self->gop_size);
+      break;
+    case PROP_NUM_SESSIONS:
+      g_value_set_uint (value, self->num_sessions);
+      break;
+    case PROP_MIN_SEGMENT_FRAMES:
+      g_value_set_uint (value, self->min_segment_frames);
+      break;
+    case PROP_MAX_SEGMENT_FRAMES:
+      g_value_set_uint (value, self->max_segment_frames);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_mfxgoptranscode_finalize (GObject * object)
+{
+  GstMfxGopTranscode *const self = GST_MFXGOPTRANSCODE (object);
+
+  gst_buffer_replace (&self->headers, NULL);
+  g_mutex_clear (&self->lock);
+  g_mutex_clear (&self->setup_lock);
+  g_cond_clear (&self->cond);
+
+  gst_mfx_plugin_base_finalize (GST_MFX_PLUGIN_BASE (self));
+  G_OBJECT_CLASS (gst_mfxgoptranscode_parent_class)->finalize (object);
+}
+
+static void
+gst_mfxgoptranscode_class_init (GstMfxGopTranscodeClass * klass)
+{
+  GObjectClass *const object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *const element_class = GST_ELEMENT_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (gst_debug_mfxgoptranscode,
+      GST_PLUGIN_NAME, 0, GST_PLUGIN_DESC);
+
+  gst_mfx_plugin_base_class_init (GST_MFX_PLUGIN_BASE_CLASS (klass));
+
+  object_class->set_property = gst_mfxgoptranscode_set_property;
+  object_class->get_property = gst_mfxgoptranscode_get_property;
+  object_class->finalize = gst_mfxgoptranscode_finalize;
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_mfxgoptranscode_change_state);
+
+  gst_element_class_set_static_metadata (element_class,
+      "MFX GOP-parallel transcoder",
+      "Codec/Decoder/Encoder/Video",
+      GST_PLUGIN_DESC, "Ishmael Sameen <ishmael.visayana.sameen@intel.com>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_mfxgoptranscode_sink_factory));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_mfxgoptranscode_src_factory));
+
+  g_object_class_install_property (object_class, PROP_CODEC,
+      g_param_spec_enum ("codec", "Codec",
+          "Codec of the transcoded stream", GST_TYPE_MFXGOPTRANSCODE_CODEC,
+          DEFAULT_CODEC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_BITRATE,
+      g_param_spec_uint ("bitrate", "Bitrate (kbps)",
+          "The desired bitrate expressed in kbps (0: auto-calculate)",
+          0, G_MAXUINT16, DEFAULT_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_RATE_CONTROL,
+      g_param_spec_enum ("rate-control", "Rate control",
+          "Rate control mode", GST_MFX_TYPE_RATE_CONTROL,
+          DEFAULT_RATE_CONTROL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_GOP_SIZE,
+      g_param_spec_uint ("gop-size", "GOP size",
+          "Number of pictures within the current GOP (0: auto-calculate)",
+          0, G_MAXUINT16, DEFAULT_GOP_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMfxGopTranscode:num-sessions
+   *
+   * The number of segments that are transcoded at the same time, each
+   * on its own decoder and encoder sessions.
+   */
+  g_object_class_install_property (object_class, PROP_NUM_SESSIONS,
+      g_param_spec_uint ("num-sessions", "Number of sessions",
+          "Number of segments transcoded in parallel",
+          1, 16, DEFAULT_NUM_SESSIONS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstMfxGopTranscode:min-segment-frames
+   *
+   * The minimum number of frames of a segment. The input is only cut at
+   * the first IDR access unit past this length, so short GOPs are
+   * batched together.
+   */
+  g_object_class_install_property (object_class, PROP_MIN_SEGMENT_FRAMES,
+      g_param_spec_uint ("min-segment-frames", "Minimum segment frames",
+          "Minimum number of frames per segment",
+          1, G_MAXUINT, DEFAULT_MIN_SEGMENT_FRAMES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMfxGopTranscode:max-segment-frames
+   *
+   * The number of frames a segment may buffer while waiting for the next
+   * IDR access unit. Past it, the segment is transcoded serially until
+   * the next IDR access unit, which bounds the memory used by streams
+   * with long or no GOPs.
+   */
+  g_object_class_install_property (object_class, PROP_MAX_SEGMENT_FRAMES,
+      g_param_spec_uint ("max-segment-frames", "Maximum segment frames",
+          "Maximum number of frames buffered per segment (0: unlimited)",
+          0, G_MAXUINT, DEFAULT_MAX_SEGMENT_FRAMES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_mfxgoptranscode_init (GstMfxGopTranscode * self)
+{
+  GstPad *pad;
+
+  pad = gst_pad_new_from_static_template (&gst_mfxgoptranscode_sink_factory,
+      "sink");
+  gst_pad_set_chain_function (pad,
+      GST_DEBUG_FUNCPTR (gst_mfxgoptranscode_chain));
+  gst_pad_set_event_function (pad,
+      GST_DEBUG_FUNCPTR (gst_mfxgoptranscode_sink_event));
+  gst_pad_set_query_function (pad,
+      GST_DEBUG_FUNCPTR (gst_mfxgoptranscode_query));
+  gst_element_add_pad (GST_ELEMENT (self), pad);
+
+  pad = gst_pad_new_from_static_template (&gst_mfxgoptranscode_src_factory,
+      "src");
+  gst_pad_set_query_function (pad,
+      GST_DEBUG_FUNCPTR (gst_mfxgoptranscode_query));
+  gst_pad_use_fixed_caps (pad);
+  gst_element_add_pad (GST_ELEMENT (self), pad);
+
+  gst_mfx_plugin_base_init (GST_MFX_PLUGIN_BASE (self), GST_CAT_DEFAULT);
+
+  self->codec = DEFAULT_CODEC;
+  self->bitrate = DEFAULT_BITRATE;
+  self->rate_control = DEFAULT_RATE_CONTROL;
+  self->gop_size = DEFAULT_GOP_SIZE;
+  self->num_sessions = DEFAULT_NUM_SESSIONS;
+  self->min_segment_frames = DEFAULT_MIN_SEGMENT_FRAMES;
+  self->max_segment_frames = DEFAULT_MAX_SEGMENT_FRAMES;
+
+  gst_video_info_init (&self->info);
+  self->last_dts = GST_CLOCK_TIME_NONE;
+  self->dts_delay = GST_CLOCK_TIME_NONE;
+  g_queue_init (&self->segments);
+  g_mutex_init (&self->lock);
+  g_mutex_init (&self->setup_lock);
+  g_cond_init (&self->cond);
+}
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef GST_MFXGOPTRANSCODE_H
+#define GST_MFXGOPTRANSCODE_H
+
+#include "gstmfxpluginbase.h"
+
+#include <gst-libs/mfx/gstmfxprofile.h>
+#include <gst-libs/mfx/gstmfxvalue.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_MFXGOPTRANSCODE \
+  (gst_mfxgoptranscode_get_type ())
+#define GST_MFXGOPTRANSCODE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_MFXGOPTRANSCODE, \
+  GstMfxGopTranscode))
+#define GST_MFXGOPTRANSCODE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_MFXGOPTRANSCODE, \
+  GstMfxGopTranscodeClass))
+#define GST_IS_MFXGOPTRANSCODE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_MFXGOPTRANSCODE))
+#define GST_IS_MFXGOPTRANSCODE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_MFXGOPTRANSCODE))
+
+#define GST_TYPE_MFXGOPTRANSCODE_CODEC \
+  (gst_mfxgoptranscode_codec_get_type ())
+
+typedef struct _GstMfxGopTranscode GstMfxGopTranscode;
+typedef struct _GstMfxGopTranscodeClass GstMfxGopTranscodeClass;
+typedef struct _GstMfxGopSegment GstMfxGopSegment;
+
+typedef enum
+{
+  GST_MFXGOPTRANSCODE_CODEC_H264 = 0,
+  GST_MFXGOPTRANSCODE_CODEC_H265,
+} GstMfxGopTranscodeCodec;
+
+struct _GstMfxGopTranscode
+{
+  /*< private >*/
+  GstMfxPluginBase        parent_instance;
+
+  /* Settings, protected by the object lock */
+  GstMfxGopTranscodeCodec codec;
+  guint                   bitrate;
+  GstMfxRateControl       rate_control;
+  guint                   gop_size;
+  guint                   num_sessions;
+  guint                   min_segment_frames;
+  guint                   max_segment_frames;
+
+  /* Input stream, protected by the sink pad stream lock */
+  GstMfxProfile           profile;
+  GstVideoInfo            info;
+  GstBuffer              *headers;
+  GstMfxGopSegment       *segment;
+  guint                   next_index;
+  GstClockTime            last_dts;
+  GstClockTime            dts_delay;
+
+  /* Segments being transcoded in input order, protected by lock */
+  GThreadPool            *workers;
+  GQueue                  segments;
+  GMutex                  lock;
+  GCond                   cond;
+  volatile gint           flushing;
+
+  /* Serializes session creation, since the encoder of a segment picks
+   * up the decoder task that was created right before it */
+  GMutex                  setup_lock;
+};
+
+struct _GstMfxGopTranscodeClass
+{
+  /*< private >*/
+  GstMfxPluginBaseClass parent_class;
+};
+
+GType
+gst_mfxgoptranscode_get_type (void);
+
+GType
+gst_mfxgoptranscode_codec_get_type (void);
+
+G_END_DECLS
+
+#endif /* GST_MFXGOPTRANSCODE_H */
@@ -29,6 +29,10 @@
 #include "gstmfxvideometa.h"
 #include "gstmfxvideobufferpool.h"
 
+#include <gst-libs/mfx/gstmfxsurface_vaapi.h>
+#include <gst-libs/mfx/gstmfxutils_copy.h>
+#include <gst-libs/mfx/gstmfxutils_p010.h>
+
 #ifdef HAVE_GST_GL_LIBS
 # if GST_CHECK_VERSION(1,11,1)
 # include <gst/gl/gstglcontext.h>
@@ -86,15 +90,17 @@ gst_mfx_plugin_base_init (GstMfxPluginBase * plugin,
 {
   plugin->debug_category = debug_category;
 
-  /* sink pad */
+  /* sink pad, aggregators only have request sink pads */
   plugin->sinkpad = gst_element_get_static_pad (GST_ELEMENT (plugin), "sink");
   gst_video_info_init (&plugin->sinkpad_info);
-  plugin->sinkpad_query = GST_PAD_QUERYFUNC (plugin->sinkpad);
+  if (plugin->sinkpad)
+    plugin->sinkpad_query = GST_PAD_QUERYFUNC (plugin->sinkpad);
 
-  /* src pad */
+  /* src pad, elements with request src pads have no static one */
   if (!(GST_OBJECT_FLAGS (plugin) & GST_ELEMENT_FLAG_SINK)) {
     plugin->srcpad = gst_element_get_static_pad (GST_ELEMENT (plugin), "src");
-    plugin->srcpad_query = GST_PAD_QUERYFUNC (plugin->srcpad);
+    if (plugin->srcpad)
+      plugin->srcpad_query = GST_PAD_QUERYFUNC (plugin->srcpad);
   }
   gst_video_info_init (&plugin->srcpad_info);
 
@@ -136,6 +142,8 @@ gst_mfx_plugin_base_close (GstMfxPluginBase * plugin)
   plugin->srcpad_caps_changed = FALSE;
   gst_video_info_init (&plugin->srcpad_info);
   plugin->need_linear_dmabuf = FALSE;
+  plugin->sinkpad_no_userptr = FALSE;
+  plugin->sinkpad_no_dmabuf_import = FALSE;
 }
 
 gboolean
@@ -147,8 +155,8 @@ gst_mfx_plugin_base_ensure_aggregator (GstMfxPluginBase * plugin)
 }
 
 /* Checks whether the supplied pad peer element supports DMABUF sharing */
-/* XXX: this is a workaround to the absence of any proposer way to
-specify DMABUF memory capsfeatures or bufferpool option to downstream */
+/* XXX: v4l2src and camerasrc import DMABUFs from our pool without saying
+so in their caps. Any other producer negotiates memory:DMABuf instead */
 static gboolean
 has_dmabuf_capable_peer (GstMfxPluginBase * plugin, GstPad * pad)
 {
@@ -203,6 +211,34 @@ has_dmabuf_capable_peer (GstMfxPluginBase * plugin, GstPad * pad)
   return is_dmabuf_capable;
 }
 
+static gboolean
+caps_need_repacking (GstCaps * caps)
+{
+  GstVideoInfo vi;
+
+  return !gst_caps_has_mfx_surface (caps)
+      && gst_video_info_from_caps (&vi, caps)
+      && gst_mfx_video_format_is_repacked (GST_VIDEO_INFO_FORMAT (&vi));
+}
+
+/* 10-bit layouts other than P010 are repacked by the CPU into P010
+ * surfaces, so the sink pad pool is made of the latter */
+static GstCaps *
+get_sinkpad_pool_caps (GstMfxPluginBase * plugin, GstCaps * caps)
+{
+  GstVideoInfo vi;
+
+  if (!plugin->sinkpad_caps_is_raw || !caps_need_repacking (caps)
+      || !gst_video_info_from_caps (&vi, caps))
+    return gst_caps_ref (caps);
+
+#if GST_CHECK_VERSION(1,10,0)
+  gst_video_info_change_format (&vi, GST_VIDEO_FORMAT_P010_10LE,
+      GST_VIDEO_INFO_WIDTH (&vi), GST_VIDEO_INFO_HEIGHT (&vi));
+#endif
+  return gst_video_info_to_caps (&vi);
+}
+
 /**
  * ensure_sinkpad_buffer_pool:
  * @plugin: a #GstMfxPluginBase
@@ -220,25 +256,37 @@ ensure_sinkpad_buffer_pool (GstMfxPluginBase * plugin, GstCaps * caps)
   GstCaps *pool_caps;
   GstStructure *config;
   GstVideoInfo vi;
-  gboolean need_pool;
-
-  if (!plugin->sinkpad_buffer_pool)
+  gboolean need_pool, success = FALSE;
+
+  /* A renegotiation away from DMABUF caps goes back to system memory,
+   * the peer is only probed before the first pool is created */
+  if (gst_caps_has_dmabuf (caps))
+    plugin->sinkpad_has_dmabuf = TRUE;
+  else if (plugin->sinkpad_buffer_pool)
+    plugin->sinkpad_has_dmabuf = FALSE;
+  else
     plugin->sinkpad_has_dmabuf =
         has_dmabuf_capable_peer (plugin, plugin->sinkpad);
 
   plugin->sinkpad_caps_is_raw = !plugin->sinkpad_has_dmabuf &&
       !gst_caps_has_mfx_surface (caps);
+  plugin->sinkpad_no_userptr = FALSE;
+  plugin->sinkpad_no_dmabuf_import = FALSE;
 
   if (!gst_mfx_plugin_base_ensure_aggregator (plugin))
     return FALSE;
 
+  caps = get_sinkpad_pool_caps (plugin, caps);
+
   if (plugin->sinkpad_buffer_pool) {
     config = gst_buffer_pool_get_config (plugin->sinkpad_buffer_pool);
     gst_buffer_pool_config_get_params (config, &pool_caps, NULL, NULL, NULL);
     need_pool = !gst_caps_is_equal (caps, pool_caps);
     gst_structure_free (config);
-    if (!need_pool)
-      return TRUE;
+    if (!need_pool) {
+      success = TRUE;
+      goto done;
+    }
     g_clear_object (&plugin->sinkpad_buffer_pool);
     plugin->sinkpad_buffer_size = 0;
   }
@@ -262,20 +310,23 @@ ensure_sinkpad_buffer_pool (GstMfxPluginBase * plugin, GstCaps * caps)
   if (!gst_buffer_pool_set_config (pool, config))
     goto error_pool_config;
   plugin->sinkpad_buffer_pool = pool;
+  success = TRUE;
 
-  return TRUE;
+done:
+  gst_caps_unref (caps);
+  return success;
 
   /* ERRORS */
 error_create_pool:
   {
     GST_ERROR ("failed to create buffer pool");
-    return FALSE;
+    goto done;
   }
 error_pool_config:
   {
     GST_ERROR ("failed to reset buffer pool config");
     gst_object_unref (pool);
-    return FALSE;
+    goto done;
   }
 }
 
@@ -357,6 +408,11 @@ gst_mfx_plugin_base_propose_allocation (GstMfxPluginBase * plugin,
 
     if (!ensure_sinkpad_buffer_pool (plugin, caps))
       return FALSE;
+
+    /* Upstream cannot write its own layout into repacked P010 buffers */
+    if (caps_need_repacking (caps))
+      goto done;
+
     gst_query_add_allocation_pool (query, plugin->sinkpad_buffer_pool,
         plugin->sinkpad_buffer_size, 0, 0);
 
@@ -371,6 +427,8 @@ gst_mfx_plugin_base_propose_allocation (GstMfxPluginBase * plugin,
     }
   }
 
+done:
+
   gst_query_add_allocation_meta (query, GST_MFX_VIDEO_META_API_TYPE, NULL);
   gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
 
@@ -551,6 +609,307 @@ config_failed:
   }
 }
 
+/* Same as gst_video_frame_copy(), with large frames split between
+ * several threads */
+static gboolean
+copy_frame (GstVideoFrame * dst, GstVideoFrame * src)
+{
+  const GstVideoFormatInfo *const finfo = dst->info.finfo;
+  GstMfxPlaneCopy planes[GST_VIDEO_MAX_PLANES];
+  guint i, c;
+
+  if (GST_VIDEO_FORMAT_INFO_IS_TILED (finfo)
+      || GST_VIDEO_FORMAT_INFO_HAS_PALETTE (finfo))
+    return gst_video_frame_copy (dst, src);
+
+  for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (dst); i++) {
+    GstMfxPlaneCopy *const p = &planes[i];
+
+    /* Plane geometry is that of its first component */
+    for (c = 0; GST_VIDEO_FORMAT_INFO_PLANE (finfo, c) != i; c++);
+
+    p->dst = GST_VIDEO_FRAME_PLANE_DATA (dst, i);
+    p->src = GST_VIDEO_FRAME_PLANE_DATA (src, i);
+    p->dst_stride = GST_VIDEO_FRAME_PLANE_STRIDE (dst, i);
+    p->src_stride = GST_VIDEO_FRAME_PLANE_STRIDE (src, i);
+    p->row_size = GST_VIDEO_FRAME_COMP_WIDTH (dst, c)
+        * GST_VIDEO_FRAME_COMP_PSTRIDE (dst, c);
+    if (!p->row_size)
+      p->row_size = MIN (p->dst_stride, p->src_stride);
+    p->height = GST_VIDEO_FRAME_COMP_HEIGHT (dst, c);
+  }
+  gst_mfx_utils_copy_planes (planes, GST_VIDEO_FRAME_N_PLANES (dst));
+  return TRUE;
+}
+
+#define FRAME_ROW(frame, p, i) \
+  ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, p) \
+      + (i) * GST_VIDEO_FRAME_PLANE_STRIDE (frame, p))
+
+/* Repacks an I420_10LE or v210 frame into a P010 frame */
+static gboolean
+repack_to_p010 (GstVideoFrame * dst, GstVideoFrame * src)
+{
+  const guint width = GST_VIDEO_FRAME_WIDTH (dst);
+  const guint height = GST_VIDEO_FRAME_HEIGHT (dst);
+  guint i;
+
+  switch (GST_VIDEO_FRAME_FORMAT (src)) {
+    case GST_VIDEO_FORMAT_I420_10LE:
+      for (i = 0; i < height; i++)
+        gst_mfx_utils_p010_pack_y ((const guint16 *) FRAME_ROW (src, 0, i),
+            (guint16 *) FRAME_ROW (dst, 0, i), width);
+      for (i = 0; i < GST_ROUND_UP_2 (height) / 2; i++)
+        gst_mfx_utils_p010_pack_uv ((const guint16 *) FRAME_ROW (src, 1, i),
+            (const guint16 *) FRAME_ROW (src, 2, i),
+            (guint16 *) FRAME_ROW (dst, 1, i), width);
+      break;
+    case GST_VIDEO_FORMAT_v210:
+      /* 4:2:2 to 4:2:0, keeping the chroma of the even rows */
+      for (i = 0; i < height; i++)
+        gst_mfx_utils_p010_from_v210 (FRAME_ROW (src, 0, i),
+            (guint16 *) FRAME_ROW (dst, 0, i),
+            (i & 1) ? NULL : (guint16 *) FRAME_ROW (dst, 1, i / 2), width);
+      break;
+    default:
+      return FALSE;
+  }
+  return TRUE;
+}
+
+#undef FRAME_ROW
+
+typedef struct _SurfaceImport SurfaceImport;
+struct _SurfaceImport
+{
+  GstMfxSurface *surface;
+  GstMfxDisplay *display;
+  GstVideoInfo info;
+};
+
+#define GST_MFX_USERPTR_IMPORT_QUARK gst_mfx_userptr_import_quark_get ()
+static GQuark
+gst_mfx_userptr_import_quark_get (void)
+{
+  static gsize g_quark;
+
+  if (g_once_init_enter (&g_quark)) {
+    gsize quark = (gsize) g_quark_from_static_string ("GstMfxUserptrImport");
+    g_once_init_leave (&g_quark, quark);
+  }
+  return g_quark;
+}
+
+#define GST_MFX_DMABUF_IMPORT_QUARK gst_mfx_dmabuf_import_quark_get ()
+static GQuark
+gst_mfx_dmabuf_import_quark_get (void)
+{
+  static gsize g_quark;
+
+  if (g_once_init_enter (&g_quark)) {
+    gsize quark = (gsize) g_quark_from_static_string ("GstMfxDmabufImport");
+    g_once_init_leave (&g_quark, quark);
+  }
+  return g_quark;
+}
+
+static SurfaceImport *
+surface_import_new (GstMfxSurface * surface, GstMfxDisplay * display,
+    const GstVideoInfo * info)
+{
+  SurfaceImport *import = g_slice_new0 (SurfaceImport);
+
+  import->surface = surface;
+  import->display = gst_mfx_display_ref (display);
+  import->info = *info;
+  return import;
+}
+
+static void
+surface_import_free (SurfaceImport * import)
+{
+  gst_mfx_surface_unref (import->surface);
+  gst_mfx_display_unref (import->display);
+  g_slice_free (SurfaceImport, import);
+}
+
+/* Returns the surface cached on @mem by an earlier import, unless the
+ * layout changed or the memory was imported on another display, e.g.
+ * by another element or before the display was renegotiated */
+static SurfaceImport *
+surface_import_lookup (GstMemory * mem, GQuark quark,
+    GstMfxDisplay * display, const GstVideoInfo * info)
+{
+  SurfaceImport *const import =
+      gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (mem), quark);
+
+  if (!import || import->display != display
+      || !gst_video_info_is_equal (&import->info, info))
+    return NULL;
+  return import;
+}
+
+/* Returns the layout of @inbuf, which may differ from the negotiated
+ * caps when upstream attached a video meta */
+static gboolean
+get_input_video_info (GstMfxPluginBase * plugin, GstBuffer * inbuf,
+    GstVideoInfo * info)
+{
+  GstVideoMeta *vmeta;
+  guint i;
+
+  *info = plugin->sinkpad_info;
+  vmeta = gst_buffer_get_video_meta (inbuf);
+  if (!vmeta)
+    return TRUE;
+
+  if (vmeta->width != GST_VIDEO_INFO_WIDTH (info)
+      || vmeta->height != GST_VIDEO_INFO_HEIGHT (info))
+    return FALSE;
+  for (i = 0; i < vmeta->n_planes; i++) {
+    GST_VIDEO_INFO_PLANE_OFFSET (info, i) = vmeta->offset[i];
+    GST_VIDEO_INFO_PLANE_STRIDE (info, i) = vmeta->stride[i];
+  }
+  return TRUE;
+}
+
+/* Wraps an imported surface into a buffer the MFX elements consume. The
+ * parent meta keeps the upstream memory alive for as long as the surface
+ * is in use downstream of this buffer */
+static GstBuffer *
+wrap_imported_surface (GstBuffer * inbuf, GstMfxSurface * surface)
+{
+  GstMfxVideoMeta *meta;
+  GstBuffer *outbuf;
+
+  meta = gst_mfx_video_meta_new ();
+  if (!meta)
+    return NULL;
+  gst_mfx_video_meta_set_surface (meta, surface);
+
+  outbuf = gst_buffer_new ();
+  gst_buffer_set_mfx_video_meta (outbuf, meta);
+  gst_mfx_video_meta_unref (meta);
+  gst_buffer_add_parent_buffer_meta (outbuf, inbuf);
+  gst_buffer_copy_into (outbuf, inbuf,
+      GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+  return outbuf;
+}
+
+/* Wraps upstream system memory into a VA surface instead of copying it
+ * into one from the sink pad pool. The surface is cached on the memory
+ * so that buffers recycled by an upstream pool are only imported once */
+static GstBuffer *
+import_userptr_buffer (GstMfxPluginBase * plugin, GstBuffer * inbuf)
+{
+  GstVideoInfo info;
+  GstMemory *mem;
+  GstMapInfo map;
+  GstMfxDisplay *display;
+  GstMfxSurface *surface;
+  SurfaceImport *import;
+  GstBuffer *outbuf = NULL;
+
+  if (plugin->sinkpad_no_userptr || gst_buffer_n_memory (inbuf) != 1)
+    return NULL;
+
+  mem = gst_buffer_peek_memory (inbuf, 0);
+  if (!gst_memory_is_type (mem, GST_ALLOCATOR_SYSMEM))
+    return NULL;
+
+  if (!get_input_video_info (plugin, inbuf, &info))
+    return NULL;
+
+  display = gst_mfx_task_aggregator_get_display (plugin->aggregator);
+  import = surface_import_lookup (mem, GST_MFX_USERPTR_IMPORT_QUARK,
+      display, &info);
+  if (!import) {
+    if (!gst_memory_map (mem, &map, GST_MAP_READ))
+      goto done;
+
+    surface = gst_mfx_surface_vaapi_new_from_userptr (display, &info,
+        map.data, map.size);
+    gst_memory_unmap (mem, &map);
+
+    if (!surface) {
+      GST_INFO_OBJECT (plugin, "upstream memory can't be imported, "
+          "falling back to copies");
+      plugin->sinkpad_no_userptr = TRUE;
+      goto done;
+    }
+
+    /* Replacing the qdata releases the surface of a stale import */
+    import = surface_import_new (surface, display, &info);
+    gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (mem),
+        GST_MFX_USERPTR_IMPORT_QUARK, import,
+        (GDestroyNotify) surface_import_free);
+  }
+  outbuf = wrap_imported_surface (inbuf, import->surface);
+
+done:
+  gst_mfx_display_unref (display);
+  return outbuf;
+}
+
+/* Wraps upstream DMABUF memory into a VA surface. Like system memory
+ * imports, the surface is cached on the memory, which owns its file
+ * descriptor, and is released along with it */
+static GstBuffer *
+import_dmabuf_buffer (GstMfxPluginBase * plugin, GstBuffer * inbuf)
+{
+  GstVideoInfo info;
+  GstMemory *mem;
+  GstMfxDisplay *display;
+  GstMfxSurface *surface;
+  SurfaceImport *import;
+  GstBuffer *outbuf = NULL;
+  gsize offset, maxsize;
+  gint fd;
+  guint i;
+
+  if (plugin->sinkpad_no_dmabuf_import || gst_buffer_n_memory (inbuf) != 1)
+    return NULL;
+
+  mem = gst_buffer_peek_memory (inbuf, 0);
+  if (!gst_is_dmabuf_memory (mem))
+    return NULL;
+
+  fd = gst_dmabuf_memory_get_fd (mem);
+  if (fd < 0)
+    return NULL;
+
+  if (!get_input_video_info (plugin, inbuf, &info))
+    return NULL;
+  gst_memory_get_sizes (mem, &offset, &maxsize);
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&info); i++)
+    GST_VIDEO_INFO_PLANE_OFFSET (&info, i) += offset;
+
+  display = gst_mfx_task_aggregator_get_display (plugin->aggregator);
+  import = surface_import_lookup (mem, GST_MFX_DMABUF_IMPORT_QUARK,
+      display, &info);
+  if (!import) {
+    surface = gst_mfx_surface_vaapi_new_from_dmabuf (display, &info, fd,
+        maxsize);
+
+    if (!surface) {
+      GST_INFO_OBJECT (plugin, "DMABUF can't be imported, "
+          "falling back to copies");
+      plugin->sinkpad_no_dmabuf_import = TRUE;
+      goto done;
+    }
+
+    import = surface_import_new (surface, display, &info);
+    gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (mem),
+        GST_MFX_DMABUF_IMPORT_QUARK, import,
+        (GDestroyNotify) surface_import_free);
+  }
+  outbuf = wrap_imported_surface (inbuf, import->surface);
+
+done:
+  gst_mfx_display_unref (display);
+  return outbuf;
+}
+
 /**
  * gst_mfx_plugin_base_get_input_buffer:
  * @plugin: a #GstMfxPluginBase
@@ -571,6 +930,7 @@ gst_mfx_plugin_base_get_input_buffer (GstMfxPluginBase * plugin,
   GstMfxVideoMeta *meta;
   GstBuffer *outbuf;
   GstVideoFrame src_frame, out_frame;
+  GstVideoInfo out_info;
   gboolean success;
 
   g_return_val_if_fail (inbuf != NULL, GST_FLOW_ERROR);
@@ -582,8 +942,19 @@ gst_mfx_plugin_base_get_input_buffer (GstMfxPluginBase * plugin,
     return GST_FLOW_OK;
   }
 
-  if (!plugin->sinkpad_caps_is_raw)
-    goto error_invalid_buffer;
+  if (!plugin->sinkpad_caps_is_raw) {
+    if (gst_caps_has_mfx_surface (plugin->sinkpad_caps))
+      goto error_invalid_buffer;
+
+    /* Raw buffers that bypassed our pool while running in video memory */
+    outbuf = import_dmabuf_buffer (plugin, inbuf);
+    if (!outbuf)
+      outbuf = import_userptr_buffer (plugin, inbuf);
+    if (outbuf) {
+      *outbuf_ptr = outbuf;
+      return GST_FLOW_OK;
+    }
+  }
 
   if (!plugin->sinkpad_buffer_pool)
     goto error_no_pool;
@@ -600,15 +971,25 @@ gst_mfx_plugin_base_get_input_buffer (GstMfxPluginBase * plugin,
         GST_MAP_READ))
     goto error_map_src_buffer;
 
-  if (!gst_video_frame_map (&out_frame, &plugin->sinkpad_info, outbuf,
-        GST_MAP_WRITE))
+  out_info = plugin->sinkpad_info;
+#if GST_CHECK_VERSION(1,10,0)
+  if (gst_mfx_video_format_is_repacked (GST_VIDEO_INFO_FORMAT (&out_info)))
+    gst_video_info_change_format (&out_info, GST_VIDEO_FORMAT_P010_10LE,
+        GST_VIDEO_INFO_WIDTH (&out_info), GST_VIDEO_INFO_HEIGHT (&out_info));
+#endif
+
+  if (!gst_video_frame_map (&out_frame, &out_info, outbuf, GST_MAP_WRITE))
     goto error_map_dst_buffer;
 
   /* Hack for incoming video frames with changed GstVideoInfo dimensions */
   GST_VIDEO_FRAME_WIDTH (&src_frame) = GST_VIDEO_FRAME_WIDTH (&out_frame);
   GST_VIDEO_FRAME_HEIGHT (&src_frame) = GST_VIDEO_FRAME_HEIGHT (&out_frame);
 
-  success = gst_video_frame_copy (&out_frame, &src_frame);
+  if (GST_VIDEO_INFO_FORMAT (&out_info) !=
+      GST_VIDEO_INFO_FORMAT (&plugin->sinkpad_info))
+    success = repack_to_p010 (&out_frame, &src_frame);
+  else
+    success = copy_frame (&out_frame, &src_frame);
   gst_video_frame_unmap (&out_frame);
   gst_video_frame_unmap (&src_frame);
   if (!success)
@@ -27,6 +27,9 @@
 #include <gst/video/gstvideodecoder.h>
 #include <gst/video/gstvideoencoder.h>
 #include <gst/video/gstvideosink.h>
+#if GST_CHECK_VERSION(1,16,0)
+# include <gst/video/gstvideoaggregator.h>
+#endif
 
 #include <gst-libs/mfx/gstmfxtaskaggregator.h>
 
@@ -66,6 +69,10 @@ typedef struct _GstMfxPluginBaseClass GstMfxPluginBaseClass;
   (&GST_MFX_PLUGIN_BASE_PARENT(plugin)->sink)
 #define GST_MFX_PLUGIN_BASE_SINK_CLASS(plugin) \
   (&GST_MFX_PLUGIN_BASE_PARENT_CLASS(plugin)->sink)
+#define GST_MFX_PLUGIN_BASE_VIDEO_AGGREGATOR(plugin) \
+  (&GST_MFX_PLUGIN_BASE_PARENT(plugin)->videoaggregator)
+#define GST_MFX_PLUGIN_BASE_VIDEO_AGGREGATOR_CLASS(plugin) \
+  (&GST_MFX_PLUGIN_BASE_PARENT_CLASS(plugin)->videoaggregator)
 
 #define GST_MFX_PLUGIN_BASE_INIT_INTERFACES \
   gst_mfx_plugin_base_init_interfaces (g_define_type_id);
@@ -100,6 +107,9 @@ struct _GstMfxPluginBase
     GstVideoEncoder encoder;
     GstBaseTransform transform;
     GstVideoSink sink;
+#if GST_CHECK_VERSION(1,16,0)
+    GstVideoAggregator videoaggregator;
+#endif
   } parent_instance;
 
   GstDebugCategory     *debug_category;
@@ -127,6 +137,8 @@ struct _GstMfxPluginBase
   GstAllocator         *dmabuf_allocator;
 
   gboolean              need_linear_dmabuf;
+  gboolean              sinkpad_no_userptr;
+  gboolean              sinkpad_no_dmabuf_import;
 
   GstMfxTaskAggregator *aggregator;
 };
@@ -141,6 +153,9 @@ struct _GstMfxPluginBaseClass
     GstVideoEncoderClass encoder;
     GstBaseTransformClass transform;
     GstVideoSinkClass sink;
+#if GST_CHECK_VERSION(1,16,0)
+    GstVideoAggregatorClass videoaggregator;
+#endif
   } parent_class;
 
   gboolean (*has_interface) (GstMfxPluginBase * plugin, GType type);
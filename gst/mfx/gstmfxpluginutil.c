@@ -382,6 +382,15 @@ gst_caps_has_mfx_surface (GstCaps * caps)
   return _gst_caps_has_feature (caps, GST_CAPS_FEATURE_MEMORY_MFX_SURFACE);
 }
 
+/* Checks whether the supplied caps contain DMABuf memory */
+gboolean
+gst_caps_has_dmabuf (GstCaps * caps)
+{
+  g_return_val_if_fail (caps != NULL, FALSE);
+
+  return _gst_caps_has_feature (caps, GST_CAPS_FEATURE_MEMORY_DMABUF);
+}
+
 gboolean
 gst_mfx_query_peer_has_raw_caps (GstPad * srcpad)
 {
@@ -421,3 +430,82 @@ gst_video_info_change_format (GstVideoInfo * vip, GstVideoFormat format,
   vip->fps_n = vi.fps_n;
   vip->fps_d = vi.fps_d;
 }
+
+/* Queries the latency upstream of @sinkpad into @latency. Elements call
+ * this when they start and on LATENCY events, so that the streaming
+ * thread doesn't have to query it every time it retunes */
+void
+gst_mfx_upstream_latency_update (GstMfxUpstreamLatency * latency,
+    GstElement * element, GstPad * sinkpad)
+{
+  GstQuery *query;
+  GstClockTime min_latency = 0, max_latency = GST_CLOCK_TIME_NONE;
+  gboolean live = FALSE;
+
+  query = gst_query_new_latency ();
+  if (gst_pad_peer_query (sinkpad, query))
+    gst_query_parse_latency (query, &live, &min_latency, &max_latency);
+  gst_query_unref (query);
+
+  GST_OBJECT_LOCK (element);
+  latency->valid = TRUE;
+  latency->live = live;
+  latency->min_latency = min_latency;
+  latency->max_latency = max_latency;
+  GST_OBJECT_UNLOCK (element);
+}
+
+/* Picks how many MFX operations to keep in flight, starting from the
+ * current @async_depth, or from scratch if it is 0. Live pipelines stay
+ * as shallow as the measured @device_latency allows, bounded by the
+ * latency upstream can absorb. Other pipelines start at the SDK default
+ * and only grow while the device or the surface pool holds frames back.
+ * The upstream latency is the one @latency was last updated with */
+guint
+gst_mfx_select_async_depth (const GstMfxUpstreamLatency * latency,
+    GstElement * element, GstClockTime frame_duration,
+    GstClockTime device_latency, gboolean pool_pressure, guint async_depth)
+{
+  GstClockTime min_latency, max_latency;
+  gboolean live;
+  guint min_depth, max_depth, depth, needed;
+
+  GST_OBJECT_LOCK (element);
+  live = latency->valid && latency->live;
+  min_latency = latency->min_latency;
+  max_latency = latency->max_latency;
+  GST_OBJECT_UNLOCK (element);
+
+  if (!GST_CLOCK_TIME_IS_VALID (frame_duration) || !frame_duration)
+    frame_duration = GST_CLOCK_TIME_NONE;
+
+  if (live) {
+    min_depth = max_depth = 1;
+    if (GST_CLOCK_TIME_IS_VALID (frame_duration)
+        && GST_CLOCK_TIME_IS_VALID (max_latency) && max_latency > min_latency)
+      max_depth = CLAMP ((max_latency - min_latency) / frame_duration,
+          1, GST_MFX_ASYNC_DEPTH_MAX);
+  }
+  else {
+    min_depth = GST_MFX_ASYNC_DEPTH_DEFAULT;
+    max_depth = GST_MFX_ASYNC_DEPTH_MAX;
+  }
+
+  if (!async_depth)
+    return min_depth;
+
+  depth = async_depth + (pool_pressure ? 1 : 0);
+
+  /* Keep enough frames in flight to hide the device latency, and give
+   * surfaces back once the device keeps up with fewer of them */
+  if (GST_CLOCK_TIME_IS_VALID (frame_duration)
+      && GST_CLOCK_TIME_IS_VALID (device_latency)) {
+    needed = (device_latency + frame_duration - 1) / frame_duration;
+    if (needed > depth)
+      depth = needed;
+    else if (!pool_pressure && needed < async_depth)
+      depth = async_depth - 1;
+  }
+
+  return CLAMP (depth, min_depth, max_depth);
+}
@@ -77,18 +77,42 @@ gst_mfx_caps_feature_to_string(GstMfxCapsFeature feature);
     GST_VIDEO_CAPS_MAKE_WITH_FEATURES(          \
     GST_CAPS_FEATURE_MEMORY_MFX_SURFACE, "{ NV12, BGRA }")
 
+#define GST_MFX_MAKE_DMABUF_CAPS                \
+    GST_VIDEO_CAPS_MAKE_WITH_FEATURES(          \
+    GST_CAPS_FEATURE_MEMORY_DMABUF, "{ NV12, BGRA }")
+
+/* I420_10LE and v210 are repacked into P010 surfaces on upload */
+#if GST_CHECK_VERSION(1,10,0)
+#define GST_MFX_SUPPORTED_10BIT_FORMATS \
+    ", P010_10LE, I420_10LE, v210"
+#else
+#define GST_MFX_SUPPORTED_10BIT_FORMATS ""
+#endif
+
 #ifdef WITH_MSS_2016
-#define GST_MFX_SUPPORTED_INPUT_FORMATS \
-    "{ NV12, YV12, I420, YUY2, BGRA, BGRx }"
+#define GST_MFX_SUPPORTED_8BIT_FORMATS \
+    "NV12, YV12, I420, YUY2, BGRA, BGRx"
 #else
-#define GST_MFX_SUPPORTED_INPUT_FORMATS \
-    "{ NV12, YV12, I420, UYVY, YUY2, BGRA, BGRx }"
+#define GST_MFX_SUPPORTED_8BIT_FORMATS \
+    "NV12, YV12, I420, UYVY, YUY2, BGRA, BGRx"
 #endif
 
+#define GST_MFX_SUPPORTED_INPUT_FORMATS \
+    "{ " GST_MFX_SUPPORTED_8BIT_FORMATS \
+    GST_MFX_SUPPORTED_10BIT_FORMATS " }"
+
+/* Only the H.265 encoder has a 10-bit profile, the other encoders would
+ * have to drop the two least significant bits of 10-bit input */
+#define GST_MFX_SUPPORTED_8BIT_INPUT_FORMATS \
+    "{ " GST_MFX_SUPPORTED_8BIT_FORMATS " }"
+
 
 gboolean
 gst_caps_has_mfx_surface(GstCaps * caps);
 
+gboolean
+gst_caps_has_dmabuf(GstCaps * caps);
+
 gboolean
 gst_mfx_query_peer_has_raw_caps(GstPad * pad);
 
@@ -96,4 +120,27 @@ void
 gst_video_info_change_format(GstVideoInfo * vip, GstVideoFormat format,
     guint width, guint height);
 
+/* Helpers to tune the number of in-flight MFX operations */
+#define GST_MFX_ASYNC_DEPTH_DEFAULT   4
+#define GST_MFX_ASYNC_DEPTH_MAX       20
+
+/* Upstream latency, protected by the object lock of the element */
+typedef struct _GstMfxUpstreamLatency GstMfxUpstreamLatency;
+struct _GstMfxUpstreamLatency
+{
+  gboolean valid;
+  gboolean live;
+  GstClockTime min_latency;
+  GstClockTime max_latency;
+};
+
+void
+gst_mfx_upstream_latency_update (GstMfxUpstreamLatency * latency,
+    GstElement * element, GstPad * sinkpad);
+
+guint
+gst_mfx_select_async_depth (const GstMfxUpstreamLatency * latency,
+    GstElement * element, GstClockTime frame_duration,
+    GstClockTime device_latency, gboolean pool_pressure, guint async_depth);
+
 #endif /* GST_MFX_PLUGIN_UTIL_H */
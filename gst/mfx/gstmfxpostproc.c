@@ -30,6 +30,9 @@
 #include "gstmfxvideobufferpool.h"
 #include "gstmfxvideomemory.h"
 
+#include <gst-libs/mfx/gstmfxutils_p010.h>
+#include <gst-libs/mfx/gstmfxutils_rgb.h>
+
 #define GST_PLUGIN_NAME "mfxvpp"
 #define GST_PLUGIN_DESC "A video postprocessing filter"
 
@@ -46,6 +49,7 @@ static const char gst_mfxpostproc_sink_caps_str[] =
         GST_CAPS_FEATURE_MEMORY_MFX_SURFACE ","
             GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION,
         "{ NV12, BGRA }") ";"
+    GST_MFX_MAKE_DMABUF_CAPS "; "
     GST_VIDEO_CAPS_MAKE_WITH_FEATURES (
         GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION,
         GST_MFX_SUPPORTED_INPUT_FORMATS) ";"
@@ -53,7 +57,14 @@ static const char gst_mfxpostproc_sink_caps_str[] =
 
 static const char gst_mfxpostproc_src_caps_str[] =
     GST_MFX_MAKE_SURFACE_CAPS "; "
-    GST_VIDEO_CAPS_MAKE ("{ NV12, BGRA }");
+    GST_VIDEO_CAPS_MAKE ("{ NV12, BGRA }")
+#if GST_CHECK_VERSION(1,10,0)
+    "; " GST_VIDEO_CAPS_MAKE ("{ P010_10LE, I420_10LE, v210 }")
+#endif
+#if GST_CHECK_VERSION(1,20,0)
+    "; " GST_VIDEO_CAPS_MAKE ("{ RGBP, BGRP }")
+#endif
+    ;
 
 static GstStaticPadTemplate gst_mfxpostproc_sink_factory =
 GST_STATIC_PAD_TEMPLATE ("sink",
@@ -479,6 +490,48 @@ video_info_update (GstCaps * caps, GstVideoInfo * info,
   return TRUE;
 }
 
+static gboolean
+is_planar_rgb_format (GstVideoFormat format)
+{
+#if GST_CHECK_VERSION(1,20,0)
+  return GST_VIDEO_FORMAT_RGBP == format || GST_VIDEO_FORMAT_BGRP == format;
+#else
+  return FALSE;
+#endif
+}
+
+/* Planar RGB is produced from an RGB4 surface scaled by VPP to the
+ * picture area, which is centered in the output when the aspect ratio
+ * is kept and padded with black */
+static void
+update_planar_rgb_rect (GstMfxPostproc * vpp)
+{
+  GstMfxRectangle *const rect = &vpp->planar_rect;
+  guint out_width = GST_VIDEO_INFO_WIDTH (&vpp->srcpad_info);
+  guint out_height = GST_VIDEO_INFO_HEIGHT (&vpp->srcpad_info);
+  guint in_width = GST_VIDEO_INFO_WIDTH (&vpp->sinkpad_info);
+  guint in_height = GST_VIDEO_INFO_HEIGHT (&vpp->sinkpad_info);
+
+  if (GST_MFX_ROTATION_90 == vpp->angle ||
+      GST_MFX_ROTATION_270 == vpp->angle) {
+    in_width = GST_VIDEO_INFO_HEIGHT (&vpp->sinkpad_info);
+    in_height = GST_VIDEO_INFO_WIDTH (&vpp->sinkpad_info);
+  }
+
+  rect->width = out_width;
+  rect->height = out_height;
+  if (vpp->keep_aspect && in_width && in_height) {
+    if ((guint64) out_width * in_height > (guint64) out_height * in_width)
+      rect->width = gst_util_uint64_scale_int (out_height, in_width,
+          in_height) & ~1;
+    else
+      rect->height = gst_util_uint64_scale_int (out_width, in_height,
+          in_width) & ~1;
+  }
+  rect->x = (out_width - rect->width) / 2;
+  rect->y = (out_height - rect->height) / 2;
+}
+
 static gboolean
 gst_mfxpostproc_update_src_caps (GstMfxPostproc * vpp, GstCaps * caps,
     gboolean * caps_changed_ptr)
@@ -488,6 +541,13 @@ gst_mfxpostproc_update_src_caps (GstMfxPostproc * vpp, GstCaps * caps,
   if (!video_info_update (caps, &vpp->srcpad_info, caps_changed_ptr))
     return FALSE;
 
+  vpp->planar_rgb =
+      is_planar_rgb_format (GST_VIDEO_INFO_FORMAT (&vpp->srcpad_info));
+  if (vpp->planar_rgb)
+    update_planar_rgb_rect (vpp);
+  vpp->unpack_p010 = gst_mfx_video_format_is_repacked (
+      GST_VIDEO_INFO_FORMAT (&vpp->srcpad_info));
+
   if (GST_VIDEO_INFO_FORMAT (&vpp->sinkpad_info) !=
       GST_VIDEO_INFO_FORMAT (&vpp->srcpad_info))
     vpp->flags |= GST_MFX_POSTPROC_FLAG_FORMAT;
@@ -592,6 +652,129 @@ gst_mfxpostproc_before_transform (GstBaseTransform * trans,
   }
 }
 
+/* Clears the letterbox borders of an output plane, i.e. the rows above
+ * and below @rect and the columns left and right of it */
+static void
+clear_planar_borders (GstVideoFrame * frame, guint p,
+    const GstMfxRectangle * rect)
+{
+  guint8 *const data = GST_VIDEO_FRAME_PLANE_DATA (frame, p);
+  const guint stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, p);
+  const guint width = GST_VIDEO_FRAME_WIDTH (frame);
+  const guint height = GST_VIDEO_FRAME_HEIGHT (frame);
+  const guint right = rect->x + rect->width;
+  const guint bottom = rect->y + rect->height;
+  guint i;
+
+  memset (data, 0, rect->y * stride);
+  if (bottom < height)
+    memset (data + bottom * stride, 0, (height - bottom) * stride);
+
+  if (rect->x == 0 && right >= width)
+    return;
+
+  for (i = rect->y; i < bottom; i++) {
+    memset (data + i * stride, 0, rect->x);
+    if (right < width)
+      memset (data + i * stride + right, 0, width - right);
+  }
+}
+
+static gboolean
+copy_planar_rgb (GstMfxPostproc * vpp, GstMfxSurface * surface,
+    GstBuffer * outbuf)
+{
+  const GstMfxRectangle *const rect = &vpp->planar_rect;
+  GstVideoFrame frame;
+  guint8 *src, *r, *g, *b;
+  guint src_stride, i, p;
+  gboolean is_bgrp;
+
+  if (!gst_video_frame_map (&frame, &vpp->srcpad_info, outbuf, GST_MAP_WRITE))
+    return FALSE;
+  if (!gst_mfx_surface_map (surface)) {
+    gst_video_frame_unmap (&frame);
+    return FALSE;
+  }
+
+  /* Letterbox borders, the picture itself is overwritten below */
+  if (rect->width != GST_VIDEO_FRAME_WIDTH (&frame)
+      || rect->height != GST_VIDEO_FRAME_HEIGHT (&frame))
+    for (p = 0; p < 3; p++)
+      clear_planar_borders (&frame, p, rect);
+
+#if GST_CHECK_VERSION(1,20,0)
+  is_bgrp = GST_VIDEO_FORMAT_BGRP == GST_VIDEO_FRAME_FORMAT (&frame);
+#else
+  is_bgrp = FALSE;
+#endif
+
+  src = gst_mfx_surface_get_plane (surface, 0);
+  src_stride = gst_mfx_surface_get_pitch (surface, 0);
+
+#define PLANE_ROW(p) ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&frame, p) \
+    + (rect->y + i) * GST_VIDEO_FRAME_PLANE_STRIDE (&frame, p) + rect->x)
+
+  for (i = 0; i < rect->height; i++) {
+    r = PLANE_ROW (is_bgrp ? 2 : 0);
+    g = PLANE_ROW (1);
+    b = PLANE_ROW (is_bgrp ? 0 : 2);
+    gst_mfx_utils_rgb_bgra_to_planar (src + i * src_stride, r, g, b,
+        rect->width);
+  }
+#undef PLANE_ROW
+
+  gst_mfx_surface_unmap (surface);
+  gst_video_frame_unmap (&frame);
+  return TRUE;
+}
+
+static gboolean
+copy_unpacked_p010 (GstMfxPostproc * vpp, GstMfxSurface * surface,
+    GstBuffer * outbuf)
+{
+  GstVideoFrame frame;
+  const guint8 *y, *uv;
+  guint y_pitch, uv_pitch, width, height, i;
+
+  if (!gst_video_frame_map (&frame, &vpp->srcpad_info, outbuf, GST_MAP_WRITE))
+    return FALSE;
+  if (!gst_mfx_surface_map (surface)) {
+    gst_video_frame_unmap (&frame);
+    return FALSE;
+  }
+
+  y = gst_mfx_surface_get_plane (surface, 0);
+  uv = gst_mfx_surface_get_plane (surface, 1);
+  y_pitch = gst_mfx_surface_get_pitch (surface, 0);
+  uv_pitch = gst_mfx_surface_get_pitch (surface, 1);
+  width = GST_VIDEO_FRAME_WIDTH (&frame);
+  height = GST_VIDEO_FRAME_HEIGHT (&frame);
+
+#define PLANE_ROW(p, i) ((guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&frame, p) \
+    + (i) * GST_VIDEO_FRAME_PLANE_STRIDE (&frame, p))
+
+  if (GST_VIDEO_FORMAT_v210 == GST_VIDEO_FRAME_FORMAT (&frame)) {
+    /* Each chroma row is repeated for the two luma rows sharing it */
+    for (i = 0; i < height; i++)
+      gst_mfx_utils_p010_to_v210 ((const guint16 *) (y + i * y_pitch),
+          (const guint16 *) (uv + (i / 2) * uv_pitch), PLANE_ROW (0, i),
+          width);
+  } else {
+    for (i = 0; i < height; i++)
+      gst_mfx_utils_p010_unpack_y ((const guint16 *) (y + i * y_pitch),
+          (guint16 *) PLANE_ROW (0, i), width);
+    for (i = 0; i < GST_ROUND_UP_2 (height) / 2; i++)
+      gst_mfx_utils_p010_unpack_uv ((const guint16 *) (uv + i * uv_pitch),
+          (guint16 *) PLANE_ROW (1, i), (guint16 *) PLANE_ROW (2, i), width);
+  }
+#undef PLANE_ROW
+
+  gst_mfx_surface_unmap (surface);
+  gst_video_frame_unmap (&frame);
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_mfxpostproc_transform (GstBaseTransform * trans, GstBuffer * inbuf,
     GstBuffer * outbuf)
@@ -632,24 +815,40 @@ gst_mfxpostproc_transform (GstBaseTransform * trans, GstBuffer * inbuf,
         && GST_MFX_FILTER_STATUS_ERROR_MORE_DATA != status)
       goto error_process_vpp;
 
-    if (GST_MFX_FILTER_STATUS_ERROR_MORE_SURFACE == status)
-      outbuf_meta = gst_buffer_get_mfx_video_meta (buf);
-    else
-      outbuf_meta = gst_buffer_get_mfx_video_meta (outbuf);
-
-    if (!outbuf_meta)
-      goto error_create_meta;
-
-    gst_mfx_video_meta_set_surface (outbuf_meta, out_surface);
-    crop_rect = gst_mfx_surface_get_crop_rect (out_surface);
-    if (crop_rect) {
-      GstVideoCropMeta *const crop_meta =
-          gst_buffer_add_video_crop_meta (outbuf);
-      if (crop_meta) {
-        crop_meta->x = crop_rect->x;
-        crop_meta->y = crop_rect->y;
-        crop_meta->width = crop_rect->width;
-        crop_meta->height = crop_rect->height;
+    if (vpp->planar_rgb) {
+      if (GST_MFX_FILTER_STATUS_ERROR_MORE_DATA != status
+          && !copy_planar_rgb (vpp, out_surface,
+              GST_MFX_FILTER_STATUS_ERROR_MORE_SURFACE == status ?
+                buf : outbuf))
+        goto error_copy_planar_rgb;
+    }
+    else if (vpp->unpack_p010) {
+      if (GST_MFX_FILTER_STATUS_ERROR_MORE_DATA != status
+          && !copy_unpacked_p010 (vpp, out_surface,
+              GST_MFX_FILTER_STATUS_ERROR_MORE_SURFACE == status ?
+                buf : outbuf))
+        goto error_copy_unpacked_p010;
+    }
+    else {
+      if (GST_MFX_FILTER_STATUS_ERROR_MORE_SURFACE == status)
+        outbuf_meta = gst_buffer_get_mfx_video_meta (buf);
+      else
+        outbuf_meta = gst_buffer_get_mfx_video_meta (outbuf);
+
+      if (!outbuf_meta)
+        goto error_create_meta;
+
+      gst_mfx_video_meta_set_surface (outbuf_meta, out_surface);
+      crop_rect = gst_mfx_surface_get_crop_rect (out_surface);
+      if (crop_rect) {
+        GstVideoCropMeta *const crop_meta =
+            gst_buffer_add_video_crop_meta (outbuf);
+        if (crop_meta) {
+          crop_meta->x = crop_rect->x;
+          crop_meta->y = crop_rect->y;
+          crop_meta->width = crop_rect->width;
+          crop_meta->height = crop_rect->height;
+        }
       }
     }
 
@@ -697,6 +896,18 @@ error_create_meta:
     gst_buffer_unref (buf);
     return GST_FLOW_ERROR;
   }
+error_copy_planar_rgb:
+  {
+    GST_ERROR ("failed to convert output to planar RGB");
+    gst_buffer_unref (buf);
+    return GST_FLOW_ERROR;
+  }
+error_copy_unpacked_p010:
+  {
+    GST_ERROR ("failed to unpack P010 output");
+    gst_buffer_unref (buf);
+    return GST_FLOW_ERROR;
+  }
 error_create_surface:
   {
     GST_ERROR ("failed to create surface surface from buffer");
@@ -722,8 +933,25 @@ gst_mfxpostproc_propose_allocation (GstBaseTransform * trans,
 static gboolean
 gst_mfxpostproc_decide_allocation (GstBaseTransform * trans, GstQuery * query)
 {
-  return gst_mfx_plugin_base_decide_allocation (GST_MFX_PLUGIN_BASE (trans),
-      query);
+  GstMfxPluginBase *const plugin = GST_MFX_PLUGIN_BASE (trans);
+  GstMfxPostproc *const vpp = GST_MFXPOSTPROC (trans);
+  GstBufferPool *pool = NULL;
+
+  if (!vpp->planar_rgb && !vpp->unpack_p010)
+    return gst_mfx_plugin_base_decide_allocation (plugin, query);
+
+  /* Planar RGB and unpacked 10-bit output are written by the CPU, so
+   * plain system memory buffers are enough and no surface is attached
+   * to them */
+  if (!GST_BASE_TRANSFORM_CLASS (gst_mfxpostproc_parent_class)->
+      decide_allocation (trans, query))
+    return FALSE;
+
+  if (gst_query_get_n_allocation_pools (query) > 0)
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, NULL, NULL, NULL);
+  g_clear_object (&plugin->srcpad_buffer_pool);
+  plugin->srcpad_buffer_pool = pool;
+  return TRUE;
 }
 
 static gboolean
@@ -879,13 +1107,20 @@ gst_mfxpostproc_create (GstMfxPostproc * vpp)
   if (vpp->async_depth)
     gst_mfx_filter_set_async_depth (vpp->filter, vpp->async_depth);
 
-  gst_mfx_filter_set_size (vpp->filter,
-    GST_VIDEO_INFO_WIDTH (&vpp->srcpad_info),
-    GST_VIDEO_INFO_HEIGHT (&vpp->srcpad_info));
+  if (vpp->planar_rgb) {
+    gst_mfx_filter_set_size (vpp->filter,
+      vpp->planar_rect.width, vpp->planar_rect.height);
+    gst_mfx_filter_set_format (vpp->filter, MFX_FOURCC_RGB4);
+  }
+  else {
+    gst_mfx_filter_set_size (vpp->filter,
+      GST_VIDEO_INFO_WIDTH (&vpp->srcpad_info),
+      GST_VIDEO_INFO_HEIGHT (&vpp->srcpad_info));
 
-  if (vpp->flags & GST_MFX_POSTPROC_FLAG_FORMAT)
-    gst_mfx_filter_set_format (vpp->filter,
-      gst_video_format_to_mfx_fourcc (vpp->format));
+    if (vpp->flags & GST_MFX_POSTPROC_FLAG_FORMAT)
+      gst_mfx_filter_set_format (vpp->filter,
+        gst_video_format_to_mfx_fourcc (vpp->format));
+  }
 
   if (vpp->flags & GST_MFX_POSTPROC_FLAG_DENOISE)
     gst_mfx_filter_set_denoising_level (vpp->filter, vpp->denoise_level);
@@ -972,6 +1207,8 @@ gst_mfxpostproc_stop (GstBaseTransform * trans)
 
   gst_video_info_init (&vpp->sinkpad_info);
   gst_video_info_init (&vpp->srcpad_info);
+  vpp->planar_rgb = FALSE;
+  vpp->unpack_p010 = FALSE;
 
   gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (vpp), FALSE);
   gst_mfxpostproc_destroy (vpp);
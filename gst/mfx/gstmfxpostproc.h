@@ -128,6 +128,13 @@ struct _GstMfxPostproc
   /* Rotation angle */
   GstMfxRotation          angle;
 
+  /* Planar RGB output, split on the CPU from the RGB4 picture area */
+  gboolean                planar_rgb;
+  GstMfxRectangle         planar_rect;
+
+  /* I420_10LE or v210 output, unpacked on the CPU from P010 */
+  gboolean                unpack_p010;
+
   guint                   keep_aspect : 1;
 };
 
@@ -36,6 +36,7 @@
 
 #include <gst-libs/mfx/gstmfxsurface.h>
 #include <gst-libs/mfx/gstmfxsurfacecomposition.h>
+#include <gst-libs/mfx/gstmfxwindow_null.h>
 
 #define GST_PLUGIN_NAME "mfxsink"
 #define GST_PLUGIN_DESC "A MFX-based videosink"
@@ -82,6 +83,7 @@ enum
   PROP_NO_FRAME_DROP,
   PROP_GL_API,
   PROP_FULL_COLOR_RANGE,
+  PROP_RENDER_STATS,
   N_PROPERTIES
 };
 
@@ -489,6 +491,29 @@ gst_mfxsink_backend_wayland (void)
 }
 #endif
 
+/* ------------------------------------------------------------------------ */
+/* --- Null Backend                                                     --- */
+/* ------------------------------------------------------------------------ */
+
+static gboolean
+gst_mfxsink_null_create_window (GstMfxSink * sink, guint width, guint height)
+{
+  g_return_val_if_fail (sink->window == NULL, FALSE);
+  sink->window = gst_mfx_window_null_new (sink->display, width, height);
+  if (!sink->window)
+    return FALSE;
+  return TRUE;
+}
+
+static const inline GstMfxSinkBackend *
+gst_mfxsink_backend_null (void)
+{
+  static const GstMfxSinkBackend GstMfxSinkBackendNull = {
+    .create_window = gst_mfxsink_null_create_window,
+  };
+  return &GstMfxSinkBackendNull;
+}
+
 
 /* ------------------------------------------------------------------------ */
 /* --- GstVideoOverlay interface                                        --- */
@@ -732,6 +757,12 @@ gst_mfxsink_set_render_backend (GstMfxSink * sink)
           GST_MFX_DISPLAY_TYPE (gst_mfx_display_egl_get_parent_display (display));
       break;
 #endif
+    case GST_MFX_DISPLAY_TYPE_NULL:
+      /* No native display, render through the VA display of the sink */
+      display = gst_mfx_display_ref (sink->drm_display);
+      sink->backend = gst_mfxsink_backend_null ();
+      sink->display_type = GST_MFX_DISPLAY_TYPE_NULL;
+      break;
 display_unsupported:
     default:
       GST_ERROR ("display type %s not supported",
@@ -838,6 +869,13 @@ gst_mfxsink_ensure_window_size (GstMfxSink * sink, guint * width_ptr,
     return;
   }
 
+  /* Headless rendering has no screen to fit into */
+  if (sink->display_type == GST_MFX_DISPLAY_TYPE_NULL) {
+    *width_ptr = sink->video_width;
+    *height_ptr = sink->video_height;
+    return;
+  }
+
   gst_mfx_display_get_size (sink->display, &display_width, &display_height);
   if (sink->fullscreen) {
     *width_ptr = display_width;
@@ -882,6 +920,15 @@ gst_mfxsink_start (GstBaseSink * base_sink)
   sink->drm_display =
       gst_mfx_task_aggregator_get_display (plugin->aggregator);
 
+  GST_OBJECT_LOCK (sink);
+  sink->frames_presented = 0;
+  sink->frames_dropped = 0;
+  sink->frame_pending = FALSE;
+  sink->render_time_last = 0;
+  sink->render_time_max = 0;
+  sink->render_time_total = 0;
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -889,12 +936,28 @@ static gboolean
 gst_mfxsink_stop (GstBaseSink * base_sink)
 {
   GstMfxSink *const sink = GST_MFXSINK_CAST (base_sink);
+  guint64 presented, dropped;
+  GstClockTime render_time_max;
+
+  GST_OBJECT_LOCK (sink);
+  presented = sink->frames_presented;
+  dropped = sink->frames_dropped;
+  render_time_max = sink->render_time_max;
+  GST_OBJECT_UNLOCK (sink);
+
+  GST_INFO_OBJECT (sink, "presented %" G_GUINT64_FORMAT ", dropped %"
+      G_GUINT64_FORMAT ", max render time %" GST_TIME_FORMAT,
+      presented, dropped, GST_TIME_ARGS (render_time_max));
 
   if (!sink->foreign_window) {
     gst_mfx_window_replace (&sink->window, NULL);
     gst_mfx_display_replace (&sink->display, NULL);
   }
 
+  if (sink->subpicture_cache) {
+    g_hash_table_unref (sink->subpicture_cache);
+    sink->subpicture_cache = NULL;
+  }
   gst_mfx_composite_filter_replace (&sink->composite_filter, NULL);
   gst_mfx_display_replace (&sink->drm_display, NULL);
 
@@ -1020,6 +1083,9 @@ gst_mfxsink_show_frame (GstVideoSink * video_sink, GstBuffer * src_buffer)
       gst_buffer_get_video_overlay_composition_meta (src_buffer);
   GstVideoOverlayComposition *overlay = NULL;
   GstMfxSurfaceComposition *composition = NULL;
+  gint64 start_time, render_time;
+
+  start_time = g_get_monotonic_time ();
 
   meta = gst_buffer_get_mfx_video_meta (src_buffer);
 
@@ -1046,7 +1112,11 @@ gst_mfxsink_show_frame (GstVideoSink * video_sink, GstBuffer * src_buffer)
         gst_mfx_composite_filter_new (plugin->aggregator,
             !gst_mfx_surface_has_video_memory (surface));
 
-    composition = gst_mfx_surface_composition_new (surface, overlay);
+    if (!sink->subpicture_cache)
+      sink->subpicture_cache = gst_mfx_surface_composition_cache_new ();
+
+    composition = gst_mfx_surface_composition_new (surface, overlay,
+        sink->subpicture_cache);
     if (!composition) {
       GST_ERROR("Failed to create new surface composition");
       goto error;
@@ -1054,13 +1124,30 @@ gst_mfxsink_show_frame (GstVideoSink * video_sink, GstBuffer * src_buffer)
 
     gst_mfx_composite_filter_apply_composition (sink->composite_filter,
         composition, &composite_surface);
-  }
+  } else if (sink->subpicture_cache)
+    g_hash_table_remove_all (sink->subpicture_cache);
 
   if (!gst_mfxsink_render_surface (sink,
         composite_surface ? composite_surface : surface, surface_rect))
     goto error;
 
   gst_mfx_surface_dequeue(surface);
+
+  render_time = (g_get_monotonic_time () - start_time) * GST_USECOND;
+  GST_OBJECT_LOCK (sink);
+  /* The preroll buffer is shown again when it gets rendered, only count
+   * the first time a prepared frame makes it to the screen */
+  if (sink->frame_pending) {
+    sink->frames_presented++;
+    sink->render_time_total += render_time;
+    sink->frame_pending = FALSE;
+  }
+  sink->render_time_last = render_time;
+  sink->render_time_max = MAX (sink->render_time_max, render_time);
+  GST_OBJECT_UNLOCK (sink);
+  GST_LOG_OBJECT (sink, "rendered in %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (render_time));
+
   ret = GST_FLOW_OK;
 done:
   gst_mfx_surface_composition_replace (&composition, NULL);
@@ -1081,6 +1168,43 @@ no_surface:
   goto done;
 }
 
+/* Called for every buffer before it is synchronized against the clock.
+ * A frame still pending from the previous call was never shown, i.e. the
+ * base class dropped it as late or it was flushed */
+static GstFlowReturn
+gst_mfxsink_prepare (GstBaseSink * base_sink, GstBuffer * buffer)
+{
+  GstMfxSink *const sink = GST_MFXSINK_CAST (base_sink);
+
+  GST_OBJECT_LOCK (sink);
+  if (sink->frame_pending)
+    sink->frames_dropped++;
+  sink->frame_pending = TRUE;
+  GST_OBJECT_UNLOCK (sink);
+
+  return GST_FLOW_OK;
+}
+
+static GstStructure *
+gst_mfxsink_get_render_stats (GstMfxSink * sink)
+{
+  GstStructure *stats;
+  guint64 presented;
+
+  GST_OBJECT_LOCK (sink);
+  presented = sink->frames_presented;
+  stats = gst_structure_new ("GstMfxSinkRenderStats",
+      "presented", G_TYPE_UINT64, presented,
+      "dropped", G_TYPE_UINT64, sink->frames_dropped,
+      "last-render-time", G_TYPE_UINT64, sink->render_time_last,
+      "max-render-time", G_TYPE_UINT64, sink->render_time_max,
+      "average-render-time", G_TYPE_UINT64,
+      presented ? sink->render_time_total / presented : 0, NULL);
+  GST_OBJECT_UNLOCK (sink);
+
+  return stats;
+}
+
 static gboolean
 gst_mfxsink_query (GstBaseSink * base_sink, GstQuery * query)
 {
@@ -1187,6 +1311,9 @@ gst_mfxsink_get_property (GObject * object,
     case PROP_GL_API:
       g_value_set_enum (value, sink->gl_api);
       break;
+    case PROP_RENDER_STATS:
+      g_value_take_boxed (value, gst_mfxsink_get_render_stats (sink));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1217,6 +1344,7 @@ gst_mfxsink_class_init (GstMfxSinkClass * klass)
   basesink_class->stop = gst_mfxsink_stop;
   basesink_class->get_caps = gst_mfxsink_get_caps;
   basesink_class->set_caps = gst_mfxsink_set_caps;
+  basesink_class->prepare = GST_DEBUG_FUNCPTR (gst_mfxsink_prepare);
   basesink_class->query = GST_DEBUG_FUNCPTR (gst_mfxsink_query);
 
   videosink_class->show_frame = GST_DEBUG_FUNCPTR (gst_mfxsink_show_frame);
@@ -1296,6 +1424,19 @@ gst_mfxsink_class_init (GstMfxSinkClass * klass)
       "Full color range",
       "Decoded frames will be in RGB 0-255",
       FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstMfxSink:render-stats:
+   *
+   * Frames presented and dropped since the sink was started, together
+   * with the last, maximum and average time spent rendering a frame in
+   * nanoseconds. Mostly useful with the headless "null" display.
+   */
+  g_properties[PROP_RENDER_STATS] =
+      g_param_spec_boxed ("render-stats",
+      "Render statistics",
+      "Presented and dropped frames and render times",
+      GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
 #ifdef USE_EGL
   /**
    * GstMfxSink:gl-api:
@@ -96,6 +96,7 @@ struct _GstMfxSink
   volatile gboolean          event_thread_cancel;
 
   GstMfxCompositeFilter     *composite_filter;
+  GHashTable                *subpicture_cache;
   GstMfxDisplay             *drm_display;
 
   GstMfxDisplay             *display;
@@ -105,6 +106,14 @@ struct _GstMfxSink
 
   GstMfxGLAPI                gl_api;
 
+  /* Render statistics, protected by the object lock */
+  guint64                    frames_presented;
+  guint64                    frames_dropped;
+  gboolean                   frame_pending;
+  GstClockTime               render_time_last;
+  GstClockTime               render_time_max;
+  GstClockTime               render_time_total;
+
   guint                      handle_events : 1;
   guint                      foreign_window : 1;
   guint                      fullscreen : 1;
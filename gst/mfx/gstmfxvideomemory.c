@@ -22,27 +22,27 @@
 
 #include "gstmfxvideomemory.h"
 
+#include <gst-libs/mfx/gstmfxutils_copy.h>
+
 GST_DEBUG_CATEGORY_STATIC (gst_debug_mfxvideomemory);
 #define GST_CAT_DEFAULT gst_debug_mfxvideomemory
 
-static gboolean
-copy_image (GstMfxVideoMemory * mem)
+/* Fills in the plane copies between the surface and the image layout
+ * of mem->data, towards the surface when @to_surface is set */
+static guint
+get_image_planes (GstMfxVideoMemory * mem, GstMfxPlaneCopy * planes,
+    gboolean to_surface)
 {
-  guint i, j, src_stride, dest_stride, height, offset, num_planes, plane_size;
-  guint8 *src_plane = NULL;
+  guint i, offset, num_planes, plane_size, stride;
+  guint8 *surface_data, *image_data;
+  guint surface_pitch;
 
   guint data_size = GST_VIDEO_INFO_SIZE (mem->image_info);
-  mem->data = g_slice_alloc (data_size);
-  if (!mem->data)
-    return FALSE;
-
   num_planes = GST_VIDEO_INFO_N_PLANES (mem->image_info);
 
   for (i = 0; i < num_planes; i++) {
-    src_plane = gst_mfx_surface_get_plane (mem->surface, i);
-    src_stride = gst_mfx_surface_get_pitch (mem->surface, i);
+    GstMfxPlaneCopy *const p = &planes[i];
 
-    dest_stride = GST_VIDEO_INFO_PLANE_STRIDE (mem->image_info, i);
     offset = GST_VIDEO_INFO_PLANE_OFFSET (mem->image_info, i);
 
     if (i != num_planes - 1)
@@ -51,15 +51,35 @@ copy_image (GstMfxVideoMemory * mem)
     else
       plane_size = data_size - offset;
 
-    if (src_stride != dest_stride) {
-      height = plane_size / dest_stride;
-      for (j = 0; j < height; j++) {
-        memcpy (mem->data + offset, src_plane, dest_stride);
-        src_plane += src_stride;
-        offset += dest_stride;
-      }
-    } else
-      memcpy (mem->data + offset, src_plane, plane_size);
+    surface_data = gst_mfx_surface_get_plane (mem->surface, i);
+    surface_pitch = gst_mfx_surface_get_pitch (mem->surface, i);
+    image_data = (guint8 *) mem->data + offset;
+    stride = GST_VIDEO_INFO_PLANE_STRIDE (mem->image_info, i);
+
+    p->src = to_surface ? image_data : surface_data;
+    p->src_stride = to_surface ? stride : surface_pitch;
+    p->dst = to_surface ? surface_data : image_data;
+    p->dst_stride = to_surface ? surface_pitch : stride;
+    p->row_size = stride;
+    p->height = plane_size / stride;
+  }
+  return num_planes;
+}
+
+static gboolean
+copy_image (GstMfxVideoMemory * mem, GstMapFlags flags)
+{
+  GstMfxPlaneCopy planes[GST_VIDEO_MAX_PLANES];
+  guint num_planes;
+
+  mem->data = g_slice_alloc (GST_VIDEO_INFO_SIZE (mem->image_info));
+  if (!mem->data)
+    return FALSE;
+
+  /* Contents of write-only mappings are undefined, don't read them back */
+  if (flags & GST_MAP_READ) {
+    num_planes = get_image_planes (mem, planes, FALSE);
+    gst_mfx_utils_copy_planes (planes, num_planes);
   }
 
   mem->new_copy = TRUE;
@@ -67,21 +87,47 @@ copy_image (GstMfxVideoMemory * mem)
   return TRUE;
 }
 
+/* The surface was made writable when mapping, see detach_surface() */
+static void
+write_back_image (GstMfxVideoMemory * mem)
+{
+  GstMfxPlaneCopy planes[GST_VIDEO_MAX_PLANES];
+  guint num_planes;
+
+  num_planes = get_image_planes (mem, planes, TRUE);
+  gst_mfx_utils_copy_planes (planes, num_planes);
+}
+
+/* Surface planes can only be handed out as is when they follow the
+ * default layout of the image, which aligned or padded pitches and
+ * heights break */
 static gboolean
-get_image_data (GstMfxVideoMemory * mem)
+has_image_layout (GstMfxVideoMemory * mem)
 {
-  guint width = GST_VIDEO_INFO_WIDTH (mem->image_info);
-  guint aligned_width = GST_MFX_SURFACE_WIDTH (mem->surface);
-  guint height = GST_VIDEO_INFO_HEIGHT (mem->image_info);
-  guint aligned_height = GST_MFX_SURFACE_HEIGHT (mem->surface);
+  const guint8 *const data = gst_mfx_surface_get_plane (mem->surface, 0);
+  guint i;
 
-  if ((width == aligned_width && height == aligned_height && !mem->image) ||
-      GST_VIDEO_INFO_N_PLANES (mem->image_info) == 1) {
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (mem->image_info); i++) {
+    if (gst_mfx_surface_get_pitch (mem->surface, i) !=
+        GST_VIDEO_INFO_PLANE_STRIDE (mem->image_info, i))
+      return FALSE;
+    if (gst_mfx_surface_get_plane (mem->surface, i) - data !=
+        GST_VIDEO_INFO_PLANE_OFFSET (mem->image_info, i))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean
+get_image_data (GstMfxVideoMemory * mem, GstMapFlags flags)
+{
+  if ((!mem->image || GST_VIDEO_INFO_N_PLANES (mem->image_info) == 1)
+      && has_image_layout (mem)) {
     mem->data = gst_mfx_surface_get_plane (mem->surface, 0);
     mem->new_copy = FALSE;
     return TRUE;
   } else {
-    return copy_image (mem);
+    return copy_image (mem, flags);
   }
 }
 
@@ -95,6 +141,74 @@ new_surface (GstMfxVideoMemory * mem)
       gst_mfx_surface_new_from_pool (allocator->surface_pool);
 }
 
+/* Decoded surfaces may still be locked by MSDK as references, and soft
+ * copies of a buffer point to the same video memory, so CPU writes can
+ * only go to a surface that nothing else is using */
+static gboolean
+is_surface_writable (GstMfxSurface * surface)
+{
+  mfxFrameSurface1 *const surf = gst_mfx_surface_get_frame_surface (surface);
+
+  if (surf && surf->Data.Locked)
+    return FALSE;
+  return !gst_mfx_surface_is_shared (surface);
+}
+
+/* Replaces the surface of @mem with a fresh one from the pool of the
+ * allocator, holding the same picture unless @flags is write-only, and
+ * swaps it into the video meta so that downstream sees the writes */
+static gboolean
+detach_surface (GstMfxVideoMemory * mem, GstMapFlags flags)
+{
+  GstMfxPlaneCopy planes[GST_VIDEO_MAX_PLANES];
+  GstMfxSurface *surface;
+  guint i, offset, plane_size, stride, num_planes;
+
+  surface = new_surface (mem);
+  if (!surface)
+    return FALSE;
+
+  if (flags & GST_MAP_READ) {
+    if (!gst_mfx_surface_map (mem->surface)
+        || !gst_mfx_surface_map (surface)) {
+      gst_mfx_surface_unmap (mem->surface);
+      gst_mfx_surface_unref (surface);
+      return FALSE;
+    }
+
+    num_planes = GST_VIDEO_INFO_N_PLANES (mem->image_info);
+    for (i = 0; i < num_planes; i++) {
+      GstMfxPlaneCopy *const p = &planes[i];
+
+      offset = GST_VIDEO_INFO_PLANE_OFFSET (mem->image_info, i);
+      if (i != num_planes - 1)
+        plane_size =
+            GST_VIDEO_INFO_PLANE_OFFSET (mem->image_info, i + 1) - offset;
+      else
+        plane_size = GST_VIDEO_INFO_SIZE (mem->image_info) - offset;
+      stride = GST_VIDEO_INFO_PLANE_STRIDE (mem->image_info, i);
+
+      p->src = gst_mfx_surface_get_plane (mem->surface, i);
+      p->src_stride = gst_mfx_surface_get_pitch (mem->surface, i);
+      p->dst = gst_mfx_surface_get_plane (surface, i);
+      p->dst_stride = gst_mfx_surface_get_pitch (surface, i);
+      p->row_size = stride;
+      p->height = plane_size / stride;
+    }
+    gst_mfx_utils_copy_planes (planes, num_planes);
+  }
+  gst_mfx_surface_unmap (mem->surface);
+
+  /* Downstream gets the new surface, don't keep the decoder waiting
+   * for the old one to be released */
+  gst_mfx_surface_dequeue (mem->surface);
+
+  gst_mfx_video_meta_set_surface (mem->meta, surface);
+  gst_mfx_surface_replace (&mem->surface, surface);
+  gst_mfx_surface_unref (surface);
+  return TRUE;
+}
+
 static gboolean
 ensure_surface (GstMfxVideoMemory * mem)
 {
@@ -137,6 +251,10 @@ gst_video_meta_map_mfx_surface (GstVideoMeta * meta, guint plane,
   if (!ensure_surface (mem))
     goto error_ensure_surface;
 
+  if ((flags & GST_MAP_WRITE) && !is_surface_writable (mem->surface)
+      && !detach_surface (mem, flags))
+    goto error_ensure_surface;
+
   if (!gst_mfx_surface_map (mem->surface))
     goto error_map_surface;
 
@@ -210,6 +328,7 @@ gst_mfx_video_memory_new (GstAllocator * base_allocator, GstMfxVideoMeta * meta)
   mem->image = NULL;
   mem->meta = meta ? gst_mfx_video_meta_ref (meta) : NULL;
   mem->map_type = 0;
+  mem->map_flags = 0;
   mem->new_copy = FALSE;
 
   return GST_MEMORY_CAST (mem);
@@ -248,13 +367,20 @@ gst_mfx_video_memory_map (GstMfxVideoMemory * mem, gsize maxsize, guint flags)
       mem->map_type = GST_MFX_VIDEO_MEMORY_MAP_TYPE_SURFACE;
       break;
     case GST_MAP_READ:
-      // Only read flag set: return raw pixels
+    case GST_MAP_WRITE:
+    case GST_MAP_READWRITE:
+      // Read and/or write flags set: return raw pixels, which are
+      // written back to the surface on unmap if they were copied
       if (!ensure_surface (mem))
         goto error_no_surface;
+      if ((flags & GST_MAP_WRITE) && !is_surface_writable (mem->surface)
+          && !detach_surface (mem, flags))
+        goto error_no_surface;
       if (!gst_mfx_surface_map(mem->surface))
         goto error_map_surface;
 
       mem->map_type = GST_MFX_SYSTEM_MEMORY_MAP_TYPE_LINEAR;
+      mem->map_flags = flags;
       break;
     default:
       goto error_unsupported_map;
@@ -267,7 +393,7 @@ gst_mfx_video_memory_map (GstMfxVideoMemory * mem, gsize maxsize, guint flags)
       mem->data = (void*) mem->surface;
       break;
     case GST_MFX_SYSTEM_MEMORY_MAP_TYPE_LINEAR:
-      if (!get_image_data (mem))
+      if (!get_image_data (mem, flags))
         goto error_no_image;
       break;
     default:
@@ -304,10 +430,16 @@ gst_mfx_video_memory_unmap (GstMfxVideoMemory * mem)
       gst_mfx_surface_replace (&mem->surface, NULL);
       break;
     case GST_MFX_SYSTEM_MEMORY_MAP_TYPE_LINEAR:
-      if (mem->data && mem->new_copy)
+      if (mem->data && mem->new_copy) {
+        if (mem->map_flags & GST_MAP_WRITE)
+          write_back_image (mem);
         g_slice_free1(GST_VIDEO_INFO_SIZE(mem->image_info), mem->data);
+      }
+      /* Unmapping the surface flushes CPU writes to it, so the next
+       * consumer of the surface sees them */
       gst_mfx_surface_unmap(mem->surface);
       mem->data = NULL;
+      mem->map_flags = 0;
       break;
     default:
       goto error_incompatible_map;
@@ -58,6 +58,10 @@ typedef struct _GstMfxVideoAllocatorClass   GstMfxVideoAllocatorClass;
 
 #define GST_CAPS_FEATURE_MEMORY_MFX_SURFACE   "memory:MFXSurface"
 
+#ifndef GST_CAPS_FEATURE_MEMORY_DMABUF
+#define GST_CAPS_FEATURE_MEMORY_DMABUF        "memory:DMABuf"
+#endif
+
 #define GST_MFX_VIDEO_MEMORY_FLAG_IS_SET(mem, flag) \
   GST_MEMORY_FLAG_IS_SET (mem, flag)
 #define GST_MFX_VIDEO_MEMORY_FLAG_SET(mem, flag) \
@@ -70,7 +74,8 @@ typedef struct _GstMfxVideoAllocatorClass   GstMfxVideoAllocatorClass;
  * @GST_MFX_VIDEO_MEMORY_MAP_TYPE_SURFACE: map with gst_buffer_map()
  *   and flags = 0x00 to return a #GstMfxSurfaceProxy
  * @GST_MFX_VIDEO_MEMORY_MAP_TYPE_LINEAR: map with gst_buffer_map()
- *   and flags = GST_MAP_READ to return the raw pixels of the whole image
+ *   and flags = GST_MAP_READ, GST_MAP_WRITE or GST_MAP_READWRITE to
+ *   return the raw pixels of the whole image
  *
  * The set of all #GstMfxVideoMemory map types.
  */
@@ -96,6 +101,7 @@ struct _GstMfxVideoMemory
   VaapiImage          *image;
   GstMfxVideoMeta     *meta;
   guint                map_type;
+  GstMapFlags          map_flags;
   guint8              *data;
   gboolean             new_copy;
 };
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2011, Hewlett-Packard Development Company, L.P.
+ *   Author: Sebastian Dröge <sebastian.droege@collabora.co.uk>, Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ */
+
+#include "gstvc1bdu.h"
+
+#include <gst-libs/mfx/gstmfxutils_startcode.h>
+
+/* Same contract as gst_vc1_identify_next_bdu(), but on top of the
+ * vectorized start code scanner */
+GstVC1ParserResult
+gst_vc1_parse_identify_next_bdu (const guint8 * data, gsize size,
+    GstVC1BDU * bdu)
+{
+  gint off1, off2;
+
+  if (size < 4)
+    return GST_VC1_PARSER_ERROR;
+
+  off1 = gst_mfx_utils_find_start_code (data, size);
+  if (off1 < 0)
+    return GST_VC1_PARSER_NO_BDU;
+
+  bdu->sc_offset = off1;
+  bdu->offset = off1 + 4;
+  bdu->data = (guint8 *) data;
+  bdu->type = (GstVC1StartCode) data[bdu->offset - 1];
+
+  if (bdu->type == GST_VC1_END_OF_SEQ) {
+    bdu->size = 0;
+    return GST_VC1_PARSER_OK;
+  }
+
+  off2 = gst_mfx_utils_find_start_code (data + bdu->offset,
+      size - bdu->offset);
+  if (off2 < 0)
+    return GST_VC1_PARSER_NO_BDU_END;
+
+  if (off2 > 0 && data[bdu->offset + off2 - 1] == 0)
+    off2--;
+
+  bdu->size = off2;
+  return GST_VC1_PARSER_OK;
+}
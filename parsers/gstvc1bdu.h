@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2011, Hewlett-Packard Development Company, L.P.
+ *   Author: Sebastian Dröge <sebastian.droege@collabora.co.uk>, Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ *
+ */
+
+#ifndef __GST_VC1_BDU_H__
+#define __GST_VC1_BDU_H__
+
+#include <gst/gst.h>
+#include <gst/codecparsers/gstvc1parser.h>
+
+G_BEGIN_DECLS
+
+GstVC1ParserResult
+gst_vc1_parse_identify_next_bdu (const guint8 * data, gsize size,
+    GstVC1BDU * bdu);
+
+G_END_DECLS
+
+#endif /* __GST_VC1_BDU_H__ */
@@ -76,6 +76,7 @@
  */
 
 #include "gstvc1parse.h"
+#include "gstvc1bdu.h"
 
 #include <gst/base/base.h>
 #include <gst/pbutils/pbutils.h>
@@ -177,9 +178,9 @@ static GstFlowReturn gst_vc1_parse_detect (GstBaseParse * parse,
 
 static void gst_vc1_parse_reset (GstMfxVC1Parse * vc1parse);
 static gboolean gst_vc1_parse_handle_seq_layer (GstMfxVC1Parse * vc1parse,
-    GstBuffer * buf, guint offset, guint size);
+    GstBuffer * buf, const guint8 * data, guint offset, guint size);
 static gboolean gst_vc1_parse_handle_seq_hdr (GstMfxVC1Parse * vc1parse,
-    GstBuffer * buf, guint offset, guint size);
+    GstBuffer * buf, const guint8 * data, guint offset, guint size);
 static gboolean gst_vc1_parse_handle_entrypoint (GstMfxVC1Parse * vc1parse,
     GstBuffer * buf, guint offset, guint size);
 static void gst_vc1_parse_update_stream_format_properties (GstMfxVC1Parse *
@@ -750,14 +751,15 @@ calculate_mb_size (GstVC1SeqHdr * seqhdr, guint width, guint height)
 
 static gboolean
 gst_vc1_parse_handle_bdu (GstMfxVC1Parse * vc1parse, GstVC1StartCode startcode,
-    GstBuffer * buffer, guint offset, guint size)
+    GstBuffer * buffer, const guint8 * data, guint offset, guint size)
 {
   GST_DEBUG_OBJECT (vc1parse, "Handling BDU with startcode 0x%02x", startcode);
 
   switch (startcode) {
     case GST_VC1_SEQUENCE:{
       GST_DEBUG_OBJECT (vc1parse, "Have new SequenceHeader header");
-      if (!gst_vc1_parse_handle_seq_hdr (vc1parse, buffer, offset, size)) {
+      if (!gst_vc1_parse_handle_seq_hdr (vc1parse, buffer, data, offset,
+              size)) {
         GST_ERROR_OBJECT (vc1parse, "Invalid VC1 sequence header");
         return FALSE;
       }
@@ -780,44 +782,37 @@ gst_vc1_parse_handle_bdu (GstMfxVC1Parse * vc1parse, GstVC1StartCode startcode,
   return TRUE;
 }
 
+/* Handles all BDUs of buffer in [offset, offset + size). The caller has
+ * already mapped buffer, data points to the start of the mapping */
 static gboolean
 gst_vc1_parse_handle_bdus (GstMfxVC1Parse * vc1parse, GstBuffer * buffer,
-    guint offset, guint size)
+    const guint8 * data, guint offset, guint size)
 {
   GstVC1BDU bdu;
   GstVC1ParserResult pres;
-  guint8 *data;
-  GstMapInfo minfo;
-
-  gst_buffer_map (buffer, &minfo, GST_MAP_READ);
-
-  data = minfo.data + offset;
+  const guint8 *ptr = data + offset;
 
   do {
     memset (&bdu, 0, sizeof (bdu));
-    pres = gst_vc1_identify_next_bdu (data, size, &bdu);
+    pres = gst_vc1_parse_identify_next_bdu (ptr, size, &bdu);
     if (pres == GST_VC1_PARSER_OK || pres == GST_VC1_PARSER_NO_BDU_END) {
       if (pres == GST_VC1_PARSER_NO_BDU_END) {
         pres = GST_VC1_PARSER_OK;
         bdu.size = size - bdu.offset;
       }
 
-      data += bdu.offset;
+      ptr += bdu.offset;
       size -= bdu.offset;
 
-      if (!gst_vc1_parse_handle_bdu (vc1parse, bdu.type, buffer,
-              data - minfo.data, bdu.size)) {
-        gst_buffer_unmap (buffer, &minfo);
+      if (!gst_vc1_parse_handle_bdu (vc1parse, bdu.type, buffer, data,
+              ptr - data, bdu.size))
         return FALSE;
-      }
 
-      data += bdu.size;
+      ptr += bdu.size;
       size -= bdu.size;
     }
   } while (pres == GST_VC1_PARSER_OK && size > 0);
 
-  gst_buffer_unmap (buffer, &minfo);
-
   if (pres != GST_VC1_PARSER_OK) {
     GST_DEBUG_OBJECT (vc1parse, "Failed to parse BDUs");
     return FALSE;
@@ -892,7 +887,7 @@ gst_vc1_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
     /* XXX: when a buffer contains multiple BDUs, does the first one start with
      * a startcode?
      */
-    pres = gst_vc1_identify_next_bdu (data, size, &bdu);
+    pres = gst_vc1_parse_identify_next_bdu (data, size, &bdu);
     switch (pres) {
       case GST_VC1_PARSER_OK:
         GST_DEBUG_OBJECT (vc1parse, "Have complete BDU");
@@ -959,7 +954,7 @@ gst_vc1_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
           || vc1parse->input_stream_format ==
           VC1_STREAM_FORMAT_SEQUENCE_LAYER_FRAME_LAYER)) {
     g_assert (size >= 36);
-    if (!gst_vc1_parse_handle_seq_layer (vc1parse, buffer, 0, size)) {
+    if (!gst_vc1_parse_handle_seq_layer (vc1parse, buffer, data, 0, size)) {
       GST_ERROR_OBJECT (vc1parse, "Invalid sequence layer");
       ret = GST_FLOW_ERROR;
       goto done;
@@ -1009,7 +1004,8 @@ gst_vc1_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
       }
     }
 
-    if (!gst_vc1_parse_handle_bdu (vc1parse, startcode, buffer, 4, size - 4)) {
+    if (!gst_vc1_parse_handle_bdu (vc1parse, startcode, buffer, data, 4,
+            size - 4)) {
       ret = GST_FLOW_ERROR;
       goto done;
     }
@@ -1039,7 +1035,7 @@ gst_vc1_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
       }
 
       if (startcodes) {
-        if (!gst_vc1_parse_handle_bdus (vc1parse, buffer, 0, size)) {
+        if (!gst_vc1_parse_handle_bdus (vc1parse, buffer, data, 0, size)) {
           ret = GST_FLOW_ERROR;
           goto done;
         }
@@ -1145,7 +1141,8 @@ gst_vc1_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
      */
     if (startcodes) {
       /* skip frame layer header */
-      if (!gst_vc1_parse_handle_bdus (vc1parse, buffer, 8, size - 8)) {
+      if (!gst_vc1_parse_handle_bdus (vc1parse, buffer, data, 8,
+              size - 8)) {
         ret = GST_FLOW_ERROR;
         goto done;
       }
@@ -1517,21 +1514,17 @@ static const guint framerates_d[] = {
 
 static gboolean
 gst_vc1_parse_handle_seq_hdr (GstMfxVC1Parse * vc1parse,
-    GstBuffer * buf, guint offset, guint size)
+    GstBuffer * buf, const guint8 * data, guint offset, guint size)
 {
   GstVC1ParserResult pres;
   GstVC1Profile profile;
-  GstMapInfo minfo;
 
   g_assert (gst_buffer_get_size (buf) >= offset + size);
   gst_buffer_replace (&vc1parse->seq_hdr_buffer, NULL);
   memset (&vc1parse->seq_hdr, 0, sizeof (vc1parse->seq_hdr));
 
-  gst_buffer_map (buf, &minfo, GST_MAP_READ);
   pres =
-      gst_vc1_parse_sequence_header (minfo.data + offset,
-      size, &vc1parse->seq_hdr);
-  gst_buffer_unmap (buf, &minfo);
+      gst_vc1_parse_sequence_header (data + offset, size, &vc1parse->seq_hdr);
 
   if (pres != GST_VC1_PARSER_OK) {
     GST_ERROR_OBJECT (vc1parse, "Invalid VC1 sequence header");
@@ -1646,24 +1639,20 @@ gst_vc1_parse_handle_seq_hdr (GstMfxVC1Parse * vc1parse,
 
 static gboolean
 gst_vc1_parse_handle_seq_layer (GstMfxVC1Parse * vc1parse,
-    GstBuffer * buf, guint offset, guint size)
+    GstBuffer * buf, const guint8 * data, guint offset, guint size)
 {
   GstVC1ParserResult pres;
   GstVC1Profile profile;
   GstVC1Level level;
   gint width, height;
-  GstMapInfo minfo;
 
   g_assert (gst_buffer_get_size (buf) >= offset + size);
 
   gst_buffer_replace (&vc1parse->seq_layer_buffer, NULL);
   memset (&vc1parse->seq_layer, 0, sizeof (vc1parse->seq_layer));
 
-  gst_buffer_map (buf, &minfo, GST_MAP_READ);
   pres =
-      gst_vc1_parse_sequence_layer (minfo.data + offset,
-      size, &vc1parse->seq_layer);
-  gst_buffer_unmap (buf, &minfo);
+      gst_vc1_parse_sequence_layer (data + offset, size, &vc1parse->seq_layer);
 
   if (pres != GST_VC1_PARSER_OK) {
     GST_ERROR_OBJECT (vc1parse, "Invalid VC1 sequence layer");
@@ -1841,7 +1830,7 @@ gst_vc1_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
       /* ASF, VC1/WMV3 simple/main profile
        * This is the sequence header without start codes
        */
-      if (!gst_vc1_parse_handle_seq_hdr (vc1parse, codec_data,
+      if (!gst_vc1_parse_handle_seq_hdr (vc1parse, codec_data, minfo.data,
               0, codec_data_size)) {
         gst_buffer_unmap (codec_data, &minfo);
         return FALSE;
@@ -1853,8 +1842,8 @@ gst_vc1_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
       vc1parse->input_header_format = VC1_HEADER_FORMAT_ASF;
     } else if (codec_data_size == 36 && minfo.data[3] == 0xc5) {
       /* Sequence Layer, SMPTE S421M-2006 Annex L.3 */
-      if (!gst_vc1_parse_handle_seq_layer (vc1parse, codec_data, 0,
-              codec_data_size)) {
+      if (!gst_vc1_parse_handle_seq_layer (vc1parse, codec_data, minfo.data,
+              0, codec_data_size)) {
         GST_ERROR_OBJECT (vc1parse, "Invalid VC1 sequence layer");
         gst_buffer_unmap (codec_data, &minfo);
         return FALSE;
@@ -1896,13 +1885,12 @@ gst_vc1_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
             "VC1 advanced profile ASF header does not start with SequenceHeader startcode");
       }
 
-      if (!gst_vc1_parse_handle_bdus (vc1parse, codec_data, offset,
-              codec_data_size - offset)) {
+      if (!gst_vc1_parse_handle_bdus (vc1parse, codec_data, minfo.data,
+              offset, codec_data_size - offset)
+          && !gst_vc1_parse_handle_bdu (vc1parse, GST_VC1_SEQUENCE,
+              codec_data, minfo.data, 0, codec_data_size)) {
         gst_buffer_unmap (codec_data, &minfo);
-        if (!gst_vc1_parse_handle_bdu (vc1parse, GST_VC1_SEQUENCE, codec_data,
-            0, codec_data_size))
-          return FALSE;
-        gst_buffer_map (codec_data, &minfo, GST_MAP_READ);
+        return FALSE;
       }
 
       if (!vc1parse->seq_hdr_buffer) {
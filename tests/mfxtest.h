@@ -0,0 +1,110 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#ifndef MFX_TEST_H
+#define MFX_TEST_H
+
+#include <gst/gst.h>
+
+/* Element tests run pipelines with the plugin of the build tree, found
+ * through GST_PLUGIN_PATH. They need a device that the Media SDK can
+ * open, so they are skipped on machines without one */
+
+#define MFX_TEST_TIMEOUT (30 * GST_SECOND)
+
+/* Plays @pipeline until EOS, an error or @timeout, and puts it back to
+ * NULL. Returns the type of the message that ended it, 0 on timeout */
+static inline GstMessageType
+mfx_test_run_pipeline (GstElement * pipeline, GstClockTime timeout)
+{
+  GstBus *const bus = gst_element_get_bus (pipeline);
+  GstMessageType type = 0;
+  GstMessage *msg;
+
+  if (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE) {
+    msg = gst_bus_timed_pop_filtered (bus, timeout,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (msg) {
+      type = GST_MESSAGE_TYPE (msg);
+      if (type == GST_MESSAGE_ERROR) {
+        GError *err = NULL;
+        gchar *debug = NULL;
+
+        gst_message_parse_error (msg, &err, &debug);
+        g_test_message ("%s: %s", err->message, debug ? debug : "");
+        g_clear_error (&err);
+        g_free (debug);
+      }
+      gst_message_unref (msg);
+    }
+  } else {
+    type = GST_MESSAGE_ERROR;
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  return type;
+}
+
+/* Returns %NULL if an element of @description is missing */
+static inline GstElement *
+mfx_test_parse_pipeline (const gchar * description)
+{
+  GstElement *pipeline;
+  GError *err = NULL;
+
+  pipeline = gst_parse_launch (description, &err);
+  if (err) {
+    g_test_message ("%s", err->message);
+    g_clear_error (&err);
+    if (pipeline)
+      gst_object_unref (pipeline);
+    return NULL;
+  }
+  return pipeline;
+}
+
+/* Checks once whether the plugin loads and a session can be opened */
+static inline gboolean
+mfx_test_has_device (void)
+{
+  static gint has_device = -1;
+  GstElement *pipeline;
+
+  if (has_device < 0) {
+    pipeline = mfx_test_parse_pipeline ("videotestsrc num-buffers=1 ! "
+        "mfxvpp ! fakesink");
+    has_device = pipeline
+        && mfx_test_run_pipeline (pipeline, MFX_TEST_TIMEOUT) ==
+        GST_MESSAGE_EOS;
+    if (pipeline)
+      gst_object_unref (pipeline);
+  }
+  return has_device;
+}
+
+#define MFX_TEST_REQUIRE_DEVICE() G_STMT_START {  \
+  if (!mfx_test_has_device ()) {                  \
+    g_test_skip ("no usable MFX device");         \
+    return;                                       \
+  }                                               \
+} G_STMT_END
+
+#endif /* MFX_TEST_H */
@@ -0,0 +1,167 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <gst/gst.h>
+
+#include "gstmfxarena.h"
+
+#define PAGE_SIZE_2M (2 * 1024 * 1024)
+
+#define NUM_THREADS 4
+#define NUM_ROUNDS  200
+
+GST_DEBUG_CATEGORY (gst_debug_mfx);
+
+/* The arena is process-wide, so every test works on its own sizes to
+ * keep the free lists of the others out of the way */
+
+static void
+test_alignment (void)
+{
+  const gsize page_size = sysconf (_SC_PAGESIZE);
+  const gsize sizes[] = { 1, 100, 4097, PAGE_SIZE_2M - 1, PAGE_SIZE_2M + 1,
+    3 * PAGE_SIZE_2M + 17
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    guint8 *const data = gst_mfx_arena_alloc (sizes[i]);
+
+    g_assert_nonnull (data);
+    g_assert_cmpuint ((guintptr) data % page_size, ==, 0);
+    g_assert_cmpuint ((guintptr) data % GST_MFX_ARENA_ALIGNMENT, ==, 0);
+    if (sizes[i] >= PAGE_SIZE_2M)
+      g_assert_cmpuint ((guintptr) data % PAGE_SIZE_2M, ==, 0);
+
+    /* The whole requested size is usable */
+    memset (data, 0xa5, sizes[i]);
+    gst_mfx_arena_free (data, sizes[i]);
+  }
+}
+
+/* A freed block comes back for the next request that rounds up to the
+ * same block size, latest freed first */
+static void
+test_reuse (void)
+{
+  const gsize page_size = sysconf (_SC_PAGESIZE);
+  const gsize size = 7 * page_size;
+  gpointer a, b;
+
+  a = gst_mfx_arena_alloc (size);
+  b = gst_mfx_arena_alloc (size - 100);
+  g_assert_true (a != b);
+
+  gst_mfx_arena_free (a, size);
+  gst_mfx_arena_free (b, size - 100);
+
+  g_assert_true (gst_mfx_arena_alloc (size - 1) == b);
+  g_assert_true (gst_mfx_arena_alloc (size) == a);
+
+  gst_mfx_arena_free (a, size);
+  gst_mfx_arena_free (b, size);
+}
+
+/* Blocks of another size class are never handed out */
+static void
+test_size_classes (void)
+{
+  const gsize page_size = sysconf (_SC_PAGESIZE);
+  const gsize small = 11 * page_size, large = 13 * page_size;
+  const gsize huge = 5 * PAGE_SIZE_2M;
+  gpointer a, b, c;
+
+  a = gst_mfx_arena_alloc (small);
+  b = gst_mfx_arena_alloc (large);
+  c = gst_mfx_arena_alloc (huge);
+  gst_mfx_arena_free (a, small);
+  gst_mfx_arena_free (b, large);
+  gst_mfx_arena_free (c, huge);
+
+  g_assert_true (gst_mfx_arena_alloc (huge) == c);
+  g_assert_true (gst_mfx_arena_alloc (large) == b);
+  g_assert_true (gst_mfx_arena_alloc (small) == a);
+
+  /* Rounding up to 2 MiB puts these in the same class as c */
+  gst_mfx_arena_free (c, huge);
+  g_assert_true (gst_mfx_arena_alloc (huge - page_size) == c);
+
+  gst_mfx_arena_free (a, small);
+  gst_mfx_arena_free (b, large);
+  gst_mfx_arena_free (c, huge);
+}
+
+static gpointer
+alloc_thread (gpointer data)
+{
+  const gsize page_size = sysconf (_SC_PAGESIZE);
+  const guint8 tag = GPOINTER_TO_UINT (data);
+  guint8 *blocks[4];
+  gsize sizes[4];
+  guint i, j;
+
+  for (i = 0; i < NUM_ROUNDS; i++) {
+    for (j = 0; j < G_N_ELEMENTS (blocks); j++) {
+      sizes[j] = (17 + g_test_rand_int_range (0, 3)) * page_size;
+      blocks[j] = gst_mfx_arena_alloc (sizes[j]);
+      g_assert_nonnull (blocks[j]);
+      memset (blocks[j], tag, sizes[j]);
+    }
+
+    /* Nobody else wrote to a block while this thread owned it */
+    for (j = 0; j < G_N_ELEMENTS (blocks); j++) {
+      g_assert_cmpuint (blocks[j][0], ==, tag);
+      g_assert_cmpuint (blocks[j][sizes[j] / 2], ==, tag);
+      g_assert_cmpuint (blocks[j][sizes[j] - 1], ==, tag);
+      gst_mfx_arena_free (blocks[j], sizes[j]);
+    }
+  }
+  return NULL;
+}
+
+/* Surface pools of several elements allocate and free concurrently */
+static void
+test_threads (void)
+{
+  GThread *threads[NUM_THREADS];
+  guint i;
+
+  for (i = 0; i < NUM_THREADS; i++)
+    threads[i] = g_thread_new ("arena", alloc_thread,
+        GUINT_TO_POINTER (i + 1));
+  for (i = 0; i < NUM_THREADS; i++)
+    g_thread_join (threads[i]);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+  gst_init (&argc, &argv);
+  GST_DEBUG_CATEGORY_INIT (gst_debug_mfx, "mfx", 0, "MFX test");
+
+  g_test_add_func ("/arena/alignment", test_alignment);
+  g_test_add_func ("/arena/reuse", test_reuse);
+  g_test_add_func ("/arena/size-classes", test_size_classes);
+  g_test_add_func ("/arena/threads", test_threads);
+
+  return g_test_run ();
+}
@@ -0,0 +1,119 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include "mfxtest.h"
+
+#define OUT_WIDTH   640
+#define OUT_HEIGHT  480
+#define NUM_FRAMES  10
+
+/* Luma of the videotestsrc black and white patterns, with some slack
+ * for the scaling filter */
+#define LUMA_BLACK  16
+#define LUMA_WHITE  235
+#define LUMA_SLACK  24
+
+typedef struct
+{
+  guint frames;
+  guint8 background;
+  guint8 overlay;
+} Output;
+
+static void
+handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad, Output * out)
+{
+  GstVideoFrame frame;
+  GstVideoInfo info;
+  GstCaps *caps;
+  const guint8 *y;
+  gint stride;
+
+  caps = gst_pad_get_current_caps (pad);
+  g_assert_nonnull (caps);
+  g_assert_true (gst_video_info_from_caps (&info, caps));
+  gst_caps_unref (caps);
+
+  g_assert_cmpint (GST_VIDEO_INFO_WIDTH (&info), ==, OUT_WIDTH);
+  g_assert_cmpint (GST_VIDEO_INFO_HEIGHT (&info), ==, OUT_HEIGHT);
+
+  g_assert_true (gst_video_frame_map (&frame, &info, buffer, GST_MAP_READ));
+  y = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+
+  /* One pixel of the base picture, one in the middle of the overlay */
+  out->background = y[16 * stride + 16];
+  out->overlay = y[(240 + 45) * stride + 320 + 80];
+  gst_video_frame_unmap (&frame);
+
+  out->frames++;
+}
+
+/* Composes a 1280x720 input, scaled down to 160x90, on top of a 640x480
+ * base picture into a 640x480 frame in system memory. The second input
+ * is larger than both the base picture and the output, so the VPP input
+ * frames must be sized after it */
+static void
+test_larger_input (void)
+{
+  GstElement *pipeline, *sink;
+  Output out = { 0, };
+
+  MFX_TEST_REQUIRE_DEVICE ();
+
+  pipeline = mfx_test_parse_pipeline (
+      "mfxcompositor name=comp "
+      "  sink_1::xpos=320 sink_1::ypos=240 "
+      "  sink_1::width=160 sink_1::height=90 ! "
+      "video/x-raw,format=NV12,width=640,height=480 ! "
+      "fakesink name=sink signal-handoffs=true sync=false "
+      "videotestsrc num-buffers=10 pattern=black ! "
+      "video/x-raw,format=NV12,width=640,height=480,framerate=30/1 ! "
+      "mfxvpp ! comp.sink_0 "
+      "videotestsrc num-buffers=10 pattern=white ! "
+      "video/x-raw,format=NV12,width=1280,height=720,framerate=30/1 ! "
+      "mfxvpp ! comp.sink_1");
+  g_assert_nonnull (pipeline);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff), &out);
+  gst_object_unref (sink);
+
+  g_assert_cmpint (mfx_test_run_pipeline (pipeline, MFX_TEST_TIMEOUT), ==,
+      GST_MESSAGE_EOS);
+  gst_object_unref (pipeline);
+
+  g_assert_cmpuint (out.frames, ==, NUM_FRAMES);
+  g_assert_cmpint (ABS (out.background - LUMA_BLACK), <=, LUMA_SLACK);
+  g_assert_cmpint (ABS (out.overlay - LUMA_WHITE), <=, LUMA_SLACK);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+  gst_init (&argc, &argv);
+
+  g_test_add_func ("/compositor/larger-input", test_larger_input);
+
+  return g_test_run ();
+}
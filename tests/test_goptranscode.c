@@ -0,0 +1,123 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <gst/gst.h>
+
+#include "mfxtest.h"
+
+#define NUM_FRAMES  90
+
+typedef struct
+{
+  guint frames;
+  guint keyframes;
+  GstClockTime last_dts;
+  gboolean dts_ordered;
+} Output;
+
+static void
+handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad, Output * out)
+{
+  if (!out->frames)
+    g_assert_false (GST_BUFFER_FLAG_IS_SET (buffer,
+            GST_BUFFER_FLAG_DELTA_UNIT));
+  if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+    out->keyframes++;
+
+  if (GST_BUFFER_DTS_IS_VALID (buffer)) {
+    if (GST_CLOCK_TIME_IS_VALID (out->last_dts)
+        && GST_BUFFER_DTS (buffer) < out->last_dts)
+      out->dts_ordered = FALSE;
+    out->last_dts = GST_BUFFER_DTS (buffer);
+  }
+  out->frames++;
+}
+
+/* Transcodes NUM_FRAMES frames of a stream encoded with @enc_props into
+ * segments of at least @min_frames, buffering at most @max_frames */
+static void
+run_transcode (const gchar * enc_props, guint min_frames, guint max_frames,
+    Output * out)
+{
+  GstElement *pipeline, *sink;
+  gchar *desc;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=%u ! "
+      "video/x-raw,format=NV12,width=320,height=240,framerate=30/1 ! "
+      "mfxh264enc %s ! "
+      "mfxgoptranscode min-segment-frames=%u max-segment-frames=%u ! "
+      "fakesink name=sink signal-handoffs=true sync=false",
+      NUM_FRAMES, enc_props, min_frames, max_frames);
+  pipeline = mfx_test_parse_pipeline (desc);
+  g_free (desc);
+  g_assert_nonnull (pipeline);
+
+  out->last_dts = GST_CLOCK_TIME_NONE;
+  out->dts_ordered = TRUE;
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff), out);
+  gst_object_unref (sink);
+
+  g_assert_cmpint (mfx_test_run_pipeline (pipeline, MFX_TEST_TIMEOUT), ==,
+      GST_MESSAGE_EOS);
+  gst_object_unref (pipeline);
+}
+
+/* IDR every 15 frames, cut into parallel segments of 30 frames */
+static void
+test_parallel (void)
+{
+  Output out = { 0, };
+
+  MFX_TEST_REQUIRE_DEVICE ();
+
+  run_transcode ("gop-size=15 idr-interval=0", 30, 60, &out);
+
+  g_assert_cmpuint (out.frames, ==, NUM_FRAMES);
+  g_assert_cmpuint (out.keyframes, >=, NUM_FRAMES / 30);
+  g_assert_true (out.dts_ordered);
+}
+
+/* A single IDR at the start: the first segment hits the cap and the rest
+ * of the stream is transcoded serially, without buffering all of it */
+static void
+test_serial_fallback (void)
+{
+  Output out = { 0, };
+
+  MFX_TEST_REQUIRE_DEVICE ();
+
+  run_transcode ("gop-size=30 idr-interval=1000", 10, 20, &out);
+
+  g_assert_cmpuint (out.frames, ==, NUM_FRAMES);
+  g_assert_true (out.dts_ordered);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+  gst_init (&argc, &argv);
+
+  g_test_add_func ("/goptranscode/parallel", test_parallel);
+  g_test_add_func ("/goptranscode/serial-fallback", test_serial_fallback);
+
+  return g_test_run ();
+}
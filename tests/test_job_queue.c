@@ -0,0 +1,151 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <glib.h>
+
+#include "gstmfxjobqueue.h"
+
+#define NUM_JOBS    200
+#define NUM_WORKERS 4
+
+typedef struct
+{
+  GstMfxJob job;
+  GstMfxJobQueue *queue;
+  guint index;
+  guint result;
+} TestJob;
+
+/* Plays a session that takes a random time, so that jobs complete out
+ * of submission order */
+static void
+run_job (gpointer data, gpointer user_data)
+{
+  TestJob *const job = data;
+
+  g_usleep (g_test_rand_int_range (0, 2000));
+  job->result = job->index * 2;
+  gst_mfx_job_queue_complete (job->queue, &job->job);
+}
+
+static TestJob *
+job_new (GstMfxJobQueue * queue, guint index)
+{
+  TestJob *const job = g_new0 (TestJob, 1);
+
+  job->queue = queue;
+  job->index = index;
+  return job;
+}
+
+/* Nothing is handed back before the oldest job completes, even when
+ * younger ones are done */
+static void
+test_head_blocks (void)
+{
+  GstMfxJobQueue queue;
+  TestJob *first, *second;
+
+  gst_mfx_job_queue_init (&queue);
+  first = job_new (&queue, 0);
+  second = job_new (&queue, 1);
+  gst_mfx_job_queue_push (&queue, &first->job);
+  gst_mfx_job_queue_push (&queue, &second->job);
+
+  gst_mfx_job_queue_complete (&queue, &second->job);
+  g_assert_null (gst_mfx_job_queue_pop (&queue, G_MAXUINT));
+
+  gst_mfx_job_queue_complete (&queue, &first->job);
+  g_assert_true (gst_mfx_job_queue_pop (&queue, G_MAXUINT) == &first->job);
+  g_assert_true (gst_mfx_job_queue_pop (&queue, G_MAXUINT) == &second->job);
+  g_assert_null (gst_mfx_job_queue_pop (&queue, 0));
+
+  g_free (first);
+  g_free (second);
+  gst_mfx_job_queue_clear (&queue);
+}
+
+/* Plays the encoder and decoder pools: at most @max_pending jobs stay
+ * in flight while jobs are submitted, then everything is drained. Jobs
+ * must come back in submission order and with their results */
+static void
+run_pool (guint max_pending)
+{
+  GstMfxJobQueue queue;
+  GThreadPool *workers;
+  TestJob *job;
+  guint i, next = 0;
+
+  gst_mfx_job_queue_init (&queue);
+  workers = g_thread_pool_new (run_job, NULL, NUM_WORKERS, FALSE, NULL);
+
+  for (i = 0; i < NUM_JOBS; i++) {
+    while ((job = (TestJob *) gst_mfx_job_queue_pop (&queue, max_pending))) {
+      g_assert_cmpuint (job->index, ==, next++);
+      g_assert_cmpuint (job->result, ==, job->index * 2);
+      g_free (job);
+    }
+    g_assert_cmpuint (i - next, <=, max_pending);
+
+    job = job_new (&queue, i);
+    gst_mfx_job_queue_push (&queue, &job->job);
+    g_thread_pool_push (workers, job, NULL);
+  }
+
+  while ((job = (TestJob *) gst_mfx_job_queue_pop (&queue, 0))) {
+    g_assert_cmpuint (job->index, ==, next++);
+    g_assert_cmpuint (job->result, ==, job->index * 2);
+    g_free (job);
+  }
+  g_assert_cmpuint (next, ==, NUM_JOBS);
+
+  g_thread_pool_free (workers, FALSE, TRUE);
+  gst_mfx_job_queue_clear (&queue);
+}
+
+static void
+test_order (void)
+{
+  run_pool (NUM_WORKERS - 1);
+}
+
+static void
+test_order_unbounded (void)
+{
+  run_pool (G_MAXUINT);
+}
+
+static void
+test_order_serial (void)
+{
+  run_pool (0);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/job-queue/head-blocks", test_head_blocks);
+  g_test_add_func ("/job-queue/order", test_order);
+  g_test_add_func ("/job-queue/order-unbounded", test_order_unbounded);
+  g_test_add_func ("/job-queue/order-serial", test_order_serial);
+
+  return g_test_run ();
+}
@@ -0,0 +1,159 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <gst/gst.h>
+
+#include "mfxtest.h"
+
+#define NUM_FRAMES  60
+#define NUM_SEEKS   5
+
+/* The decoder outputs MFX surfaces to the sink, so it waits for the sink
+ * to release the previous one before decoding the next frame. These
+ * tests check that EOS, flushes and state changes end that wait */
+#define PIPELINE_DESC \
+    "videotestsrc num-buffers=%u ! " \
+    "video/x-raw,format=NV12,width=320,height=240,framerate=30/1 ! " \
+    "mfxh264enc ! mfxh264dec ! " \
+    "fakesink name=sink signal-handoffs=true sync=%s"
+
+static void
+handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad, guint * frames)
+{
+  (*frames)++;
+}
+
+static GstElement *
+create_pipeline (guint num_buffers, gboolean sync, guint * frames)
+{
+  GstElement *pipeline, *sink;
+  gchar *desc;
+
+  desc = g_strdup_printf (PIPELINE_DESC, num_buffers,
+      sync ? "true" : "false");
+  pipeline = mfx_test_parse_pipeline (desc);
+  g_free (desc);
+  g_assert_nonnull (pipeline);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff), frames);
+  gst_object_unref (sink);
+
+  return pipeline;
+}
+
+/* Waits for a pending state change, such as a preroll */
+static void
+wait_state (GstElement * pipeline, GstState state)
+{
+  GstState current;
+
+  g_assert_cmpint (gst_element_get_state (pipeline, &current, NULL,
+          MFX_TEST_TIMEOUT), ==, GST_STATE_CHANGE_SUCCESS);
+  g_assert_cmpint (current, ==, state);
+}
+
+/* Every frame is output and EOS comes through once the decoder is
+ * drained */
+static void
+test_eos (void)
+{
+  GstElement *pipeline;
+  guint frames = 0;
+
+  MFX_TEST_REQUIRE_DEVICE ();
+
+  pipeline = create_pipeline (NUM_FRAMES, FALSE, &frames);
+  g_assert_cmpint (mfx_test_run_pipeline (pipeline, MFX_TEST_TIMEOUT), ==,
+      GST_MESSAGE_EOS);
+  gst_object_unref (pipeline);
+
+  g_assert_cmpuint (frames, ==, NUM_FRAMES);
+}
+
+/* A prerolled sink holds the last surface while the decoder waits for
+ * it. Flushing seeks must wake the decoder up, and decoding carries on
+ * after each of them */
+static void
+test_flush (void)
+{
+  GstElement *pipeline;
+  guint frames = 0, i;
+
+  MFX_TEST_REQUIRE_DEVICE ();
+
+  pipeline = create_pipeline (NUM_FRAMES, TRUE, &frames);
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  wait_state (pipeline, GST_STATE_PAUSED);
+
+  for (i = 0; i < NUM_SEEKS; i++) {
+    g_assert_true (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+            GST_SEEK_FLAG_FLUSH, 0));
+    wait_state (pipeline, GST_STATE_PAUSED);
+  }
+
+  /* The source counts its buffers across seeks, so only check that
+   * frames still get through */
+  frames = 0;
+  g_assert_cmpint (mfx_test_run_pipeline (pipeline, MFX_TEST_TIMEOUT), ==,
+      GST_MESSAGE_EOS);
+  gst_object_unref (pipeline);
+
+  g_assert_cmpuint (frames, >, 0);
+}
+
+/* Shutting down a prerolled pipeline must not hang in the decoder, and
+ * the element must be usable again afterwards */
+static void
+test_state_change (void)
+{
+  GstElement *pipeline;
+  guint frames = 0, i;
+
+  MFX_TEST_REQUIRE_DEVICE ();
+
+  pipeline = create_pipeline (NUM_FRAMES, TRUE, &frames);
+
+  for (i = 0; i < NUM_SEEKS; i++) {
+    gst_element_set_state (pipeline, GST_STATE_PAUSED);
+    wait_state (pipeline, GST_STATE_PAUSED);
+    g_assert_cmpint (gst_element_set_state (pipeline, GST_STATE_NULL), ==,
+        GST_STATE_CHANGE_SUCCESS);
+  }
+
+  frames = 0;
+  g_assert_cmpint (mfx_test_run_pipeline (pipeline, MFX_TEST_TIMEOUT), ==,
+      GST_MESSAGE_EOS);
+  gst_object_unref (pipeline);
+
+  g_assert_cmpuint (frames, ==, NUM_FRAMES);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+  gst_init (&argc, &argv);
+
+  g_test_add_func ("/mfxdec/eos", test_eos);
+  g_test_add_func ("/mfxdec/flush", test_flush);
+  g_test_add_func ("/mfxdec/state-change", test_state_change);
+
+  return g_test_run ();
+}
@@ -0,0 +1,95 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <gst/gst.h>
+
+#include "mfxtest.h"
+
+#define NUM_BRANCHES  6
+#define NUM_FRAMES    60
+
+/* Elements of one pipeline share a display, so these branches create,
+ * map and export VA surfaces from as many streaming threads at once.
+ * Odd branches download the decoded frames to system memory, even ones
+ * keep them in MFX surfaces */
+static gchar *
+build_pipeline_desc (void)
+{
+  GString *desc = g_string_new (NULL);
+  guint i;
+
+  for (i = 0; i < NUM_BRANCHES; i++)
+    g_string_append_printf (desc, "videotestsrc num-buffers=%u pattern=%u ! "
+        "video/x-raw,format=NV12,width=320,height=240,framerate=30/1 ! "
+        "mfxh264enc ! mfxh264dec ! %s"
+        "mfxvpp ! video/x-raw,width=160,height=120 ! "
+        "fakesink name=sink%u signal-handoffs=true sync=false ",
+        NUM_FRAMES, i, (i & 1) ? "video/x-raw ! " : "", i);
+
+  return g_string_free (desc, FALSE);
+}
+
+static void
+handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad, guint * frames)
+{
+  (*frames)++;
+}
+
+static void
+test_concurrent_branches (void)
+{
+  GstElement *pipeline, *sink;
+  guint frames[NUM_BRANCHES] = { 0, };
+  gchar *desc, *name;
+  guint i;
+
+  MFX_TEST_REQUIRE_DEVICE ();
+
+  desc = build_pipeline_desc ();
+  pipeline = mfx_test_parse_pipeline (desc);
+  g_free (desc);
+  g_assert_nonnull (pipeline);
+
+  for (i = 0; i < NUM_BRANCHES; i++) {
+    name = g_strdup_printf ("sink%u", i);
+    sink = gst_bin_get_by_name (GST_BIN (pipeline), name);
+    g_free (name);
+    g_signal_connect (sink, "handoff", G_CALLBACK (handoff), &frames[i]);
+    gst_object_unref (sink);
+  }
+
+  g_assert_cmpint (mfx_test_run_pipeline (pipeline, MFX_TEST_TIMEOUT), ==,
+      GST_MESSAGE_EOS);
+  gst_object_unref (pipeline);
+
+  for (i = 0; i < NUM_BRANCHES; i++)
+    g_assert_cmpuint (frames[i], ==, NUM_FRAMES);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+  gst_init (&argc, &argv);
+
+  g_test_add_func ("/shared-display/concurrent-branches",
+      test_concurrent_branches);
+
+  return g_test_run ();
+}
@@ -0,0 +1,190 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include <gst/gst.h>
+
+#include "gstmfxutils_copy.h"
+
+#define GUARD_BYTE 0xa5
+
+GST_DEBUG_CATEGORY (gst_debug_mfx);
+
+typedef struct
+{
+  guint row_size;
+  guint height;
+  guint src_stride;
+  guint dst_stride;
+} PlaneLayout;
+
+/* Cheap enough for 4K frames, and no two neighbouring rows alike */
+static void
+fill_random (guint8 * data, gsize size)
+{
+  guint32 state = g_test_rand_int_range (1, G_MAXINT32);
+  gsize i;
+
+  for (i = 0; i < size; i++) {
+    state = state * 1664525 + 1013904223;
+    data[i] = state >> 24;
+  }
+}
+
+/* Copies the planes of @layouts and checks every row against the source
+ * and every byte of the destination padding against the guard byte */
+static void
+check_copy (const PlaneLayout * layouts, guint n_planes)
+{
+  GstMfxPlaneCopy planes[4];
+  guint8 *src[4], *dst[4];
+  guint i, row;
+
+  for (i = 0; i < n_planes; i++) {
+    const PlaneLayout *const l = &layouts[i];
+
+    src[i] = g_malloc ((gsize) l->src_stride * l->height + 1);
+    dst[i] = g_malloc ((gsize) l->dst_stride * l->height + 1);
+    fill_random (src[i], (gsize) l->src_stride * l->height);
+    memset (dst[i], GUARD_BYTE, (gsize) l->dst_stride * l->height + 1);
+
+    planes[i].src = src[i];
+    planes[i].dst = dst[i];
+    planes[i].src_stride = l->src_stride;
+    planes[i].dst_stride = l->dst_stride;
+    planes[i].row_size = l->row_size;
+    planes[i].height = l->height;
+  }
+
+  gst_mfx_utils_copy_planes (planes, n_planes);
+
+  for (i = 0; i < n_planes; i++) {
+    const PlaneLayout *const l = &layouts[i];
+
+    for (row = 0; row < l->height; row++) {
+      const guint8 *const d = dst[i] + (gsize) row * l->dst_stride;
+      guint j;
+
+      g_assert (memcmp (d, src[i] + (gsize) row * l->src_stride,
+              l->row_size) == 0);
+      for (j = l->row_size; j < l->dst_stride; j++)
+        g_assert_cmpuint (d[j], ==, GUARD_BYTE);
+    }
+    g_assert_cmpuint (dst[i][(gsize) l->dst_stride * l->height], ==,
+        GUARD_BYTE);
+
+    g_free (src[i]);
+    g_free (dst[i]);
+  }
+}
+
+/* Below the threading threshold, copied on the calling thread */
+static void
+test_small (void)
+{
+  const PlaneLayout nv12[] = {
+    {640, 480, 640, 704}, {640, 240, 640, 704}
+  };
+  const PlaneLayout packed[] = {
+    {4 * 33, 17, 4 * 33, 4 * 33}
+  };
+
+  check_copy (nv12, G_N_ELEMENTS (nv12));
+  check_copy (packed, G_N_ELEMENTS (packed));
+}
+
+/* 4K NV12 with padded surface pitches, split into bands on machines
+ * with more than one processor. Odd heights leave rows over when
+ * divided among the bands */
+static void
+test_banded (void)
+{
+  const PlaneLayout nv12[] = {
+    {3840, 2160, 3840, 4096}, {3840, 1080, 3840, 4096}
+  };
+  const PlaneLayout odd[] = {
+    {3840, 2161, 4096, 3840}, {3840, 1081, 4096, 3840}
+  };
+  const PlaneLayout contiguous[] = {
+    {4096, 2160, 4096, 4096}, {4096, 1080, 4096, 4096}
+  };
+
+  check_copy (nv12, G_N_ELEMENTS (nv12));
+  check_copy (odd, G_N_ELEMENTS (odd));
+  check_copy (contiguous, G_N_ELEMENTS (contiguous));
+}
+
+/* Planes with fewer rows than bands, an empty plane, and the maximum
+ * number of planes of very different sizes */
+static void
+test_band_edges (void)
+{
+  const PlaneLayout few_rows[] = {
+    {2 * 1024 * 1024, 3, 2 * 1024 * 1024 + 64, 2 * 1024 * 1024 + 128}
+  };
+  const PlaneLayout mixed[] = {
+    {7680, 1100, 7680, 7744}, {16, 1, 16, 32}, {7680, 0, 7680, 7680},
+    {1920, 540, 1984, 1920}
+  };
+
+  check_copy (few_rows, G_N_ELEMENTS (few_rows));
+  check_copy (mixed, G_N_ELEMENTS (mixed));
+}
+
+/* Several elements copy at the same time through the shared pool */
+static gpointer
+copy_thread (gpointer data)
+{
+  const PlaneLayout i420[] = {
+    {2560, 1600, 2560, 2624}, {1280, 800, 1280, 1344}, {1280, 800, 1280,
+        1344}
+  };
+  guint i;
+
+  for (i = 0; i < 8; i++)
+    check_copy (i420, G_N_ELEMENTS (i420));
+  return NULL;
+}
+
+static void
+test_threads (void)
+{
+  GThread *threads[3];
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("copy", copy_thread, NULL);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+  gst_init (&argc, &argv);
+  GST_DEBUG_CATEGORY_INIT (gst_debug_mfx, "mfx", 0, "MFX test");
+
+  g_test_add_func ("/utils/copy/small", test_small);
+  g_test_add_func ("/utils/copy/banded", test_banded);
+  g_test_add_func ("/utils/copy/band-edges", test_band_edges);
+  g_test_add_func ("/utils/copy/threads", test_threads);
+
+  return g_test_run ();
+}
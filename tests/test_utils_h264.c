@@ -0,0 +1,382 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <glib.h>
+
+#include "sysdeps.h"
+#include "gstmfxutils_h264.h"
+
+#define CORPUS_DIR    MFX_TEST_CORPUS_DIR "/h264"
+#define MUTATIONS     2000
+#define MAX_INPUT_SIZE     256
+
+/* Input buffer surrounded by inaccessible pages, so that any read out of
+ * bounds faults instead of going unnoticed */
+typedef struct
+{
+  guint8 *pages;
+  gsize page_size;
+} GuardedBuffer;
+
+static void
+guarded_buffer_init (GuardedBuffer * buf)
+{
+  buf->page_size = sysconf (_SC_PAGESIZE);
+  buf->pages = mmap (NULL, 3 * buf->page_size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  g_assert (buf->pages != MAP_FAILED);
+  g_assert (mprotect (buf->pages, buf->page_size, PROT_NONE) == 0);
+  g_assert (mprotect (buf->pages + 2 * buf->page_size, buf->page_size,
+          PROT_NONE) == 0);
+}
+
+static void
+guarded_buffer_clear (GuardedBuffer * buf)
+{
+  munmap (buf->pages, 3 * buf->page_size);
+}
+
+/* Copies @data right before the trailing guard page, or right after the
+ * leading one */
+static const guint8 *
+guarded_buffer_place (GuardedBuffer * buf, const guint8 * data, gsize size,
+    gboolean at_end)
+{
+  guint8 *const start = buf->pages + buf->page_size;
+  guint8 *const dest = at_end ? start + buf->page_size - size : start;
+
+  g_assert_cmpuint (size, <=, buf->page_size);
+  memcpy (dest, data, size);
+  return dest;
+}
+
+/* Reference bit reader: strips the emulation prevention bytes first, then
+ * reads bit by bit */
+typedef struct
+{
+  guint8 rbsp[MAX_INPUT_SIZE];
+  gsize size;
+  gsize bit;
+} RefReader;
+
+static void
+ref_reader_init (RefReader * reader, const guint8 * data, gsize size)
+{
+  guint zeros = 0;
+  gsize i;
+
+  reader->size = 0;
+  reader->bit = 0;
+  for (i = 0; i < size; i++) {
+    if (zeros >= 2 && data[i] == 0x03) {
+      zeros = 0;
+      continue;
+    }
+    zeros = data[i] ? 0 : zeros + 1;
+    reader->rbsp[reader->size++] = data[i];
+  }
+}
+
+static gboolean
+ref_reader_get_bit (RefReader * reader, guint * bit)
+{
+  if (reader->bit >= 8 * reader->size)
+    return FALSE;
+  *bit = (reader->rbsp[reader->bit / 8] >> (7 - reader->bit % 8)) & 1;
+  reader->bit++;
+  return TRUE;
+}
+
+static gboolean
+ref_reader_get_ue (RefReader * reader, guint32 * value)
+{
+  guint leading_zeros = 0, bit, i;
+  guint32 suffix = 0;
+
+  for (;;) {
+    if (!ref_reader_get_bit (reader, &bit))
+      return FALSE;
+    if (bit)
+      break;
+    if (++leading_zeros > 28)
+      return FALSE;
+  }
+  for (i = 0; i < leading_zeros; i++) {
+    if (!ref_reader_get_bit (reader, &bit))
+      return FALSE;
+    suffix = (suffix << 1) | bit;
+  }
+  *value = (1U << leading_zeros) - 1 + suffix;
+  return TRUE;
+}
+
+static gboolean
+ref_is_slice_intra (const guint8 * data, gint size)
+{
+  RefReader reader;
+  guint32 first_mb_in_slice, slice_type;
+
+  if (size < 2)
+    return FALSE;
+
+  ref_reader_init (&reader, data + 1, size - 1);
+  if (!ref_reader_get_ue (&reader, &first_mb_in_slice)
+      || !ref_reader_get_ue (&reader, &slice_type))
+    return FALSE;
+  return slice_type % 5 == 2;
+}
+
+static gboolean
+ref_avc_has_intra (const guint8 * data, gint size)
+{
+  gint64 offset = 0, nal_size;
+
+  while (size - offset > 4) {
+    nal_size = ((guint32) data[offset] << 24) | (data[offset + 1] << 16)
+        | (data[offset + 2] << 8) | data[offset + 3];
+    offset += 4;
+    if (!nal_size || nal_size > size - offset)
+      return FALSE;
+    if ((data[offset] & 0x1f) == 5)
+      return TRUE;
+    if ((data[offset] & 0x1f) == 1
+        && ref_is_slice_intra (data + offset, nal_size))
+      return TRUE;
+    offset += nal_size;
+  }
+  return FALSE;
+}
+
+/* Minimal RBSP writer for the slice headers of the tests */
+typedef struct
+{
+  guint8 data[MAX_INPUT_SIZE];
+  guint bits;
+} BitWriter;
+
+static void
+bit_writer_put (BitWriter * writer, guint32 value, guint n)
+{
+  while (n--) {
+    if ((value >> n) & 1)
+      writer->data[writer->bits / 8] |= 0x80 >> (writer->bits % 8);
+    writer->bits++;
+  }
+}
+
+static void
+bit_writer_put_ue (BitWriter * writer, guint32 value)
+{
+  guint n = g_bit_storage (value + 1);
+
+  bit_writer_put (writer, 0, n - 1);
+  bit_writer_put (writer, value + 1, n);
+}
+
+/* Writes a slice NAL unit with emulation prevention, returns its size */
+static gsize
+make_slice (guint8 * out, guint8 nal_header, guint32 first_mb,
+    guint32 slice_type, const guint8 * tail, gsize tail_size)
+{
+  BitWriter writer = { {0,}, 0 };
+  guint zeros = 0;
+  gsize i, size, n = 0;
+
+  bit_writer_put_ue (&writer, first_mb);
+  bit_writer_put_ue (&writer, slice_type);
+  bit_writer_put (&writer, 1, 1);
+  size = (writer.bits + 7) / 8;
+  memcpy (writer.data + size, tail, tail_size);
+  size += tail_size;
+
+  out[n++] = nal_header;
+  for (i = 0; i < size; i++) {
+    if (zeros >= 2 && writer.data[i] <= 3) {
+      out[n++] = 0x03;
+      zeros = 0;
+    }
+    zeros = writer.data[i] ? 0 : zeros + 1;
+    out[n++] = writer.data[i];
+  }
+  return n;
+}
+
+static void
+check_input (GuardedBuffer * buf, const guint8 * data, gsize size)
+{
+  const guint8 *placed;
+  gboolean at_end;
+
+  for (at_end = FALSE; at_end <= TRUE; at_end++) {
+    placed = guarded_buffer_place (buf, data, size, at_end);
+    g_assert_cmpint (gst_mfx_utils_h264_is_slice_intra (placed, size), ==,
+        ref_is_slice_intra (data, size));
+    g_assert_cmpint (gst_mfx_utils_h264_avc_has_intra (placed, size), ==,
+        ref_avc_has_intra (data, size));
+  }
+}
+
+/* Slice types are read right after first_mb_in_slice of any length, at
+ * any alignment of the slice, with and without emulation prevention */
+static void
+test_slice_type (void)
+{
+  static const guint32 first_mbs[] = {
+    0, 1, 2, 7, 255, 396, 1000, 8159, 65535, 1 << 20, (1 << 27) - 2
+  };
+  static const guint8 tails[][8] = {
+    {0xa5, 0x5a, 0x12, 0x34, 0xff, 0xff, 0xff, 0xff},
+    {0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x02},
+  };
+  guint8 slice[MAX_INPUT_SIZE + 4];
+  guint i, t, slice_type, offset;
+  gsize size;
+
+  for (i = 0; i < G_N_ELEMENTS (first_mbs); i++) {
+    for (t = 0; t < G_N_ELEMENTS (tails); t++) {
+      for (slice_type = 0; slice_type < 10; slice_type++) {
+        for (offset = 0; offset < 4; offset++) {
+          size = make_slice (slice + offset, 0x61, first_mbs[i], slice_type,
+              tails[t], sizeof (tails[t]));
+          g_assert_cmpint (gst_mfx_utils_h264_is_slice_intra (slice + offset,
+                  size), ==, slice_type % 5 == 2);
+        }
+      }
+    }
+  }
+}
+
+/* Lengths that run past the buffer, wrap around or are zero stop the
+ * walk, units before them are still looked at */
+static void
+test_avc_lengths (void)
+{
+  static const guint8 tail[] = { 0xa5, 0x5a };
+  static const guint32 bad_lengths[] = {
+    0, 0x7fffffff, 0x80000000, 0xffffffff
+  };
+  guint8 au[MAX_INPUT_SIZE];
+  gsize size, n;
+  guint i;
+
+  n = make_slice (au + 4, 0x65, 0, 7, tail, sizeof (tail));
+  GST_WRITE_UINT32_BE (au, n);
+  g_assert (gst_mfx_utils_h264_avc_has_intra (au, n + 4));
+  g_assert (!gst_mfx_utils_h264_avc_has_intra (au, n + 3));
+
+  for (i = 0; i < G_N_ELEMENTS (bad_lengths); i++) {
+    GST_WRITE_UINT32_BE (au, bad_lengths[i]);
+    g_assert (!gst_mfx_utils_h264_avc_has_intra (au, n + 4));
+  }
+  GST_WRITE_UINT32_BE (au, n + 1);
+  g_assert (!gst_mfx_utils_h264_avc_has_intra (au, n + 4));
+
+  /* P slice followed by an I slice */
+  size = make_slice (au + 4, 0x41, 0, 0, tail, sizeof (tail));
+  GST_WRITE_UINT32_BE (au, size);
+  size += 4;
+  n = make_slice (au + size + 4, 0x41, 396, 2, tail, sizeof (tail));
+  GST_WRITE_UINT32_BE (au + size, n);
+  g_assert (gst_mfx_utils_h264_avc_has_intra (au, size + n + 4));
+  g_assert (!gst_mfx_utils_h264_avc_has_intra (au, size + n + 3));
+}
+
+static void
+mutate (guint8 * data, gsize * size)
+{
+  guint i, n = g_test_rand_int_range (1, 4);
+
+  for (i = 0; i < n; i++) {
+    switch (g_test_rand_int_range (0, 4)) {
+      case 0:
+        if (*size)
+          data[g_test_rand_int_range (0, *size)] ^=
+              1 << g_test_rand_int_range (0, 8);
+        break;
+      case 1:
+        if (*size)
+          data[g_test_rand_int_range (0, *size)] =
+              g_test_rand_int_range (0, 4);
+        break;
+      case 2:
+        if (*size)
+          *size = g_test_rand_int_range (0, *size);
+        break;
+      case 3:
+        if (*size < MAX_INPUT_SIZE)
+          data[(*size)++] = g_test_rand_int_range (0, 256);
+        break;
+    }
+  }
+}
+
+/* Every corpus entry and mutations of it, read next to guard pages, give
+ * the results of the reference reader */
+static void
+test_corpus (void)
+{
+  GuardedBuffer buf;
+  GDir *dir;
+  const gchar *name;
+  gchar *path, *contents;
+  guint8 data[MAX_INPUT_SIZE];
+  gsize length, size;
+  guint i, entries = 0;
+
+  dir = g_dir_open (CORPUS_DIR, 0, NULL);
+  g_assert (dir != NULL);
+  guarded_buffer_init (&buf);
+
+  while ((name = g_dir_read_name (dir))) {
+    path = g_build_filename (CORPUS_DIR, name, NULL);
+    g_assert (g_file_get_contents (path, &contents, &length, NULL));
+    g_assert_cmpuint (length, <=, MAX_INPUT_SIZE);
+
+    check_input (&buf, (guint8 *) contents, length);
+    for (i = 0; i < MUTATIONS; i++) {
+      memcpy (data, contents, length);
+      size = length;
+      mutate (data, &size);
+      check_input (&buf, data, size);
+    }
+
+    g_free (contents);
+    g_free (path);
+    entries++;
+  }
+  g_assert_cmpuint (entries, >, 0);
+
+  guarded_buffer_clear (&buf);
+  g_dir_close (dir);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/utils/h264/slice-type", test_slice_type);
+  g_test_add_func ("/utils/h264/avc-lengths", test_avc_lengths);
+  g_test_add_func ("/utils/h264/corpus", test_corpus);
+
+  return g_test_run ();
+}
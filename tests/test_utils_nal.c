@@ -0,0 +1,241 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include "sysdeps.h"
+#include "gstmfxutils_nal.h"
+#include "gstmfxutils_startcode.h"
+
+#define CORPUS_DIR  MFX_TEST_CORPUS_DIR "/nal"
+#define MAX_NALS    32
+
+/* What gst_mfx_utils_nal_parse_header() is expected to report for each
+ * NAL unit of a corpus stream */
+typedef struct
+{
+  gboolean parsed;
+  guint8 type;
+  gboolean is_vcl;
+  gboolean is_sps;
+  gboolean is_keyframe;
+  gboolean starts_au;
+} NalExpectation;
+
+typedef struct
+{
+  const gchar *file;
+  mfxU32 codec;
+  const NalExpectation *nals;
+  guint num_nals;
+  /* Index of the first NAL unit of each access unit */
+  const guint *au_starts;
+  const gboolean *au_keyframes;
+  guint num_aus;
+} CorpusStream;
+
+static const NalExpectation avc_nals[] = {
+  {TRUE, 9, FALSE, FALSE, FALSE, TRUE},         /* AUD */
+  {TRUE, 7, FALSE, TRUE, FALSE, TRUE},          /* SPS */
+  {TRUE, 8, FALSE, FALSE, FALSE, TRUE},         /* PPS */
+  {TRUE, 6, FALSE, FALSE, FALSE, TRUE},         /* SEI */
+  {TRUE, 5, TRUE, FALSE, TRUE, TRUE},           /* IDR, first_mb_in_slice 0 */
+  {TRUE, 5, TRUE, FALSE, TRUE, FALSE},          /* IDR, next slice */
+  {TRUE, 1, TRUE, FALSE, FALSE, TRUE},          /* P */
+  {TRUE, 1, TRUE, FALSE, FALSE, FALSE},         /* P, next slice */
+  {TRUE, 6, FALSE, FALSE, FALSE, TRUE},         /* SEI */
+  {TRUE, 1, TRUE, FALSE, FALSE, TRUE},          /* non-reference B */
+  {TRUE, 14, FALSE, FALSE, FALSE, TRUE},        /* prefix NAL unit */
+  {TRUE, 1, TRUE, FALSE, FALSE, TRUE},          /* P */
+  {TRUE, 12, FALSE, FALSE, FALSE, FALSE},       /* filler data */
+  {TRUE, 7, FALSE, TRUE, FALSE, TRUE},          /* SPS */
+  {TRUE, 8, FALSE, FALSE, FALSE, TRUE},         /* PPS */
+  {TRUE, 5, TRUE, FALSE, TRUE, TRUE},           /* IDR */
+  {FALSE, 0, FALSE, FALSE, FALSE, FALSE},       /* end of stream, 1 byte */
+};
+
+static const guint avc_au_starts[] = { 0, 6, 8, 10, 13 };
+static const gboolean avc_au_keyframes[] = { TRUE, FALSE, FALSE, FALSE, TRUE };
+
+static const NalExpectation hevc_nals[] = {
+  {TRUE, 35, FALSE, FALSE, FALSE, TRUE},        /* AUD */
+  {TRUE, 32, FALSE, FALSE, FALSE, TRUE},        /* VPS */
+  {TRUE, 33, FALSE, TRUE, FALSE, TRUE},         /* SPS */
+  {TRUE, 34, FALSE, FALSE, FALSE, TRUE},        /* PPS */
+  {TRUE, 39, FALSE, FALSE, FALSE, TRUE},        /* prefix SEI */
+  {TRUE, 19, TRUE, FALSE, TRUE, TRUE},          /* IDR_W_RADL, first segment */
+  {TRUE, 19, TRUE, FALSE, TRUE, FALSE},         /* IDR_W_RADL, next segment */
+  {TRUE, 1, TRUE, FALSE, FALSE, TRUE},          /* TRAIL_R */
+  {TRUE, 40, FALSE, FALSE, FALSE, FALSE},       /* suffix SEI */
+  {TRUE, 0, TRUE, FALSE, FALSE, TRUE},          /* TRAIL_N */
+  {TRUE, 1, FALSE, FALSE, FALSE, FALSE},        /* TRAIL_R of layer 1 */
+  {TRUE, 39, FALSE, FALSE, FALSE, FALSE},       /* prefix SEI of layer 1 */
+  {TRUE, 21, TRUE, FALSE, TRUE, TRUE},          /* CRA */
+  {FALSE, 0, FALSE, FALSE, FALSE, FALSE},       /* end of bitstream, 2 bytes */
+};
+
+static const guint hevc_au_starts[] = { 0, 7, 9, 12 };
+static const gboolean hevc_au_keyframes[] = { TRUE, FALSE, FALSE, TRUE };
+
+static const CorpusStream streams[] = {
+  {"avc-au.264", MFX_CODEC_AVC, avc_nals, G_N_ELEMENTS (avc_nals),
+      avc_au_starts, avc_au_keyframes, G_N_ELEMENTS (avc_au_starts)},
+  {"hevc-au.265", MFX_CODEC_HEVC, hevc_nals, G_N_ELEMENTS (hevc_nals),
+      hevc_au_starts, hevc_au_keyframes, G_N_ELEMENTS (hevc_au_starts)},
+};
+
+/* Offsets of the NAL unit headers of a byte stream */
+static guint
+find_nal_units (const guint8 * data, gsize size, gsize * offsets,
+    gsize * sizes)
+{
+  guint n = 0;
+  gsize offset = 0;
+  gint pos;
+
+  while ((pos = gst_mfx_utils_find_start_code (data + offset,
+              size - offset)) >= 0) {
+    if (n)
+      sizes[n - 1] = offset + pos - offsets[n - 1];
+    g_assert_cmpuint (n, <, MAX_NALS);
+    offsets[n++] = offset + pos + 3;
+    offset += pos + 3;
+  }
+  if (n)
+    sizes[n - 1] = size - offsets[n - 1];
+  return n;
+}
+
+static void
+load_stream (const CorpusStream * stream, guint8 ** data, gsize * size)
+{
+  gchar *path = g_build_filename (CORPUS_DIR, stream->file, NULL);
+
+  g_assert_true (g_file_get_contents (path, (gchar **) data, size, NULL));
+  g_free (path);
+}
+
+static void
+test_parse_header (void)
+{
+  gsize offsets[MAX_NALS], sizes[MAX_NALS];
+  GstMfxNalUnitInfo info;
+  const NalExpectation *nal;
+  guint8 *data;
+  gsize size;
+  guint i, j, n;
+
+  for (i = 0; i < G_N_ELEMENTS (streams); i++) {
+    load_stream (&streams[i], &data, &size);
+    n = find_nal_units (data, size, offsets, sizes);
+    g_assert_cmpuint (n, ==, streams[i].num_nals);
+
+    for (j = 0; j < n; j++) {
+      nal = &streams[i].nals[j];
+      g_test_message ("%s: NAL unit %u", streams[i].file, j);
+
+      g_assert_cmpint (gst_mfx_utils_nal_parse_header (streams[i].codec,
+              data + offsets[j], sizes[j], &info), ==, nal->parsed);
+      if (!nal->parsed)
+        continue;
+      g_assert_cmpuint (info.type, ==, nal->type);
+      g_assert_cmpint (info.is_vcl, ==, nal->is_vcl);
+      g_assert_cmpint (info.is_sps, ==, nal->is_sps);
+      g_assert_cmpint (info.is_keyframe, ==, nal->is_keyframe);
+      g_assert_cmpint (info.starts_au, ==, nal->starts_au);
+    }
+    g_free (data);
+  }
+}
+
+/* Splits the corpus streams like the decoder does on unaligned input,
+ * looking at no more than the first three bytes of each NAL unit */
+static void
+test_au_split (void)
+{
+  gsize offsets[MAX_NALS], sizes[MAX_NALS];
+  GstMfxNalUnitInfo info;
+  GstMfxNalAu au;
+  guint8 *data;
+  gsize size;
+  guint i, j, n, num_aus;
+
+  for (i = 0; i < G_N_ELEMENTS (streams); i++) {
+    const CorpusStream *const stream = &streams[i];
+
+    load_stream (stream, &data, &size);
+    n = find_nal_units (data, size, offsets, sizes);
+
+    memset (&au, 0, sizeof (au));
+    num_aus = 0;
+    for (j = 0; j < n; j++) {
+      gst_mfx_utils_nal_parse_header (stream->codec, data + offsets[j],
+          MIN (sizes[j], 3), &info);
+      if (gst_mfx_utils_nal_au_add (&au, &info))
+        continue;
+
+      /* The previous access unit is complete */
+      g_assert_cmpuint (num_aus + 1, <, stream->num_aus);
+      g_assert_cmpint (au.is_keyframe, ==, stream->au_keyframes[num_aus]);
+      g_assert_cmpuint (stream->au_starts[++num_aus], ==, j);
+
+      memset (&au, 0, sizeof (au));
+      g_assert_true (gst_mfx_utils_nal_au_add (&au, &info));
+    }
+
+    /* At EOS, the rest makes up the last access unit */
+    g_assert_true (au.has_vcl);
+    g_assert_cmpint (au.is_keyframe, ==, stream->au_keyframes[num_aus]);
+    g_assert_cmpuint (num_aus + 1, ==, stream->num_aus);
+    g_free (data);
+  }
+}
+
+/* Headers cut short are rejected rather than read past their end */
+static void
+test_truncated_header (void)
+{
+  static const guint8 avc_idr[] = { 0x65, 0x88 };
+  static const guint8 hevc_idr[] = { 0x26, 0x01, 0xaf };
+  GstMfxNalUnitInfo info;
+
+  g_assert_false (gst_mfx_utils_nal_parse_header (MFX_CODEC_AVC, avc_idr,
+          1, &info));
+  g_assert_true (gst_mfx_utils_nal_parse_header (MFX_CODEC_AVC, avc_idr,
+          2, &info));
+  g_assert_false (gst_mfx_utils_nal_parse_header (MFX_CODEC_HEVC, hevc_idr,
+          2, &info));
+  g_assert_true (gst_mfx_utils_nal_parse_header (MFX_CODEC_HEVC, hevc_idr,
+          3, &info));
+  g_assert_false (gst_mfx_utils_nal_parse_header (MFX_CODEC_MPEG2, hevc_idr,
+          3, &info));
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/utils-nal/parse-header", test_parse_header);
+  g_test_add_func ("/utils-nal/au-split", test_au_split);
+  g_test_add_func ("/utils-nal/truncated-header", test_truncated_header);
+
+  return g_test_run ();
+}
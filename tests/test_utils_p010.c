@@ -0,0 +1,260 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include <glib.h>
+
+#include "gstmfxutils_p010.h"
+
+#define MAX_WIDTH  100
+#define GUARD      16
+#define GUARD_WORD 0xa5a5
+
+/* Room for whole v210 groups past MAX_WIDTH plus the guard */
+#define ROW_WORDS  (MAX_WIDTH + 8 + GUARD)
+#define V210_BYTES (16 * ((MAX_WIDTH + 5) / 6) + 8 + 2 * GUARD)
+
+static void
+fill_random (guint16 * data, guint n, guint bits)
+{
+  guint i;
+
+  for (i = 0; i < n; i++)
+    data[i] = g_test_rand_int_range (0, 1 << bits);
+}
+
+static void
+fill_guard (guint16 * data, guint n)
+{
+  guint i;
+
+  for (i = 0; i < n; i++)
+    data[i] = GUARD_WORD;
+}
+
+static void
+check_guard (const guint16 * data, guint n)
+{
+  guint i;
+
+  for (i = 0; i < GUARD; i++)
+    g_assert_cmphex (data[n + i], ==, GUARD_WORD);
+}
+
+static guint
+v210_size (guint width)
+{
+  return 16 * ((width + 5) / 6);
+}
+
+static guint
+read_sample (const guint8 * row, guint word, guint n)
+{
+  const guint32 w = row[4 * word] | (row[4 * word + 1] << 8)
+      | (row[4 * word + 2] << 16) | ((guint32) row[4 * word + 3] << 24);
+
+  return (w >> (10 * n)) & 0x3ff;
+}
+
+/* Position of luma sample x, and of chroma sample c (Cb Cr interleaved)
+ * of a v210 row, as word and slot */
+static void
+v210_luma_pos (guint x, guint * word, guint * slot)
+{
+  static const guint w[6] = { 0, 1, 1, 2, 3, 3 };
+  static const guint s[6] = { 1, 0, 2, 1, 0, 2 };
+
+  *word = 4 * (x / 6) + w[x % 6];
+  *slot = s[x % 6];
+}
+
+static void
+v210_chroma_pos (guint c, guint * word, guint * slot)
+{
+  static const guint w[6] = { 0, 0, 1, 2, 2, 3 };
+  static const guint s[6] = { 0, 2, 1, 0, 2, 1 };
+
+  *word = 4 * (c / 6) + w[c % 6];
+  *slot = s[c % 6];
+}
+
+/* The I420_10LE <-> P010 kernels match a plain shift of every sample, at
+ * any width and alignment, and write nothing past the row */
+static void
+test_i420_10le (void)
+{
+  guint16 src[3][ROW_WORDS], dst[3][ROW_WORDS];
+  guint width, offset, n, i;
+
+  for (width = 0; width <= MAX_WIDTH; width++) {
+    n = (width + 1) / 2;
+    for (offset = 0; offset < 4; offset++) {
+      fill_random (src[0] + offset, width, 10);
+      fill_random (src[1] + offset, n, 10);
+      fill_random (src[2] + offset, n, 10);
+
+      fill_guard (dst[0], ROW_WORDS);
+      gst_mfx_utils_p010_pack_y (src[0] + offset, dst[0] + offset, width);
+      for (i = 0; i < width; i++)
+        g_assert_cmphex (dst[0][offset + i], ==, src[0][offset + i] << 6);
+      check_guard (dst[0] + offset, width);
+
+      fill_guard (dst[0], ROW_WORDS);
+      gst_mfx_utils_p010_pack_uv (src[1] + offset, src[2] + offset,
+          dst[0] + offset, width);
+      for (i = 0; i < n; i++) {
+        g_assert_cmphex (dst[0][offset + 2 * i], ==, src[1][offset + i] << 6);
+        g_assert_cmphex (dst[0][offset + 2 * i + 1], ==,
+            src[2][offset + i] << 6);
+      }
+      check_guard (dst[0] + offset, 2 * n);
+
+      /* Any P010 word, the low bits being padding */
+      fill_random (src[0] + offset, 2 * n > width ? 2 * n : width, 16);
+      fill_guard (dst[1], ROW_WORDS);
+      gst_mfx_utils_p010_unpack_y (src[0] + offset, dst[1] + offset, width);
+      for (i = 0; i < width; i++)
+        g_assert_cmphex (dst[1][offset + i], ==, src[0][offset + i] >> 6);
+      check_guard (dst[1] + offset, width);
+
+      fill_guard (dst[1], ROW_WORDS);
+      fill_guard (dst[2], ROW_WORDS);
+      gst_mfx_utils_p010_unpack_uv (src[0] + offset, dst[1] + offset,
+          dst[2] + offset, width);
+      for (i = 0; i < n; i++) {
+        g_assert_cmphex (dst[1][offset + i], ==,
+            src[0][offset + 2 * i] >> 6);
+        g_assert_cmphex (dst[2][offset + i], ==,
+            src[0][offset + 2 * i + 1] >> 6);
+      }
+      check_guard (dst[1] + offset, n);
+      check_guard (dst[2] + offset, n);
+    }
+  }
+}
+
+/* v210 samples land in P010 luma and chroma, chroma being left alone
+ * for the rows whose chroma is dropped */
+static void
+test_from_v210 (void)
+{
+  guint8 src[V210_BYTES];
+  guint16 y[ROW_WORDS], uv[ROW_WORDS];
+  guint width, i, word, slot, n, c;
+
+  for (width = 0; width <= MAX_WIDTH; width++) {
+    for (i = 0; i < sizeof (src); i++)
+      src[i] = g_test_rand_int_range (0, 256);
+    n = 2 * ((width + 1) / 2);
+
+    fill_guard (y, ROW_WORDS);
+    fill_guard (uv, ROW_WORDS);
+    gst_mfx_utils_p010_from_v210 (src, y, uv, width);
+
+    for (i = 0; i < width; i++) {
+      v210_luma_pos (i, &word, &slot);
+      g_assert_cmphex (y[i], ==, read_sample (src, word, slot) << 6);
+    }
+    for (c = 0; c < n; c++) {
+      v210_chroma_pos (c, &word, &slot);
+      g_assert_cmphex (uv[c], ==, read_sample (src, word, slot) << 6);
+    }
+    check_guard (y, width);
+    check_guard (uv, n);
+
+    fill_guard (uv, ROW_WORDS);
+    gst_mfx_utils_p010_from_v210 (src, y, NULL, width);
+    check_guard (uv, 0);
+  }
+}
+
+/* P010 rows pack into v210 with the last pixel repeated in the padding
+ * of the last group, and whole groups only are written */
+static void
+test_to_v210 (void)
+{
+  guint16 y[ROW_WORDS], uv[ROW_WORDS];
+  guint8 dst[V210_BYTES];
+  guint width, size, i, word, slot, x, c;
+
+  for (width = 1; width <= MAX_WIDTH; width++) {
+    fill_random (y, ROW_WORDS, 16);
+    fill_random (uv, ROW_WORDS, 16);
+    size = v210_size (width);
+
+    memset (dst, 0xa5, sizeof (dst));
+    gst_mfx_utils_p010_to_v210 (y, uv, dst, width);
+
+    for (i = 0; i < size / 16 * 6; i++) {
+      x = MIN (i, width - 1);
+      v210_luma_pos (i, &word, &slot);
+      g_assert_cmphex (read_sample (dst, word, slot), ==, y[x] >> 6);
+
+      c = 2 * (x / 2) + (i & 1);
+      v210_chroma_pos (i, &word, &slot);
+      g_assert_cmphex (read_sample (dst, word, slot), ==, uv[c] >> 6);
+    }
+    for (i = 0; i < size / 4; i++)
+      g_assert_cmphex (dst[4 * i + 3] >> 6, ==, 0);
+    for (i = size; i < sizeof (dst); i++)
+      g_assert_cmphex (dst[i], ==, 0xa5);
+  }
+}
+
+/* 10-bit samples survive a round trip through each pair of kernels */
+static void
+test_round_trip (void)
+{
+  guint16 y[ROW_WORDS], uv[ROW_WORDS], u[ROW_WORDS], v[ROW_WORDS];
+  guint16 y2[ROW_WORDS], uv2[ROW_WORDS];
+  guint16 y3[ROW_WORDS], u3[ROW_WORDS], v3[ROW_WORDS];
+  guint8 v210[V210_BYTES];
+  guint width, n;
+
+  for (width = 1; width <= MAX_WIDTH; width++) {
+    n = (width + 1) / 2;
+    fill_random (y, width, 10);
+    fill_random (u, n, 10);
+    fill_random (v, n, 10);
+
+    gst_mfx_utils_p010_pack_y (y, y2, width);
+    gst_mfx_utils_p010_pack_uv (u, v, uv, width);
+    gst_mfx_utils_p010_to_v210 (y2, uv, v210, width);
+    gst_mfx_utils_p010_from_v210 (v210, y2, uv2, width);
+    gst_mfx_utils_p010_unpack_y (y2, y3, width);
+    gst_mfx_utils_p010_unpack_uv (uv2, u3, v3, width);
+
+    g_assert (memcmp (y3, y, width * sizeof (guint16)) == 0);
+    g_assert (memcmp (u3, u, n * sizeof (guint16)) == 0);
+    g_assert (memcmp (v3, v, n * sizeof (guint16)) == 0);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/utils/p010/i420-10le", test_i420_10le);
+  g_test_add_func ("/utils/p010/from-v210", test_from_v210);
+  g_test_add_func ("/utils/p010/to-v210", test_to_v210);
+  g_test_add_func ("/utils/p010/round-trip", test_round_trip);
+
+  return g_test_run ();
+}
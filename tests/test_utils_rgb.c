@@ -0,0 +1,124 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include <glib.h>
+
+#include "gstmfxutils_rgb.h"
+
+#define MAX_WIDTH 100
+#define GUARD     16
+#define GUARD_BYTE 0xa5
+
+static void
+reference_bgra_to_planar (const guint8 * src, guint8 * r, guint8 * g,
+    guint8 * b, guint width)
+{
+  guint i;
+
+  for (i = 0; i < width; i++) {
+    b[i] = src[4 * i];
+    g[i] = src[4 * i + 1];
+    r[i] = src[4 * i + 2];
+  }
+}
+
+static void
+fill_random (guint8 * data, gsize size)
+{
+  gsize i;
+
+  for (i = 0; i < size; i++)
+    data[i] = g_random_int_range (0, 256);
+}
+
+static void
+check_guard (const guint8 * data, guint width)
+{
+  guint i;
+
+  for (i = 0; i < GUARD; i++)
+    g_assert_cmpuint (data[width + i], ==, GUARD_BYTE);
+}
+
+/* Every width up to a few SIMD blocks, with source and destination rows
+ * at all byte offsets, compared with the scalar conversion */
+static void
+test_bgra_to_planar (void)
+{
+  guint8 src[4 * MAX_WIDTH + 16];
+  guint8 planes[3][MAX_WIDTH + 16 + GUARD];
+  guint8 ref[3][MAX_WIDTH];
+  guint width, offset, p;
+
+  for (width = 0; width <= MAX_WIDTH; width++) {
+    for (offset = 0; offset < 4; offset++) {
+      guint8 *const bgra = src + offset;
+
+      fill_random (bgra, 4 * width);
+      for (p = 0; p < 3; p++)
+        memset (planes[p], GUARD_BYTE, sizeof (planes[p]));
+
+      gst_mfx_utils_rgb_bgra_to_planar (bgra, planes[0] + offset,
+          planes[1] + offset, planes[2] + offset, width);
+      reference_bgra_to_planar (bgra, ref[0], ref[1], ref[2], width);
+
+      for (p = 0; p < 3; p++) {
+        g_assert (memcmp (planes[p] + offset, ref[p], width) == 0);
+        check_guard (planes[p] + offset, width);
+      }
+    }
+  }
+}
+
+/* Alpha is dropped, so it must not leak into any of the planes */
+static void
+test_bgra_to_planar_alpha (void)
+{
+  guint8 src[4 * MAX_WIDTH];
+  guint8 r[MAX_WIDTH], g[MAX_WIDTH], b[MAX_WIDTH];
+  guint i;
+
+  for (i = 0; i < MAX_WIDTH; i++) {
+    src[4 * i] = 0x10;
+    src[4 * i + 1] = 0x20;
+    src[4 * i + 2] = 0x30;
+    src[4 * i + 3] = 0xff;
+  }
+
+  gst_mfx_utils_rgb_bgra_to_planar (src, r, g, b, MAX_WIDTH);
+
+  for (i = 0; i < MAX_WIDTH; i++) {
+    g_assert_cmpuint (r[i], ==, 0x30);
+    g_assert_cmpuint (g[i], ==, 0x20);
+    g_assert_cmpuint (b[i], ==, 0x10);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/utils/rgb/bgra-to-planar", test_bgra_to_planar);
+  g_test_add_func ("/utils/rgb/bgra-to-planar-alpha",
+      test_bgra_to_planar_alpha);
+
+  return g_test_run ();
+}
@@ -0,0 +1,183 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <glib.h>
+
+#include "gstmfxvalock.h"
+
+#define NUM_THREADS 8
+#define ITERATIONS  20000
+
+typedef struct
+{
+  GstMfxVaLock lock;
+  volatile gint readers;
+  volatile gint writers;
+  volatile gint violations;
+  guint counter;
+} StressData;
+
+/* Exclusive sections must see neither readers nor other writers */
+static void
+check_exclusive (StressData * data)
+{
+  if (g_atomic_int_get (&data->readers) || g_atomic_int_get (&data->writers))
+    g_atomic_int_inc (&data->violations);
+}
+
+static void
+exclusive_section (StressData * data)
+{
+  gst_mfx_va_lock_acquire (&data->lock, TRUE);
+  check_exclusive (data);
+  g_atomic_int_inc (&data->writers);
+
+  /* Window system code calling back into the shared VA helpers */
+  gst_mfx_va_lock_acquire (&data->lock, FALSE);
+  gst_mfx_va_lock_acquire (&data->lock, TRUE);
+  data->counter++;
+  gst_mfx_va_lock_release (&data->lock);
+  gst_mfx_va_lock_release (&data->lock);
+
+  g_atomic_int_add (&data->writers, -1);
+  gst_mfx_va_lock_release (&data->lock);
+}
+
+static void
+shared_section (StressData * data)
+{
+  gst_mfx_va_lock_acquire (&data->lock, FALSE);
+  g_atomic_int_inc (&data->readers);
+  if (g_atomic_int_get (&data->writers))
+    g_atomic_int_inc (&data->violations);
+  g_atomic_int_add (&data->readers, -1);
+  gst_mfx_va_lock_release (&data->lock);
+}
+
+static gpointer
+stress_thread (gpointer user_data)
+{
+  StressData *const data = user_data;
+  guint i;
+
+  for (i = 0; i < ITERATIONS; i++) {
+    if (g_random_int_range (0, 8) == 0)
+      exclusive_section (data);
+    else
+      shared_section (data);
+  }
+  return NULL;
+}
+
+/* Threads mixing shared, exclusive and nested sections never overlap an
+ * exclusive section, and no exclusive section is lost */
+static void
+test_stress (void)
+{
+  StressData data = { 0, };
+  GThread *threads[NUM_THREADS];
+  guint i, expected;
+
+  gst_mfx_va_lock_init (&data.lock);
+  g_random_set_seed (0x5eed);
+
+  for (i = 0; i < NUM_THREADS; i++)
+    threads[i] = g_thread_new ("va-lock", stress_thread, &data);
+  for (i = 0; i < NUM_THREADS; i++)
+    g_thread_join (threads[i]);
+
+  g_assert_cmpint (data.violations, ==, 0);
+  g_assert_cmpint (data.readers, ==, 0);
+  g_assert_cmpint (data.writers, ==, 0);
+  g_assert_cmpuint (data.counter, >, 0);
+
+  /* Everyone has released the lock, so it must be free */
+  expected = data.counter;
+  exclusive_section (&data);
+  g_assert_cmpuint (data.counter, ==, expected + 1);
+
+  gst_mfx_va_lock_clear (&data.lock);
+}
+
+static gpointer
+hold_shared_thread (gpointer user_data)
+{
+  GstMfxVaLock *const lock = user_data;
+
+  gst_mfx_va_lock_acquire (lock, FALSE);
+  gst_mfx_va_lock_release (lock);
+  return NULL;
+}
+
+/* A nested exclusive lock is only released by its outermost release */
+static void
+test_recursive (void)
+{
+  GstMfxVaLock lock;
+  GThread *thread;
+
+  gst_mfx_va_lock_init (&lock);
+
+  gst_mfx_va_lock_acquire (&lock, TRUE);
+  gst_mfx_va_lock_acquire (&lock, TRUE);
+  gst_mfx_va_lock_acquire (&lock, FALSE);
+  gst_mfx_va_lock_release (&lock);
+  gst_mfx_va_lock_release (&lock);
+
+  /* Still held, so a reader in another thread has to wait for it */
+  thread = g_thread_new ("va-lock-reader", hold_shared_thread, &lock);
+  while (!gst_mfx_va_lock_get_contention (&lock))
+    g_usleep (1000);
+
+  gst_mfx_va_lock_release (&lock);
+  g_thread_join (thread);
+
+  g_assert_cmpuint (gst_mfx_va_lock_get_contention (&lock), ==, 1);
+  gst_mfx_va_lock_clear (&lock);
+}
+
+/* Shared sections of several threads may overlap */
+static void
+test_shared (void)
+{
+  GstMfxVaLock lock;
+  GThread *thread;
+
+  gst_mfx_va_lock_init (&lock);
+
+  gst_mfx_va_lock_acquire (&lock, FALSE);
+  thread = g_thread_new ("va-lock-reader", hold_shared_thread, &lock);
+  g_thread_join (thread);
+  gst_mfx_va_lock_release (&lock);
+
+  g_assert_cmpuint (gst_mfx_va_lock_get_contention (&lock), ==, 0);
+  gst_mfx_va_lock_clear (&lock);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/display/va-lock/shared", test_shared);
+  g_test_add_func ("/display/va-lock/recursive", test_recursive);
+  g_test_add_func ("/display/va-lock/stress", test_stress);
+
+  return g_test_run ();
+}
@@ -0,0 +1,212 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include <glib.h>
+
+#include "gstvc1bdu.h"
+#include "gstmfxutils_startcode.h"
+
+#define MAX_SIZE     300
+#define BENCH_SIZE   (16 * 1024 * 1024)
+#define BENCH_ROUNDS 8
+
+/* Random bytes that are mostly 0x00 and 0x01, so that start codes and
+ * near misses show up at every position of the SIMD blocks */
+static void
+fill_sparse (guint8 * data, gsize size)
+{
+  gsize i;
+
+  for (i = 0; i < size; i++) {
+    switch (g_test_rand_int_range (0, 8)) {
+      case 0:
+      case 1:
+      case 2:
+        data[i] = 0x00;
+        break;
+      case 3:
+        data[i] = 0x01;
+        break;
+      default:
+        data[i] = g_test_rand_int_range (0, 256);
+        break;
+    }
+  }
+}
+
+/* Walks all BDUs of data with both parsers, like the element does */
+static void
+check_equivalence (const guint8 * data, gsize size)
+{
+  GstVC1ParserResult res, ref_res;
+  GstVC1BDU bdu, ref_bdu;
+  gsize offset = 0;
+
+  for (;;) {
+    memset (&bdu, 0, sizeof (bdu));
+    memset (&ref_bdu, 0, sizeof (ref_bdu));
+    res = gst_vc1_parse_identify_next_bdu (data + offset, size - offset,
+        &bdu);
+    ref_res = gst_vc1_identify_next_bdu (data + offset, size - offset,
+        &ref_bdu);
+
+    g_assert_cmpint (res, ==, ref_res);
+    if (res != GST_VC1_PARSER_OK && res != GST_VC1_PARSER_NO_BDU_END)
+      break;
+
+    g_assert_cmpuint (bdu.sc_offset, ==, ref_bdu.sc_offset);
+    g_assert_cmpuint (bdu.offset, ==, ref_bdu.offset);
+    g_assert_cmpint (bdu.type, ==, ref_bdu.type);
+    g_assert (bdu.data == ref_bdu.data);
+    if (res == GST_VC1_PARSER_NO_BDU_END)
+      break;
+    g_assert_cmpuint (bdu.size, ==, ref_bdu.size);
+
+    offset += bdu.offset + bdu.size;
+  }
+}
+
+/* Random buffers of every size up to a few AVX2 blocks, at every
+ * alignment of the first byte */
+static void
+test_random (void)
+{
+  guint8 buf[MAX_SIZE + 32];
+  gsize size, align;
+  guint round;
+
+  for (round = 0; round < 20; round++) {
+    for (size = 0; size <= MAX_SIZE; size++) {
+      for (align = 0; align < 32; align += 3) {
+        fill_sparse (buf + align, size);
+        check_equivalence (buf + align, size);
+      }
+    }
+  }
+}
+
+/* A single start code at each position, including the ones straddling
+ * SIMD blocks and the last one that fits */
+static void
+test_positions (void)
+{
+  guint8 buf[MAX_SIZE];
+  gsize size, pos;
+
+  for (size = 4; size <= 100; size++) {
+    for (pos = 0; pos + 4 <= size; pos++) {
+      memset (buf, 0x55, size);
+      buf[pos] = 0x00;
+      buf[pos + 1] = 0x00;
+      buf[pos + 2] = 0x01;
+      buf[pos + 3] = 0x0f;
+      g_assert_cmpint (gst_mfx_utils_find_start_code (buf, size), ==, pos);
+      check_equivalence (buf, size);
+    }
+
+    /* A start code prefix without its type byte is not a start code */
+    memset (buf, 0x55, size);
+    buf[size - 3] = 0x00;
+    buf[size - 2] = 0x00;
+    buf[size - 1] = 0x01;
+    g_assert_cmpint (gst_mfx_utils_find_start_code (buf, size), ==, -1);
+    check_equivalence (buf, size);
+  }
+}
+
+/* Compressed data with a BDU every few kilobytes */
+static guint8 *
+make_stream (gsize size)
+{
+  guint8 *const data = g_malloc (size);
+  gsize i;
+
+  for (i = 0; i < size; i++)
+    data[i] = g_test_rand_int_range (2, 256);
+  for (i = 0; i + 4 <= size; i += g_test_rand_int_range (1024, 8192)) {
+    data[i] = 0x00;
+    data[i + 1] = 0x00;
+    data[i + 2] = 0x01;
+    data[i + 3] = GST_VC1_FRAME;
+  }
+  return data;
+}
+
+static guint
+count_bdus (const guint8 * data, gsize size, gboolean reference)
+{
+  GstVC1ParserResult res;
+  GstVC1BDU bdu;
+  gsize offset = 0;
+  guint n = 0;
+
+  do {
+    res = reference ?
+        gst_vc1_identify_next_bdu (data + offset, size - offset, &bdu) :
+        gst_vc1_parse_identify_next_bdu (data + offset, size - offset, &bdu);
+    if (res == GST_VC1_PARSER_OK)
+      offset += bdu.offset + bdu.size;
+    n++;
+  } while (res == GST_VC1_PARSER_OK);
+  return n;
+}
+
+/* Throughput of both parsers over the same stream, run with -m perf */
+static void
+test_benchmark (void)
+{
+  guint8 *data;
+  gdouble elapsed[2];
+  guint i, n[2];
+  gint reference;
+
+  if (!g_test_perf ()) {
+    g_test_skip ("run with -m perf");
+    return;
+  }
+
+  data = make_stream (BENCH_SIZE);
+  for (reference = 0; reference < 2; reference++) {
+    g_test_timer_start ();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+      n[reference] = count_bdus (data, BENCH_SIZE, reference);
+    elapsed[reference] = g_test_timer_elapsed ();
+  }
+  g_assert_cmpuint (n[0], ==, n[1]);
+
+  g_test_message ("scan_for_start_code: %.0f MB/s, scalar parser %.0f MB/s",
+      BENCH_ROUNDS * BENCH_SIZE / elapsed[0] / 1e6,
+      BENCH_ROUNDS * BENCH_SIZE / elapsed[1] / 1e6);
+  g_test_minimized_result (elapsed[0] / BENCH_ROUNDS,
+      "%.3f ms per 16 MiB", 1000 * elapsed[0] / BENCH_ROUNDS);
+  g_free (data);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/parsers/vc1/scan/positions", test_positions);
+  g_test_add_func ("/parsers/vc1/scan/random", test_random);
+  g_test_add_func ("/parsers/vc1/scan/benchmark", test_benchmark);
+
+  return g_test_run ();
+}
@@ -0,0 +1,206 @@
+/*
+ *  Copyright (C) 2017 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <glib.h>
+
+#include "gstmfxwaitqueue.h"
+
+/* Long enough to tell a wake-up from a timeout on a loaded machine */
+#define WAIT_TIMEOUT  (5 * G_TIME_SPAN_SECOND)
+#define PEER_DELAY    (20 * G_TIME_SPAN_MILLISECOND)
+
+typedef struct
+{
+  GstMfxWaitQueue *queue;
+  volatile guint queued;
+  volatile gint cancel;
+} Session;
+
+static void
+session_init (Session * session)
+{
+  session->queue = gst_mfx_wait_queue_new ();
+  session->queued = 1;
+  session->cancel = 0;
+}
+
+static void
+session_clear (Session * session)
+{
+  gst_mfx_wait_queue_replace (&session->queue, NULL);
+}
+
+/* Plays the sink, which releases the surface once it was shown */
+static gpointer
+dequeue_thread (gpointer data)
+{
+  Session *const session = data;
+
+  g_usleep (PEER_DELAY);
+  gst_mfx_wait_queue_clear_flag (session->queue, &session->queued);
+  return NULL;
+}
+
+/* Plays a flush or a state change, which set the cancel flag from
+ * another thread than the streaming one */
+static gpointer
+cancel_thread (gpointer data)
+{
+  Session *const session = data;
+
+  g_usleep (PEER_DELAY);
+  g_atomic_int_set (&session->cancel, 1);
+  gst_mfx_wait_queue_wake (session->queue);
+  return NULL;
+}
+
+/* Normal streaming up to EOS: the waiter sleeps until the surface is
+ * released, instead of running into the timeout */
+static void
+test_dequeue (void)
+{
+  Session session;
+  GThread *thread;
+  gint64 start;
+  gboolean dequeued;
+
+  session_init (&session);
+  thread = g_thread_new ("dequeue", dequeue_thread, &session);
+
+  start = g_get_monotonic_time ();
+  dequeued = gst_mfx_wait_queue_wait (session.queue, &session.queued,
+      start + WAIT_TIMEOUT, &session.cancel);
+  g_assert_true (dequeued);
+  g_assert_cmpint (g_get_monotonic_time () - start, <, WAIT_TIMEOUT);
+  g_assert_cmpuint (session.queued, ==, 0);
+
+  g_thread_join (thread);
+  session_clear (&session);
+}
+
+/* A surface that was released before the wait doesn't block at all */
+static void
+test_already_dequeued (void)
+{
+  Session session;
+
+  session_init (&session);
+  gst_mfx_wait_queue_clear_flag (session.queue, &session.queued);
+
+  g_assert_true (gst_mfx_wait_queue_wait (session.queue, &session.queued,
+          g_get_monotonic_time (), &session.cancel));
+  session_clear (&session);
+}
+
+/* FLUSH_START and PAUSED_TO_READY cancel the wait while the sink still
+ * holds the surface */
+static void
+test_cancel (void)
+{
+  Session session;
+  GThread *thread;
+  gint64 start;
+  gboolean dequeued;
+
+  session_init (&session);
+  thread = g_thread_new ("cancel", cancel_thread, &session);
+
+  start = g_get_monotonic_time ();
+  dequeued = gst_mfx_wait_queue_wait (session.queue, &session.queued,
+      start + WAIT_TIMEOUT, &session.cancel);
+  g_assert_false (dequeued);
+  g_assert_cmpint (g_get_monotonic_time () - start, <, WAIT_TIMEOUT);
+  g_assert_cmpuint (session.queued, ==, 1);
+
+  g_thread_join (thread);
+  session_clear (&session);
+}
+
+/* A flush that happened before the next frame came in */
+static void
+test_cancel_before_wait (void)
+{
+  Session session;
+  gint64 start;
+
+  session_init (&session);
+  g_atomic_int_set (&session.cancel, 1);
+
+  start = g_get_monotonic_time ();
+  g_assert_false (gst_mfx_wait_queue_wait (session.queue, &session.queued,
+          start + WAIT_TIMEOUT, &session.cancel));
+  g_assert_cmpint (g_get_monotonic_time () - start, <, WAIT_TIMEOUT);
+  session_clear (&session);
+}
+
+/* A sink that keeps the surface, e.g. paused, bounds the wait to the
+ * frame duration */
+static void
+test_timeout (void)
+{
+  Session session;
+  gint64 end_time;
+
+  session_init (&session);
+
+  end_time = g_get_monotonic_time () + PEER_DELAY;
+  g_assert_false (gst_mfx_wait_queue_wait (session.queue, &session.queued,
+          end_time, &session.cancel));
+  g_assert_cmpint (g_get_monotonic_time (), >=, end_time);
+  session_clear (&session);
+}
+
+/* Releasing the surface of one session leaves the waiter of another one
+ * blocked until its own surface is released */
+static void
+test_sessions (void)
+{
+  Session a, b;
+  GThread *thread;
+  gint64 end_time;
+
+  session_init (&a);
+  session_init (&b);
+  thread = g_thread_new ("dequeue", dequeue_thread, &b);
+
+  end_time = g_get_monotonic_time () + 4 * PEER_DELAY;
+  g_assert_false (gst_mfx_wait_queue_wait (a.queue, &a.queued, end_time,
+          &a.cancel));
+  g_assert_cmpint (g_get_monotonic_time (), >=, end_time);
+  g_assert_cmpuint (b.queued, ==, 0);
+
+  g_thread_join (thread);
+  session_clear (&a);
+  session_clear (&b);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/wait-queue/dequeue", test_dequeue);
+  g_test_add_func ("/wait-queue/already-dequeued", test_already_dequeued);
+  g_test_add_func ("/wait-queue/cancel", test_cancel);
+  g_test_add_func ("/wait-queue/cancel-before-wait", test_cancel_before_wait);
+  g_test_add_func ("/wait-queue/timeout", test_timeout);
+  g_test_add_func ("/wait-queue/sessions", test_sessions);
+
+  return g_test_run ();
+}